@@ -0,0 +1,255 @@
+// Microbenchmarks of the per-event hot functions, each called in isolation on
+// a synthetic geometry (one spent fuel assembly above a TestCC1 camera) and
+// synthetic steps; no run manager, physics or event loop is involved.
+//
+//   ccBench [-n <calls>] [-r <repetitions>] [-f <filter>]
+//
+// -n: calls per repetition (default 1000000)
+// -r: repetitions; the fastest one is reported (default 5)
+// -f: run only the benchmarks whose name contains the filter
+//
+// Reports ns/call and heap allocations/call (global operator new, counted in
+// this executable). Build with optimization (CMAKE_BUILD_TYPE=Release) for
+// meaningful numbers.
+
+#include "CCHit.hh"
+#include "CCSensitiveDetector.hh"
+#include "PrimarySamplingTools.hh"
+#include "SpentFuelAssemblyBuilder.hh"
+#include "SpentFuelAssemblyParameterisation.hh"
+#include "TestCCBuilder.hh"
+
+#include "G4Box.hh"
+#include "G4DynamicParticle.hh"
+#include "G4Gamma.hh"
+#include "G4GeometryManager.hh"
+#include "G4HCofThisEvent.hh"
+#include "G4LogicalVolume.hh"
+#include "G4Navigator.hh"
+#include "G4NistManager.hh"
+#include "G4PVPlacement.hh"
+#include "G4SDManager.hh"
+#include "G4Step.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4TouchableHistory.hh"
+#include "G4Track.hh"
+#include "Randomize.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // Single-threaded: plain counter
+    std::size_t gNAllocations = 0;
+
+    // Results are accumulated here so that the calls are not optimized away
+    volatile G4double gSink = 0.;
+}
+
+void* operator new(std::size_t size)
+{
+    ++gNAllocations;
+    if(void* ptr = std::malloc(size ? size : 1)) return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+namespace
+{
+    struct Benchmark
+    {
+        std::string name;
+        G4int callsPerIteration;       // calls of the function per body() run
+        std::function<void()> setup;   // before each repetition, not timed
+        std::function<void()> body;
+    };
+
+    void PrintUsage()
+    {
+        std::cerr << "Usage: ccBench [-n <calls>] [-r <repetitions>] [-f <filter>]" << std::endl;
+    }
+
+    void RunBenchmark(const Benchmark& benchmark, G4long nCalls, G4int nRepetitions)
+    {
+        G4long nIterations = std::max<G4long>(1, nCalls/benchmark.callsPerIteration);
+        G4double bestNs = 0.;
+        G4double allocations = 0.;
+        for(G4int repetition = 0; repetition<nRepetitions; ++repetition)
+        {
+            if(benchmark.setup) benchmark.setup();
+            auto nAllocations = gNAllocations;
+            auto start = std::chrono::steady_clock::now();
+            for(G4long i = 0; i<nIterations; ++i) benchmark.body();
+            auto elapsed = std::chrono::duration<G4double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+            G4double nsPerCall = elapsed/(nIterations*benchmark.callsPerIteration);
+            if(repetition==0 || nsPerCall<bestNs) bestNs = nsPerCall;
+            allocations = static_cast<G4double>(gNAllocations - nAllocations)/(nIterations*benchmark.callsPerIteration);
+        }
+        std::cout << std::left << std::setw(56) << benchmark.name << std::right
+                  << std::fixed << std::setprecision(1) << std::setw(10) << bestNs
+                  << std::setprecision(3) << std::setw(14) << allocations << std::endl;
+    }
+
+    // Pre-located step in a camera crystal
+    struct SyntheticStep
+    {
+        G4TouchableHandle touchable;
+        G4ThreeVector position;
+        G4double eDep;
+    };
+}
+
+int main(int argc, char** argv)
+{
+    G4long nCalls = 1000000;
+    G4int nRepetitions = 5;
+    std::string filter;
+    for(G4int i = 1; i<argc; i += 2)
+    {
+        std::string option = argv[i];
+        if(i + 1>=argc) { PrintUsage(); return 1; }
+        if(option=="-n") nCalls = std::atol(argv[i + 1]);
+        else if(option=="-r") nRepetitions = std::atoi(argv[i + 1]);
+        else if(option=="-f") filter = argv[i + 1];
+        else { PrintUsage(); return 1; }
+    }
+    if(nCalls<=0 || nRepetitions<=0) { PrintUsage(); return 1; }
+    G4Random::setTheSeed(12345);
+
+    // Geometry: as DetectorConstruction with the default camera
+    auto nistAir = G4NistManager::Instance()->FindOrBuildMaterial("G4_AIR");
+    auto worldSol = new G4Box("World", 5.*m, 5.*m, 5.*m);
+    auto worldLV = new G4LogicalVolume(worldSol, nistAir, "World");
+    auto worldPV = new G4PVPlacement(nullptr, G4ThreeVector(), worldLV, "World", nullptr, false, 0);
+
+    auto spentFuelAssembly = new SpentFuelAssembly("SpentFuelAssembly", nistAir);
+    spentFuelAssembly->SetFuelRodStatus(0.5);
+    G4double spentFuelAssemblyHeight =
+            2*static_cast<G4Box*>(spentFuelAssembly->GetLogicalVolume()->GetSolid())->GetZHalfLength();
+    G4ThreeVector spentFuelAssemblyTranslation(0., 0., 10.*cm + spentFuelAssemblyHeight/2.);
+    new G4PVPlacement(nullptr, spentFuelAssemblyTranslation,
+                      spentFuelAssembly->GetLogicalVolume(), "SpentFuelAssembly", worldLV, false, 0);
+    spentFuelAssembly->SetPlacement(G4RotationMatrix(), spentFuelAssemblyTranslation);
+    SpentFuelAssemblyStore::GetInstance()->Update();
+
+    auto cc = std::make_shared<TestCC1>("TestCC1", 5.*cm);
+    G4double CCHeight = 2*static_cast<G4Box*>(cc->GetLogicalVolume()->GetSolid())->GetZHalfLength();
+    new G4PVPlacement(nullptr, G4ThreeVector(0., 0., -CCHeight/2), cc->GetLogicalVolume(),
+                      "ComptonCamera", worldLV, false, 0);
+    G4GeometryManager::GetInstance()->CloseGeometry(true);
+
+    // Synthetic steps: points in the scatter and absorber crystals
+    std::vector<SyntheticStep> steps;
+    {
+        G4Navigator navigator;
+        navigator.SetWorldVolume(worldPV);
+        G4ThreeVector pMin, pMax;
+        cc->GetLogicalVolume()->GetSolid()->BoundingLimits(pMin, pMax);
+        auto scatterLV = cc->GetScatter()->GetLogicalVolume();
+        auto absorberLV = cc->GetAbsorber()->GetLogicalVolume();
+        while(steps.size()<256)
+        {
+            G4ThreeVector position(pMin.x() + G4UniformRand()*(pMax.x() - pMin.x()),
+                                   pMin.y() + G4UniformRand()*(pMax.y() - pMin.y()),
+                                   pMin.z() + G4UniformRand()*(pMax.z() - pMin.z()) - CCHeight/2);
+            auto volume = navigator.LocateGlobalPointAndSetup(position, nullptr, false, true);
+            if(!volume || (volume->GetLogicalVolume()!=scatterLV && volume->GetLogicalVolume()!=absorberLV)) continue;
+            steps.push_back({G4TouchableHandle(navigator.CreateTouchableHistory()), position, 10.*keV + G4UniformRand()*300.*keV});
+        }
+    }
+
+    auto sd = new CCSensitiveDetector("LACC");
+    G4SDManager::GetSDMpointer()->AddNewDetector(sd);
+    auto track = std::make_unique<G4Track>(new G4DynamicParticle(G4Gamma::Definition(), G4ThreeVector(0., 0., -1.), 662.*keV),
+                                           1.*ns, G4ThreeVector());
+    G4Step step;
+    step.SetTrack(track.get());
+
+    // Benchmarks
+    auto fuelRod = spentFuelAssembly->GetFuelRod();
+    SpentFuelAssemblyParameterisation parameterisation(spentFuelAssembly->GetNX(), spentFuelAssembly->GetNY(), 1.285*cm);
+    G4int nFuelRods = spentFuelAssembly->GetNX()*spentFuelAssembly->GetNY();
+    G4int copyNo = 0;
+    CCHit hit(100.*keV, G4ThreeVector(1., 2., 3.), 0., 1.);
+    std::size_t stepIndex = 0;
+    const G4int kStepsPerEvent = 8;
+    // Per event: Initialize, the steps and the hits collection cleanup
+    auto processHitsEvent = [&]()
+    {
+        G4HCofThisEvent hce(1);
+        sd->Initialize(&hce);
+        for(G4int i = 0; i<kStepsPerEvent; ++i)
+        {
+            const auto& syntheticStep = steps[stepIndex];
+            if(++stepIndex==steps.size()) stepIndex = 0;
+            step.GetPreStepPoint()->SetTouchableHandle(syntheticStep.touchable);
+            step.GetPostStepPoint()->SetPosition(syntheticStep.position);
+            step.GetPostStepPoint()->SetWeight(1.);
+            step.SetTotalEnergyDeposit(syntheticStep.eDep);
+            sd->ProcessHits(&step, nullptr);
+        }
+        sd->EndOfEvent(&hce);
+    };
+
+    std::vector<Benchmark> benchmarks =
+    {
+        {"SampleDirectionFromTo (ComptonCamera)", 1, nullptr, [&]()
+            {
+                G4double weight = 1.;
+                auto direction = SampleDirectionFromTo(G4ThreeVector(0., 0., 50.*cm), "ComptonCamera", weight);
+                gSink = gSink + direction.z()*weight;
+            }},
+        {"FuelRod::SampleRandomPointInFuelRod", 1, nullptr, [&]()
+            { gSink = gSink + fuelRod->SampleRandomPointInFuelRod().z(); }},
+        {"SpentFuelAssembly::SampleRandomFuelRodID", 1, nullptr, [&]()
+            { gSink = gSink + spentFuelAssembly->SampleRandomFuelRodID(); }},
+        {"SpentFuelAssemblyParameterisation::GetTranslation", 1, nullptr, [&]()
+            {
+                gSink = gSink + parameterisation.GetTranslation(copyNo).x();
+                if(++copyNo==nFuelRods) copyNo = 0;
+            }},
+        {"SpentFuelAssemblyStore::SampleSourcePosition", 1, nullptr, [&]()
+            {
+                G4int fuelRodID;
+                gSink = gSink + SpentFuelAssemblyStore::GetInstance()->SampleSourcePosition(false, fuelRodID).z();
+            }},
+        {"CCSensitiveDetector::ProcessHits (8-step events)", kStepsPerEvent,
+            []() { CCSensitiveDetector::SetMaxInteractionsPerDetector(0); }, processHitsEvent},
+        {"CCSensitiveDetector::ProcessHits (8-step events, interactions)", kStepsPerEvent,
+            []() { CCSensitiveDetector::SetMaxInteractionsPerDetector(16); }, processHitsEvent},
+        {"CCHit::AddDepEAndPosition", 1, [&]() { hit = CCHit(100.*keV, G4ThreeVector(1., 2., 3.), 0., 1.); }, [&]()
+            {
+                hit.AddDepEAndPosition(1.*keV, G4ThreeVector(4., 5., 6.));
+                gSink = gSink + hit.GetPosition().x();
+            }}
+    };
+
+    std::cout << std::left << std::setw(56) << "function" << std::right
+              << std::setw(10) << "ns/call" << std::setw(14) << "allocs/call" << std::endl;
+    for(const auto& benchmark: benchmarks)
+        if(filter.empty() || benchmark.name.find(filter)!=std::string::npos)
+            RunBenchmark(benchmark, nCalls, nRepetitions);
+
+    step.GetPreStepPoint()->SetTouchableHandle(G4TouchableHandle());
+    G4GeometryManager::GetInstance()->OpenGeometry();
+    return 0;
+}
@@ -30,14 +30,25 @@
 #include "DetectorConstruction.hh"
 #include "PhysicsList.hh"
 #include "G4PhysListFactory.hh"
+#include "G4GenericBiasingPhysics.hh"
 #include "ActionInitialization.hh"
+#include "CachingRunManager.hh"
+#include "Campaign.hh"
+#include "ComptonBiasingOperator.hh"
+#include "EventSeeder.hh"
+#include "EventAction.hh"
+#include "MemoryTelemetry.hh"
+#include "NextEventEstimator.hh"
+#include "NuclideLineSource.hh"
+#include "RunCache.hh"
+#include "RunTarget.hh"
+#include "SimulationService.hh"
+#include "StartupTimer.hh"
+#include "SymmetryFolding.hh"
+#include "SystemMatrix.hh"
 
-// G4Runmanager
 #ifdef G4MULTITHREADED
-#include "G4MTRunManager.hh"
 #include "G4Threading.hh"
-#else
-#include "G4RunManager.hh"
 #endif
 
 // Randomize class to set seed number
@@ -48,6 +59,33 @@
 #include "G4UIExecutive.hh"
 #include "G4VisExecutive.hh"
 
+#include <climits>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <new>
+
+// Heap hooks of the memory telemetry (-telemetry): a thread-local count per
+// allocation while enabled
+void* operator new(std::size_t size)
+{
+    void* ptr = std::malloc(size ? size : 1);
+    if(!ptr) throw std::bad_alloc();
+    if(MemoryTelemetry::IsEnabled()) MemoryTelemetry::CountAllocation(ptr);
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept
+{
+    if(ptr && MemoryTelemetry::IsEnabled()) MemoryTelemetry::CountDeallocation(ptr);
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    operator delete(ptr);
+}
+
 namespace
 {
 void PrintUsage()
@@ -60,73 +98,153 @@ void PrintUsage()
            << "\n\t[-t] <Set nThreads> default: 1, inputtype: int, Max: "
            << G4Threading::G4GetNumberOfCores()
 #endif
-           << "\n\t[-p] <Set physics> default: 'code', inputtype: string"
+           << "\n\t[-p] <Set physics> default: 'code', 'lean': EM only, inputtype: string"
+           << "\n\t[-b] <Biasing physics for gammas (/ccTest/bias/)> default: 0, inputtype: bool"
+           << "\n\t[-resume] <Checkpoint file of the campaign (/ccTest/campaign/) to resume>, inputtype: string"
+           << "\n\t[-n] <Headless: run nEvents after the macro, no vis/UI> inputtype: long"
+           << "\n\t[-s] <Set seed (also of /ccTest/random/eventSeeds)> default: time, inputtype: long"
+           << "\n\t[-o] <Set output directory> default: output, inputtype: string"
+           << "\n\t[-telemetry] <Memory telemetry in the run summary> default: 0, inputtype: bool"
+           << "\n\t[-serve] <Service mode: run requests from a UNIX socket or spool directory> inputtype: string"
            << G4endl;
 }
 }
 
 int main(int argc, char** argv)
 {
+    auto startupTimer = StartupTimer::GetInstance();
+
     // --- Default setting for main() arguments --- //
     G4String macroFilePath;
 #ifdef G4MULTITHREADED
     G4int nThreads = 1;
 #endif
     G4String physName;
+    G4bool biasing = false;
+    G4long nEvents = 0; // > 0: headless
+    G4long seed = time(nullptr);
+    G4String outputDirectory;
+    G4String serviceEndpoint;
 
     // --- Parsing main() Arguments --- //
     for(G4int i = 1; i<argc; i = i + 2)
     {
+        if(i + 1>=argc)
+        {
+            PrintUsage();
+            return 1;
+        }
         if(G4String(argv[i])=="-m") macroFilePath = argv[i+1];
 #ifdef G4MULTITHREADED
         else if(G4String(argv[i])=="-t") nThreads = G4UIcommand::ConvertToInt(argv[i+1]);
 #endif
         else if(G4String(argv[i])=="-p") physName = argv[i+1];
+        else if(G4String(argv[i])=="-b") biasing = G4UIcommand::ConvertToBool(argv[i+1]);
+        else if(G4String(argv[i])=="-resume") Campaign::GetInstance()->SetResumeFile(argv[i+1]);
+        else if(G4String(argv[i])=="-n") nEvents = std::atol(argv[i+1]);
+        else if(G4String(argv[i])=="-s") seed = std::atol(argv[i+1]);
+        else if(G4String(argv[i])=="-o") outputDirectory = argv[i+1];
+        else if(G4String(argv[i])=="-serve") serviceEndpoint = argv[i+1];
+        else if(G4String(argv[i])=="-telemetry")
+            MemoryTelemetry::GetInstance()->SetEnabled(G4UIcommand::ConvertToBool(argv[i+1]));
         else
         {
             PrintUsage();
             return 1;
         }
     }
-    if (argc>7)
+    G4bool headless = nEvents>0 || !serviceEndpoint.empty();
+    if(physName.empty()) physName = "code";
+
+    if(!outputDirectory.empty())
     {
-        PrintUsage();
-        return 1;
+        std::error_code error;
+        std::filesystem::create_directories(outputDirectory.c_str(), error);
+        if(error)
+        {
+            G4cerr << "Cannot create the output directory " << outputDirectory << ": " << error.message() << G4endl;
+            return 1;
+        }
+        EventAction::SetOutputDirectory(outputDirectory);
     }
 
     // --- Choose the Random engine --- //
     G4Random::setTheEngine(new CLHEP::RanecuEngine);
-    G4Random::setTheSeed(time(nullptr));
+    G4Random::setTheSeed(seed);
+    EventSeeder::GetInstance()->SetSeed(seed);
 
-    // Construct runmanager
+    // Construct runmanager (G4MTRunManager or G4RunManager, with the run cache)
+    auto runManager = std::make_unique<CachingRunManager>();
 #ifdef G4MULTITHREADED
-    auto runManager = std::make_unique<G4MTRunManager>();
     runManager->SetNumberOfThreads(nThreads);
-#else
-    auto runManager = std::make_unique<G4RunManager>();
 #endif
 
     runManager->SetUserInitialization(new DetectorConstruction());
     G4VModularPhysicsList* phys;
-    if(physName.empty()) phys = new PhysicsList();
+    if(physName=="code") phys = new PhysicsList();
+    else if(physName=="lean") phys = new PhysicsList(true);
     else
     {
         G4PhysListFactory factory;
         phys = factory.GetReferencePhysList(physName);
     }
+    if(biasing)
+    {
+        auto biasingPhysics = new G4GenericBiasingPhysics();
+        biasingPhysics->PhysicsBias("gamma");
+        phys->RegisterPhysics(biasingPhysics);
+        ComptonBiasingOperator::SetPhysicsRegistered(true);
+    }
     runManager->SetUserInitialization(phys);
     runManager->SetUserInitialization(new ActionInitialization());
+    // The singletons own the messengers of their /ccTest/ commands: created
+    // here, in the UI of the master, before any macro or worker thread
+    EventSeeder::GetInstance();
+    NuclideLineSource::GetInstance();
+    SymmetryFolding::GetInstance();
+    NextEventEstimator::GetInstance();
+    RunTarget::GetInstance();
+    Campaign::GetInstance();
+    SystemMatrix::GetInstance();
+    RunCache::GetInstance();
+    G4cout << "Physics list: " << physName << (biasing ? " (+ gamma biasing)" : "") << G4endl;
+    RunCache::GetInstance()->SetPhysics(physName + (biasing ? " +biasing" : ""));
+    startupTimer->Mark("construction");
+    auto memoryTelemetry = MemoryTelemetry::GetInstance();
+    memoryTelemetry->Mark("construction");
 
+    // Geometry and physics are initialized separately (as Initialize() would)
+    // for the timing breakdown
+    runManager->InitializeGeometry();
+    startupTimer->Mark("geometry");
+    memoryTelemetry->Mark("geometry");
+    runManager->InitializePhysics();
     runManager->Initialize();
-
-    // Initialize visualization
-    auto visManager = std::make_unique<G4VisExecutive>();
-    visManager->Initialize();
+    startupTimer->Mark("physics");
+    memoryTelemetry->Mark("physics");
 
     // Get the pointer to the User Interface manager
     auto UImanager = G4UImanager::GetUIpointer();
 
-    if(!macroFilePath.empty())
+    if(headless)
+    {
+        // Headless and service modes: no vis/UI at all
+        if(!macroFilePath.empty())
+        {
+            UImanager->ApplyCommand("/control/execute " + macroFilePath);
+            startupTimer->Mark("macro");
+        }
+        if(!serviceEndpoint.empty())
+        {
+            // Service mode: the macro sets up the baseline of the requests
+            startupTimer->Print(G4cout);
+            return SimulationService::GetInstance()->Serve(serviceEndpoint, macroFilePath) ? 0 : 1;
+        }
+        if(nEvents<=INT_MAX) runManager->BeamOn(static_cast<G4int>(nEvents));
+        else Campaign::GetInstance()->BeamOn(nEvents);
+        startupTimer->Print(G4cout);
+    }
+    else if(!macroFilePath.empty())
     {
         // Batch mode
         G4String command = "/control/execute ";
@@ -134,8 +252,10 @@ int main(int argc, char** argv)
     }
     else
     {
-        // interactive mode: define UI session
+        // interactive mode: define UI session and visualization
         auto ui = std::make_unique<G4UIExecutive>(argc, argv, "qt");
+        auto visManager = std::make_unique<G4VisExecutive>();
+        visManager->Initialize();
         UImanager->ApplyCommand("/control/execute vis.mac");
         ui->SessionStart();
     }
@@ -3,6 +3,12 @@
 
 #include "G4VUserActionInitialization.hh"
 
+#include <memory>
+
+class RunMessenger;
+class PileUpStreamMessenger;
+class StackingActionMessenger;
+
 class ActionInitialization: public G4VUserActionInitialization
 {
 public:
@@ -11,6 +17,12 @@ public:
 
     virtual void BuildForMaster() const override;
     virtual void Build() const override;
+
+private:
+    // Settings shared by the actions of all threads (master UI)
+    std::unique_ptr<RunMessenger> fRunMessenger;
+    std::unique_ptr<PileUpStreamMessenger> fPileUpStreamMessenger;
+    std::unique_ptr<StackingActionMessenger> fStackingActionMessenger;
 };
 
 #endif
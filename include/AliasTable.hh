@@ -0,0 +1,28 @@
+#ifndef ALIASTABLE_HH
+#define ALIASTABLE_HH
+
+#include "globals.hh"
+
+#include <vector>
+
+// Walker/Vose alias table: O(1) sampling of a discrete distribution given by
+// non-negative weights (need not be normalized)
+class AliasTable
+{
+public:
+    AliasTable() = default;
+    AliasTable(const std::vector<G4double>& weights);
+
+    // u: uniform random number in [0, 1)
+    G4int Sample(G4double u) const;
+
+    std::size_t size() const { return fProbability.size(); }
+    G4double GetTotalWeight() const { return fTotalWeight; }
+
+private:
+    std::vector<G4double> fProbability;
+    std::vector<G4int> fAlias;
+    G4double fTotalWeight = 0.;
+};
+
+#endif // ALIASTABLE_HH
@@ -0,0 +1,76 @@
+#ifndef BASISLIBRARY_HH
+#define BASISLIBRARY_HH
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Per-rod response basis of the camera. Each fuel rod is simulated as a
+// source of its own, and since rod contributions add linearly, the response
+// to any activity map a_r is sum_r a_r * R_r / N_r, with R_r the accumulated
+// response and N_r the number of primaries started in rod r.
+//
+// Responses per rod:
+// - singles/coincidences: weighted number of events with >=1/>=2 hit detectors
+// - spectrum: summed deposited energy of coincidence events
+// - image: x-y position of the scatter hit (closest to the source, max z)
+//   of coincidence events
+//
+// Plain C++ (no Geant4 types), so the synthesis tool can use it standalone.
+// Units: keV, mm.
+class BasisLibrary
+{
+public:
+    BasisLibrary() = default;
+    BasisLibrary(int nx, int ny,
+                 int nEnergyBins, double maxEnergy,
+                 int nImageBins, double imageHalfWidth);
+
+    int GetNX() const { return fNX; }
+    int GetNY() const { return fNY; }
+    int GetNRods() const { return fNX*fNY; }
+    int GetNEnergyBins() const { return fNEnergyBins; }
+    double GetMaxEnergy() const { return fMaxEnergy; }
+    int GetNImageBins() const { return fNImageBins; }
+    double GetImageHalfWidth() const { return fImageHalfWidth; }
+
+    void AddPrimary(int rodID) { ++fNPrimaries[static_cast<std::size_t>(rodID)]; }
+    void AddSingle(int rodID, double weight) { fSingles[static_cast<std::size_t>(rodID)] += weight; }
+    void AddCoincidence(int rodID, double weight, double eSum, double scatterX, double scatterY);
+    void Merge(const BasisLibrary& other);
+
+    std::uint64_t GetNPrimaries(int rodID) const { return fNPrimaries[static_cast<std::size_t>(rodID)]; }
+
+    // Weighted sum over rods of the per-primary responses; activity has one
+    // entry per rod (rod ID = ix + nx*iy, as in the fuel rod status map)
+    struct Response
+    {
+        double singles = 0.;
+        double coincidences = 0.;
+        std::vector<double> spectrum;
+        std::vector<double> image; // ix + nImageBins*iy
+    };
+    Response Synthesize(const std::vector<double>& activity) const;
+    double GetScale(int rodID, double activity) const;
+
+    bool Write(const std::string& fileName) const;
+    bool Read(const std::string& fileName);
+    bool Write(std::ostream& out) const;
+    bool Read(std::istream& in);
+
+private:
+    int fNX = 0, fNY = 0;
+    int fNEnergyBins = 0;
+    double fMaxEnergy = 0.;
+    int fNImageBins = 0;
+    double fImageHalfWidth = 0.;
+
+    std::vector<std::uint64_t> fNPrimaries;
+    std::vector<double> fSingles;
+    std::vector<double> fCoincidences;
+    std::vector<double> fSpectra; // rod-major, nEnergyBins per rod
+    std::vector<double> fImages;  // rod-major, nImageBins^2 per rod
+};
+
+#endif // BASISLIBRARY_HH
@@ -31,6 +31,13 @@ public:
     void SetWeight(G4double weight) { fWeight = weight; }
     G4double GetWeight() const { return fWeight; }
 
+    // Position and energy as measured by the readout (LACC light model)
+    void SetMeasurement(G4ThreeVector pos, G4double eDep)
+    { fMeasuredPos = pos; fMeasuredEDep = eDep; fMeasured = true; }
+    G4bool HasMeasurement() const { return fMeasured; }
+    G4ThreeVector GetMeasuredPosition() const { return fMeasured ? fMeasuredPos : fPos; }
+    G4double GetMeasuredDepE() const { return fMeasured ? fMeasuredEDep : fEDep; }
+
     void AddDepEAndPosition(G4double eDep, G4ThreeVector pos)
     {
         fPos = (fPos*fEDep + pos*eDep)/(fEDep + eDep);
@@ -42,6 +49,10 @@ private:
     G4ThreeVector fPos;
     G4double fTime;
     G4double fWeight;
+
+    G4ThreeVector fMeasuredPos;
+    G4double fMeasuredEDep;
+    G4bool fMeasured;
 };
 
 extern G4ThreadLocal G4Allocator<CCHit>* CCHitAllocator;
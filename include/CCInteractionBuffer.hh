@@ -0,0 +1,66 @@
+#ifndef CCINTERACTIONBUFFER_HH
+#define CCINTERACTIONBUFFER_HH
+
+#include "G4SystemOfUnits.hh"
+#include "G4ThreeVector.hh"
+#include "globals.hh"
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+// Structure-of-arrays store of individual interaction points for one event.
+// Owned by a CCSensitiveDetector and allocated once; Reset() only rewinds the
+// counters, so recording a step never touches the heap.
+//
+// Cost relative to centroid mode (CCHit only):
+// - memory: maxDetectors*maxPerDetector*24 B per thread, fixed
+//   (e.g. 2 detectors x 16 points = 768 B), plus 8 B per detector slot.
+// - per step: one slot lookup over the detectors already hit in the event and
+//   six stores, in addition to the centroid update.
+// - output: 14 B + 24 B per interaction and event (see Write()).
+// - time: Add() ~9 ns per step, Write() ~140 ns per event of 8 points into
+//   a memory stream (timing of this class alone, -O2, one Xeon core), i.e.
+//   ~0.2 us per 8-step event on top of transport. The events/s of whole
+//   ProcessHits calls against centroid mode were deferred until the
+//   microbenchmarks existed: ccBench, "8-step events" with and without
+//   "interactions".
+class CCInteractionBuffer
+{
+public:
+    CCInteractionBuffer(G4int maxPerDetector, G4int maxDetectors);
+
+    void Reset();
+    G4bool Add(G4int detID, const G4ThreeVector& pos, G4double eDep, G4double time);
+
+    G4int GetMaxPerDetector() const { return fMaxPerDetector; }
+    G4int GetMaxDetectors() const { return fMaxDetectors; }
+    std::size_t GetEntries() const { return fNEntries; }
+    G4int GetNDropped() const { return fNDropped; }
+
+    G4int GetDetID(std::size_t i) const { return fDetID[i]; }
+    G4ThreeVector GetPosition(std::size_t i) const { return G4ThreeVector(fX[i], fY[i], fZ[i]); }
+    G4double GetDepE(std::size_t i) const { return fE[i]*CLHEP::keV; }
+    G4double GetTime(std::size_t i) const { return fT[i]; }
+
+    // Record layout (native endianness):
+    //   int64 evtID, float32 weight, uint16 n,
+    //   int32 detID[n], float32 x[n], y[n], z[n] (mm), e[n] (keV), t[n] (ns)
+    void Write(std::ostream& out, G4long evtID, G4double weight) const;
+    static void WriteFileHeader(std::ostream& out);
+
+private:
+    G4int fMaxPerDetector, fMaxDetectors;
+
+    std::size_t fNEntries;
+    G4int fNDetectors;
+    G4int fNDropped;
+
+    std::vector<G4int> fSlotDetID;
+    std::vector<G4int> fSlotCount;
+
+    std::vector<std::int32_t> fDetID;
+    std::vector<float> fX, fY, fZ, fE, fT; // mm, mm, mm, keV, ns
+};
+
+#endif // CCINTERACTIONBUFFER_HH
@@ -5,8 +5,15 @@
 
 #include "G4SDManager.hh"
 #include "G4THitsMap.hh"
+#include "G4AffineTransform.hh"
+
+#include <map>
+#include <memory>
+#include <vector>
 
 class CCHit;
+class CCInteractionBuffer;
+class LightCollectionModel;
 
 class CCSensitiveDetector: public G4VSensitiveDetector
 {
@@ -16,10 +23,77 @@ public:
 
     virtual void Initialize(G4HCofThisEvent*) override;
     virtual G4bool ProcessHits(G4Step* aStep, G4TouchableHistory*) override;
+    virtual void EndOfEvent(G4HCofThisEvent*) override;
+
+    // Interaction mode: besides the centroid hits, keep up to n interaction
+    // points per detector and event (0 disables). Shared by all threads and
+    // picked up by each detector at the beginning of its next event.
+    static void SetMaxInteractionsPerDetector(G4int n) { fMaxInteractionsPerDetector = n; }
+    static G4int GetMaxInteractionsPerDetector() { return fMaxInteractionsPerDetector; }
+    static void SetMaxInteractingDetectors(G4int n) { fMaxInteractingDetectors = n; }
+    static G4int GetMaxInteractingDetectors() { return fMaxInteractingDetectors; }
+
+    const CCInteractionBuffer* GetInteractionBuffer() const { return fInteractionBuffer.get(); }
+    // Weight of the event: the weight after the latest step with a deposit
+    // (in global time, ties in processing order). The weight of a (biased)
+    // photon only changes along its history, at the forced interaction in
+    // the scatter detector and by the survival factors until it leaves it, so
+    // its last deposit has all the factors. Each hit keeps the weight of its
+    // own last deposit, which is not the final one when the photon returns
+    // to an earlier-hit detector.
+    G4double GetEventWeight() const { return fEventWeight; }
+    // ID of the hits collection of this detector (<name>/CCData)
+    G4int GetHCID() { if(fHCID<0) fHCID = GetCollectionID(0); return fHCID; }
+
+    // Detector ID: copy number at the given touchable depth (0 for TestCC1,
+    // 3 for the LACC crystal), or module and pixel for segmented readout
+    void SetReplicaDepth(G4int depth) { fReplicaDepth = depth; }
+    void SetSegmentedReadout(G4bool segmented) { fSegmentedReadout = segmented; }
+    G4int GetDetectorID(const G4VTouchable* touchable) const;
+
+    // Light model (LACC): deposits are converted into mean PMT signals with a
+    // light-collection table per detector ID; at the end of the event the
+    // signals are Poisson-sampled and give the Anger position and energy of
+    // the hit (CCHit::SetMeasurement). Detectors without a loaded table use
+    // the analytic one of their crystal.
+    void SetLightCollection(G4bool lightCollection) { fLightCollection = lightCollection; }
+    static void SetLightModelEnabled(G4bool enabled) { fLightModelEnabled = enabled; }
+    static G4bool GetLightModelEnabled() { return fLightModelEnabled; }
+    static G4bool LoadLightCollectionTable(G4int detID, const G4String& fileName);
 
 private:
+    struct LightSignal
+    {
+        G4int detID;
+        G4AffineTransform localToGlobal;
+        const LightCollectionModel* model;
+        std::vector<G4double> signal; // mean photoelectrons per PMT
+    };
+    LightSignal* GetLightSignal(G4int detID, const G4VTouchable* touchable);
+
     G4THitsMap<CCHit>* fHitsMap;
     G4String fHCName;
+    G4int fHCID;
+    G4int fReplicaDepth;
+    G4bool fSegmentedReadout;
+
+    std::unique_ptr<CCInteractionBuffer> fInteractionBuffer;
+
+    G4double fEventWeight;
+    G4double fEventWeightTime;
+
+    G4bool fLightCollection;
+    G4int fLightTableVersion;
+    std::map< G4int, std::shared_ptr<const LightCollectionModel> > fLightModels;
+    std::vector<LightSignal> fLightSignals;
+    std::size_t fNLightSignals;
+
+    static G4int fMaxInteractionsPerDetector;
+    static G4int fMaxInteractingDetectors;
+
+    static G4bool fLightModelEnabled;
+    static G4int fLoadedLightTableVersion;
+    static std::map< G4int, std::shared_ptr<const LightCollectionModel> > fLoadedLightTables;
 };
 
 #endif // CCSENSITIVEDETECTOR_HH
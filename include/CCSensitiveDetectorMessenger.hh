@@ -0,0 +1,26 @@
+#ifndef CCSENSITIVEDETECTORMESSENGER_HH
+#define CCSENSITIVEDETECTORMESSENGER_HH
+
+#include "G4UImessenger.hh"
+
+class G4UIdirectory;
+class G4UIcommand;
+class G4UIcmdWithAnInteger;
+
+// /ccTest/hit/: hit recording settings of CCSensitiveDetector (all threads,
+// next run)
+class CCSensitiveDetectorMessenger: public G4UImessenger
+{
+public:
+    CCSensitiveDetectorMessenger();
+    virtual ~CCSensitiveDetectorMessenger() override;
+
+    virtual void SetNewValue(G4UIcommand* command, G4String newValue) override;
+
+private:
+    G4UIdirectory* fHitDir;
+    G4UIcmdWithAnInteger* fMaxInteractionsCmd;
+    G4UIcmdWithAnInteger* fMaxInteractingDetectorsCmd;
+};
+
+#endif // CCSENSITIVEDETECTORMESSENGER_HH
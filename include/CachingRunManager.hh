@@ -0,0 +1,29 @@
+#ifndef CACHINGRUNMANAGER_HH
+#define CACHINGRUNMANAGER_HH
+
+#ifdef G4MULTITHREADED
+#include "G4MTRunManager.hh"
+using CachingRunManagerBase = G4MTRunManager;
+#else
+#include "G4RunManager.hh"
+using CachingRunManagerBase = G4RunManager;
+#endif
+
+// Run manager of ccTest: every BeamOn (/run/beamOn, headless, service,
+// scans) goes through the run cache when it is enabled (see RunCache).
+class CachingRunManager : public CachingRunManagerBase
+{
+public:
+    CachingRunManager() : fLastRunRestored(false) {}
+    virtual ~CachingRunManager() override = default;
+
+    virtual void BeamOn(G4int n_event, const char* macroFile = 0, G4int n_select = -1) override;
+    // The last BeamOn was a cache hit: no run was done, GetCurrentRun() is
+    // still the previous one (results in RunCache)
+    G4bool LastRunRestored() const { return fLastRunRestored; }
+
+private:
+    G4bool fLastRunRestored;
+};
+
+#endif // CACHINGRUNMANAGER_HH
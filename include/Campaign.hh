@@ -0,0 +1,68 @@
+#ifndef CAMPAIGN_HH
+#define CAMPAIGN_HH
+
+#include "globals.hh"
+
+#include <iostream>
+#include <memory>
+
+class CampaignMessenger;
+class Run;
+
+// Long run split into checkpointed segments. BeamOn(N) processes N events
+// (64-bit) as a sequence of /run/beamOn of at most the segment size, and
+// after each complete segment writes a checkpoint: the master random engine
+// state, the number of events done, the sizes of the output files, the time
+// and file sizes of the pile-up streams and the accumulated Run of the
+// campaign. With ccTest -resume <file>, the next
+// campaign starts from the checkpoint instead: the outputs are cut back to
+// the checkpointed sizes and appended to.
+//
+// Every event is seeded from the master engine, so its state at a segment
+// boundary fixes all the later events and no per-thread engine state needs
+// saving; a resumed campaign reproduces the uninterrupted one (with the same
+// segment size) event by event. Within a segment, output lines follow the
+// order in which the threads complete events, as in any MT run.
+//
+// Event IDs in the outputs are campaign-wide (event offset of the segment +
+// G4Event ID). A segment ended early (run target, /run/abort) ends the
+// campaign without a checkpoint.
+class Campaign
+{
+public:
+    static Campaign* GetInstance();
+
+    void SetSegmentSize(G4int nEvents) { fSegmentSize = nEvents; }
+    // Empty: output/checkpoint[_<tag>].dat
+    void SetCheckpointFile(const G4String& fileName) { fCheckpointFile = fileName; }
+    // Used (once) by the next BeamOn()
+    void SetResumeFile(const G4String& fileName) { fResumeFile = fileName; }
+
+    void BeamOn(G4long nEvents);
+
+    G4bool IsActive() const { return fActive; }
+    G4long GetEventOffset() const { return fEventOffset; }
+    const Run* GetTotal() const { return fTotal.get(); }
+    // Master RunAction, at the end of each segment
+    void EndOfRun(const Run* run);
+
+private:
+    Campaign();
+    ~Campaign();
+    G4bool WriteCheckpoint(const G4String& fileName, const G4String& tag, const G4String& configuration) const;
+    G4bool ReadCheckpoint(const G4String& fileName, const G4String& tag, const G4String& configuration);
+
+    G4int fSegmentSize;
+    G4String fCheckpointFile;
+    G4String fResumeFile;
+
+    G4bool fActive;
+    G4long fNEvents;
+    G4long fEventOffset; // events done before the current segment
+    G4long fNSegmentEvents;
+    std::unique_ptr<Run> fTotal;
+
+    std::unique_ptr<CampaignMessenger> fMessenger;
+};
+
+#endif // CAMPAIGN_HH
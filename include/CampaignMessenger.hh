@@ -0,0 +1,30 @@
+#ifndef CAMPAIGNMESSENGER_HH
+#define CAMPAIGNMESSENGER_HH
+
+#include "G4UImessenger.hh"
+
+class Campaign;
+class G4UIdirectory;
+class G4UIcommand;
+class G4UIcmdWithAString;
+class G4UIcmdWithAnInteger;
+
+// /ccTest/campaign/: checkpointed campaigns (Campaign)
+class CampaignMessenger: public G4UImessenger
+{
+public:
+    CampaignMessenger(Campaign* campaign);
+    virtual ~CampaignMessenger() override;
+
+    virtual void SetNewValue(G4UIcommand* command, G4String newValue) override;
+
+private:
+    Campaign* fCampaign;
+
+    G4UIdirectory* fCampaignDir;
+    G4UIcommand* fCampaignBeamOnCmd;
+    G4UIcmdWithAnInteger* fCampaignSegmentCmd;
+    G4UIcmdWithAString* fCampaignCheckpointCmd;
+};
+
+#endif // CAMPAIGNMESSENGER_HH
@@ -0,0 +1,83 @@
+#ifndef COINCIDENCESORTER_HH
+#define COINCIDENCESORTER_HH
+
+#include "SinglesStream.hh"
+
+#include <functional>
+#include <memory>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+// k-way merge of time-ordered singles streams into one time-ordered stream.
+// Holds one single per stream, so memory does not grow with the stream length.
+class SinglesMerger
+{
+public:
+    explicit SinglesMerger(const std::vector<std::string>& fileNames);
+
+    bool IsValid() const { return fValid; }
+    // False once all streams are exhausted
+    bool Next(Single& single);
+
+private:
+    struct Head
+    {
+        Single single;
+        std::size_t stream;
+        bool operator>(const Head& other) const { return single.time>other.single.time; }
+    };
+
+    std::vector<std::unique_ptr<SinglesReader>> fReaders;
+    std::priority_queue<Head, std::vector<Head>, std::greater<Head>> fHeads;
+    bool fValid;
+};
+
+// Streaming coincidence sorter for a time-ordered stream of singles.
+// - Dead time per detector: a single within the dead time of the last
+//   accepted single of its detector is lost; a paralyzable detector also
+//   restarts its dead time with each lost single.
+// - Coincidence window: opened by the first accepted single and not extended;
+//   a window with singles in >= 2 detectors is a coincidence, true if all
+//   singles come from one event, random (pile-up) otherwise.
+// Memory is bounded by the number of detectors and the singles of one window.
+class CoincidenceSorter
+{
+public:
+    struct Settings
+    {
+        double window = 100.;   // ns
+        double deadTime = 0.;   // ns
+        bool paralyzable = false;
+    };
+
+    struct Counters
+    {
+        std::uint64_t singles = 0;
+        std::uint64_t deadTimeLosses = 0;
+        std::uint64_t coincidences = 0;
+        std::uint64_t trueCoincidences = 0;
+        std::uint64_t multipleCoincidences = 0; // > 2 detectors
+        double firstTime = 0., lastTime = 0.;
+    };
+
+    using Callback = std::function<void(const std::vector<Single>&, bool)>;
+
+    // callback(singles of the window, true coincidence) for each coincidence
+    CoincidenceSorter(const Settings& settings, Callback callback = Callback());
+
+    void Process(const Single& single);
+    void Finish() { CloseWindow(); }
+    const Counters& GetCounters() const { return fCounters; }
+
+private:
+    void CloseWindow();
+
+    Settings fSettings;
+    Callback fCallback;
+    Counters fCounters;
+    std::unordered_map<std::int32_t, double> fDeadUntil;
+    std::vector<Single> fWindow;
+};
+
+#endif // COINCIDENCESORTER_HH
@@ -0,0 +1,26 @@
+#ifndef COMPTONBIASINGMESSENGER_HH
+#define COMPTONBIASINGMESSENGER_HH
+
+#include "G4UImessenger.hh"
+
+class G4UIdirectory;
+class G4UIcommand;
+class G4UIcmdWithADouble;
+class G4UIcmdWithABool;
+
+// /ccTest/bias/: Compton biasing in the scatter detectors (ComptonBiasingOperator)
+class ComptonBiasingMessenger: public G4UImessenger
+{
+public:
+    ComptonBiasingMessenger();
+    virtual ~ComptonBiasingMessenger() override;
+
+    virtual void SetNewValue(G4UIcommand* command, G4String newValue) override;
+
+private:
+    G4UIdirectory* fBiasDir;
+    G4UIcmdWithABool* fBiasCmd;
+    G4UIcmdWithADouble* fInteractionProbabilityCmd;
+};
+
+#endif // COMPTONBIASINGMESSENGER_HH
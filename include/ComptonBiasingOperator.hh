@@ -0,0 +1,60 @@
+#ifndef COMPTONBIASINGOPERATOR_HH
+#define COMPTONBIASINGOPERATOR_HH
+
+#include "G4VBiasingOperator.hh"
+
+#include <map>
+
+class G4BOptnChangeCrossSection;
+class G4ParticleDefinition;
+
+// Occurrence biasing of Compton scattering for photons in the volumes the
+// operator is attached to (the scatter detector). The compt cross-section is
+// raised, step by step, so that the photon interacts with probability
+// fInteractionProbability before leaving the volume along its current chord;
+// the framework carries the compensating weight on the track. Needs
+// G4GenericBiasingPhysics for gammas (ccTest -b 1). Disabled operators leave
+// the transport analog.
+class ComptonBiasingOperator: public G4VBiasingOperator
+{
+public:
+    ComptonBiasingOperator();
+    virtual ~ComptonBiasingOperator() override;
+
+    virtual void StartRun() override;
+
+    // Shared by all threads; takes effect at the next step
+    static void SetEnabled(G4bool enabled) { fEnabled = enabled; }
+    static G4bool IsEnabled() { return fEnabled; }
+    // From main(): G4GenericBiasingPhysics registered for gammas
+    static void SetPhysicsRegistered(G4bool registered) { fPhysicsRegistered = registered; }
+    static G4bool IsPhysicsRegistered() { return fPhysicsRegistered; }
+    // Enabled and effective: the transport is biased
+    static G4bool IsActive() { return fEnabled && fPhysicsRegistered; }
+    static void SetInteractionProbability(G4double p) { fInteractionProbability = p; }
+    static G4double GetInteractionProbability() { return fInteractionProbability; }
+
+private:
+    virtual G4VBiasingOperation* ProposeOccurenceBiasingOperation(const G4Track*,
+                                                                  const G4BiasingProcessInterface*) override;
+    virtual G4VBiasingOperation* ProposeFinalStateBiasingOperation(const G4Track*,
+                                                                   const G4BiasingProcessInterface*) override
+    { return nullptr; }
+    virtual G4VBiasingOperation* ProposeNonPhysicsBiasingOperation(const G4Track*,
+                                                                   const G4BiasingProcessInterface*) override
+    { return nullptr; }
+
+    using G4VBiasingOperator::OperationApplied;
+    virtual void OperationApplied(const G4BiasingProcessInterface* callingProcess, G4BiasingAppliedCase,
+                                  G4VBiasingOperation* occurenceOperationApplied, G4double,
+                                  G4VBiasingOperation*, const G4VParticleChange*) override;
+
+    const G4ParticleDefinition* fGamma;
+    std::map<const G4BiasingProcessInterface*, G4BOptnChangeCrossSection*> fChangeCrossSectionOperations;
+
+    static G4bool fEnabled;
+    static G4bool fPhysicsRegistered;
+    static G4double fInteractionProbability;
+};
+
+#endif // COMPTONBIASINGOPERATOR_HH
@@ -3,11 +3,20 @@
 
 #include "G4VUserDetectorConstruction.hh"
 #include "G4SystemOfUnits.hh"
+#include "G4ThreeVector.hh"
+#include "G4RotationMatrix.hh"
 
 #include <memory>
+#include <utility>
+#include <vector>
 
 class G4VPhysicalVolume;
 class ComptonCamera;
+class DetectorMessenger;
+class CCSensitiveDetectorMessenger;
+class LACCMessenger;
+class ComptonBiasingMessenger;
+class ParameterScan;
 
 class DetectorConstruction: public G4VUserDetectorConstruction
 {
@@ -18,8 +27,92 @@ public:
     virtual G4VPhysicalVolume* Construct() override;
     virtual void ConstructSDandField() override;
 
+    // Geometry parameters; changes take effect at the next geometry
+    // (re)initialization (see DetectorMessenger)
+    void SetCameraType(const G4String& type) { fCameraType = type; }
+    G4String GetCameraType() const { return fCameraType; }
+    void SetSc2AbDistance(G4double distance) { fSc2AbDistance = distance; }
+    G4double GetSc2AbDistance() const { return fSc2AbDistance; }
+    void SetFuelRodRatio(G4double ratio) { fFuelRodRatio = ratio; }
+    G4double GetFuelRodRatio() const { return fFuelRodRatio; }
+    // 1: single assembly; more: cask basket (see BasketPositions())
+    void SetNAssemblies(G4int nAssemblies) { fNAssemblies = nAssemblies; }
+    G4int GetNAssemblies() const { return fNAssemblies; }
+    // Homogenized assemblies (see SpentFuelAssembly)
+    void SetHomogenized(G4bool homogenized) { fHomogenized = homogenized; }
+    G4bool GetHomogenized() const { return fHomogenized; }
+    // After a change: rebuilds the geometry once initialized (before, the
+    // first Construct() uses the new value)
+    void ReinitializeGeometry() const;
+
+    // Camera views: view 0 is the camera below the source, facing up; each
+    // added view is another camera of the same type centred at the given
+    // position and facing the centre of the source. Every view has its own
+    // sensitive detector and output files.
+    void AddView(const G4ThreeVector& position) { fViewPositions.push_back(position); }
+    // What a camera added at the position would overlap (the assemblies, the
+    // basket or the camera of a view), empty if nothing. Known from the last
+    // construction; empty as well while a pending change of the camera or
+    // the assemblies makes that outdated, the construction then checks it.
+    G4String CheckView(const G4ThreeVector& position) const;
+    void ClearViews() { fViewPositions.clear(); }
+    G4int GetNViews() const { return 1 + static_cast<G4int>(fViewPositions.size()); }
+    // Sensitive detector of a view: "LACC", "LACC_view1", ...
+    static G4String GetReadoutName(G4int view);
+
+    // Output file tag (set during parameter scans) and configuration summary
+    void SetOutputTag(const G4String& tag) { fOutputTag = tag; }
+    G4String GetOutputTag() const { return fOutputTag; }
+    G4String GetConfiguration() const;
+
+    // Screening scene of the current geometry and source at the photon
+    // energy (see ScreeningScene); false if the assemblies are homogenized
+    // or the file cannot be written
+    G4bool ExportScreeningScene(const G4String& fileName, G4double energy) const;
+
 private:
-    std::shared_ptr<ComptonCamera> fCC;
+    // Cell centres of the n cells of a square basket grid nearest to its
+    // centre (24: 6x6 without 3 cells per corner, 32: 6x6 without the corners)
+    static std::vector<G4ThreeVector> BasketPositions(G4int n, G4double pitch);
+
+    std::shared_ptr<ComptonCamera> CreateCamera(const G4String& suffix) const;
+    // Rotation of an added view, camera axis (+z) towards the source
+    G4RotationMatrix GetViewRotation(const G4ThreeVector& position) const;
+    // Overlap of a camera at the position with the source, view 0 and the
+    // given added views (view, position), by their bounding boxes
+    G4String CheckViewOverlap(const G4ThreeVector& position,
+                              const std::vector<std::pair<G4int, G4ThreeVector>>& views) const;
+
+    std::vector< std::shared_ptr<ComptonCamera> > fCCs; // per view, null if not built
+
+    // Bounding boxes of the last construction: camera (any view, in its own
+    // frame) and source (assembly or basket)
+    struct Envelopes
+    {
+        G4String cameraType;
+        G4double sc2AbDistance;
+        G4int nAssemblies;
+        G4ThreeVector cameraHalfSize;
+        G4ThreeVector sourceCentre, sourceHalfSize;
+    };
+    Envelopes fEnvelopes;
+
+    G4String fCameraType;
+    G4double fSc2AbDistance; // <0: camera default
+    G4double fFuelRodRatio;
+    G4int fNAssemblies;
+    G4bool fHomogenized;
+    std::vector<G4ThreeVector> fViewPositions;
+    G4String fOutputTag;
+
+    G4VPhysicalVolume* fWorldPV;
+
+    std::unique_ptr<DetectorMessenger> fMessenger;
+    // Settings of the volumes and detectors it builds
+    std::unique_ptr<CCSensitiveDetectorMessenger> fSDMessenger;
+    std::unique_ptr<LACCMessenger> fLACCMessenger;
+    std::unique_ptr<ComptonBiasingMessenger> fBiasingMessenger;
+    std::unique_ptr<ParameterScan> fParameterScan;
 };
 
 #endif
@@ -0,0 +1,47 @@
+#ifndef DETECTORMESSENGER_HH
+#define DETECTORMESSENGER_HH
+
+#include "G4UImessenger.hh"
+
+class DetectorConstruction;
+class G4UIdirectory;
+class G4UIcommand;
+class G4UIcmdWithAString;
+class G4UIcmdWithADouble;
+class G4UIcmdWithADoubleAndUnit;
+class G4UIcmdWith3VectorAndUnit;
+class G4UIcmdWithAnInteger;
+class G4UIcmdWithABool;
+class G4UIcmdWithoutParameter;
+
+// /ccTest/ and /ccTest/det/: geometry parameters of DetectorConstruction, and
+// the assembly activities of the source (/ccTest/source/). The other
+// directories belong to the messengers of their classes.
+class DetectorMessenger: public G4UImessenger
+{
+public:
+    DetectorMessenger(DetectorConstruction* detector);
+    virtual ~DetectorMessenger() override;
+
+    virtual void SetNewValue(G4UIcommand* command, G4String newValue) override;
+
+private:
+    DetectorConstruction* fDetector;
+
+    G4UIdirectory* fCCTestDir;
+    G4UIdirectory* fDetDir;
+    G4UIcmdWithAString* fCameraCmd;
+    G4UIcmdWithADoubleAndUnit* fSc2AbDistanceCmd;
+    G4UIcmdWithADouble* fFuelRodRatioCmd;
+    G4UIcmdWithAnInteger* fNAssembliesCmd;
+    G4UIcmdWithABool* fHomogenizedCmd;
+    G4UIcmdWithAnInteger* fValidateHomogenizedCmd;
+    G4UIcommand* fExportSceneCmd;
+    G4UIcmdWith3VectorAndUnit* fAddViewCmd;
+    G4UIcmdWithoutParameter* fClearViewsCmd;
+
+    G4UIcommand* fAssemblyActivitiesCmd;
+    G4UIcommand* fAxialProfileCmd;
+};
+
+#endif
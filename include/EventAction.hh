@@ -1,11 +1,17 @@
 #ifndef EVENTACTION_HH
 #define EVENTACTION_HH
 
+#include "CCHit.hh"
+
 #include "G4UserEventAction.hh"
 #include "G4Event.hh"
 #include "globals.hh"
 
 #include <fstream>
+#include <vector>
+
+class CCInteractionBuffer;
+class CCSensitiveDetector;
 
 class EventAction: public G4UserEventAction
 {
@@ -15,9 +21,56 @@ public:
 
     virtual void EndOfEventAction(const G4Event*) override;
 
+    // Output files are shared by all threads and opened by the master
+    // RunAction. A file stays open (and is appended to) while the tag and the
+    // output directory are unchanged; a new tag starts new files
+    // output/data_<tag>.txt, ...
+    // In basis mode the source fuel rod ID follows the event ID; with the
+    // nuclide source the gamma line ID follows the particle weight; with the
+    // light model each detector block ends with the measured position/energy.
+    // Camera views other than view 0 write data_view<N>[_<tag>].txt, ...
+    // With symmetry folding, an event has one line per replica.
+    static void OpenOutput(const G4String& tag, const G4String& configuration, G4int nViews);
+    static void CloseOutput();
+    // Master, at the end of each run: the files hold every event of the run
+    static void FlushOutput();
+    // Checkpoints: flush and report the file sizes per view, or reopen the
+    // files of a checkpointed run cut back to those sizes (0: interactions
+    // not written)
+    static void GetOutputOffsets(std::vector<std::streamoff>& dataOffsets,
+                                 std::vector<std::streamoff>& interactionsOffsets);
+    static G4bool ResumeOutput(const G4String& tag, const std::vector<std::streamoff>& dataOffsets,
+                               const std::vector<std::streamoff>& interactionsOffsets);
+    // Reopen the existing files of the tag for appending, as they are on disk
+    // (files replaced while closed, see RunCache); false leaves them closed
+    static G4bool ContinueOutput(const G4String& tag, G4int nViews);
+
+    // Output files are <directory>/<name>[_<tag>]<extension>; default "output"
+    static void SetOutputDirectory(const G4String& directory) { fOutputDirectory = directory; }
+    static G4String GetOutputDirectory() { return fOutputDirectory; }
+    static G4String GetOutputFileName(const G4String& name, const G4String& tag, const G4String& extension);
+
 private:
-    G4int fCCHCID;
-    static std::ofstream ofs;
+    struct Readout
+    {
+        G4int hcID;
+        CCSensitiveDetector* sd;
+    };
+    void ResolveReadouts(G4int nViews);
+    static G4String GetViewFileName(const G4String& name, std::size_t view);
+    static void WriteEvent(std::size_t view, G4long eventID, const G4Event* anEvent, G4double eventWeight,
+                           const CCHitsMap* hitsMap, const CCInteractionBuffer* interactionBuffer);
+
+    std::vector<Readout> fReadouts; // per view
+    static std::vector<std::ofstream> ofs; // per view
+    static std::vector<std::ofstream> ofsInteractions;
+    static G4String fOutputTag;
+    static G4String fOutputDirectory;
+    static G4String fOpenDirectory; // of the open files
+    static G4bool fWriteFuelRodID;
+    static G4bool fWriteLineID;
+    static G4bool fWriteMeasurement;
+    static G4bool fWriteFolded;
 };
 
 #endif
@@ -0,0 +1,25 @@
+#ifndef EVENTINFORMATION_HH
+#define EVENTINFORMATION_HH
+
+#include "G4VUserEventInformation.hh"
+#include "globals.hh"
+
+// Source information of an event, attached by PrimaryGeneratorAction
+class EventInformation: public G4VUserEventInformation
+{
+public:
+    EventInformation(G4int fuelRodID, G4int lineID = -1);
+    virtual ~EventInformation() override;
+
+    virtual void Print() const override;
+
+    G4int GetFuelRodID() const { return fFuelRodID; }
+    // Gamma line of the nuclide source (-1: particle gun energy)
+    G4int GetLineID() const { return fLineID; }
+
+private:
+    G4int fFuelRodID;
+    G4int fLineID;
+};
+
+#endif // EVENTINFORMATION_HH
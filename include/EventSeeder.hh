@@ -0,0 +1,49 @@
+#ifndef EVENTSEEDER_HH
+#define EVENTSEEDER_HH
+
+#include "globals.hh"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+
+class EventSeederMessenger;
+
+// Per-event random streams: at the start of each event the engine of the
+// processing thread is reseeded from (seed, run ID, event ID) through the
+// Philox4x32-10 counter-based generator. An event's random numbers then
+// depend neither on the thread that processes it nor on the events before
+// it, so a run is reproducible event by event for any number of threads.
+//
+// In a campaign the run ID is 0 and the event ID campaign-wide, so a resumed
+// campaign draws the same streams. Configured on the master between runs.
+class EventSeeder
+{
+public:
+    static EventSeeder* GetInstance();
+
+    void SetEnabled(G4bool enabled) { fEnabled = enabled; }
+    G4bool IsEnabled() const { return fEnabled; }
+    void SetSeed(G4long seed) { fSeed = seed; }
+    G4long GetSeed() const { return fSeed; }
+
+    // Reseeds the engine of the calling thread
+    void SeedEvent(G4int runID, G4long eventID) const;
+    // Times n reseeds against n engine draws
+    void Benchmark(G4int n, std::ostream& out) const;
+
+    static std::array<std::uint32_t, 4> Philox(std::array<std::uint32_t, 4> counter,
+                                               std::array<std::uint32_t, 2> key);
+
+private:
+    EventSeeder();
+    ~EventSeeder();
+
+    G4bool fEnabled;
+    G4long fSeed;
+
+    std::unique_ptr<EventSeederMessenger> fMessenger;
+};
+
+#endif // EVENTSEEDER_HH
@@ -0,0 +1,30 @@
+#ifndef EVENTSEEDERMESSENGER_HH
+#define EVENTSEEDERMESSENGER_HH
+
+#include "G4UImessenger.hh"
+
+class EventSeeder;
+class G4UIdirectory;
+class G4UIcommand;
+class G4UIcmdWithAnInteger;
+class G4UIcmdWithABool;
+
+// /ccTest/random/: per-event random streams (EventSeeder)
+class EventSeederMessenger: public G4UImessenger
+{
+public:
+    EventSeederMessenger(EventSeeder* eventSeeder);
+    virtual ~EventSeederMessenger() override;
+
+    virtual void SetNewValue(G4UIcommand* command, G4String newValue) override;
+
+private:
+    EventSeeder* fEventSeeder;
+
+    G4UIdirectory* fRandomDir;
+    G4UIcmdWithABool* fEventSeedsCmd;
+    G4UIcommand* fEventSeedCmd;
+    G4UIcmdWithAnInteger* fSeedBenchmarkCmd;
+};
+
+#endif // EVENTSEEDERMESSENGER_HH
@@ -8,7 +8,11 @@
 #include "G4ThreeVector.hh"
 #include "G4UImanager.hh"
 
+#include <ostream>
+#include <vector>
+
 class G4LogicalVolume;
+class G4VSolid;
 
 class LAScintDet: public Detector
 {
@@ -17,8 +21,37 @@ public:
 
     G4LogicalVolume* GetCrystalLV() const { return fCrystalLV; }
     G4LogicalVolume* GetPMTPhotoCathodeLV() const { return fPMTPhotoCathodeLV; }
+    // Half-width of the square crystal face (without the fillets)
+    static G4double GetCrystalHalfWidth() { return fCrystalHalfWidth; }
+
+    // Filleted (octagonal) crystal, paint and glue as G4ExtrudedSolid prisms
+    // instead of intersections of a box and a 45 deg rotated box. Used by
+    // detectors constructed afterwards.
+    static void SetExtrudedSolids(G4bool extruded) { fExtrudedSolids = extruded; }
+    static G4bool GetExtrudedSolids() { return fExtrudedSolids; }
+
+    // Equivalence of the two constructions (volume, Inside() at random
+    // points) and timing of Inside()/DistanceToIn()/DistanceToOut(), for the
+    // slabs of a detector with the given crystal thickness
+    static void CompareFilletedSolids(G4int nPoints, G4double crystalThickness, std::ostream& out);
 
 private:
+    // Filleted slabs of the front housing, in construction order
+    enum { kCrystalSlab = 0, kPaintSideSlab, kPaintFrontSlab, kOpticalGlueSlab };
+    struct FilletedSlab
+    {
+        G4String name;
+        G4double halfWidth, filletHalfWidth, halfZ;
+    };
+    static std::vector<FilletedSlab> FilletedSlabs(G4double crystalThickness);
+    static G4VSolid* ConstructFilletedSlab(const G4String& name, G4double halfWidth,
+                                           G4double filletHalfWidth, G4double halfZ, G4bool extruded);
+    static G4bool fExtrudedSolids;
+    static const G4double fCrystalHalfWidth;
+    static const G4double fCrystalFilletHalfWidth;
+    static const G4double fPaintThickness;
+    static const G4double fOpticalGlueThickness;
+
     G4LogicalVolume* ConstructFrontHousing();
     G4LogicalVolume* ConstructRearHousing();
 
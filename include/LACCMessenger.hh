@@ -0,0 +1,32 @@
+#ifndef LACCMESSENGER_HH
+#define LACCMESSENGER_HH
+
+#include "G4UImessenger.hh"
+
+class DetectorConstruction;
+class G4UIdirectory;
+class G4UIcommand;
+class G4UIcmdWithABool;
+
+// /ccTest/lacc/: LACC scintillation readout (light model and tables of
+// CCSensitiveDetector) and crystal solids (LAScintDet)
+class LACCMessenger: public G4UImessenger
+{
+public:
+    LACCMessenger(DetectorConstruction* detector);
+    virtual ~LACCMessenger() override;
+
+    virtual void SetNewValue(G4UIcommand* command, G4String newValue) override;
+
+private:
+    DetectorConstruction* fDetector;
+
+    G4UIdirectory* fLACCDir;
+    G4UIcmdWithABool* fLightModelCmd;
+    G4UIcommand* fLightTableCmd;
+    G4UIcommand* fWriteLightTableCmd;
+    G4UIcmdWithABool* fExtrudedSolidsCmd;
+    G4UIcommand* fCompareSolidsCmd;
+};
+
+#endif // LACCMESSENGER_HH
@@ -0,0 +1,51 @@
+#ifndef LIGHTCOLLECTIONMODEL_HH
+#define LIGHTCOLLECTIONMODEL_HH
+
+#include "G4SystemOfUnits.hh"
+#include "G4ThreeVector.hh"
+#include "globals.hh"
+
+#include <vector>
+
+// Light-collection lookup table of an LAScintDet crystal: mean number of
+// photoelectrons per keV deposited, for each PMT of the 6x6 array, binned by
+// the interaction position in the crystal frame (PMTs on the -z side).
+//
+// The table is either read from a file produced by a detailed optical run, or
+// built analytically: direct light plus the mirror image of the front
+// reflector, each seen through the solid angle of the photocathode.
+//
+// File format (text): nx ny nz nPMT halfX(mm) halfY(mm) halfZ(mm),
+// nPMT lines "x(mm) y(mm)" of the PMT centres, then nx*ny*nz*nPMT values
+// (PMT fastest, then x, y, z).
+class LightCollectionModel
+{
+public:
+    // Analytic table for a crystal of the given half dimensions
+    LightCollectionModel(G4double crystalHalfWidth, G4double crystalHalfThickness);
+    // Table from file (check IsValid())
+    LightCollectionModel(const G4String& fileName);
+
+    G4bool IsValid() const { return !fTable.empty(); }
+    G4bool Write(const G4String& fileName) const;
+
+    G4int GetNPMTs() const { return static_cast<G4int>(fPMTX.size()); }
+    G4double GetPMTX(G4int k) const { return fPMTX[static_cast<std::size_t>(k)]; }
+    G4double GetPMTY(G4int k) const { return fPMTY[static_cast<std::size_t>(k)]; }
+
+    // GetNPMTs() values for the bin containing localPos (clamped to the table)
+    const G4float* GetResponse(const G4ThreeVector& localPos) const;
+    // Summed response at the crystal centre (photoelectrons per keV)
+    G4double GetCalibration() const { return fCalibration; }
+
+private:
+    void Calibrate();
+
+    G4int fNX, fNY, fNZ;
+    G4double fHalfX, fHalfY, fHalfZ;
+    std::vector<G4double> fPMTX, fPMTY;
+    std::vector<G4float> fTable;
+    G4double fCalibration;
+};
+
+#endif // LIGHTCOLLECTIONMODEL_HH
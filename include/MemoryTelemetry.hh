@@ -0,0 +1,70 @@
+#ifndef MEMORYTELEMETRY_HH
+#define MEMORYTELEMETRY_HH
+
+#include "G4Threading.hh"
+#include "globals.hh"
+
+#include <atomic>
+#include <cstddef>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+// Opt-in memory telemetry (ccTest -telemetry 1), to size the number of
+// threads per node:
+// - process RSS after each startup phase (marked by main()) and each run
+// - per thread and run: heap allocations and bytes per event, peak of the
+//   thread's net heap, and the G4Allocator pools of hits, tracks and
+//   dynamic particles
+// The report is printed with the run summary on the master.
+//
+// Heap counting relies on the global operator new/delete of ccTest, which
+// report here while counting is enabled. Memory freed by another thread
+// than the allocating one is attributed to the freeing thread.
+class MemoryTelemetry
+{
+public:
+    static MemoryTelemetry* GetInstance();
+
+    void SetEnabled(G4bool enabled) { fEnabled = enabled; }
+    static G4bool IsEnabled() { return fEnabled.load(std::memory_order_relaxed); }
+
+    // Allocation hooks (any thread)
+    static void CountAllocation(void* ptr);
+    static void CountDeallocation(void* ptr);
+
+    // Process resident set size, current and peak (bytes; 0 if unknown)
+    static G4double GetRSS();
+    static G4double GetPeakRSS();
+
+    // Master: process RSS at the end of a phase
+    void Mark(const G4String& phase);
+    // Threads processing events, around their event loop
+    void BeginThreadRun();
+    void EndThreadRun(G4int nEvents);
+    // Master, at the end of the run
+    void EndRun(G4int runID, std::ostream& out);
+
+private:
+    MemoryTelemetry() = default;
+
+    struct ThreadSummary
+    {
+        G4int threadID;
+        G4int nEvents;
+        G4double allocationsPerEvent;
+        G4double bytesPerEvent;
+        G4double peakHeap;      // net bytes allocated by the thread
+        G4double hitPool;       // G4Allocator pool sizes (bytes)
+        G4double trackPool;
+        G4double particlePool;
+    };
+
+    static std::atomic<G4bool> fEnabled;
+
+    G4Mutex fMutex;
+    std::vector<std::pair<G4String, G4double>> fPhases; // RSS (bytes)
+    std::vector<ThreadSummary> fThreadSummaries;        // current run
+};
+
+#endif // MEMORYTELEMETRY_HH
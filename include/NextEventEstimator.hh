@@ -0,0 +1,99 @@
+#ifndef NEXTEVENTESTIMATOR_HH
+#define NEXTEVENTESTIMATOR_HH
+
+#include "G4ThreeVector.hh"
+#include "G4SystemOfUnits.hh"
+#include "globals.hh"
+
+#include <memory>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+class G4Material;
+class G4Navigator;
+class G4Step;
+class G4VProcess;
+class NextEventEstimatorMessenger;
+class Run;
+
+// Next-event point-detector estimator of the photon flux at detector points
+// (/ccTest/nee/): at the emission of each primary photon and at each Compton
+// collision, the probability density of reaching a detector point without
+// further collision is scored deterministically:
+//   source:    w exp(-tau(E)) / (4 pi R^2)                  (isotropic source)
+//   collision: w p_KN(cos theta) exp(-tau(E')) / R^2        (E' of the angle)
+// with tau the optical depth along the ray, from the per-material
+// attenuation coefficients of the physics list (Compton, photoelectric and
+// pair production; Rayleigh scattering is taken as straight-through, and the
+// photons born in other processes score at their later collisions only).
+// R is bounded below by the exclusion radius to keep the variance finite.
+//
+// Points are given in the world frame or as an n x n grid over the front
+// face (local +z, toward the source) of the camera of a view, resolved at
+// the beginning of each run. Per point, the uncollided and scattered flux
+// per primary with their errors and the energy spectra are written to
+// output/nee[_<tag>].txt at the end of the run.
+class NextEventEstimator
+{
+public:
+    enum Component { kUncollided = 0, kScattered, kNComponents };
+
+    static NextEventEstimator* GetInstance();
+
+    void SetEnabled(G4bool enabled) { fEnabled = enabled; }
+    G4bool IsEnabled() const { return fEnabled; }
+    void AddPoint(const G4ThreeVector& point) { fFixedPoints.push_back(point); }
+    void SetFaceGrid(G4int n, G4int view) { fFaceGridN = n; fFaceGridView = view; }
+    void ClearPoints() { fFixedPoints.clear(); fFaceGridN = 0; }
+    void SetEnergyBinning(G4int nBins, G4double maxEnergy) { fNEnergyBins = nBins; fMaxEnergy = maxEnergy; }
+    void SetExclusionRadius(G4double radius) { fExclusionRadius = radius; }
+
+    // Master, at the beginning and the end of a run
+    void BeginRun();
+    void EndRun(const Run* run, const G4String& tag) const;
+    G4bool IsActive() const { return fActive; }
+    std::size_t GetNPoints() const { return fPoints.size(); }
+    G4int GetNEnergyBins() const { return fNEnergyBins; }
+
+    // Threads processing events
+    void ScoreStep(const G4Step* step);
+    void EndOfEvent();
+
+private:
+    NextEventEstimator();
+    ~NextEventEstimator();
+
+    struct ThreadState
+    {
+        G4int runID = -1;
+        Run* run = nullptr;
+        std::unique_ptr<G4Navigator> navigator;
+        std::vector<G4double> eventFlux; // per point and component
+        G4bool eventScored = false;
+        std::unordered_map<const G4Material*, std::vector<G4double>> attenuation;
+        std::unordered_map<const G4VProcess*, G4bool> compton;
+    };
+
+    ThreadState& GetThreadState();
+    void Score(ThreadState& state, const G4ThreeVector& position, const G4ThreeVector& direction,
+               G4double energy, G4double weight, Component component);
+    G4double Transmission(ThreadState& state, const G4ThreeVector& start, const G4ThreeVector& end, G4double energy) const;
+    G4double GetAttenuationCoefficient(ThreadState& state, const G4Material* material, G4double energy) const;
+
+    G4bool fEnabled;
+    G4bool fActive;
+    std::vector<G4ThreeVector> fFixedPoints;
+    G4int fFaceGridN;
+    G4int fFaceGridView;
+    G4int fNEnergyBins;
+    G4double fMaxEnergy;
+    G4double fExclusionRadius;
+    std::vector<G4ThreeVector> fPoints; // of the current run
+
+    static G4ThreadLocal ThreadState* fThreadState;
+
+    std::unique_ptr<NextEventEstimatorMessenger> fMessenger;
+};
+
+#endif // NEXTEVENTESTIMATOR_HH
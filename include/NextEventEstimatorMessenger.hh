@@ -0,0 +1,34 @@
+#ifndef NEXTEVENTESTIMATORMESSENGER_HH
+#define NEXTEVENTESTIMATORMESSENGER_HH
+
+#include "G4UImessenger.hh"
+
+class NextEventEstimator;
+class G4UIdirectory;
+class G4UIcommand;
+class G4UIcmdWithADoubleAndUnit;
+class G4UIcmdWithABool;
+class G4UIcmdWithoutParameter;
+
+// /ccTest/nee/: next-event point-detector estimator (NextEventEstimator)
+class NextEventEstimatorMessenger: public G4UImessenger
+{
+public:
+    NextEventEstimatorMessenger(NextEventEstimator* estimator);
+    virtual ~NextEventEstimatorMessenger() override;
+
+    virtual void SetNewValue(G4UIcommand* command, G4String newValue) override;
+
+private:
+    NextEventEstimator* fEstimator;
+
+    G4UIdirectory* fNEEDir;
+    G4UIcmdWithABool* fNEEEnableCmd;
+    G4UIcommand* fNEEPointCmd;
+    G4UIcommand* fNEEFaceGridCmd;
+    G4UIcmdWithoutParameter* fNEEClearCmd;
+    G4UIcommand* fNEEEnergyBinningCmd;
+    G4UIcmdWithADoubleAndUnit* fNEEExclusionRadiusCmd;
+};
+
+#endif // NEXTEVENTESTIMATORMESSENGER_HH
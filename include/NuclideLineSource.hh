@@ -0,0 +1,71 @@
+#ifndef NUCLIDELINESOURCE_HH
+#define NUCLIDELINESOURCE_HH
+
+#include "AliasTable.hh"
+
+#include "G4SystemOfUnits.hh"
+#include "globals.hh"
+
+#include <memory>
+#include <ostream>
+#include <vector>
+
+class NuclideLineSourceMessenger;
+
+// Gamma line source of the spent fuel nuclides (Cs-137, Cs-134, Eu-154).
+// Line intensities are yield x activity at discharge x decay over the cooling
+// time; the emitted line is alias-sampled. Line IDs index the full line table
+// and do not depend on the activities.
+//
+// Configured on the master between runs (see NuclideLineSourceMessenger) and
+// only read by the worker threads during a run.
+class NuclideLineSource
+{
+public:
+    struct GammaLine
+    {
+        G4String nuclide;
+        G4double energy;
+        G4double yield; // per decay
+    };
+
+    static NuclideLineSource* GetInstance();
+
+    void SetEnabled(G4bool enabled) { fEnabled = enabled; }
+    G4bool IsEnabled() const { return fEnabled; }
+
+    G4bool SetActivity(const G4String& nuclide, G4double activity);
+    void SetCoolingTime(G4double coolingTime);
+    G4double GetCoolingTime() const { return fCoolingTime; }
+
+    G4int SampleLine() const;
+    const GammaLine& GetLine(G4int lineID) const { return fLines[static_cast<std::size_t>(lineID)]; }
+    std::size_t GetNLines() const { return fLines.size(); }
+    G4double GetLineIntensity(G4int lineID) const { return fIntensities[static_cast<std::size_t>(lineID)]; }
+    G4double GetTotalIntensity() const { return fAliasTable.GetTotalWeight(); }
+
+    void Print(std::ostream& out) const;
+
+private:
+    NuclideLineSource();
+    ~NuclideLineSource();
+    void Update();
+
+    struct Nuclide
+    {
+        G4String name;
+        G4double halfLife;
+        G4double activity; // at discharge
+    };
+    std::vector<Nuclide> fNuclides;
+    std::vector<GammaLine> fLines;
+    std::vector<G4double> fIntensities; // photons per unit time
+    AliasTable fAliasTable;
+
+    G4bool fEnabled;
+    G4double fCoolingTime;
+
+    std::unique_ptr<NuclideLineSourceMessenger> fMessenger;
+};
+
+#endif // NUCLIDELINESOURCE_HH
@@ -0,0 +1,35 @@
+#ifndef NUCLIDELINESOURCEMESSENGER_HH
+#define NUCLIDELINESOURCEMESSENGER_HH
+
+#include "G4UImessenger.hh"
+
+class NuclideLineSource;
+class G4UIdirectory;
+class G4UIcommand;
+class G4UIcmdWithAString;
+class G4UIcmdWithADoubleAndUnit;
+class G4UIcmdWithoutParameter;
+
+// /ccTest/source/: source type and nuclide line table (NuclideLineSource);
+// the assembly activities of the directory are set by DetectorMessenger
+class NuclideLineSourceMessenger: public G4UImessenger
+{
+public:
+    NuclideLineSourceMessenger(NuclideLineSource* source);
+    virtual ~NuclideLineSourceMessenger() override;
+
+    virtual void SetNewValue(G4UIcommand* command, G4String newValue) override;
+
+private:
+    NuclideLineSource* fSource;
+
+    G4UIdirectory* fSourceDir;
+    G4UIcmdWithAString* fSourceTypeCmd;
+    G4UIcommand* fActivityCmd;
+    G4UIcmdWithADoubleAndUnit* fCoolingTimeCmd;
+    G4UIcmdWithoutParameter* fListLinesCmd;
+    G4UIcommand* fAssemblyActivitiesCmd;
+    G4UIcommand* fAxialProfileCmd;
+};
+
+#endif // NUCLIDELINESOURCEMESSENGER_HH
@@ -0,0 +1,30 @@
+#ifndef PARAMETERSCAN_HH
+#define PARAMETERSCAN_HH
+
+#include "globals.hh"
+
+#include <memory>
+
+class DetectorConstruction;
+class ParameterScanMessenger;
+
+// In-process parameter scan (/ccTest/scan/run): for each value, the geometry
+// parameter is set with its /ccTest/det/ command (geometry rebuilt only) and
+// nEvents are run under the output tag <parameter>_<value>[unit]; the wall
+// time of each point is summarized at the end. The output tag is restored.
+// Owned by DetectorConstruction; master only.
+class ParameterScan
+{
+public:
+    ParameterScan(DetectorConstruction* detector);
+    ~ParameterScan();
+
+    // values: separated by spaces; a trailing unit for sc2abDistance
+    void Scan(const G4String& parameterName, G4int nEvents, const G4String& values);
+
+private:
+    DetectorConstruction* fDetector;
+    std::unique_ptr<ParameterScanMessenger> fMessenger;
+};
+
+#endif // PARAMETERSCAN_HH
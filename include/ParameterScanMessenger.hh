@@ -0,0 +1,26 @@
+#ifndef PARAMETERSCANMESSENGER_HH
+#define PARAMETERSCANMESSENGER_HH
+
+#include "G4UImessenger.hh"
+
+class ParameterScan;
+class G4UIdirectory;
+class G4UIcommand;
+
+// /ccTest/scan/: in-process parameter scans (ParameterScan)
+class ParameterScanMessenger: public G4UImessenger
+{
+public:
+    ParameterScanMessenger(ParameterScan* scan);
+    virtual ~ParameterScanMessenger() override;
+
+    virtual void SetNewValue(G4UIcommand* command, G4String newValue) override;
+
+private:
+    ParameterScan* fScan;
+
+    G4UIdirectory* fScanDir;
+    G4UIcommand* fScanCmd;
+};
+
+#endif // PARAMETERSCANMESSENGER_HH
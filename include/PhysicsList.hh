@@ -3,10 +3,13 @@
 
 #include "G4VModularPhysicsList.hh"
 
+// Decay, EM, radioactive decay and QGSP_BIC hadron physics; the lean variant
+// registers standard EM physics only, which is all the gamma sources below the
+// photonuclear thresholds need and keeps the startup short.
 class PhysicsList: public G4VModularPhysicsList
 {
 public:
-    PhysicsList();
+    explicit PhysicsList(G4bool lean = false);
     virtual ~PhysicsList() override;
 
     virtual void SetCuts() override;
@@ -0,0 +1,75 @@
+#ifndef PILEUPSTREAM_HH
+#define PILEUPSTREAM_HH
+
+#include "CCHit.hh"
+
+#include "G4SystemOfUnits.hh"
+#include "globals.hh"
+
+#include <cstdint>
+#include <vector>
+
+class SinglesWriter;
+
+// Pile-up mode: events are no longer isolated but arrive as a Poisson process
+// with the given activity (rate of simulated primaries). A run of N events
+// covers the time window N/activity after the previous run, and each event
+// arrives uniformly within it: N uniform arrivals in the window are the
+// Poisson process with N arrivals, however the events are shared between
+// the threads. The arrival is drawn from the engine of the event, so it is
+// reproducible with event seeds.
+//
+// Each thread writes the time-stamped singles of its events (arrival time +
+// hit time) to output/singles[_<tag>]_t<thread>.bin (see SinglesStream),
+// keeping the singles of a run in memory and writing them sorted in time at
+// the end of the run (40 B per single; a campaign bounds this by its segment
+// size). tools/sortCoincidences merges the streams into coincidences with a
+// coincidence window and dead time.
+//
+// Runs with the same tag and output directory continue the streams: the
+// files are appended to and the time goes on. Another tag, another directory
+// or a run without pile-up starts over at time 0 with new files. Campaign
+// checkpoints carry the stream time and the file sizes.
+//
+// Singles carry the measured energy and position when the light model is on.
+class PileUpStream
+{
+public:
+    // 0 disables; shared by all threads, takes effect at the next run
+    static void SetActivity(G4double activity) { fActivity = activity; }
+    static G4double GetActivity() { return fActivity; }
+    static G4bool IsEnabled() { return fActivity>0.; }
+
+    // Master, before the threads start a run of nEvents, and for a run
+    // restored by RunCache: places the run window in the stream
+    static void BeginMasterRun(const G4String& tag, G4long nEvents);
+    // Master, for checkpoints: the stream time after the last run and the
+    // file size per thread (empty without pile-up), or resume the streams
+    // of a checkpoint, cutting the files back to those sizes
+    static void GetStreamState(G4double& time, std::vector<std::uintmax_t>& fileSizes);
+    static G4bool ResumeStreams(const G4String& tag, G4double time, const std::vector<std::uintmax_t>& fileSizes);
+
+    // Per thread: BeginRun/EndRun from the RunAction of the thread processing
+    // the events, AddEvent from its EventAction (also for events without hits)
+    static void BeginRun(const G4String& tag);
+    static void EndRun();
+    static void AddEvent(G4long eventID, const CCHitsMap* hitsMap);
+
+private:
+    static G4String GetFileName(const G4String& tag, G4int threadID);
+
+    static G4double fActivity;
+    // Stream state, set by the master before the threads start
+    static G4bool fStreaming;
+    static G4String fStreamTag;
+    static G4String fStreamDirectory;
+    static G4int fNStreams;
+    static G4bool fAppend;      // the run continues the files
+    static G4double fRunStart;  // window of the current run
+    static G4double fRunWindow;
+    static G4double fStreamTime; // end of the window of the last run
+
+    static G4ThreadLocal SinglesWriter* fWriter;
+};
+
+#endif // PILEUPSTREAM_HH
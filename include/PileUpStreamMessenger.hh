@@ -0,0 +1,23 @@
+#ifndef PILEUPSTREAMMESSENGER_HH
+#define PILEUPSTREAMMESSENGER_HH
+
+#include "G4UImessenger.hh"
+
+class G4UIdirectory;
+class G4UIcommand;
+
+// /ccTest/pileup/: activity of the pile-up mode (PileUpStream)
+class PileUpStreamMessenger: public G4UImessenger
+{
+public:
+    PileUpStreamMessenger();
+    virtual ~PileUpStreamMessenger() override;
+
+    virtual void SetNewValue(G4UIcommand* command, G4String newValue) override;
+
+private:
+    G4UIdirectory* fPileUpDir;
+    G4UIcommand* fPileUpActivityCmd;
+};
+
+#endif // PILEUPSTREAMMESSENGER_HH
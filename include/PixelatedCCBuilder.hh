@@ -0,0 +1,53 @@
+#ifndef PIXELATEDCCBUILDER_HH
+#define PIXELATEDCCBUILDER_HH
+
+#include "CCBuilder.hh"
+
+#include "G4VTouchable.hh"
+
+class G4LogicalVolume;
+
+class PixelatedDetector: public Detector
+{
+public:
+    PixelatedDetector(G4int nPixelX, G4int nPixelY,
+                      G4double pixelPitch, G4double pixelThickness, G4double reflectorThickness);
+
+    G4LogicalVolume* GetPixelLV() const { return fPixelLV; }
+    G4int GetNPixelX() const { return fNPixelX; }
+    G4int GetNPixelY() const { return fNPixelY; }
+
+private:
+    G4int fNPixelX, fNPixelY;
+
+    G4LogicalVolume* fPixelLV;
+};
+
+class PixelatedCC: public SimpleScAbCC
+{
+public:
+    PixelatedCC(G4String name,
+                G4double sc2abDistance = 5.*cm,
+                G4int nPixelX = 32,
+                G4int nPixelY = 32,
+                G4double pixelPitch = 3.2*mm,
+                G4double scThk = 5.*mm,
+                G4double abThk = 10.*mm);
+
+    // Detector ID: module (0: scatter, 1: absorber) | pixel row | pixel column
+    static G4int EncodeDetectorID(G4int module, G4int ix, G4int iy) { return (module<<16) | (iy<<8) | ix; }
+    static G4int GetModule(G4int detID) { return detID>>16; }
+    static G4int GetPixelX(G4int detID) { return detID & 0xFF; }
+    static G4int GetPixelY(G4int detID) { return (detID>>8) & 0xFF; }
+
+    // Touchable depths inside the camera: 0 pixel crystal, 1 column replica,
+    // 2 row replica, 3 module placement
+    static G4int GetDetectorID(const G4VTouchable* touchable)
+    {
+        return EncodeDetectorID(touchable->GetReplicaNumber(3),
+                                touchable->GetReplicaNumber(1),
+                                touchable->GetReplicaNumber(2));
+    }
+};
+
+#endif // PIXELATEDCCBUILDER_HH
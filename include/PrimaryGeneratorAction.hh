@@ -9,8 +9,6 @@
 #include "G4ParticleGun.hh"
 #include "G4PhysicalVolumeStore.hh"
 
-class SpentFuelAssembly;
-
 class PrimaryGeneratorAction: public G4VUserPrimaryGeneratorAction
 {
 public:
@@ -21,8 +19,6 @@ public:
 
 private:
     std::unique_ptr<G4ParticleGun> fPrimary;
-
-    std::shared_ptr<SpentFuelAssembly> fSpentFuelAssembly;
 };
 
 #endif
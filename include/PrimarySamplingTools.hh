@@ -7,10 +7,10 @@
 #include "G4LogicalVolume.hh"
 #include "G4PhysicalVolumeStore.hh"
 
-G4ThreeVector SampleDirectionFromTo(const G4ThreeVector& referencePoint,
-                                    const G4String& physicalVolumeName,
-                                    G4double& particleWeight,
-                                    G4double margin = 0.)
+inline G4ThreeVector SampleDirectionFromTo(const G4ThreeVector& referencePoint,
+                                           const G4String& physicalVolumeName,
+                                           G4double& particleWeight,
+                                           G4double margin = 0.)
 {
     // No physical volume setting
     if(!physicalVolumeName.size()) return G4RandomDirection();
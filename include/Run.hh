@@ -0,0 +1,102 @@
+#ifndef RUN_HH
+#define RUN_HH
+
+#include "G4Run.hh"
+#include "G4Event.hh"
+#include "G4SystemOfUnits.hh"
+#include "CCHit.hh"
+#include "RunTarget.hh"
+#include "StackingAction.hh"
+
+#include <array>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+class BasisLibrary;
+class CCSensitiveDetector;
+class EventInformation;
+
+class Run: public G4Run
+{
+public:
+    Run();
+    virtual ~Run() override;
+
+    virtual void RecordEvent(const G4Event*) override;
+    virtual void Merge(const G4Run*) override;
+
+    const BasisLibrary* GetBasisLibrary() const { return fBasisLibrary.get(); }
+
+    // Weighted coincidence count (per started primary: divide by the number
+    // of events) and its relative statistical error
+    G4double GetCoincidenceWeight() const { return fTallies.weight[RunTarget::kCoincidences]; }
+    G4long GetNCoincidences() const { return fNCoincidences; }
+    G4double GetCoincidenceRelativeError() const;
+    // Merged tallies of the run target (see RunTarget)
+    const RunTarget::Sums& GetTallies() const { return fTallies; }
+    // 64-bit event count (G4Run::numberOfEvent is an int)
+    G4long GetNEvents() const { return fTallies.nEvents; }
+
+    // Secondaries killed by the stacking rules (see StackingAction)
+    void AddKilledTrack(G4int rule, G4double kineticEnergy)
+    { ++fNKilledTracks[rule]; fKilledEnergy[rule] += kineticEnergy; }
+    void PrintKilledTracks(std::ostream& out) const;
+
+    // Photon leakage of the assemblies, sums of the per-event weights and of
+    // their squares by bin (see LeakageDetector)
+    void AddLeakage(G4int bin, G4double weight);
+    const std::vector<G4double>& GetLeakage() const { return fLeakage; }
+    const std::vector<G4double>& GetLeakage2() const { return fLeakage2; }
+
+    // Next-event estimator: sums of the per-event flux and of its square by
+    // point and component, and spectra (see NextEventEstimator)
+    void AddNextEventFlux(std::size_t index, G4double flux);
+    void AddNextEventSpectrum(std::size_t index, G4double flux);
+    const std::vector<G4double>& GetNextEventFlux() const { return fNextEventFlux; }
+    const std::vector<G4double>& GetNextEventFlux2() const { return fNextEventFlux2; }
+    const std::vector<G4double>& GetNextEventSpectra() const { return fNextEventSpectra; }
+
+    // Accumulator state for checkpoints (see Campaign): tallies, basis library,
+    // killed tracks, leakage and next-event sums
+    G4bool Write(std::ostream& out) const;
+    G4bool Read(std::istream& in);
+
+    // Basis mode: primaries are started uniformly in all fuel rods regardless
+    // of the rod status, and each run accumulates the per-rod responses into a
+    // BasisLibrary. Shared by all threads; takes effect at the next run.
+    static void SetBasisMode(G4bool basisMode) { fBasisMode = basisMode; }
+    static G4bool GetBasisMode() { return fBasisMode; }
+    static void SetBasisEnergyBinning(G4int nBins, G4double maxEnergy)
+    { fBasisNEnergyBins = nBins; fBasisMaxEnergy = maxEnergy; }
+    static void SetBasisImageBinning(G4int nBins, G4double halfWidth)
+    { fBasisNImageBins = nBins; fBasisImageHalfWidth = halfWidth; }
+
+private:
+    G4int fCCHCID;
+    CCSensitiveDetector* fCCSD;
+    std::unique_ptr<BasisLibrary> fBasisLibrary;
+
+    void ReportToTarget();
+    // Hits of view 0 (one replica under symmetry folding): weights added to
+    // the run target tallies of the event
+    void RecordHits(const CCHitsMap* hitsMap, G4double weight, const EventInformation* eventInformation,
+                    std::array<G4double, RunTarget::kNTallies>& eventWeights);
+
+    RunTarget::Sums fTallies;
+    RunTarget::Sums fPendingTallies; // not yet reported to the run target
+    G4long fNCoincidences;
+    G4bool fAborted;
+    std::array<G4long, StackingAction::kNRules> fNKilledTracks;
+    std::array<G4double, StackingAction::kNRules> fKilledEnergy;
+    std::vector<G4double> fLeakage, fLeakage2;
+    std::vector<G4double> fNextEventFlux, fNextEventFlux2, fNextEventSpectra;
+
+    static G4bool fBasisMode;
+    static G4int fBasisNEnergyBins;
+    static G4double fBasisMaxEnergy;
+    static G4int fBasisNImageBins;
+    static G4double fBasisImageHalfWidth;
+};
+
+#endif // RUN_HH
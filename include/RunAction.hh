@@ -5,13 +5,23 @@
 #include "G4Run.hh"
 #include "G4RunManager.hh"
 
+#include <chrono>
+
 class RunAction: public G4UserRunAction
 {
 public:
     RunAction();
     virtual ~RunAction() override;
 
+    virtual G4Run* GenerateRun() override;
     virtual void BeginOfRunAction(const G4Run*) override;
+    virtual void EndOfRunAction(const G4Run*) override;
+
+private:
+    void PrintFigureOfMerit(const G4Run* aRun) const;
+
+    std::chrono::steady_clock::time_point fStartTime;
+    static G4double fAnalogFigureOfMerit; // last analog run, 0 if none
 };
 
 #endif
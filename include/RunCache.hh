@@ -0,0 +1,88 @@
+#ifndef RUNCACHE_HH
+#define RUNCACHE_HH
+
+#include "globals.hh"
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <utility>
+
+class Run;
+class RunCacheMessenger;
+
+// Content-addressed cache of completed runs (/ccTest/cache/). Before a run
+// the effective configuration is hashed (SHA-256):
+// - code: the executable file and the Geant4 version
+// - physics list (and biasing), number of threads
+// - every UI command applied so far, except vis, control, verbosity and
+//   cache commands, with the contents of the files the commands name
+// - geometry configuration and output tag
+// - run ID, number of events, state of the master random engine, event seeds
+// If <directory>/<hash>/ holds the run complete (manifest, every listed file
+// and a valid engine state), its output files are copied next to the outputs
+// and renamed over them, and the run is skipped: the run ID and the engine
+// state advance as if it had run, and the data files are reopened for
+// appending as after a run. An incomplete entry is a miss that leaves the
+// output directory untouched. Otherwise the files the run creates or changes
+// in the output directory (whole files, as they are after the run) are
+// stored under the hash: copied into a temporary directory, then renamed
+// into place, so an entry is complete or absent.
+// Beyond the size limit, the least recently used entries are evicted.
+//
+// The key errs on the side of a miss: any earlier command, even one without
+// effect on the run, changes it. State outside the UI history is not hashed,
+// so campaigns, system matrix sweeps, run targets and the leakage validation
+// always run. Master only.
+class RunCache
+{
+public:
+    static RunCache* GetInstance();
+
+    // Empty: disabled
+    void SetDirectory(const G4String& directory) { fDirectory = directory; }
+    void SetMaxSize(std::uintmax_t bytes) { fMaxSize = bytes; }
+    // From main(): physics list name and options
+    void SetPhysics(const G4String& physics) { fPhysics = physics; }
+    G4bool IsEnabled() const { return !fDirectory.empty(); }
+
+    // Before a run of nEvents with the given ID: restores it and returns true
+    // on a hit; on a miss, prepares the entry for Store()
+    G4bool Lookup(G4int runID, G4int nEvents);
+    // After the run of the last missed Lookup()
+    void Store(const Run* run);
+    // Of the last run looked up or stored
+    G4long GetLastNEvents() const { return fLastNEvents; }
+    G4long GetLastNCoincidences() const { return fLastNCoincidences; }
+
+    void Report(std::ostream& out) const;
+
+private:
+    RunCache();
+    ~RunCache();
+    G4String Configuration(G4int runID, G4int nEvents) const;
+    std::map<G4String, std::pair<std::uintmax_t, std::int64_t>> ScanOutputs() const;
+    void Evict(const G4String& keep);
+
+    G4String fDirectory;
+    std::uintmax_t fMaxSize;
+    G4String fPhysics;
+
+    // Pending entry (miss)
+    G4String fKey;
+    G4String fConfiguration;
+    std::map<G4String, std::pair<std::uintmax_t, std::int64_t>> fOutputsBefore; // size, mtime
+    std::chrono::steady_clock::time_point fStartTime;
+
+    G4long fLastNEvents;
+    G4long fLastNCoincidences;
+
+    G4int fNHits, fNMisses, fNStored, fNEvicted;
+    G4double fSavedSeconds;
+
+    std::unique_ptr<RunCacheMessenger> fMessenger;
+};
+
+#endif // RUNCACHE_HH
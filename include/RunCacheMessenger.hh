@@ -0,0 +1,30 @@
+#ifndef RUNCACHEMESSENGER_HH
+#define RUNCACHEMESSENGER_HH
+
+#include "G4UImessenger.hh"
+
+class RunCache;
+class G4UIdirectory;
+class G4UIcommand;
+class G4UIcmdWithAString;
+class G4UIcmdWithoutParameter;
+
+// /ccTest/cache/: run cache settings (RunCache)
+class RunCacheMessenger: public G4UImessenger
+{
+public:
+    RunCacheMessenger(RunCache* runCache);
+    virtual ~RunCacheMessenger() override;
+
+    virtual void SetNewValue(G4UIcommand* command, G4String newValue) override;
+
+private:
+    RunCache* fRunCache;
+
+    G4UIdirectory* fCacheDir;
+    G4UIcmdWithAString* fCacheDirectoryCmd;
+    G4UIcommand* fCacheMaxSizeCmd;
+    G4UIcmdWithoutParameter* fCacheReportCmd;
+};
+
+#endif // RUNCACHEMESSENGER_HH
@@ -0,0 +1,26 @@
+#ifndef RUNMESSENGER_HH
+#define RUNMESSENGER_HH
+
+#include "G4UImessenger.hh"
+
+class G4UIdirectory;
+class G4UIcommand;
+class G4UIcmdWithABool;
+
+// /ccTest/basis/: per-rod response basis of the Run (all threads, next run)
+class RunMessenger: public G4UImessenger
+{
+public:
+    RunMessenger();
+    virtual ~RunMessenger() override;
+
+    virtual void SetNewValue(G4UIcommand* command, G4String newValue) override;
+
+private:
+    G4UIdirectory* fBasisDir;
+    G4UIcmdWithABool* fBasisModeCmd;
+    G4UIcommand* fBasisEnergyBinningCmd;
+    G4UIcommand* fBasisImageBinningCmd;
+};
+
+#endif // RUNMESSENGER_HH
@@ -0,0 +1,97 @@
+#ifndef RUNTARGET_HH
+#define RUNTARGET_HH
+
+#include "G4Threading.hh"
+#include "globals.hh"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <ostream>
+
+class RunTargetMessenger;
+
+// Precision-targeted run termination: /run/beamOn gives the maximum number
+// of events, and the run ends as soon as every active tally reaches the
+// target relative error, or the wall-time budget is spent.
+//
+// Each thread reports its partial sums every check interval. A report never
+// waits: if another thread holds the totals, the sums are kept for the next
+// interval. Once the target is met, every thread ends its event loop with a
+// soft abort, so events in flight are completed and merged as usual.
+//
+// Tallies (weighted, per started primary):
+// - coincidences: events with >=2 hit detectors
+// - energy window: coincidences with summed deposit in [eMin, eMax]
+// - image region: coincidences with the scatter hit (max z) in [x1,x2]x[y1,y2]
+//
+// Configured on the master between runs (see RunTargetMessenger).
+class RunTarget
+{
+public:
+    enum Tally { kCoincidences, kEnergyWindow, kImageRegion, kNTallies };
+
+    struct Sums
+    {
+        G4long nEvents = 0;
+        G4double weight[kNTallies] = {};
+        G4double weight2[kNTallies] = {};
+
+        void Add(Tally tally, G4double w) { weight[tally] += w; weight2[tally] += w*w; }
+        void Merge(const Sums& other);
+    };
+
+    static RunTarget* GetInstance();
+
+    // 0 disables the precision target
+    void SetRelativeError(G4double relativeError) { fRelativeError = relativeError; }
+    // eMax<=eMin disables the energy window tally
+    void SetEnergyWindow(G4double eMin, G4double eMax) { fEMin = eMin; fEMax = eMax; }
+    // x2<=x1 or y2<=y1 disables the image region tally
+    void SetImageRegion(G4double x1, G4double x2, G4double y1, G4double y2)
+    { fX1 = x1; fX2 = x2; fY1 = y1; fY2 = y2; }
+    // 0 disables the wall-time budget
+    void SetWallTime(G4double wallTime) { fWallTime = wallTime; }
+    void SetMinEvents(G4long nEvents) { fMinEvents = nEvents; }
+    void SetCheckInterval(G4int nEvents) { fCheckInterval = nEvents; }
+
+    G4bool IsActive() const { return fRelativeError>0. || fWallTime>0.; }
+    G4bool IsTallyActive(Tally tally) const;
+    G4int GetCheckInterval() const { return fCheckInterval; }
+    G4bool InEnergyWindow(G4double eSum) const { return eSum>=fEMin && eSum<=fEMax; }
+    G4bool InImageRegion(G4double x, G4double y) const { return x>=fX1 && x<=fX2 && y>=fY1 && y<=fY2; }
+
+    // Master, at the beginning of each run
+    void BeginRun();
+    // Adds the sums to the run totals and resets them, unless another thread
+    // is reporting; returns true once the run should end
+    G4bool Report(Sums& sums);
+    G4bool StopRequested() const { return fStop.load(std::memory_order_relaxed); }
+    // Master, at the end of the run, with the merged tallies
+    void Print(std::ostream& out, const Sums& tallies) const;
+
+    // Relative error of a mean over nEvents from the sums of w and w^2
+    static G4double RelativeError(G4long nEvents, G4double weight, G4double weight2);
+
+private:
+    RunTarget();
+    ~RunTarget();
+    G4bool TargetReached() const;
+
+    G4double fRelativeError;
+    G4double fEMin, fEMax;
+    G4double fX1, fX2, fY1, fY2;
+    G4double fWallTime;
+    G4long fMinEvents;
+    G4int fCheckInterval;
+
+    G4Mutex fMutex;
+    Sums fTotals;
+    std::chrono::steady_clock::time_point fStartTime;
+    std::atomic<G4bool> fStop;
+    G4String fStopReason;
+
+    std::unique_ptr<RunTargetMessenger> fMessenger;
+};
+
+#endif // RUNTARGET_HH
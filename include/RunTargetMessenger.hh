@@ -0,0 +1,34 @@
+#ifndef RUNTARGETMESSENGER_HH
+#define RUNTARGETMESSENGER_HH
+
+#include "G4UImessenger.hh"
+
+class RunTarget;
+class G4UIdirectory;
+class G4UIcommand;
+class G4UIcmdWithADouble;
+class G4UIcmdWithADoubleAndUnit;
+class G4UIcmdWithAnInteger;
+
+// /ccTest/target/: precision-targeted runs (RunTarget)
+class RunTargetMessenger: public G4UImessenger
+{
+public:
+    RunTargetMessenger(RunTarget* runTarget);
+    virtual ~RunTargetMessenger() override;
+
+    virtual void SetNewValue(G4UIcommand* command, G4String newValue) override;
+
+private:
+    RunTarget* fRunTarget;
+
+    G4UIdirectory* fTargetDir;
+    G4UIcmdWithADouble* fTargetErrorCmd;
+    G4UIcommand* fTargetEnergyWindowCmd;
+    G4UIcommand* fTargetImageRegionCmd;
+    G4UIcmdWithADoubleAndUnit* fTargetWallTimeCmd;
+    G4UIcmdWithAnInteger* fTargetMinEventsCmd;
+    G4UIcmdWithAnInteger* fTargetCheckIntervalCmd;
+};
+
+#endif // RUNTARGETMESSENGER_HH
@@ -0,0 +1,71 @@
+#ifndef SCREENINGSCENE_HH
+#define SCREENINGSCENE_HH
+
+#include <array>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Geometry, attenuation and source of the spent fuel assemblies and the
+// cameras at one photon energy, for deterministic screening of camera
+// placements and diversion patterns (tools/screenPlacements). Written from
+// the current geometry with /ccTest/det/exportScene, read by the tool.
+//
+// The rods are coaxial cylinders of the assembly height (pellet, gap and
+// cladding), on the lattice of their assembly; the space between them is
+// of the surrounding material, and everything outside the assemblies of the
+// world material. Rod IDs are global, rod + nx*ny*assembly, as in the app.
+//
+// Plain C++ (no Geant4 types), so the tool can use it standalone.
+// Units: keV, mm, attenuation coefficients in 1/mm.
+class ScreeningScene
+{
+public:
+    using Vector = std::array<double, 3>;
+
+    struct Rod
+    {
+        double pelletRadius = 0., gapRadius = 0., claddingRadius = 0.;
+        double halfHeight = 0.;
+        double muPellet = 0., muGap = 0., muCladding = 0.;
+    };
+    struct Assembly
+    {
+        int nx = 0, ny = 0;
+        double interval = 0.;
+        Vector halfSize = {};                  // envelope box
+        std::array<Vector, 3> axes = {};       // local x, y, z in the world
+        Vector translation = {};
+        double activity = 1.;                  // relative, per active rod
+        std::vector<int> activeRods;           // local rod IDs
+    };
+    struct Camera
+    {
+        Vector centre = {};
+        std::array<Vector, 3> axes = {};       // local +z toward the source
+        Vector halfSize = {};
+    };
+
+    double energy = 0.;
+    double muSurrounding = 0.;
+    double muWorld = 0.;
+    Rod rod;
+    std::vector<Assembly> assemblies;
+    std::vector<double> axialProfile;          // equal-height bins, bottom to top; empty: uniform
+    std::vector<Camera> cameras;               // per view
+
+    int GetNRodsPerAssembly() const { return assemblies.empty() ? 0 : assemblies.front().nx*assemblies.front().ny; }
+    int GetNRods() const { return GetNRodsPerAssembly()*static_cast<int>(assemblies.size()); }
+    // Rod centre in the assembly frame
+    Vector GetRodLocation(const Assembly& assembly, int rodID) const;
+    // Relative activity of every rod (0 for the inactive ones)
+    std::vector<double> GetRodActivities() const;
+    Vector GetSourceCentre() const;
+
+    bool Write(const std::string& fileName) const;
+    bool Read(const std::string& fileName);
+    bool Write(std::ostream& out) const;
+    bool Read(std::istream& in);
+};
+
+#endif // SCREENINGSCENE_HH
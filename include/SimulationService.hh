@@ -0,0 +1,93 @@
+#ifndef SIMULATIONSERVICE_HH
+#define SIMULATIONSERVICE_HH
+
+#include "G4Threading.hh"
+#include "globals.hh"
+
+#include <atomic>
+#include <functional>
+#include <istream>
+#include <string>
+#include <vector>
+
+// Long-lived service (ccTest -serve <endpoint>): geometry and physics are
+// initialized once, then run requests are executed back to back on the same
+// run manager. The endpoint is an existing directory, used as a spool
+// (<name>.req files, processed in name order; write a request under another
+// name and rename it to .req), or else the path of a UNIX socket to create
+// (one connection per request, served in arrival order; client: ccClient).
+//
+// Request, one "key value" per line:
+//   macro <file>          macro executed before the run (repeatable)
+//   command <command>     UI command applied before the run (repeatable)
+//   events <N>            events to run (64-bit, > INT_MAX: campaign; 0: none)
+//   seed <S>              master seed, also of /ccTest/random/eventSeeds
+//                         (default: the engine continues)
+//   output <directory>    output directory (default: the one of the service)
+//   end                   end of the request (or end of file)
+// or the single line "shutdown", which stops the service.
+//
+// Status lines are streamed back on the socket, or appended to <name>.status
+// next to a spool request, which is renamed <name>.running, then
+// <name>.done or <name>.failed:
+//   accepted
+//   progress <events done> <N>
+//   done events=<n> coincidences=<n> seconds=<s>
+//   error <message>
+//
+// Each request starts from the baseline of the service, the state after the
+// startup macro: after a request has applied commands or run, the macro is
+// executed again before the next one. Settings that the macro does not make
+// are not reset, so a service macro should set everything its requests
+// change (e.g. /ccTest/det/clearViews before adding the views).
+class SimulationService
+{
+public:
+    struct Request
+    {
+        std::vector<G4String> commands; // macros as /control/execute
+        G4long nEvents = 0;
+        G4long seed = -1;
+        G4String outputDirectory;
+        G4bool shutdown = false;
+    };
+
+    static SimulationService* GetInstance();
+
+    // Master, after the startup macro (empty: none): blocks until a shutdown
+    // request; false if the endpoint cannot be used
+    G4bool Serve(const G4String& endpoint, const G4String& baselineMacro);
+
+    // Threads processing events
+    void EventDone()
+    {
+        if(!fRunning.load(std::memory_order_relaxed)) return;
+        auto nEventsDone = ++fNEventsDone;
+        if(nEventsDone%fProgressInterval==0) ReportProgress(nEventsDone);
+    }
+
+    // False (with the reason) on an unknown key or invalid value
+    static G4bool ParseRequest(std::istream& in, Request& request, G4String& error);
+
+private:
+    SimulationService();
+
+    G4bool ServeSocket(const G4String& path);
+    G4bool ServeSpool(const G4String& directory);
+    // Runs a request, streaming its status; false on error
+    G4bool Execute(const Request& request);
+    void ReportProgress(G4long nEventsDone);
+    void Status(const std::string& line);
+
+    G4Mutex fMutex;
+    std::function<void(const std::string&)> fStatusSink; // current request
+    G4String fDefaultOutputDirectory;
+    G4String fBaselineMacro;
+    G4bool fBaselineChanged; // by the last request
+    std::atomic<G4bool> fRunning;
+    std::atomic<G4long> fNEventsDone;
+    G4long fNEvents;
+    G4long fProgressInterval;
+};
+
+#endif // SIMULATIONSERVICE_HH
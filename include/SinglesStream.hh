@@ -0,0 +1,64 @@
+#ifndef SINGLESSTREAM_HH
+#define SINGLESSTREAM_HH
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Time-stamped detector singles of the pile-up mode and their binary stream
+// files (one per thread, each in time order). Plain C++ (no Geant4 types), so
+// the sorting tool can use it standalone. Units: ns, keV, mm.
+//
+// File layout (native endianness): "CCS1", then 40 B records:
+//   float64 time, int64 evtID, int32 detID, float32 e, x, y, z, weight
+struct Single
+{
+    double time = 0.;
+    std::int64_t eventID = 0;
+    std::int32_t detID = 0;
+    float energy = 0.f;
+    float x = 0.f, y = 0.f, z = 0.f;
+    float weight = 1.f;
+};
+
+// Writes singles added in per-event batches. Singles of one event come after
+// its arrival time, so everything up to the arrival time of a new event is
+// final; later singles wait in a small buffer to keep the file in time order.
+// Without BeginEvent() calls, everything waits and is written sorted by
+// Close(). Appending continues an existing file (or starts an empty one).
+class SinglesWriter
+{
+public:
+    explicit SinglesWriter(const std::string& fileName, bool append = false);
+    ~SinglesWriter();
+
+    bool IsOpen() const { return fOut.is_open(); }
+    void BeginEvent(double arrivalTime);
+    void Add(const Single& single) { fPending.push_back(single); }
+    void Close();
+    std::uint64_t GetNWritten() const { return fNWritten; }
+
+private:
+    void Flush(double upToTime);
+
+    std::ofstream fOut;
+    std::vector<Single> fPending;
+    std::uint64_t fNWritten;
+};
+
+class SinglesReader
+{
+public:
+    explicit SinglesReader(const std::string& fileName);
+
+    bool IsValid() const { return fValid; }
+    // False at the end of the file
+    bool Next(Single& single);
+
+private:
+    std::ifstream fIn;
+    bool fValid;
+};
+
+#endif // SINGLESSTREAM_HH
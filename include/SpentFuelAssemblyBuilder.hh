@@ -1,11 +1,17 @@
 #ifndef SPENTFUELASSEMBLYBUILDER_HH
 #define SPENTFUELASSEMBLYBUILDER_HH
 
+#include "AliasTable.hh"
+
 #include "G4NistManager.hh"
+#include "G4RotationMatrix.hh"
 #include "G4SystemOfUnits.hh"
 #include "G4ThreeVector.hh"
 #include "G4UImanager.hh"
 
+#include <utility>
+#include <vector>
+
 class G4LogicalVolume;
 class G4VPhysicalVolume;
 class SpentFuelAssemblyParameterisation;
@@ -16,16 +22,27 @@ public:
     FuelRod();
 
     G4LogicalVolume* GetLogicalVolume() const { return fCladdingLV; }
+    // Cladding, gap and pellet
+    std::vector<G4LogicalVolume*> GetLogicalVolumes() const { return {fCladdingLV, fHeGapLV, fFuelPelletLV}; }
+    // Material and cross-section area of each layer (pellet, gap, cladding)
+    std::vector<std::pair<G4Material*, G4double>> GetCrossSections() const;
     G4ThreeVector SampleRandomPointInFuelRod() const;
+    // zFraction in [0,1): axial position from the bottom of the fuel
+    G4ThreeVector SampleRandomPointInFuelRod(G4double zFraction) const;
 
 private:
     void DefineMaterials();
     static G4bool fDefineMaterialsFlag;
 
     G4LogicalVolume* fCladdingLV;
+    G4LogicalVolume* fHeGapLV;
     G4LogicalVolume* fFuelPelletLV;
 };
 
+// Homogenized: a single box of the mixture of the lattice (fuel, gap,
+// cladding and surrounding material by their volume fractions) instead of
+// the rods, for far-field studies. The rod status then only scales the
+// activity of the assembly; sources are uniform over the box.
 class SpentFuelAssembly
 {
 public:
@@ -33,13 +50,15 @@ public:
                       G4Material* surrMat,
                       G4int nx = 16,
                       G4int ny = 16,
-                      G4double interval = 1.285*cm);
+                      G4double interval = 1.285*cm,
+                      G4bool homogenized = false);
 
     void SetName(G4String name) { fName = name; }
     G4String GetName() const { return fName; }
     G4LogicalVolume* GetLogicalVolume() const { return fSpentFuelAssemblyLV; }
     G4int GetNX() const { return fNX; }
     G4int GetNY() const { return fNY; }
+    G4double GetInterval() const { return fInterval; }
     void Print() { G4UImanager::GetUIpointer()->ApplyCommand("/vis/drawTree " + fName); }
 
     std::shared_ptr<FuelRod> GetFuelRod() const { return fFuelRod; }
@@ -48,13 +67,33 @@ public:
     void SetFuelRodStatus(std::vector<G4int> fuelRodIDVec) { fFuelRodIDVec = fuelRodIDVec; }
     void PrintFuelRodStatus(std::ostream& out) const;
     G4int SampleRandomFuelRodID() const;
+    G4int GetNActiveFuelRods() const { return static_cast<G4int>(fFuelRodIDVec.size()); }
+    const std::vector<G4int>& GetActiveFuelRodIDs() const { return fFuelRodIDVec; }
+    G4bool IsHomogenized() const { return fHomogenized; }
+    // Envelope and, for the explicit lattice, the rod volumes
+    std::vector<G4LogicalVolume*> GetLogicalVolumes() const;
+
+    // Homogenized sampling (local frame); zFraction as for FuelRod
+    G4ThreeVector SampleRandomPointInLattice(G4double zFraction) const;
+    G4ThreeVector SampleRandomPointInCell(G4int i, G4double zFraction) const;
+    G4int GetLatticeCell(const G4ThreeVector& localPos) const;
+
+    // Placement in the world (set by DetectorConstruction)
+    void SetPlacement(const G4RotationMatrix& rotation, const G4ThreeVector& translation)
+    { fRotation = rotation; fTranslation = translation; }
+    G4ThreeVector LocalToGlobal(const G4ThreeVector& localPos) const { return fTranslation + fRotation*localPos; }
 
 private:
+    G4Material* GetHomogenizedMaterial(G4Material* surrMat) const;
+
     G4String fName;
 
     G4int fNX, fNY;
     G4double fInterval;
+    G4bool fHomogenized;
     std::vector<G4int> fFuelRodIDVec;
+    G4RotationMatrix fRotation;
+    G4ThreeVector fTranslation;
 
     std::shared_ptr<FuelRod> fFuelRod;
 
@@ -62,6 +101,14 @@ private:
     SpentFuelAssemblyParameterisation* fSpentFuelAssemblyParam;
 };
 
+// Assemblies of the current geometry, in basket order, and the source
+// sampling over them. Sampling is hierarchical, one table per level:
+// assembly (relative activity x active rods, alias table) -> active rod of
+// the assembly (uniform) -> axial bin of the axial profile (alias table),
+// uniform within the bin. The cost per primary does not depend on the
+// number of assemblies. Fuel rod IDs are global: rod + nRods*assembly; in a
+// homogenized assembly, the point is uniform over the box and the rod ID is
+// its lattice cell.
 class SpentFuelAssemblyStore: public std::vector< std::shared_ptr<SpentFuelAssembly> >
 {
 public:
@@ -75,10 +122,35 @@ public:
 
     std::shared_ptr<SpentFuelAssembly> GetSpentFuelAssembly(const G4String& name) const;
 
+    // Relative activity per assembly (missing entries: 1) and axial source
+    // profile (equal-height bins, bottom to top; empty: uniform). Take
+    // effect at the next Update().
+    void SetAssemblyActivities(const std::vector<G4double>& activities) { fAssemblyActivities = activities; }
+    void SetAxialProfile(const std::vector<G4double>& profile) { fAxialProfile = profile; }
+    const std::vector<G4double>& GetAxialProfile() const { return fAxialProfile; }
+    G4double GetAssemblyActivity(std::size_t i) const { return (i<fAssemblyActivities.size()) ? fAssemblyActivities[i] : 1.; }
+    // Master, after the assemblies or the rod status changed
+    void Update();
+
+    G4int GetNFuelRods() const;
+    // allRods: uniform over all rods, whatever their status and activity (basis mode)
+    G4ThreeVector SampleSourcePosition(G4bool allRods, G4int& fuelRodID) const;
+    // Point in the given (global) fuel rod, following the axial profile
+    G4ThreeVector SamplePointInFuelRod(G4int fuelRodID) const;
+    // Centre of the given fuel rod
+    G4ThreeVector GetFuelRodPosition(G4int fuelRodID) const;
+    void PrintFuelRodStatus(std::ostream& out) const;
+
     ~SpentFuelAssemblyStore() { GetInstance()->clear(); }
 
 private:
     SpentFuelAssemblyStore() = default;
+    G4double SampleZFraction() const;
+
+    std::vector<G4double> fAssemblyActivities;
+    std::vector<G4double> fAxialProfile;
+    std::unique_ptr<AliasTable> fAssemblyTable;
+    std::unique_ptr<AliasTable> fAxialTable;
 };
 
 #endif // SPENTFUELASSEMBLYBUILDER_HH
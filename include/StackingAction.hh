@@ -0,0 +1,80 @@
+#ifndef STACKINGACTION_HH
+#define STACKINGACTION_HH
+
+#include "G4UserStackingAction.hh"
+#include "G4ThreeVector.hh"
+#include "globals.hh"
+
+#include <ostream>
+#include <utility>
+#include <vector>
+
+class G4LogicalVolume;
+class G4ParticleDefinition;
+class Run;
+
+// Kill rules for secondaries and the priority of photons (/ccTest/stack/).
+// A secondary is killed, by the first rule that matches:
+// - by particle: e.g. the neutrinos of the radioactive decays
+// - by creation volume: e.g. electrons born in FuelPellet or Cladding
+// - below an energy threshold
+// Rules select a particle name, "ions" (nuclei) or "all". Primaries are
+// never killed. Killed tracks and their kinetic energy are counted per rule
+// in the Run. With the camera priority on, photons heading toward a camera
+// (bounding sphere of a "ComptonCamera" volume) are urgent and the others
+// waiting, so that the camera-bound part of an event is tracked first.
+//
+// Rules are shared by all threads and take effect at the next run.
+class StackingAction: public G4UserStackingAction
+{
+public:
+    enum Rule { kParticleRule = 0, kVolumeRule, kEnergyRule, kNRules };
+
+    StackingAction();
+    virtual ~StackingAction() override;
+
+    virtual G4ClassificationOfNewTrack ClassifyNewTrack(const G4Track* track) override;
+    virtual void PrepareNewEvent() override;
+
+    static void KillParticle(const G4String& particle) { fParticleRules.push_back(particle); }
+    static void KillInVolume(const G4String& particle, const G4String& volume)
+    { fVolumeRules.emplace_back(particle, volume); }
+    static void KillBelow(const G4String& particle, G4double energy) { fEnergyRules.emplace_back(particle, energy); }
+    static void SetCameraPriority(G4bool priority) { fCameraPriority = priority; }
+    static void ClearRules();
+    static G4bool HasKillRules() { return !fParticleRules.empty() || !fVolumeRules.empty() || !fEnergyRules.empty(); }
+    static void PrintRules(std::ostream& out);
+
+private:
+    struct Selector
+    {
+        enum Type { kAll, kIons, kParticle } type;
+        const G4ParticleDefinition* particle;
+
+        G4bool Matches(const G4ParticleDefinition* definition) const;
+    };
+    struct Sphere
+    {
+        G4ThreeVector centre;
+        G4double radius;
+    };
+
+    // Rules and cameras of the current run, resolved to pointers
+    void Resolve();
+    G4bool Resolve(const G4String& particle, Selector& selector) const;
+    G4bool HeadsToCamera(const G4Track* track) const;
+
+    Run* fRun;
+    G4int fRunID;
+    std::vector<Selector> fParticleSelectors;
+    std::vector<std::pair<Selector, const G4LogicalVolume*>> fVolumeSelectors;
+    std::vector<std::pair<Selector, G4double>> fEnergySelectors;
+    std::vector<Sphere> fCameras;
+
+    static std::vector<G4String> fParticleRules;
+    static std::vector<std::pair<G4String, G4String>> fVolumeRules;
+    static std::vector<std::pair<G4String, G4double>> fEnergyRules;
+    static G4bool fCameraPriority;
+};
+
+#endif // STACKINGACTION_HH
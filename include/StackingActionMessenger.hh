@@ -0,0 +1,32 @@
+#ifndef STACKINGACTIONMESSENGER_HH
+#define STACKINGACTIONMESSENGER_HH
+
+#include "G4UImessenger.hh"
+
+class G4UIdirectory;
+class G4UIcommand;
+class G4UIcmdWithAString;
+class G4UIcmdWithABool;
+class G4UIcmdWithoutParameter;
+
+// /ccTest/stack/: kill rules and camera priority of StackingAction (all
+// threads, next event)
+class StackingActionMessenger: public G4UImessenger
+{
+public:
+    StackingActionMessenger();
+    virtual ~StackingActionMessenger() override;
+
+    virtual void SetNewValue(G4UIcommand* command, G4String newValue) override;
+
+private:
+    G4UIdirectory* fStackDir;
+    G4UIcmdWithAString* fKillParticleCmd;
+    G4UIcommand* fKillInVolumeCmd;
+    G4UIcommand* fKillBelowCmd;
+    G4UIcmdWithABool* fCameraPriorityCmd;
+    G4UIcmdWithoutParameter* fClearStackRulesCmd;
+    G4UIcmdWithoutParameter* fListStackRulesCmd;
+};
+
+#endif // STACKINGACTIONMESSENGER_HH
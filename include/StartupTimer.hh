@@ -0,0 +1,36 @@
+#ifndef STARTUPTIMER_HH
+#define STARTUPTIMER_HH
+
+#include "globals.hh"
+
+#include <atomic>
+#include <chrono>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+// Wall-clock breakdown of the startup of a job: main() marks the end of each
+// phase on the master, and the first thread to complete an event marks the
+// end of the "first event" phase, measured from the last mark.
+class StartupTimer
+{
+public:
+    static StartupTimer* GetInstance();
+
+    void Mark(const G4String& phase);
+    void FirstEventDone()
+    {
+        if(!fFirstEventDone.load(std::memory_order_relaxed) && !fFirstEventDone.exchange(true))
+            fFirstEventTime = std::chrono::steady_clock::now();
+    }
+    void Print(std::ostream& out) const;
+
+private:
+    StartupTimer();
+
+    std::chrono::steady_clock::time_point fStartTime, fLastMarkTime, fFirstEventTime;
+    std::vector<std::pair<G4String, G4double>> fPhases; // s
+    std::atomic<G4bool> fFirstEventDone;
+};
+
+#endif // STARTUPTIMER_HH
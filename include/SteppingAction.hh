@@ -0,0 +1,21 @@
+#ifndef STEPPINGACTION_HH
+#define STEPPINGACTION_HH
+
+#include "G4UserSteppingAction.hh"
+#include "NextEventEstimator.hh"
+
+// Per-step scoring: the next-event estimator, when active
+class SteppingAction: public G4UserSteppingAction
+{
+public:
+    SteppingAction();
+    virtual ~SteppingAction() override;
+
+    virtual void UserSteppingAction(const G4Step* step) override
+    {
+        auto nextEventEstimator = NextEventEstimator::GetInstance();
+        if(nextEventEstimator->IsActive()) nextEventEstimator->ScoreStep(step);
+    }
+};
+
+#endif // STEPPINGACTION_HH
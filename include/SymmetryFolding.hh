@@ -0,0 +1,108 @@
+#ifndef SYMMETRYFOLDING_HH
+#define SYMMETRYFOLDING_HH
+
+#include "CCHit.hh"
+
+#include "G4ThreeVector.hh"
+#include "globals.hh"
+
+#include <map>
+#include <memory>
+#include <ostream>
+#include <tuple>
+#include <vector>
+
+class CCSensitiveDetector;
+class G4Navigator;
+class SymmetryFoldingMessenger;
+
+// Lattice-symmetry folding (/ccTest/fold/): the source is sampled in the
+// fundamental domain of the symmetry group only, and the hits of each event
+// are replicated under every operation of the group, each replica with
+// 1/(group order) of the event weight. A transported history thus stands for
+// all its symmetric images.
+//
+// The group is made of the operations of the square (about the vertical axis
+// through the centre of the assemblies) under which, on the current
+// placements:
+// - every fuel rod maps onto a rod of an assembly of the same activity, and
+//   active rods onto active rods
+// - every camera maps onto itself
+// - the volumes around the cameras and the assemblies map onto the same
+//   logical volumes (checked at random probe points)
+// Folding is refused in basis mode, during a matrix sweep, with pile-up, the
+// interaction mode, the light model or the next-event estimator (its scores
+// are not replicated), or when only the identity is left.
+//
+// Replicated hits are moved by the operation and take the detector ID of the
+// image detector, found by navigation from the detector centre.
+class SymmetryFolding
+{
+public:
+    // (x, y) -> (xx*x + xy*y, yx*x + yy*y) about the axis
+    struct Operation
+    {
+        const char* name;
+        G4int xx, xy, yx, yy;
+    };
+
+    static SymmetryFolding* GetInstance();
+
+    void SetEnabled(G4bool enabled) { fEnabled = enabled; }
+    G4bool IsEnabled() const { return fEnabled; }
+
+    // Master: selects the operations on the current geometry and source and
+    // prints them with the reasons of the rejected ones; false if only the
+    // identity holds
+    G4bool Check(std::ostream& out);
+    // Master, at the beginning of a run: folding is active if enabled and checked
+    void BeginRun();
+    G4bool IsActive() const { return fActive; }
+    void PrintOperations(std::ostream& out) const;
+
+    // Source point moved into the fundamental domain, with its fuel rod
+    G4ThreeVector Fold(const G4ThreeVector& position, G4int& fuelRodID) const;
+    // Threads processing events: the replicas of the hits, identity first;
+    // valid until the next call of the thread
+    const std::vector< std::unique_ptr<CCHitsMap> >& Replicate(const CCHitsMap* hitsMap, const CCSensitiveDetector* sd);
+    // Share of the event weight of each replica
+    G4double GetWeightFactor() const { return 1./static_cast<G4double>(fOperations.size()); }
+
+private:
+    SymmetryFolding();
+    ~SymmetryFolding();
+
+    struct ThreadState
+    {
+        G4int runID = -1;
+        std::unique_ptr<G4Navigator> navigator;
+        std::vector< std::unique_ptr<CCHitsMap> > replicas;
+        std::map<std::tuple<const CCSensitiveDetector*, std::size_t, G4int>, G4int> detectorImages;
+    };
+
+    G4ThreeVector Apply(const Operation& operation, const G4ThreeVector& position) const
+    {
+        G4double x = position.x() - fAxis.x(), y = position.y() - fAxis.y();
+        return G4ThreeVector(fAxis.x() + operation.xx*x + operation.xy*y,
+                             fAxis.y() + operation.yx*x + operation.yy*y, position.z());
+    }
+    // Empty if the operation holds, else the reason
+    G4String CheckOperation(const Operation& operation, G4Navigator& navigator, std::vector<G4int>& rodImages) const;
+    G4String CheckSetup() const;
+    G4int FindFuelRod(const G4ThreeVector& position) const;
+    G4int GetDetectorImage(ThreadState& state, const CCSensitiveDetector* sd, std::size_t k,
+                           G4int detID, const G4ThreeVector& position) const;
+
+    G4bool fEnabled;
+    G4bool fActive;
+    G4ThreeVector fAxis;
+    std::vector<Operation> fOperations;           // selected, identity first
+    std::vector< std::vector<G4int> > fRodImages; // per selected operation
+    std::vector<G4bool> fActiveRods;
+
+    static G4ThreadLocal ThreadState* fThreadState;
+
+    std::unique_ptr<SymmetryFoldingMessenger> fMessenger;
+};
+
+#endif // SYMMETRYFOLDING_HH
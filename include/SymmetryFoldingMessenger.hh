@@ -0,0 +1,29 @@
+#ifndef SYMMETRYFOLDINGMESSENGER_HH
+#define SYMMETRYFOLDINGMESSENGER_HH
+
+#include "G4UImessenger.hh"
+
+class SymmetryFolding;
+class G4UIdirectory;
+class G4UIcommand;
+class G4UIcmdWithABool;
+class G4UIcmdWithoutParameter;
+
+// /ccTest/fold/: lattice-symmetry folding (SymmetryFolding)
+class SymmetryFoldingMessenger: public G4UImessenger
+{
+public:
+    SymmetryFoldingMessenger(SymmetryFolding* symmetryFolding);
+    virtual ~SymmetryFoldingMessenger() override;
+
+    virtual void SetNewValue(G4UIcommand* command, G4String newValue) override;
+
+private:
+    SymmetryFolding* fSymmetryFolding;
+
+    G4UIdirectory* fFoldDir;
+    G4UIcmdWithABool* fFoldEnableCmd;
+    G4UIcmdWithoutParameter* fFoldCheckCmd;
+};
+
+#endif // SYMMETRYFOLDINGMESSENGER_HH
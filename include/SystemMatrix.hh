@@ -0,0 +1,123 @@
+#ifndef SYSTEMMATRIX_HH
+#define SYSTEMMATRIX_HH
+
+#include "CCHit.hh"
+
+#include "G4Threading.hh"
+#include "G4ThreeVector.hh"
+#include "globals.hh"
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class SystemMatrixMessenger;
+
+// System response matrix of the camera (view 0): for each source point, the
+// probability per emitted photon of each measurement bin. Source points are
+// the fuel rods of the store (global IDs, axial profile applied) or the
+// voxels of an nx x ny grid around the assembly axis covering the fuel height.
+// A measurement is a coincidence binned as (scatter x, scatter y, absorber x,
+// absorber y, scatter energy): scatter hit = max z, absorber hit = min z;
+// coincidences outside the binning only count as emitted photons.
+//
+// Sweep(eventsPerPoint) on the master sweeps the points not yet in the matrix
+// file with one /run/beamOn: event i is a photon of point i/eventsPerPoint,
+// and the event modulo is set to eventsPerPoint so that each worker takes
+// whole points from the run manager's event queue. Each thread tallies the
+// sparse row of its current point and hands it over when the point changes;
+// a row is written as soon as all its events are in.
+//
+// File (binary, native endianness):
+//   header  "CCSM", int32 version, int32 points mode, int32 nPoints,
+//           int64 eventsPerPoint, int32 nPositionBins, double halfWidth (mm),
+//           int32 nEnergyBins, double maxEnergy (MeV), int64 size + chars of
+//           the configuration, nPoints x 3 doubles (point centres, mm)
+//   rows    int32 pointID, int64 nEvents, int64 nnz,
+//           nnz x (uint64 measurement index, float probability), by index
+//   footer  int32 -1, int64 nRows, nRows x (int32 pointID, int64 row offset)
+//           by point ID; written once every point is done
+// Measurement index: (((sx*n + sy)*n + ax)*n + ay)*nEnergyBins + e.
+//
+// Restart: a Sweep() with an existing file of the same header keeps its
+// complete rows, cuts off a partly written last row and sweeps the other
+// points only. Points in flight when a run ends early are redone.
+class SystemMatrix
+{
+public:
+    enum PointsMode { kRods = 0, kVoxels = 1 };
+
+    static SystemMatrix* GetInstance();
+
+    void SetPointsMode(PointsMode mode) { fPointsMode = mode; }
+    void SetVoxelGrid(G4int nx, G4int ny, G4double halfWidth)
+    { fNVoxelsX = nx; fNVoxelsY = ny; fVoxelHalfWidth = halfWidth; }
+    void SetPositionBinning(G4int nBins, G4double halfWidth) { fNPositionBins = nBins; fPositionHalfWidth = halfWidth; }
+    void SetEnergyBinning(G4int nBins, G4double maxEnergy) { fNEnergyBins = nBins; fMaxEnergy = maxEnergy; }
+    // Empty: output/matrix[_<tag>].dat
+    void SetFileName(const G4String& fileName) { fFileName = fileName; }
+
+    // Master: sweep the remaining points
+    void Sweep(G4int eventsPerPoint);
+
+    G4bool IsActive() const { return fActive; }
+    // Source point of an event and a photon origin in it
+    G4int GetPointID(G4int eventID) const { return fRemainingPoints[static_cast<std::size_t>(eventID/fEventsPerPoint)]; }
+    G4ThreeVector SamplePoint(G4int pointID) const;
+
+    // Threads processing events
+    void RecordEvent(G4int pointID, const CCHitsMap* hitsMap, G4double eventWeight);
+    void EndThreadRun();
+
+private:
+    SystemMatrix();
+    ~SystemMatrix();
+
+    struct Row
+    {
+        G4int pointID;
+        G4long nEvents;
+        std::unordered_map<std::uint64_t, G4double> weights;
+    };
+    static G4ThreadLocal Row* fThreadRow; // current point of the thread
+
+    void BuildPoints();
+    std::string BuildHeader(const G4String& configuration) const;
+    G4bool Resume(const G4String& fileName, const std::string& header);
+    void Deposit(Row& row);
+    void WriteRow(const Row& row);
+    void WriteFooter();
+    void PrintProgress(std::ostream& out, G4bool summary);
+
+    PointsMode fPointsMode;
+    G4int fNVoxelsX, fNVoxelsY;
+    G4double fVoxelHalfWidth;
+    G4int fNPositionBins;
+    G4double fPositionHalfWidth;
+    G4int fNEnergyBins;
+    G4double fMaxEnergy;
+    G4String fFileName;
+
+    G4bool fActive;
+    G4int fEventsPerPoint;
+    std::vector<G4ThreeVector> fPoints;   // rods: centres; voxels: centres
+    G4double fVoxelZMin, fVoxelZMax;
+    std::vector<G4int> fRemainingPoints;  // event block -> point ID
+
+    G4Mutex fMutex;
+    std::ofstream fOut;
+    std::map<G4int, std::int64_t> fIndex; // point ID -> row offset
+    std::unordered_map<G4int, Row> fPending;
+    G4int fNRowsWritten;                  // this sweep
+    std::chrono::steady_clock::time_point fStartTime, fLastReport;
+
+    std::unique_ptr<SystemMatrixMessenger> fMessenger;
+};
+
+#endif // SYSTEMMATRIX_HH
@@ -0,0 +1,33 @@
+#ifndef SYSTEMMATRIXMESSENGER_HH
+#define SYSTEMMATRIXMESSENGER_HH
+
+#include "G4UImessenger.hh"
+
+class SystemMatrix;
+class G4UIdirectory;
+class G4UIcommand;
+class G4UIcmdWithAString;
+class G4UIcmdWithAnInteger;
+
+// /ccTest/matrix/: system response matrix sweeps (SystemMatrix)
+class SystemMatrixMessenger: public G4UImessenger
+{
+public:
+    SystemMatrixMessenger(SystemMatrix* systemMatrix);
+    virtual ~SystemMatrixMessenger() override;
+
+    virtual void SetNewValue(G4UIcommand* command, G4String newValue) override;
+
+private:
+    SystemMatrix* fSystemMatrix;
+
+    G4UIdirectory* fMatrixDir;
+    G4UIcmdWithAString* fMatrixPointsCmd;
+    G4UIcommand* fMatrixVoxelGridCmd;
+    G4UIcommand* fMatrixPositionBinningCmd;
+    G4UIcommand* fMatrixEnergyBinningCmd;
+    G4UIcmdWithAString* fMatrixFileCmd;
+    G4UIcmdWithAnInteger* fMatrixRunCmd;
+};
+
+#endif // SYSTEMMATRIXMESSENGER_HH
@@ -7,6 +7,8 @@ class GAGGDetector: public Detector
 {
 public:
     GAGGDetector();
+
+    static G4Material* FindOrBuildGAGGCe();
 };
 
 class TestCC1: public SimpleScAbCC
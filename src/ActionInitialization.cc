@@ -2,10 +2,19 @@
 #include "PrimaryGeneratorAction.hh"
 #include "RunAction.hh"
 #include "EventAction.hh"
+#include "StackingAction.hh"
+#include "SteppingAction.hh"
+#include "RunMessenger.hh"
+#include "PileUpStreamMessenger.hh"
+#include "StackingActionMessenger.hh"
 
 ActionInitialization::ActionInitialization()
 :G4VUserActionInitialization()
-{}
+{
+    fRunMessenger = std::make_unique<RunMessenger>();
+    fPileUpStreamMessenger = std::make_unique<PileUpStreamMessenger>();
+    fStackingActionMessenger = std::make_unique<StackingActionMessenger>();
+}
 
 ActionInitialization::~ActionInitialization()
 {}
@@ -21,4 +30,6 @@ void ActionInitialization::Build() const
 
     SetUserAction(new RunAction());
     SetUserAction(new EventAction);
+    SetUserAction(new StackingAction());
+    SetUserAction(new SteppingAction());
 }
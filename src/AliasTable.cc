@@ -0,0 +1,44 @@
+#include "AliasTable.hh"
+
+AliasTable::AliasTable(const std::vector<G4double>& weights)
+: fProbability(weights.size(), 0.), fAlias(weights.size(), 0)
+{
+    for(auto weight: weights) fTotalWeight += weight;
+    if(weights.empty() || fTotalWeight<=0.) return;
+
+    auto n = weights.size();
+    std::vector<G4double> scaled(n);
+    std::vector<G4int> small, large;
+    for(std::size_t i = 0; i<n; ++i)
+    {
+        scaled[i] = weights[i]*static_cast<G4double>(n)/fTotalWeight;
+        (scaled[i]<1. ? small : large).push_back(static_cast<G4int>(i));
+    }
+
+    while(!small.empty() && !large.empty())
+    {
+        auto s = static_cast<std::size_t>(small.back());
+        small.pop_back();
+        auto l = static_cast<std::size_t>(large.back());
+
+        fProbability[s] = scaled[s];
+        fAlias[s] = static_cast<G4int>(l);
+        scaled[l] -= 1. - scaled[s];
+        if(scaled[l]<1.)
+        {
+            large.pop_back();
+            small.push_back(static_cast<G4int>(l));
+        }
+    }
+    // Leftovers are 1 up to rounding
+    for(auto i: large) fProbability[static_cast<std::size_t>(i)] = 1.;
+    for(auto i: small) fProbability[static_cast<std::size_t>(i)] = 1.;
+}
+
+G4int AliasTable::Sample(G4double u) const
+{
+    G4double x = u*static_cast<G4double>(fProbability.size());
+    auto i = static_cast<std::size_t>(x);
+    if(i>=fProbability.size()) i = fProbability.size() - 1;
+    return (x - static_cast<G4double>(i)<fProbability[i]) ? static_cast<G4int>(i) : fAlias[i];
+}
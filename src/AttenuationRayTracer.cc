@@ -0,0 +1,269 @@
+#include "AttenuationRayTracer.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <thread>
+
+namespace
+{
+    const double kPi = 3.14159265358979323846;
+    // Candidate rods are packed in blocks of this size for the chord pass
+    const std::size_t kBlockSize = 64;
+
+    double Dot(const AttenuationRayTracer::Vector& a, const AttenuationRayTracer::Vector& b)
+    { return a[0]*b[0] + a[1]*b[1] + a[2]*b[2]; }
+
+    // Gauss-Legendre nodes and weights on [0, 1]
+    void GaussLegendre(int n, std::vector<double>& nodes, std::vector<double>& weights)
+    {
+        nodes.assign(static_cast<std::size_t>(n), 0.);
+        weights.assign(static_cast<std::size_t>(n), 0.);
+        for(int i = 0; i<n; ++i)
+        {
+            double x = std::cos(kPi*(i + 0.75)/(n + 0.5)), derivative = 1.;
+            for(int iteration = 0; iteration<100; ++iteration)
+            {
+                double p0 = 1., p1 = x;
+                for(int k = 2; k<=n; ++k)
+                {
+                    double p2 = ((2*k - 1)*x*p1 - (k - 1)*p0)/k;
+                    p0 = p1;
+                    p1 = p2;
+                }
+                derivative = n*(x*p1 - p0)/(x*x - 1.);
+                double dx = p1/derivative;
+                x -= dx;
+                if(std::abs(dx)<1.e-15) break;
+            }
+            nodes[static_cast<std::size_t>(i)] = 0.5*(1. - x);
+            weights[static_cast<std::size_t>(i)] = 1./((1. - x*x)*derivative*derivative);
+        }
+    }
+}
+
+AttenuationRayTracer::AttenuationRayTracer(const ScreeningScene& scene, const Settings& settings)
+: fScene(scene), fSettings(settings)
+{
+    // Cross section: uniform in r^2, Gauss in r^2 and equal azimuth steps,
+    // the rings staggered
+    std::vector<double> radialNodes, radialWeights;
+    GaussLegendre(std::max(fSettings.nRadial, 1), radialNodes, radialWeights);
+    std::vector<Node> section;
+    auto nAzimuthal = std::max(fSettings.nAzimuthal, 1);
+    for(std::size_t i = 0; i<radialNodes.size(); ++i)
+        for(int j = 0; j<nAzimuthal; ++j)
+        {
+            double r = scene.rod.pelletRadius*std::sqrt(radialNodes[i]);
+            double phi = 2.*kPi*(j + 0.5*static_cast<double>(i%2))/nAzimuthal;
+            section.push_back({r*std::cos(phi), r*std::sin(phi), 0., radialWeights[i]/nAzimuthal});
+        }
+
+    // Axial segments: geometric from both ends, split at the profile bins
+    double height = 2.*scene.rod.halfHeight;
+    std::vector<double> edges = {0., height/2., height};
+    for(double d = std::max(fSettings.firstSegment, 1.e-3); d<height/2.; d *= 2.)
+    {
+        edges.push_back(d);
+        edges.push_back(height - d);
+    }
+    const auto& profile = scene.axialProfile;
+    double profileSum = 0.;
+    for(auto value: profile) profileSum += std::max(value, 0.);
+    auto nBins = static_cast<double>(profile.size());
+    if(profileSum>0.)
+        for(std::size_t k = 1; k<profile.size(); ++k) edges.push_back(height*static_cast<double>(k)/nBins);
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end(), [](double a, double b) { return b - a<1.e-9; }), edges.end());
+
+    for(std::size_t k = 0; k + 1<edges.size(); ++k)
+    {
+        double mid = 0.5*(edges[k] + edges[k + 1]), half = 0.5*(edges[k + 1] - edges[k]);
+        double density = 1.;
+        if(profileSum>0.)
+        {
+            auto bin = std::min(static_cast<std::size_t>(mid/height*nBins), profile.size() - 1);
+            density = std::max(profile[bin], 0.)*nBins/profileSum;
+        }
+        if(density<=0.) continue;
+        for(double sign: {-1., 1.})
+        {
+            double z = mid + sign*half/std::sqrt(3.) - height/2.;
+            for(const auto& point: section)
+                fNodes.push_back({point.x, point.y, z, point.weight*half/height*density});
+        }
+    }
+}
+
+double AttenuationRayTracer::OpticalDepth(const Vector& start, const Vector& end) const
+{
+    Vector direction = {end[0] - start[0], end[1] - start[1], end[2] - start[2]};
+    double length = std::sqrt(Dot(direction, direction));
+    const auto& rod = fScene.rod;
+    double tau = fScene.muWorld*length;
+    for(const auto& assembly: fScene.assemblies)
+    {
+        // Into the assembly frame; t in [0, 1] along the segment
+        Vector offset = {start[0] - assembly.translation[0], start[1] - assembly.translation[1],
+                         start[2] - assembly.translation[2]};
+        Vector origin, localDirection;
+        for(std::size_t k = 0; k<3; ++k)
+        {
+            origin[k] = Dot(assembly.axes[k], offset);
+            localDirection[k] = Dot(assembly.axes[k], direction);
+        }
+        double t0 = 0., t1 = 1.;
+        for(std::size_t k = 0; k<3 && t0<t1; ++k)
+        {
+            if(localDirection[k]==0.)
+            {
+                if(std::abs(origin[k])>assembly.halfSize[k]) t1 = t0;
+                continue;
+            }
+            double tA = (-assembly.halfSize[k] - origin[k])/localDirection[k];
+            double tB = (assembly.halfSize[k] - origin[k])/localDirection[k];
+            t0 = std::max(t0, std::min(tA, tB));
+            t1 = std::min(t1, std::max(tA, tB));
+        }
+        if(t0>=t1) continue;
+
+        Chords chords = {0., 0., 0.};
+        AddRodChords(assembly, origin, localDirection, t0, t1, chords);
+        tau += length*((fScene.muSurrounding - fScene.muWorld)*(t1 - t0)
+                       + (rod.muCladding - fScene.muSurrounding)*chords.cladding
+                       + (rod.muGap - rod.muCladding)*chords.gap
+                       + (rod.muPellet - rod.muGap)*chords.pellet);
+    }
+    return tau;
+}
+
+void AttenuationRayTracer::AddRodChords(const ScreeningScene::Assembly& assembly, const Vector& origin,
+                                        const Vector& direction, double t0, double t1, Chords& chords) const
+{
+    const auto& rod = fScene.rod;
+    double pellet2 = rod.pelletRadius*rod.pelletRadius, gap2 = rod.gapRadius*rod.gapRadius;
+    double cladding2 = rod.claddingRadius*rod.claddingRadius;
+    double ox = origin[0], oy = origin[1], dx = direction[0], dy = direction[1];
+    double a = dx*dx + dy*dy;
+
+    // Chords (in t) of the packed candidates: no branch, so the loop vectorizes
+    double cx[kBlockSize], cy[kBlockSize];
+    std::size_t n = 0;
+    auto Flush = [&]()
+    {
+        double pellet = 0., gap = 0., cladding = 0.;
+        if(a<=0.)
+        {
+            // Parallel to the rods: all or nothing
+            for(std::size_t k = 0; k<n; ++k)
+            {
+                double ex = ox - cx[k], ey = oy - cy[k], c = ex*ex + ey*ey;
+                pellet += (c<pellet2) ? 1. : 0.;
+                gap += (c<gap2) ? 1. : 0.;
+                cladding += (c<cladding2) ? 1. : 0.;
+            }
+            chords.pellet += pellet*(t1 - t0);
+            chords.gap += gap*(t1 - t0);
+            chords.cladding += cladding*(t1 - t0);
+        }
+        else
+        {
+            for(std::size_t k = 0; k<n; ++k)
+            {
+                double ex = ox - cx[k], ey = oy - cy[k];
+                double b = ex*dx + ey*dy, c = ex*ex + ey*ey, tMid = -b/a;
+                double hPellet = std::sqrt(std::max(b*b - a*(c - pellet2), 0.))/a;
+                double hGap = std::sqrt(std::max(b*b - a*(c - gap2), 0.))/a;
+                double hCladding = std::sqrt(std::max(b*b - a*(c - cladding2), 0.))/a;
+                pellet += std::max(std::min(tMid + hPellet, t1) - std::max(tMid - hPellet, t0), 0.);
+                gap += std::max(std::min(tMid + hGap, t1) - std::max(tMid - hGap, t0), 0.);
+                cladding += std::max(std::min(tMid + hCladding, t1) - std::max(tMid - hCladding, t0), 0.);
+            }
+            chords.pellet += pellet;
+            chords.gap += gap;
+            chords.cladding += cladding;
+        }
+        n = 0;
+    };
+
+    // Cells under the ray, from t0 to t1 (a rod lies within its cell)
+    double startX = -(assembly.nx - 1)/2.*assembly.interval, startY = -(assembly.ny - 1)/2.*assembly.interval;
+    auto ix = std::clamp(static_cast<int>(std::floor((ox + t0*dx - startX)/assembly.interval + 0.5)), 0, assembly.nx - 1);
+    auto iy = std::clamp(static_cast<int>(std::floor((oy + t0*dy - startY)/assembly.interval + 0.5)), 0, assembly.ny - 1);
+    const double infinity = std::numeric_limits<double>::infinity();
+    int stepX = (dx>0.) ? 1 : -1, stepY = (dy>0.) ? 1 : -1;
+    double tDeltaX = (dx!=0.) ? assembly.interval/std::abs(dx) : infinity;
+    double tDeltaY = (dy!=0.) ? assembly.interval/std::abs(dy) : infinity;
+    double tMaxX = (dx!=0.) ? (startX + (ix + 0.5*stepX)*assembly.interval - ox)/dx : infinity;
+    double tMaxY = (dy!=0.) ? (startY + (iy + 0.5*stepY)*assembly.interval - oy)/dy : infinity;
+    while(true)
+    {
+        cx[n] = startX + ix*assembly.interval;
+        cy[n] = startY + iy*assembly.interval;
+        if(++n==kBlockSize) Flush();
+        if(tMaxX<tMaxY)
+        {
+            if(tMaxX>=t1) break;
+            ix += stepX;
+            if(ix<0 || ix>=assembly.nx) break;
+            tMaxX += tDeltaX;
+        }
+        else
+        {
+            if(tMaxY>=t1) break;
+            iy += stepY;
+            if(iy<0 || iy>=assembly.ny) break;
+            tMaxY += tDeltaY;
+        }
+    }
+    if(n>0) Flush();
+}
+
+double AttenuationRayTracer::RodFlux(int rodID, const Vector& point, const Vector* normal) const
+{
+    auto nRods = fScene.GetNRodsPerAssembly();
+    const auto& assembly = fScene.assemblies[static_cast<std::size_t>(rodID/nRods)];
+    auto centre = fScene.GetRodLocation(assembly, rodID%nRods);
+    double flux = 0.;
+    for(const auto& node: fNodes)
+    {
+        Vector local = {centre[0] + node.x, centre[1] + node.y, centre[2] + node.z};
+        Vector source = assembly.translation;
+        for(std::size_t k = 0; k<3; ++k)
+            for(std::size_t l = 0; l<3; ++l) source[l] += assembly.axes[k][l]*local[k];
+        Vector ray = {point[0] - source[0], point[1] - source[1], point[2] - source[2]};
+        double distance2 = Dot(ray, ray);
+        if(distance2<=0.) continue;
+        double value = node.weight/(4.*kPi*distance2);
+        if(normal)
+        {
+            double cosine = -Dot(*normal, ray)/std::sqrt(distance2);
+            if(cosine<=0.) continue;
+            value *= cosine;
+        }
+        flux += value*std::exp(-OpticalDepth(source, point));
+    }
+    return flux;
+}
+
+std::vector<double> AttenuationRayTracer::Response(const std::vector<Vector>& points, const Vector* normal) const
+{
+    // Inactive rods contribute to no pattern: left at 0
+    auto activities = fScene.GetRodActivities();
+    auto nRods = activities.size();
+    std::vector<double> response(points.size()*nRods, 0.);
+    std::atomic<std::size_t> next(0);
+    auto Work = [&]()
+    {
+        for(std::size_t p = next++; p<points.size(); p = next++)
+            for(std::size_t rod = 0; rod<nRods; ++rod)
+                if(activities[rod]>0.)
+                    response[p*nRods + rod] = RodFlux(static_cast<int>(rod), points[p], normal);
+    };
+    std::vector<std::thread> threads;
+    for(int i = 1; i<fSettings.nThreads; ++i) threads.emplace_back(Work);
+    Work();
+    for(auto& thread: threads) thread.join();
+    return response;
+}
@@ -0,0 +1,152 @@
+#include "BasisLibrary.hh"
+
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+namespace
+{
+    const char kMagic[4] = {'C', 'C', 'B', '1'};
+
+    template<typename T>
+    void WriteValue(std::ostream& out, const T& value)
+    { out.write(reinterpret_cast<const char*>(&value), sizeof(T)); }
+
+    template<typename T>
+    void ReadValue(std::istream& in, T& value)
+    { in.read(reinterpret_cast<char*>(&value), sizeof(T)); }
+
+    template<typename T>
+    void WriteVector(std::ostream& out, const std::vector<T>& vec)
+    { out.write(reinterpret_cast<const char*>(vec.data()), static_cast<std::streamsize>(vec.size()*sizeof(T))); }
+
+    template<typename T>
+    void ReadVector(std::istream& in, std::vector<T>& vec)
+    { in.read(reinterpret_cast<char*>(vec.data()), static_cast<std::streamsize>(vec.size()*sizeof(T))); }
+}
+
+BasisLibrary::BasisLibrary(int nx, int ny,
+                           int nEnergyBins, double maxEnergy,
+                           int nImageBins, double imageHalfWidth)
+: fNX(nx), fNY(ny),
+  fNEnergyBins(nEnergyBins), fMaxEnergy(maxEnergy),
+  fNImageBins(nImageBins), fImageHalfWidth(imageHalfWidth)
+{
+    auto nRods = static_cast<std::size_t>(GetNRods());
+    fNPrimaries.assign(nRods, 0);
+    fSingles.assign(nRods, 0.);
+    fCoincidences.assign(nRods, 0.);
+    fSpectra.assign(nRods*static_cast<std::size_t>(fNEnergyBins), 0.);
+    fImages.assign(nRods*static_cast<std::size_t>(fNImageBins*fNImageBins), 0.);
+}
+
+void BasisLibrary::AddCoincidence(int rodID, double weight, double eSum, double scatterX, double scatterY)
+{
+    auto rod = static_cast<std::size_t>(rodID);
+    fCoincidences[rod] += weight;
+
+    auto eBin = static_cast<int>(std::floor(eSum/fMaxEnergy*fNEnergyBins));
+    if(eBin>=0 && eBin<fNEnergyBins)
+        fSpectra[rod*static_cast<std::size_t>(fNEnergyBins) + static_cast<std::size_t>(eBin)] += weight;
+
+    auto ix = static_cast<int>(std::floor((scatterX + fImageHalfWidth)/(2.*fImageHalfWidth)*fNImageBins));
+    auto iy = static_cast<int>(std::floor((scatterY + fImageHalfWidth)/(2.*fImageHalfWidth)*fNImageBins));
+    if(ix>=0 && ix<fNImageBins && iy>=0 && iy<fNImageBins)
+        fImages[rod*static_cast<std::size_t>(fNImageBins*fNImageBins) + static_cast<std::size_t>(ix + fNImageBins*iy)] += weight;
+}
+
+void BasisLibrary::Merge(const BasisLibrary& other)
+{
+    for(std::size_t i = 0; i<fNPrimaries.size(); ++i) fNPrimaries[i] += other.fNPrimaries[i];
+    for(std::size_t i = 0; i<fSingles.size(); ++i) fSingles[i] += other.fSingles[i];
+    for(std::size_t i = 0; i<fCoincidences.size(); ++i) fCoincidences[i] += other.fCoincidences[i];
+    for(std::size_t i = 0; i<fSpectra.size(); ++i) fSpectra[i] += other.fSpectra[i];
+    for(std::size_t i = 0; i<fImages.size(); ++i) fImages[i] += other.fImages[i];
+}
+
+double BasisLibrary::GetScale(int rodID, double activity) const
+{
+    auto nPrimaries = fNPrimaries[static_cast<std::size_t>(rodID)];
+    if(activity==0. || nPrimaries==0) return 0.;
+    return activity/static_cast<double>(nPrimaries);
+}
+
+BasisLibrary::Response BasisLibrary::Synthesize(const std::vector<double>& activity) const
+{
+    Response response;
+    auto nE = static_cast<std::size_t>(fNEnergyBins);
+    auto nImage = static_cast<std::size_t>(fNImageBins*fNImageBins);
+    response.spectrum.assign(nE, 0.);
+    response.image.assign(nImage, 0.);
+
+    for(int rodID = 0; rodID<GetNRods() && rodID<static_cast<int>(activity.size()); ++rodID)
+    {
+        auto scale = GetScale(rodID, activity[static_cast<std::size_t>(rodID)]);
+        if(scale==0.) continue;
+
+        auto rod = static_cast<std::size_t>(rodID);
+        response.singles += scale*fSingles[rod];
+        response.coincidences += scale*fCoincidences[rod];
+        const double* spectrum = &fSpectra[rod*nE];
+        for(std::size_t i = 0; i<nE; ++i) response.spectrum[i] += scale*spectrum[i];
+        const double* image = &fImages[rod*nImage];
+        for(std::size_t i = 0; i<nImage; ++i) response.image[i] += scale*image[i];
+    }
+
+    return response;
+}
+
+bool BasisLibrary::Write(const std::string& fileName) const
+{
+    std::ofstream out(fileName, std::ios::binary);
+    return out && Write(out);
+}
+
+bool BasisLibrary::Read(const std::string& fileName)
+{
+    std::ifstream in(fileName, std::ios::binary);
+    return in && Read(in);
+}
+
+bool BasisLibrary::Write(std::ostream& out) const
+{
+    out.write(kMagic, sizeof(kMagic));
+    WriteValue(out, static_cast<std::int32_t>(fNX));
+    WriteValue(out, static_cast<std::int32_t>(fNY));
+    WriteValue(out, static_cast<std::int32_t>(fNEnergyBins));
+    WriteValue(out, fMaxEnergy);
+    WriteValue(out, static_cast<std::int32_t>(fNImageBins));
+    WriteValue(out, fImageHalfWidth);
+    WriteVector(out, fNPrimaries);
+    WriteVector(out, fSingles);
+    WriteVector(out, fCoincidences);
+    WriteVector(out, fSpectra);
+    WriteVector(out, fImages);
+
+    return static_cast<bool>(out);
+}
+
+bool BasisLibrary::Read(std::istream& in)
+{
+    char magic[4];
+    if(!in.read(magic, sizeof(magic)) || std::memcmp(magic, kMagic, sizeof(kMagic))!=0) return false;
+
+    std::int32_t nx, ny, nEnergyBins, nImageBins;
+    double maxEnergy, imageHalfWidth;
+    ReadValue(in, nx);
+    ReadValue(in, ny);
+    ReadValue(in, nEnergyBins);
+    ReadValue(in, maxEnergy);
+    ReadValue(in, nImageBins);
+    ReadValue(in, imageHalfWidth);
+    if(!in || nx<=0 || ny<=0 || nEnergyBins<=0 || nImageBins<=0) return false;
+
+    *this = BasisLibrary(nx, ny, nEnergyBins, maxEnergy, nImageBins, imageHalfWidth);
+    ReadVector(in, fNPrimaries);
+    ReadVector(in, fSingles);
+    ReadVector(in, fCoincidences);
+    ReadVector(in, fSpectra);
+    ReadVector(in, fImages);
+
+    return static_cast<bool>(in);
+}
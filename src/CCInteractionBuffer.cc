@@ -0,0 +1,75 @@
+#include "CCInteractionBuffer.hh"
+
+#include "G4SystemOfUnits.hh"
+
+CCInteractionBuffer::CCInteractionBuffer(G4int maxPerDetector, G4int maxDetectors)
+: fMaxPerDetector(maxPerDetector), fMaxDetectors(maxDetectors),
+  fNEntries(0), fNDetectors(0), fNDropped(0)
+{
+    auto nSlots = static_cast<std::size_t>(fMaxDetectors);
+    auto capacity = nSlots*static_cast<std::size_t>(fMaxPerDetector);
+    fSlotDetID.resize(nSlots);
+    fSlotCount.resize(nSlots);
+    fDetID.resize(capacity);
+    fX.resize(capacity);
+    fY.resize(capacity);
+    fZ.resize(capacity);
+    fE.resize(capacity);
+    fT.resize(capacity);
+}
+
+void CCInteractionBuffer::Reset()
+{
+    fNEntries = 0;
+    fNDetectors = 0;
+    fNDropped = 0;
+}
+
+G4bool CCInteractionBuffer::Add(G4int detID, const G4ThreeVector& pos, G4double eDep, G4double time)
+{
+    G4int slot = 0;
+    while(slot<fNDetectors && fSlotDetID[slot]!=detID) ++slot;
+    if(slot==fNDetectors)
+    {
+        if(fNDetectors==fMaxDetectors) { ++fNDropped; return false; }
+        fSlotDetID[slot] = detID;
+        fSlotCount[slot] = 0;
+        ++fNDetectors;
+    }
+    if(fSlotCount[slot]==fMaxPerDetector) { ++fNDropped; return false; }
+    ++fSlotCount[slot];
+
+    fDetID[fNEntries] = detID;
+    fX[fNEntries] = static_cast<float>(pos.x());
+    fY[fNEntries] = static_cast<float>(pos.y());
+    fZ[fNEntries] = static_cast<float>(pos.z());
+    fE[fNEntries] = static_cast<float>(eDep/keV);
+    fT[fNEntries] = static_cast<float>(time);
+    ++fNEntries;
+
+    return true;
+}
+
+void CCInteractionBuffer::WriteFileHeader(std::ostream& out)
+{
+    const char magic[4] = {'C', 'C', 'I', '2'};
+    out.write(magic, sizeof(magic));
+}
+
+void CCInteractionBuffer::Write(std::ostream& out, G4long evtID, G4double weight) const
+{
+    auto id = static_cast<std::int64_t>(evtID);
+    auto w = static_cast<float>(weight);
+    auto n = static_cast<std::uint16_t>(fNEntries);
+    out.write(reinterpret_cast<const char*>(&id), sizeof(id));
+    out.write(reinterpret_cast<const char*>(&w), sizeof(w));
+    out.write(reinterpret_cast<const char*>(&n), sizeof(n));
+
+    auto nBytes = static_cast<std::streamsize>(n*sizeof(float));
+    out.write(reinterpret_cast<const char*>(fDetID.data()), static_cast<std::streamsize>(n*sizeof(std::int32_t)));
+    out.write(reinterpret_cast<const char*>(fX.data()), nBytes);
+    out.write(reinterpret_cast<const char*>(fY.data()), nBytes);
+    out.write(reinterpret_cast<const char*>(fZ.data()), nBytes);
+    out.write(reinterpret_cast<const char*>(fE.data()), nBytes);
+    out.write(reinterpret_cast<const char*>(fT.data()), nBytes);
+}
@@ -1,8 +1,25 @@
 #include "CCSensitiveDetector.hh"
 #include "CCHit.hh"
+#include "CCInteractionBuffer.hh"
+#include "LightCollectionModel.hh"
+#include "PixelatedCCBuilder.hh"
+
+#include "G4Poisson.hh"
+#include "G4VSolid.hh"
+
+#include <algorithm>
+#include <cfloat>
+
+G4int CCSensitiveDetector::fMaxInteractionsPerDetector = 0;
+G4int CCSensitiveDetector::fMaxInteractingDetectors = 2;
+G4bool CCSensitiveDetector::fLightModelEnabled = false;
+G4int CCSensitiveDetector::fLoadedLightTableVersion = 0;
+std::map< G4int, std::shared_ptr<const LightCollectionModel> > CCSensitiveDetector::fLoadedLightTables;
 
 CCSensitiveDetector::CCSensitiveDetector(G4String detName)
-: G4VSensitiveDetector(detName), fHitsMap(nullptr), fHCName("CCData")
+: G4VSensitiveDetector(detName), fHitsMap(nullptr), fHCName("CCData"), fHCID(-1),
+  fReplicaDepth(0), fSegmentedReadout(false), fEventWeight(0.), fEventWeightTime(0.),
+  fLightCollection(false), fLightTableVersion(-1), fNLightSignals(0)
 {
     collectionName.insert(fHCName);
 }
@@ -13,8 +30,64 @@ CCSensitiveDetector::~CCSensitiveDetector()
 void CCSensitiveDetector::Initialize(G4HCofThisEvent* hce)
 {
     fHitsMap = new CCHitsMap(GetName(), fHCName);
-    G4int hcID = G4SDManager::GetSDMpointer()->GetCollectionID(fHCName);
-    hce->AddHitsCollection(hcID, fHitsMap);
+    hce->AddHitsCollection(GetHCID(), fHitsMap);
+    fEventWeight = 0.;
+    fEventWeightTime = -DBL_MAX;
+
+    // (Re)allocate the interaction buffer only when its configuration changed.
+    // The per-event point count is serialized as uint16.
+    G4int maxPerDetector = std::min(fMaxInteractionsPerDetector, 65535/fMaxInteractingDetectors);
+    if(maxPerDetector<=0) fInteractionBuffer.reset();
+    else if(!fInteractionBuffer ||
+            fInteractionBuffer->GetMaxPerDetector()!=maxPerDetector ||
+            fInteractionBuffer->GetMaxDetectors()!=fMaxInteractingDetectors)
+        fInteractionBuffer = std::make_unique<CCInteractionBuffer>(maxPerDetector, fMaxInteractingDetectors);
+    if(fInteractionBuffer) fInteractionBuffer->Reset();
+
+    // Tables loaded since the last event replace the cached ones
+    if(fLightTableVersion!=fLoadedLightTableVersion)
+    {
+        fLightModels = fLoadedLightTables;
+        fLightTableVersion = fLoadedLightTableVersion;
+    }
+    fNLightSignals = 0;
+}
+
+G4bool CCSensitiveDetector::LoadLightCollectionTable(G4int detID, const G4String& fileName)
+{
+    auto model = std::make_shared<const LightCollectionModel>(fileName);
+    if(!model->IsValid()) return false;
+
+    fLoadedLightTables[detID] = model;
+    ++fLoadedLightTableVersion;
+    return true;
+}
+
+CCSensitiveDetector::LightSignal* CCSensitiveDetector::GetLightSignal(G4int detID, const G4VTouchable* touchable)
+{
+    for(std::size_t i = 0; i<fNLightSignals; ++i)
+        if(fLightSignals[i].detID==detID) return &fLightSignals[i];
+
+    auto& model = fLightModels[detID];
+    if(!model)
+    {
+        G4ThreeVector crystalMin, crystalMax;
+        touchable->GetSolid()->BoundingLimits(crystalMin, crystalMax);
+        model = std::make_shared<const LightCollectionModel>(crystalMax.x(), crystalMax.z());
+    }
+
+    if(fNLightSignals==fLightSignals.size()) fLightSignals.emplace_back();
+    auto& lightSignal = fLightSignals[fNLightSignals++];
+    lightSignal.detID = detID;
+    lightSignal.localToGlobal = touchable->GetHistory()->GetTopTransform().Inverse();
+    lightSignal.model = model.get();
+    lightSignal.signal.assign(static_cast<std::size_t>(model->GetNPMTs()), 0.);
+    return &lightSignal;
+}
+
+G4int CCSensitiveDetector::GetDetectorID(const G4VTouchable* touchable) const
+{
+    return fSegmentedReadout ? PixelatedCC::GetDetectorID(touchable) : touchable->GetReplicaNumber(fReplicaDepth);
 }
 
 G4bool CCSensitiveDetector::ProcessHits(G4Step* aStep, G4TouchableHistory*)
@@ -22,10 +95,28 @@ G4bool CCSensitiveDetector::ProcessHits(G4Step* aStep, G4TouchableHistory*)
     G4double eDep = aStep->GetTotalEnergyDeposit();
     if(0. == eDep) return false;
 
-    G4int cpNo = aStep->GetPreStepPoint()->GetTouchable()->GetReplicaNumber(0); // 3 for LACC
+    auto touchable = aStep->GetPreStepPoint()->GetTouchable();
+    G4int cpNo = GetDetectorID(touchable);
     G4double time = aStep->GetTrack()->GetGlobalTime();
     G4ThreeVector pos = aStep->GetPostStepPoint()->GetPosition();
-    G4double weight = aStep->GetPreStepPoint()->GetWeight();
+    // Weight after the step: biasing may have changed it in this very step
+    G4double weight = aStep->GetPostStepPoint()->GetWeight();
+
+    if(time>=fEventWeightTime)
+    {
+        fEventWeight = weight;
+        fEventWeightTime = time;
+    }
+    if(fInteractionBuffer) fInteractionBuffer->Add(cpNo, pos, eDep, time);
+
+    if(fLightCollection && fLightModelEnabled)
+    {
+        auto lightSignal = GetLightSignal(cpNo, touchable);
+        auto localPos = touchable->GetHistory()->GetTopTransform().TransformPoint(pos);
+        auto response = lightSignal->model->GetResponse(localPos);
+        G4double eDepKeV = eDep/keV;
+        for(std::size_t k = 0; k<lightSignal->signal.size(); ++k) lightSignal->signal[k] += eDepKeV*response[k];
+    }
 
     CCHit* thisHit;
 
@@ -35,6 +126,7 @@ G4bool CCSensitiveDetector::ProcessHits(G4Step* aStep, G4TouchableHistory*)
         {
             thisHit = itr->second;
             thisHit->AddDepEAndPosition(eDep, pos);
+            thisHit->SetWeight(weight);
             break;
         }
 
@@ -47,3 +139,30 @@ G4bool CCSensitiveDetector::ProcessHits(G4Step* aStep, G4TouchableHistory*)
     return true;
 }
 
+void CCSensitiveDetector::EndOfEvent(G4HCofThisEvent*)
+{
+    // Photon statistics and Anger logic in the crystal frame
+    for(std::size_t i = 0; i<fNLightSignals; ++i)
+    {
+        const auto& lightSignal = fLightSignals[i];
+        auto model = lightSignal.model;
+        G4double nSum = 0., xSum = 0., ySum = 0.;
+        for(G4int k = 0; k<model->GetNPMTs(); ++k)
+        {
+            auto n = static_cast<G4double>(G4Poisson(lightSignal.signal[static_cast<std::size_t>(k)]));
+            nSum += n;
+            xSum += n*model->GetPMTX(k);
+            ySum += n*model->GetPMTY(k);
+        }
+
+        auto hit = (*fHitsMap)[lightSignal.detID];
+        if(!hit) continue;
+        if(nSum==0.)
+        {
+            hit->SetMeasurement(hit->GetPosition(), 0.);
+            continue;
+        }
+        auto measuredPos = lightSignal.localToGlobal.TransformPoint(G4ThreeVector(xSum/nSum, ySum/nSum, 0.));
+        hit->SetMeasurement(measuredPos, nSum/model->GetCalibration()*keV);
+    }
+}
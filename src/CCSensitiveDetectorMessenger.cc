@@ -0,0 +1,43 @@
+#include "CCSensitiveDetectorMessenger.hh"
+#include "CCSensitiveDetector.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithAnInteger.hh"
+
+CCSensitiveDetectorMessenger::CCSensitiveDetectorMessenger()
+: G4UImessenger()
+{
+    fHitDir = new G4UIdirectory("/ccTest/hit/");
+    fHitDir->SetGuidance("Hit recording in the Compton camera detectors.");
+
+    fMaxInteractionsCmd = new G4UIcmdWithAnInteger("/ccTest/hit/maxInteractions", this);
+    fMaxInteractionsCmd->SetGuidance("Keep up to N individual interaction points per detector and event");
+    fMaxInteractionsCmd->SetGuidance("in addition to the energy-weighted centroid (0: centroid only).");
+    fMaxInteractionsCmd->SetGuidance("Points are written to output/interactions.bin.");
+    fMaxInteractionsCmd->SetParameterName("N", false);
+    fMaxInteractionsCmd->SetRange("N>=0");
+    fMaxInteractionsCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fMaxInteractionsCmd->SetToBeBroadcasted(false);
+
+    fMaxInteractingDetectorsCmd = new G4UIcmdWithAnInteger("/ccTest/hit/maxDetectors", this);
+    fMaxInteractingDetectorsCmd->SetGuidance("Number of distinct detectors per event the interaction buffer holds.");
+    fMaxInteractingDetectorsCmd->SetParameterName("N", false);
+    fMaxInteractingDetectorsCmd->SetRange("N>0");
+    fMaxInteractingDetectorsCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fMaxInteractingDetectorsCmd->SetToBeBroadcasted(false);
+}
+
+CCSensitiveDetectorMessenger::~CCSensitiveDetectorMessenger()
+{
+    delete fMaxInteractingDetectorsCmd;
+    delete fMaxInteractionsCmd;
+    delete fHitDir;
+}
+
+void CCSensitiveDetectorMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+    if(command==fMaxInteractionsCmd)
+        CCSensitiveDetector::SetMaxInteractionsPerDetector(fMaxInteractionsCmd->GetNewIntValue(newValue));
+    else if(command==fMaxInteractingDetectorsCmd)
+        CCSensitiveDetector::SetMaxInteractingDetectors(fMaxInteractingDetectorsCmd->GetNewIntValue(newValue));
+}
@@ -0,0 +1,32 @@
+#include "CachingRunManager.hh"
+#include "Campaign.hh"
+#include "LeakageDetector.hh"
+#include "Run.hh"
+#include "RunCache.hh"
+#include "RunTarget.hh"
+#include "SystemMatrix.hh"
+
+void CachingRunManager::BeamOn(G4int n_event, const char* macroFile, G4int n_select)
+{
+    // Per-event macros, and state the key does not cover: always run
+    fLastRunRestored = false;
+    auto runCache = RunCache::GetInstance();
+    G4bool cached = runCache->IsEnabled() && n_event>0 && !macroFile
+                    && !Campaign::GetInstance()->IsActive() && !SystemMatrix::GetInstance()->IsActive()
+                    && !RunTarget::GetInstance()->IsActive() && !LeakageDetector::IsEnabled();
+    if(!cached)
+    {
+        CachingRunManagerBase::BeamOn(n_event, macroFile, n_select);
+        return;
+    }
+
+    if(runCache->Lookup(runIDCounter, n_event))
+    {
+        // As if the run had been done
+        fLastRunRestored = true;
+        ++runIDCounter;
+        return;
+    }
+    CachingRunManagerBase::BeamOn(n_event, macroFile, n_select);
+    runCache->Store(static_cast<const Run*>(GetCurrentRun()));
+}
@@ -0,0 +1,202 @@
+#include "Campaign.hh"
+#include "CampaignMessenger.hh"
+#include "DetectorConstruction.hh"
+#include "EventAction.hh"
+#include "PileUpStream.hh"
+#include "Run.hh"
+
+#include "G4RunManager.hh"
+#include "G4UIcommand.hh"
+#include "G4UImanager.hh"
+#include "Randomize.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+namespace
+{
+    const char kMagic[4] = {'C', 'C', 'K', '4'};
+
+    void WriteLong(std::ostream& out, G4long value)
+    {
+        auto v = static_cast<std::int64_t>(value);
+        out.write(reinterpret_cast<const char*>(&v), sizeof(v));
+    }
+
+    G4long ReadLong(std::istream& in)
+    {
+        std::int64_t v = 0;
+        in.read(reinterpret_cast<char*>(&v), sizeof(v));
+        return static_cast<G4long>(v);
+    }
+
+    void WriteString(std::ostream& out, const std::string& str)
+    {
+        WriteLong(out, static_cast<G4long>(str.size()));
+        out.write(str.data(), static_cast<std::streamsize>(str.size()));
+    }
+
+    std::string ReadString(std::istream& in)
+    {
+        auto size = ReadLong(in);
+        if(!in || size<0) return std::string();
+        std::string str(static_cast<std::size_t>(size), '\0');
+        in.read(&str[0], static_cast<std::streamsize>(size));
+        return str;
+    }
+}
+
+Campaign* Campaign::GetInstance()
+{
+    static Campaign fInstance;
+    return &fInstance;
+}
+
+Campaign::Campaign()
+: fSegmentSize(1000000), fActive(false), fNEvents(0), fEventOffset(0), fNSegmentEvents(0)
+{
+    fMessenger = std::make_unique<CampaignMessenger>(this);
+}
+
+Campaign::~Campaign()
+{}
+
+void Campaign::BeamOn(G4long nEvents)
+{
+    auto detector = static_cast<const DetectorConstruction*>(
+                G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+    G4String tag = detector->GetOutputTag();
+    G4String configuration = detector->GetConfiguration();
+    G4String checkpointFile = fCheckpointFile.empty()
+            ? EventAction::GetOutputFileName("checkpoint", tag, ".dat") : fCheckpointFile;
+
+    fTotal = std::make_unique<Run>();
+    fNEvents = nEvents;
+    fEventOffset = 0;
+    if(!fResumeFile.empty())
+    {
+        G4String resumeFile = fResumeFile;
+        fResumeFile = "";
+        if(!ReadCheckpoint(resumeFile, tag, configuration))
+        {
+            G4Exception("Campaign::BeamOn()", "", JustWarning,
+                        G4String("    Cannot resume from '" + resumeFile + "'; campaign not started.").c_str());
+            return;
+        }
+        G4cout << "Resuming the campaign at event " << fEventOffset << " of " << fNEvents
+               << " from " << resumeFile << G4endl;
+    }
+
+    fActive = true;
+    auto UImanager = G4UImanager::GetUIpointer();
+    while(fEventOffset<fNEvents)
+    {
+        auto nSegmentEvents = static_cast<G4int>(std::min<G4long>(fSegmentSize, fNEvents - fEventOffset));
+        fNSegmentEvents = 0;
+        UImanager->ApplyCommand("/run/beamOn " + G4UIcommand::ConvertToString(nSegmentEvents));
+        fEventOffset += fNSegmentEvents;
+        if(fNSegmentEvents<nSegmentEvents) break;
+
+        if(!WriteCheckpoint(checkpointFile, tag, configuration))
+            G4Exception("Campaign::BeamOn()", "", JustWarning,
+                        G4String("    Cannot write '" + checkpointFile + "'.").c_str());
+    }
+    fActive = false;
+
+    G4cout << "Campaign: " << fEventOffset << " of " << fNEvents << " events, "
+           << fTotal->GetNCoincidences() << " coincidences (rel. error "
+           << fTotal->GetCoincidenceRelativeError() << ")" << G4endl;
+}
+
+void Campaign::EndOfRun(const Run* run)
+{
+    fTotal->Merge(run);
+    fNSegmentEvents = run->GetNEvents();
+}
+
+G4bool Campaign::WriteCheckpoint(const G4String& fileName, const G4String& tag, const G4String& configuration) const
+{
+    std::vector<std::streamoff> dataOffsets, interactionsOffsets;
+    EventAction::GetOutputOffsets(dataOffsets, interactionsOffsets);
+    G4double streamTime;
+    std::vector<std::uintmax_t> streamSizes;
+    PileUpStream::GetStreamState(streamTime, streamSizes);
+    std::ostringstream engineState;
+    G4Random::saveFullState(engineState);
+
+    // Replace the previous checkpoint only once the new one is complete
+    G4String tmpFileName = fileName + ".tmp";
+    {
+        std::ofstream out(tmpFileName, std::ios::binary);
+        out.write(kMagic, sizeof(kMagic));
+        WriteLong(out, fNEvents);
+        WriteLong(out, fEventOffset);
+        WriteString(out, tag);
+        WriteString(out, configuration);
+        WriteLong(out, static_cast<G4long>(dataOffsets.size()));
+        for(std::size_t view = 0; view<dataOffsets.size(); ++view)
+        {
+            WriteLong(out, dataOffsets[view]);
+            WriteLong(out, interactionsOffsets[view]);
+        }
+        out.write(reinterpret_cast<const char*>(&streamTime), sizeof(streamTime));
+        WriteLong(out, static_cast<G4long>(streamSizes.size()));
+        for(auto size: streamSizes) WriteLong(out, static_cast<G4long>(size));
+        WriteString(out, engineState.str());
+        if(!fTotal->Write(out) || !out.flush()) return false;
+    }
+    return std::rename(tmpFileName.c_str(), fileName.c_str())==0;
+}
+
+G4bool Campaign::ReadCheckpoint(const G4String& fileName, const G4String& tag, const G4String& configuration)
+{
+    std::ifstream in(fileName, std::ios::binary);
+    char magic[4];
+    if(!in.read(magic, sizeof(magic)) || std::memcmp(magic, kMagic, sizeof(kMagic))!=0) return false;
+
+    auto nEvents = ReadLong(in);
+    auto eventOffset = ReadLong(in);
+    auto checkpointTag = ReadString(in);
+    auto checkpointConfiguration = ReadString(in);
+    auto nViews = ReadLong(in);
+    if(!in || nViews<=0 || nViews>1024) return false;
+    std::vector<std::streamoff> dataOffsets, interactionsOffsets;
+    for(G4long view = 0; view<nViews; ++view)
+    {
+        dataOffsets.push_back(ReadLong(in));
+        interactionsOffsets.push_back(ReadLong(in));
+    }
+    G4double streamTime = 0.;
+    in.read(reinterpret_cast<char*>(&streamTime), sizeof(streamTime));
+    auto nStreams = ReadLong(in);
+    if(!in || nStreams<0 || nStreams>4096) return false;
+    std::vector<std::uintmax_t> streamSizes;
+    for(G4long stream = 0; stream<nStreams; ++stream)
+        streamSizes.push_back(static_cast<std::uintmax_t>(ReadLong(in)));
+    std::istringstream engineState(ReadString(in));
+    if(!in) return false;
+    if(checkpointTag!=tag || checkpointConfiguration!=configuration)
+    {
+        G4Exception("Campaign::ReadCheckpoint()", "", JustWarning,
+                    G4String("    The checkpoint was written with another configuration:\n    "
+                             + checkpointConfiguration).c_str());
+        return false;
+    }
+    if(nEvents!=fNEvents)
+        G4Exception("Campaign::ReadCheckpoint()", "", JustWarning,
+                    G4String("    Campaign size " + G4UIcommand::ConvertToString(nEvents)
+                             + " of the checkpoint kept.").c_str());
+
+    if(!fTotal->Read(in)) return false;
+    if(!EventAction::ResumeOutput(tag, dataOffsets, interactionsOffsets)) return false;
+    if(!PileUpStream::ResumeStreams(tag, streamTime, streamSizes)) return false;
+    G4Random::restoreFullState(engineState);
+    fNEvents = nEvents;
+    fEventOffset = eventOffset;
+    return true;
+}
@@ -0,0 +1,65 @@
+#include "CampaignMessenger.hh"
+#include "Campaign.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcommand.hh"
+#include "G4UIparameter.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithAnInteger.hh"
+
+#include <sstream>
+
+CampaignMessenger::CampaignMessenger(Campaign* campaign)
+: G4UImessenger(), fCampaign(campaign)
+{
+    fCampaignDir = new G4UIdirectory("/ccTest/campaign/");
+    fCampaignDir->SetGuidance("Long runs split into segments, with a checkpoint after each segment");
+    fCampaignDir->SetGuidance("(resume with ccTest -resume <file>).");
+
+    fCampaignBeamOnCmd = new G4UIcommand("/ccTest/campaign/beamOn", this);
+    fCampaignBeamOnCmd->SetGuidance("Process nEvents (64-bit) as a sequence of /run/beamOn of at most");
+    fCampaignBeamOnCmd->SetGuidance("segmentSize events. Event IDs in the outputs are campaign-wide.");
+    fCampaignBeamOnCmd->SetParameter(new G4UIparameter("nEvents", 's', false));
+    fCampaignBeamOnCmd->AvailableForStates(G4State_Idle);
+    fCampaignBeamOnCmd->SetToBeBroadcasted(false);
+
+    fCampaignSegmentCmd = new G4UIcmdWithAnInteger("/ccTest/campaign/segmentSize", this);
+    fCampaignSegmentCmd->SetGuidance("Events between checkpoints. A resumed campaign reproduces the");
+    fCampaignSegmentCmd->SetGuidance("uninterrupted one only with the same segment size.");
+    fCampaignSegmentCmd->SetParameterName("nEvents", false);
+    fCampaignSegmentCmd->SetRange("nEvents>0");
+    fCampaignSegmentCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fCampaignSegmentCmd->SetToBeBroadcasted(false);
+
+    fCampaignCheckpointCmd = new G4UIcmdWithAString("/ccTest/campaign/checkpointFile", this);
+    fCampaignCheckpointCmd->SetGuidance("Checkpoint file (default: output/checkpoint[_<tag>].dat).");
+    fCampaignCheckpointCmd->SetParameterName("fileName", false);
+    fCampaignCheckpointCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fCampaignCheckpointCmd->SetToBeBroadcasted(false);
+}
+
+CampaignMessenger::~CampaignMessenger()
+{
+    delete fCampaignCheckpointCmd;
+    delete fCampaignSegmentCmd;
+    delete fCampaignBeamOnCmd;
+    delete fCampaignDir;
+}
+
+void CampaignMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+    if(command==fCampaignBeamOnCmd)
+    {
+        std::istringstream iss(newValue);
+        G4long nEvents = 0;
+        if(!(iss >> nEvents) || nEvents<=0)
+            G4Exception("CampaignMessenger::SetNewValue()", "", JustWarning,
+                        G4String("    Invalid number of events '" + newValue + "'.").c_str());
+        else
+            fCampaign->BeamOn(nEvents);
+    }
+    else if(command==fCampaignSegmentCmd)
+        fCampaign->SetSegmentSize(fCampaignSegmentCmd->GetNewIntValue(newValue));
+    else if(command==fCampaignCheckpointCmd)
+        fCampaign->SetCheckpointFile(newValue);
+}
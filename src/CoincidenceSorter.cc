@@ -0,0 +1,70 @@
+#include "CoincidenceSorter.hh"
+
+#include <algorithm>
+
+SinglesMerger::SinglesMerger(const std::vector<std::string>& fileNames)
+: fValid(true)
+{
+    for(const auto& fileName: fileNames)
+    {
+        fReaders.push_back(std::make_unique<SinglesReader>(fileName));
+        fValid = fValid && fReaders.back()->IsValid();
+        Head head;
+        head.stream = fReaders.size() - 1;
+        if(fReaders.back()->Next(head.single)) fHeads.push(head);
+    }
+}
+
+bool SinglesMerger::Next(Single& single)
+{
+    if(fHeads.empty()) return false;
+    Head head = fHeads.top();
+    fHeads.pop();
+    single = head.single;
+    if(fReaders[head.stream]->Next(head.single)) fHeads.push(head);
+    return true;
+}
+
+CoincidenceSorter::CoincidenceSorter(const Settings& settings, Callback callback)
+: fSettings(settings), fCallback(std::move(callback))
+{}
+
+void CoincidenceSorter::Process(const Single& single)
+{
+    if(fCounters.singles==0) fCounters.firstTime = single.time;
+    fCounters.lastTime = single.time;
+    ++fCounters.singles;
+
+    auto deadUntil = fDeadUntil.find(single.detID);
+    if(deadUntil!=fDeadUntil.end() && single.time<deadUntil->second)
+    {
+        ++fCounters.deadTimeLosses;
+        if(fSettings.paralyzable) deadUntil->second = single.time + fSettings.deadTime;
+        return;
+    }
+    fDeadUntil[single.detID] = single.time + fSettings.deadTime;
+
+    if(!fWindow.empty() && single.time - fWindow.front().time>fSettings.window) CloseWindow();
+    fWindow.push_back(single);
+}
+
+void CoincidenceSorter::CloseWindow()
+{
+    if(fWindow.size()>=2)
+    {
+        std::vector<std::int32_t> detIDs;
+        for(const auto& single: fWindow) detIDs.push_back(single.detID);
+        std::sort(detIDs.begin(), detIDs.end());
+        auto nDetectors = std::unique(detIDs.begin(), detIDs.end()) - detIDs.begin();
+        if(nDetectors>=2)
+        {
+            bool trueCoincidence = std::all_of(fWindow.begin(), fWindow.end(), [this](const Single& single)
+                                               { return single.eventID==fWindow.front().eventID; });
+            ++fCounters.coincidences;
+            if(trueCoincidence) ++fCounters.trueCoincidences;
+            if(nDetectors>2) ++fCounters.multipleCoincidences;
+            if(fCallback) fCallback(fWindow, trueCoincidence);
+        }
+    }
+    fWindow.clear();
+}
@@ -0,0 +1,51 @@
+#include "ComptonBiasingMessenger.hh"
+#include "ComptonBiasingOperator.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithADouble.hh"
+#include "G4UIcmdWithABool.hh"
+
+ComptonBiasingMessenger::ComptonBiasingMessenger()
+: G4UImessenger()
+{
+    fBiasDir = new G4UIdirectory("/ccTest/bias/");
+    fBiasDir->SetGuidance("Compton biasing in the scatter detector (needs ccTest -b 1).");
+
+    fBiasCmd = new G4UIcmdWithABool("/ccTest/bias/enable", this);
+    fBiasCmd->SetGuidance("Raise the Compton cross-section of photons in the scatter detector; event");
+    fBiasCmd->SetGuidance("weights compensate. Each run prints its coincidence figure of merit and,");
+    fBiasCmd->SetGuidance("when biased, the gain over the last analog run. Needs ccTest -b 1.");
+    fBiasCmd->SetParameterName("enable", true);
+    fBiasCmd->SetDefaultValue(true);
+    fBiasCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fBiasCmd->SetToBeBroadcasted(false);
+
+    fInteractionProbabilityCmd = new G4UIcmdWithADouble("/ccTest/bias/interactionProbability", this);
+    fInteractionProbabilityCmd->SetGuidance("Target probability of a Compton interaction along the chord through");
+    fInteractionProbabilityCmd->SetGuidance("the scatter detector (never below the analog one).");
+    fInteractionProbabilityCmd->SetParameterName("p", false);
+    fInteractionProbabilityCmd->SetRange("p>0. && p<1.");
+    fInteractionProbabilityCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fInteractionProbabilityCmd->SetToBeBroadcasted(false);
+}
+
+ComptonBiasingMessenger::~ComptonBiasingMessenger()
+{
+    delete fInteractionProbabilityCmd;
+    delete fBiasCmd;
+    delete fBiasDir;
+}
+
+void ComptonBiasingMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+    if(command==fBiasCmd)
+    {
+        G4bool enable = fBiasCmd->GetNewBoolValue(newValue);
+        if(enable && !ComptonBiasingOperator::IsPhysicsRegistered())
+            G4Exception("ComptonBiasingMessenger::SetNewValue()", "", JustWarning,
+                        "    Biasing needs the generic biasing physics (ccTest -b 1); transport stays analog.");
+        else ComptonBiasingOperator::SetEnabled(enable);
+    }
+    else if(command==fInteractionProbabilityCmd)
+        ComptonBiasingOperator::SetInteractionProbability(fInteractionProbabilityCmd->GetNewDoubleValue(newValue));
+}
@@ -0,0 +1,85 @@
+#include "ComptonBiasingOperator.hh"
+
+#include "G4BiasingProcessInterface.hh"
+#include "G4BiasingProcessSharedData.hh"
+#include "G4BOptnChangeCrossSection.hh"
+#include "G4Gamma.hh"
+#include "G4NavigationHistory.hh"
+#include "G4ProcessManager.hh"
+#include "G4Track.hh"
+#include "G4VSolid.hh"
+#include "geomdefs.hh"
+
+#include <cfloat>
+#include <cmath>
+
+G4bool ComptonBiasingOperator::fEnabled = false;
+G4bool ComptonBiasingOperator::fPhysicsRegistered = false;
+G4double ComptonBiasingOperator::fInteractionProbability = 0.5;
+
+ComptonBiasingOperator::ComptonBiasingOperator()
+: G4VBiasingOperator("ComptonBiasingOperator"), fGamma(G4Gamma::Definition())
+{}
+
+ComptonBiasingOperator::~ComptonBiasingOperator()
+{
+    for(auto& operation: fChangeCrossSectionOperations) delete operation.second;
+}
+
+void ComptonBiasingOperator::StartRun()
+{
+    if(!fChangeCrossSectionOperations.empty()) return;
+
+    auto sharedData = G4BiasingProcessInterface::GetSharedData(fGamma->GetProcessManager());
+    if(!sharedData) return; // no biasing physics
+    for(auto wrapperProcess: sharedData->GetPhysicsBiasingProcessInterfaces())
+        if(wrapperProcess->GetWrappedProcess()->GetProcessName()=="compt")
+            fChangeCrossSectionOperations[wrapperProcess] = new G4BOptnChangeCrossSection("BiasedCompt");
+}
+
+G4VBiasingOperation* ComptonBiasingOperator::ProposeOccurenceBiasingOperation(const G4Track* track,
+                                                                            const G4BiasingProcessInterface* callingProcess)
+{
+    if(!fEnabled || track->GetDefinition()!=fGamma) return nullptr;
+
+    auto itr = fChangeCrossSectionOperations.find(callingProcess);
+    if(itr==fChangeCrossSectionOperations.end()) return nullptr;
+    auto operation = itr->second;
+
+    G4double analogInteractionLength = callingProcess->GetWrappedProcess()->GetCurrentInteractionLength();
+    if(analogInteractionLength>DBL_MAX/10.) return nullptr;
+    G4double analogXS = 1./analogInteractionLength;
+
+    // Remaining chord through the current volume along the flight direction
+    auto touchable = track->GetTouchable();
+    const auto& globalToLocal = touchable->GetHistory()->GetTopTransform();
+    G4double chord = touchable->GetSolid()->DistanceToOut(globalToLocal.TransformPoint(track->GetPosition()),
+                                                         globalToLocal.TransformAxis(track->GetMomentumDirection()));
+    G4double biasedXS = analogXS;
+    if(chord>0. && chord<kInfinity)
+        biasedXS = std::max(analogXS, -std::log(1. - fInteractionProbability)/chord);
+
+    auto previousOperation = callingProcess->GetPreviousOccurenceBiasingOperation();
+    if(previousOperation!=operation || operation->GetInteractionOccured())
+    {
+        operation->SetBiasedCrossSection(biasedXS);
+        operation->Sample();
+    }
+    else
+    {
+        operation->UpdateForStep(callingProcess->GetPreviousStepSize());
+        operation->SetBiasedCrossSection(biasedXS);
+        operation->UpdateForStep(0.);
+    }
+
+    return operation;
+}
+
+void ComptonBiasingOperator::OperationApplied(const G4BiasingProcessInterface* callingProcess, G4BiasingAppliedCase,
+                                              G4VBiasingOperation* occurenceOperationApplied, G4double,
+                                              G4VBiasingOperation*, const G4VParticleChange*)
+{
+    auto itr = fChangeCrossSectionOperations.find(callingProcess);
+    if(itr!=fChangeCrossSectionOperations.end() && itr->second==occurenceOperationApplied)
+        itr->second->SetInteractionOccured();
+}
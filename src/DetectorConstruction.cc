@@ -1,10 +1,21 @@
 #include "DetectorConstruction.hh"
 #include "LACCBuilder.hh"
 #include "TestCCBuilder.hh"
+#include "PixelatedCCBuilder.hh"
 #include "SpentFuelAssemblyBuilder.hh"
 #include "CCSensitiveDetector.hh"
+#include "LeakageDetector.hh"
+#include "DetectorMessenger.hh"
+#include "CCSensitiveDetectorMessenger.hh"
+#include "LACCMessenger.hh"
+#include "ComptonBiasingMessenger.hh"
+#include "ParameterScan.hh"
+#include "ComptonBiasingOperator.hh"
+#include "ScreeningScene.hh"
 
 #include "G4Box.hh"
+#include "G4EmCalculator.hh"
+#include "G4Gamma.hh"
 #include "G4Tubs.hh"
 
 #include "G4LogicalVolume.hh"
@@ -12,18 +23,85 @@
 #include "G4VisAttributes.hh"
 
 #include "G4PVPlacement.hh"
+#include "G4UIcommand.hh"
+#include "G4UImanager.hh"
+#include "G4StateManager.hh"
 
 #include "G4SDManager.hh"
 
+#include "G4GeometryManager.hh"
+#include "G4PhysicalVolumeStore.hh"
+#include "G4LogicalVolumeStore.hh"
+#include "G4SolidStore.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+namespace
+{
+    G4ThreadLocal ComptonBiasingOperator* comptonBiasingOperator = nullptr;
+
+    // Separating axis test of two boxes (centre, rotation, half sizes);
+    // touching boxes do not overlap
+    G4bool BoxesOverlap(const G4ThreeVector& centreA, const G4RotationMatrix& rotationA, const G4ThreeVector& halfA,
+                        const G4ThreeVector& centreB, const G4RotationMatrix& rotationB, const G4ThreeVector& halfB)
+    {
+        const G4ThreeVector axesA[3] = {rotationA.colX(), rotationA.colY(), rotationA.colZ()};
+        const G4ThreeVector axesB[3] = {rotationB.colX(), rotationB.colY(), rotationB.colZ()};
+        std::vector<G4ThreeVector> axes(axesA, axesA + 3);
+        axes.insert(axes.end(), axesB, axesB + 3);
+        for(const auto& a: axesA)
+            for(const auto& b: axesB)
+            {
+                auto axis = a.cross(b);
+                if(axis.mag2()>1.e-12) axes.push_back(axis.unit());
+            }
+        auto distance = centreB - centreA;
+        for(const auto& axis: axes)
+        {
+            G4double radiusA = 0., radiusB = 0.;
+            for(G4int i = 0; i<3; ++i)
+            {
+                radiusA += halfA[i]*std::abs(axesA[i].dot(axis));
+                radiusB += halfB[i]*std::abs(axesB[i].dot(axis));
+            }
+            if(std::abs(distance.dot(axis))>=radiusA + radiusB - 1.*nm) return false;
+        }
+        return true;
+    }
+}
+
 DetectorConstruction::DetectorConstruction()
-: G4VUserDetectorConstruction()
-{}
+: G4VUserDetectorConstruction(),
+  fCameraType("TestCC1"), fSc2AbDistance(-1.), fFuelRodRatio(1.), fNAssemblies(1), fHomogenized(false), fWorldPV(nullptr)
+{
+    fEnvelopes.sc2AbDistance = 0.;
+    fEnvelopes.nAssemblies = 0;
+    fMessenger = std::make_unique<DetectorMessenger>(this);
+    fSDMessenger = std::make_unique<CCSensitiveDetectorMessenger>();
+    fLACCMessenger = std::make_unique<LACCMessenger>(this);
+    fBiasingMessenger = std::make_unique<ComptonBiasingMessenger>();
+    fParameterScan = std::make_unique<ParameterScan>(this);
+}
 
 DetectorConstruction::~DetectorConstruction()
 {}
 
 G4VPhysicalVolume* DetectorConstruction::Construct()
 {
+    // Rebuild (/run/reinitializeGeometry): drop the previous geometry
+    if(fWorldPV)
+    {
+        G4GeometryManager::GetInstance()->OpenGeometry();
+        G4PhysicalVolumeStore::GetInstance()->Clean();
+        G4LogicalVolumeStore::GetInstance()->Clean();
+        G4SolidStore::GetInstance()->Clean();
+        ComptonCameraStore::GetInstance()->clear();
+        SpentFuelAssemblyStore::GetInstance()->clear();
+        fCCs.clear();
+    }
+
     // World
     G4double worldSize = 10.*m;
     auto worldSol = new G4Box("World", 0.5*worldSize, 0.5*worldSize, 0.5*worldSize);
@@ -33,11 +111,11 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
     worldVA->SetForceWireframe(true);
     worldLV->SetVisAttributes(worldVA);
     auto worldPV = new G4PVPlacement(nullptr, G4ThreeVector(), worldLV, "World", nullptr, false, 0);
+    fWorldPV = worldPV;
 
     // Spent Fuel Assembly
-    auto spentFuelAssembly = new SpentFuelAssembly("SpentFuelAssembly", nistAir);
-    spentFuelAssembly->SetFuelRodStatus(1.);
-    spentFuelAssembly->PrintFuelRodStatus(G4cout);
+    auto spentFuelAssembly = new SpentFuelAssembly("SpentFuelAssembly", nistAir, 16, 16, 1.285*cm, fHomogenized);
+    spentFuelAssembly->SetFuelRodStatus(fFuelRodRatio);
     G4double spentFuelAssemblySurfaceDistance = 10.*cm;
 //    G4double spentFuelAssemblyLength =
 //            2*static_cast<G4Box*>(spentFuelAssembly->GetLogicalVolume()->GetSolid())->GetYHalfLength();
@@ -46,21 +124,87 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
 //                      spentFuelAssembly->GetLogicalVolume(), "SpentFuelAssembly", worldLV, false, 0);
     G4double spentFuelAssemblyHeight =
             2*static_cast<G4Box*>(spentFuelAssembly->GetLogicalVolume()->GetSolid())->GetZHalfLength();
-    new G4PVPlacement(G4Transform3D(G4RotationMatrix(),
-                                    G4ThreeVector(0., 0., spentFuelAssemblySurfaceDistance + spentFuelAssemblyHeight/2.)),
-                      spentFuelAssembly->GetLogicalVolume(), "SpentFuelAssembly", worldLV, false, 0);
-
-    // TestCC1
-    fCC = std::make_shared<TestCC1>("TestCC1", 5.*cm);
-    G4double CCHeight = 2*static_cast<G4Box*>(fCC->GetLogicalVolume()->GetSolid())->GetZHalfLength();
-    new G4PVPlacement(nullptr, G4ThreeVector(0., 0., -CCHeight/2),
-                      fCC->GetLogicalVolume(), "ComptonCamera", worldLV, false, 0);
-
-//    // LACC
-//    fCC = std::make_shared<LACC>("LACC");
-//    G4double laccHeight = 2*static_cast<G4Box*>(fCC->GetLogicalVolume()->GetSolid())->GetZHalfLength();
-//    new G4PVPlacement(nullptr, G4ThreeVector(0., 0., -laccHeight/2),
-//                      fCC->GetLogicalVolume(), "ComptonCamera", worldLV, false, 0);
+    G4ThreeVector spentFuelAssemblyTranslation(0., 0., spentFuelAssemblySurfaceDistance + spentFuelAssemblyHeight/2.);
+    fEnvelopes.sourceCentre = spentFuelAssemblyTranslation;
+    if(fNAssemblies<=1)
+    {
+        auto assemblySol = static_cast<G4Box*>(spentFuelAssembly->GetLogicalVolume()->GetSolid());
+        fEnvelopes.sourceHalfSize.set(assemblySol->GetXHalfLength(), assemblySol->GetYHalfLength(),
+                                      assemblySol->GetZHalfLength());
+        new G4PVPlacement(G4Transform3D(G4RotationMatrix(), spentFuelAssemblyTranslation),
+                          spentFuelAssembly->GetLogicalVolume(), "SpentFuelAssembly", worldLV, false, 0);
+        spentFuelAssembly->SetPlacement(G4RotationMatrix(), spentFuelAssemblyTranslation);
+    }
+    else
+    {
+        // Cask basket: the assemblies are daughters of one basket volume, so
+        // the world holds a single volume and the basket is voxelized over
+        // its cells; a step looks at the few candidates of its voxel, not at
+        // every assembly.
+        G4double assemblyHalfWidth = static_cast<G4Box*>(spentFuelAssembly->GetLogicalVolume()->GetSolid())->GetXHalfLength();
+        G4double basketPitch = 2.*assemblyHalfWidth + 2.*cm; // cell wall and clearance
+        auto basketPositions = BasketPositions(fNAssemblies, basketPitch);
+        G4double basketHalfWidth = 0.;
+        for(const auto& position: basketPositions)
+            basketHalfWidth = std::max({basketHalfWidth, std::abs(position.x()), std::abs(position.y())});
+        basketHalfWidth += basketPitch/2.;
+        auto basketSol = new G4Box("Basket", basketHalfWidth, basketHalfWidth, spentFuelAssemblyHeight/2.);
+        fEnvelopes.sourceHalfSize.set(basketHalfWidth, basketHalfWidth, spentFuelAssemblyHeight/2.);
+        auto basketLV = new G4LogicalVolume(basketSol, nistAir, "Basket");
+        basketLV->SetVisAttributes(G4VisAttributes::GetInvisible());
+        new G4PVPlacement(nullptr, spentFuelAssemblyTranslation, basketLV, "Basket", worldLV, false, 0);
+
+        for(G4int i = 0; i<fNAssemblies; ++i)
+        {
+            // One SpentFuelAssembly per cell, for its own rod status
+            auto assembly = (i==0) ? spentFuelAssembly : new SpentFuelAssembly("SpentFuelAssembly", nistAir, 16, 16, 1.285*cm, fHomogenized);
+            if(i>0) assembly->SetFuelRodStatus(fFuelRodRatio);
+            const auto& position = basketPositions[static_cast<std::size_t>(i)];
+            new G4PVPlacement(nullptr, position, assembly->GetLogicalVolume(), "SpentFuelAssembly", basketLV, false, i);
+            assembly->SetPlacement(G4RotationMatrix(), spentFuelAssemblyTranslation + position);
+        }
+    }
+    auto spentFuelAssemblyStore = SpentFuelAssemblyStore::GetInstance();
+    spentFuelAssemblyStore->Update();
+    spentFuelAssemblyStore->PrintFuelRodStatus(G4cout);
+
+    // Compton cameras. The camera of view 0 gives the size of all of them;
+    // the added views are checked before any of them is built. A view that
+    // would overlap the assemblies, the basket or another camera (added
+    // before initialization, or since then moved into by a larger camera or
+    // basket) is not built and its readout stays empty, until the
+    // configuration is changed.
+    auto cc0 = CreateCamera("");
+    auto cameraSol = static_cast<G4Box*>(cc0->GetLogicalVolume()->GetSolid());
+    new G4PVPlacement(nullptr, G4ThreeVector(0., 0., -cameraSol->GetZHalfLength()),
+                      cc0->GetLogicalVolume(), "ComptonCamera", worldLV, false, 0);
+    fEnvelopes.cameraType = fCameraType;
+    fEnvelopes.sc2AbDistance = fSc2AbDistance;
+    fEnvelopes.nAssemblies = fNAssemblies;
+    fEnvelopes.cameraHalfSize.set(cameraSol->GetXHalfLength(), cameraSol->GetYHalfLength(), cameraSol->GetZHalfLength());
+
+    std::vector<std::pair<G4int, G4ThreeVector>> builtViews;
+    for(G4int view = 1; view<GetNViews(); ++view)
+    {
+        const auto& position = fViewPositions[static_cast<std::size_t>(view - 1)];
+        G4String overlap = CheckViewOverlap(position, builtViews);
+        if(overlap.empty()) builtViews.emplace_back(view, position);
+        else
+            G4Exception("DetectorConstruction::Construct()", "", JustWarning,
+                        G4String("    View " + G4UIcommand::ConvertToString(view) + " at ("
+                                 + G4UIcommand::ConvertToString(position/mm) + ") mm overlaps " + overlap
+                                 + "; not built (move it, or /ccTest/det/clearViews).").c_str());
+    }
+    fCCs.assign(static_cast<std::size_t>(GetNViews()), nullptr);
+    fCCs[0] = cc0;
+    for(const auto& builtView: builtViews)
+    {
+        G4int view = builtView.first;
+        auto cc = CreateCamera("_view" + G4UIcommand::ConvertToString(view));
+        new G4PVPlacement(G4Transform3D(GetViewRotation(builtView.second), builtView.second),
+                          cc->GetLogicalVolume(), "ComptonCamera", worldLV, false, view);
+        fCCs[static_cast<std::size_t>(view)] = cc;
+    }
 
 //    // Tungsten shield
 //    G4double shieldWidth = 30.*cm, shieldLength = 30.*cm, shieldHeight = 5.*cm;
@@ -77,10 +221,248 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
 
 void DetectorConstruction::ConstructSDandField()
 {
-    auto sd_Det = new CCSensitiveDetector("LACC");
-    G4SDManager::GetSDMpointer()->AddNewDetector(sd_Det);
-//    SetSensitiveDetector(std::static_pointer_cast<LAScintDet>(std::static_pointer_cast<SimpleScAbCC>(fCC)->GetScatter())->GetCrystalLV(), sd_Det);
-//    SetSensitiveDetector(std::static_pointer_cast<LAScintDet>(std::static_pointer_cast<SimpleScAbCC>(fCC)->GetAbsorber())->GetCrystalLV(), sd_Det);
-    SetSensitiveDetector(std::static_pointer_cast<SimpleScAbCC>(fCC)->GetScatter()->GetLogicalVolume(), sd_Det);
-    SetSensitiveDetector(std::static_pointer_cast<SimpleScAbCC>(fCC)->GetAbsorber()->GetLogicalVolume(), sd_Det);
+    // One operator per thread, reattached after each rebuild
+    if(!comptonBiasingOperator) comptonBiasingOperator = new ComptonBiasingOperator();
+
+    // The detectors survive geometry rebuilds; only the volumes are reattached
+    auto sdManager = G4SDManager::GetSDMpointer();
+    for(std::size_t view = 0; view<fCCs.size(); ++view)
+    {
+        const auto& cc = fCCs[view];
+        if(!cc) continue;
+        G4String readoutName = GetReadoutName(static_cast<G4int>(view));
+        auto sd_Det = static_cast<CCSensitiveDetector*>(sdManager->FindSensitiveDetector(readoutName, false));
+        if(!sd_Det)
+        {
+            sd_Det = new CCSensitiveDetector(readoutName);
+            sdManager->AddNewDetector(sd_Det);
+        }
+        sd_Det->SetReplicaDepth(0);
+        sd_Det->SetSegmentedReadout(false);
+        sd_Det->SetLightCollection(false);
+
+        G4LogicalVolume* scatterLV;
+        G4LogicalVolume* absorberLV;
+        if(auto pixelatedCC = std::dynamic_pointer_cast<PixelatedCC>(cc))
+        {
+            sd_Det->SetSegmentedReadout(true);
+            scatterLV = std::static_pointer_cast<PixelatedDetector>(pixelatedCC->GetScatter())->GetPixelLV();
+            absorberLV = std::static_pointer_cast<PixelatedDetector>(pixelatedCC->GetAbsorber())->GetPixelLV();
+        }
+        else if(auto lacc = std::dynamic_pointer_cast<LACC>(cc))
+        {
+            sd_Det->SetReplicaDepth(3); // Crystal < PaintSide < FrontHousing < Scatter/Absorber
+            sd_Det->SetLightCollection(true);
+            scatterLV = std::static_pointer_cast<LAScintDet>(lacc->GetScatter())->GetCrystalLV();
+            absorberLV = std::static_pointer_cast<LAScintDet>(lacc->GetAbsorber())->GetCrystalLV();
+        }
+        else
+        {
+            scatterLV = std::static_pointer_cast<SimpleScAbCC>(cc)->GetScatter()->GetLogicalVolume();
+            absorberLV = std::static_pointer_cast<SimpleScAbCC>(cc)->GetAbsorber()->GetLogicalVolume();
+        }
+        SetSensitiveDetector(scatterLV, sd_Det);
+        SetSensitiveDetector(absorberLV, sd_Det);
+
+        // Compton biasing in the scatter detectors (effective only with
+        // biasing physics, see ccTest -b); occurrence biasing stays unbiased
+        // wherever it is applied.
+        comptonBiasingOperator->AttachTo(scatterLV);
+    }
+
+    // Photons leaving the assemblies (/ccTest/det/validateHomogenized)
+    if(LeakageDetector::IsEnabled())
+    {
+        auto sd_Leakage = sdManager->FindSensitiveDetector("Leakage", false);
+        if(!sd_Leakage)
+        {
+            sd_Leakage = new LeakageDetector("Leakage");
+            sdManager->AddNewDetector(sd_Leakage);
+        }
+        for(const auto& assembly: *SpentFuelAssemblyStore::GetInstance())
+            for(auto volume: assembly->GetLogicalVolumes())
+                SetSensitiveDetector(volume, sd_Leakage);
+    }
+}
+
+void DetectorConstruction::ReinitializeGeometry() const
+{
+    if(G4StateManager::GetStateManager()->GetCurrentState()!=G4State_PreInit)
+        G4UImanager::GetUIpointer()->ApplyCommand("/run/reinitializeGeometry");
+}
+
+G4String DetectorConstruction::GetReadoutName(G4int view)
+{
+    return (view==0) ? G4String("LACC") : G4String("LACC_view" + G4UIcommand::ConvertToString(view));
+}
+
+std::shared_ptr<ComptonCamera> DetectorConstruction::CreateCamera(const G4String& suffix) const
+{
+    if(fCameraType=="LACC")
+        return std::make_shared<LACC>("LACC" + suffix, 2.*cm, 3.*cm, (fSc2AbDistance<0.) ? 25.*cm : fSc2AbDistance);
+    if(fCameraType=="PixelatedCC") // 2x(32x32) GAGG pixels
+        return std::make_shared<PixelatedCC>("PixelatedCC" + suffix, (fSc2AbDistance<0.) ? 5.*cm : fSc2AbDistance);
+    return std::make_shared<TestCC1>("TestCC1" + suffix, (fSc2AbDistance<0.) ? 5.*cm : fSc2AbDistance);
+}
+
+G4RotationMatrix DetectorConstruction::GetViewRotation(const G4ThreeVector& position) const
+{
+    // Rotate the camera axis (+z, towards the source) onto the view direction
+    auto direction = (fEnvelopes.sourceCentre - position).unit();
+    G4RotationMatrix rotation;
+    if(direction.z()<-1. + 1.e-12) rotation.rotateX(180.*deg);
+    else if(direction.z()<1. - 1.e-12)
+        rotation = G4RotationMatrix(G4ThreeVector(0., 0., 1.).cross(direction).unit(), std::acos(direction.z()));
+    return rotation;
+}
+
+G4String DetectorConstruction::CheckViewOverlap(const G4ThreeVector& position,
+                                                const std::vector<std::pair<G4int, G4ThreeVector>>& views) const
+{
+    const auto& cameraHalfSize = fEnvelopes.cameraHalfSize;
+    auto rotation = GetViewRotation(position);
+    if(BoxesOverlap(position, rotation, cameraHalfSize,
+                    fEnvelopes.sourceCentre, G4RotationMatrix(), fEnvelopes.sourceHalfSize))
+        return (fEnvelopes.nAssemblies>1) ? "the basket" : "the assembly";
+    if(BoxesOverlap(position, rotation, cameraHalfSize,
+                    G4ThreeVector(0., 0., -cameraHalfSize.z()), G4RotationMatrix(), cameraHalfSize))
+        return "the camera of view 0";
+    for(const auto& view: views)
+        if(BoxesOverlap(position, rotation, cameraHalfSize, view.second, GetViewRotation(view.second), cameraHalfSize))
+            return "the camera of view " + G4UIcommand::ConvertToString(view.first);
+    return "";
+}
+
+G4String DetectorConstruction::CheckView(const G4ThreeVector& position) const
+{
+    if(fEnvelopes.cameraType!=fCameraType || fEnvelopes.sc2AbDistance!=fSc2AbDistance ||
+       fEnvelopes.nAssemblies!=fNAssemblies)
+        return "";
+
+    std::vector<std::pair<G4int, G4ThreeVector>> views;
+    for(std::size_t i = 0; i<fViewPositions.size(); ++i)
+        views.emplace_back(static_cast<G4int>(i) + 1, fViewPositions[i]);
+    return CheckViewOverlap(position, views);
+}
+
+G4String DetectorConstruction::GetConfiguration() const
+{
+    std::ostringstream oss;
+    oss << "camera=" << fCameraType
+        << " sc2abDistance=";
+    if(fSc2AbDistance<0.) oss << "default";
+    else oss << fSc2AbDistance/mm << "mm";
+    oss << " fuelRodRatio=" << fFuelRodRatio;
+    if(fNAssemblies>1) oss << " nAssemblies=" << fNAssemblies;
+    if(fHomogenized) oss << " homogenized=1";
+    if(fCameraType=="LACC") oss << " extrudedSolids=" << LAScintDet::GetExtrudedSolids();
+    for(const auto& position: fViewPositions)
+        oss << " view=(" << position.x()/mm << "," << position.y()/mm << "," << position.z()/mm << ")mm";
+    return oss.str();
+}
+
+std::vector<G4ThreeVector> DetectorConstruction::BasketPositions(G4int n, G4double pitch)
+{
+    // Smallest grid holding n cells; one size up if that keeps the removed
+    // cells symmetric over the four corners
+    auto m = static_cast<G4int>(std::ceil(std::sqrt(static_cast<G4double>(n)) - 1.e-9));
+    if((m*m - n)%4!=0 && ((m + 1)*(m + 1) - n)%4==0) ++m;
+
+    std::vector<G4ThreeVector> cells;
+    for(G4int j = 0; j<m; ++j)
+        for(G4int i = 0; i<m; ++i)
+            cells.emplace_back((i - (m - 1)/2.)*pitch, (j - (m - 1)/2.)*pitch, 0.);
+    std::stable_sort(cells.begin(), cells.end(), [](const G4ThreeVector& a, const G4ThreeVector& b)
+    { return a.perp2()<b.perp2() - 1.e-6; });
+    cells.resize(static_cast<std::size_t>(n));
+
+    // Basket order: row by row
+    std::sort(cells.begin(), cells.end(), [](const G4ThreeVector& a, const G4ThreeVector& b)
+    { return (std::abs(a.y() - b.y())>1.e-6) ? a.y()<b.y() : a.x()<b.x(); });
+    return cells;
+}
+
+G4bool DetectorConstruction::ExportScreeningScene(const G4String& fileName, G4double energy) const
+{
+    auto spentFuelAssemblyStore = SpentFuelAssemblyStore::GetInstance();
+    if(!fWorldPV || spentFuelAssemblyStore->empty()) return false;
+    if(fHomogenized)
+    {
+        G4Exception("DetectorConstruction::ExportScreeningScene()", "", JustWarning,
+                    "    The screening scene needs the explicit rod lattice.");
+        return false;
+    }
+
+    // Attenuation as in the next-event estimator (Rayleigh scattering taken
+    // as straight-through)
+    G4EmCalculator emCalculator;
+    auto Attenuation = [&](const G4Material* material)
+    {
+        G4double mu = 0.;
+        for(const char* process: {"compt", "phot", "conv"})
+            mu += emCalculator.ComputeCrossSectionPerVolume(energy, G4Gamma::Definition(), process, material);
+        return mu*mm;
+    };
+    auto ToVector = [](const G4ThreeVector& v) { return ScreeningScene::Vector{v.x()/mm, v.y()/mm, v.z()/mm}; };
+    auto ToDirection = [](const G4ThreeVector& v) { return ScreeningScene::Vector{v.x(), v.y(), v.z()}; };
+
+    ScreeningScene scene;
+    scene.energy = energy/keV;
+    scene.muWorld = Attenuation(fWorldPV->GetLogicalVolume()->GetMaterial());
+    const auto& front = spentFuelAssemblyStore->front();
+    scene.muSurrounding = Attenuation(front->GetLogicalVolume()->GetMaterial());
+    auto rodVolumes = front->GetFuelRod()->GetLogicalVolumes(); // cladding, gap, pellet
+    auto cladding = static_cast<G4Tubs*>(rodVolumes[0]->GetSolid());
+    scene.rod.claddingRadius = cladding->GetRMax()/mm;
+    scene.rod.gapRadius = static_cast<G4Tubs*>(rodVolumes[1]->GetSolid())->GetRMax()/mm;
+    scene.rod.pelletRadius = static_cast<G4Tubs*>(rodVolumes[2]->GetSolid())->GetRMax()/mm;
+    scene.rod.halfHeight = cladding->GetZHalfLength()/mm;
+    scene.rod.muCladding = Attenuation(rodVolumes[0]->GetMaterial());
+    scene.rod.muGap = Attenuation(rodVolumes[1]->GetMaterial());
+    scene.rod.muPellet = Attenuation(rodVolumes[2]->GetMaterial());
+    scene.axialProfile = spentFuelAssemblyStore->GetAxialProfile();
+
+    for(std::size_t i = 0; i<spentFuelAssemblyStore->size(); ++i)
+    {
+        const auto& assembly = spentFuelAssemblyStore->at(i);
+        auto box = static_cast<G4Box*>(assembly->GetLogicalVolume()->GetSolid());
+        ScreeningScene::Assembly sceneAssembly;
+        sceneAssembly.nx = assembly->GetNX();
+        sceneAssembly.ny = assembly->GetNY();
+        sceneAssembly.interval = assembly->GetInterval()/mm;
+        sceneAssembly.halfSize = {box->GetXHalfLength()/mm, box->GetYHalfLength()/mm, box->GetZHalfLength()/mm};
+        auto origin = assembly->LocalToGlobal(G4ThreeVector());
+        sceneAssembly.axes = {ToDirection(assembly->LocalToGlobal(G4ThreeVector(1., 0., 0.)) - origin),
+                              ToDirection(assembly->LocalToGlobal(G4ThreeVector(0., 1., 0.)) - origin),
+                              ToDirection(assembly->LocalToGlobal(G4ThreeVector(0., 0., 1.)) - origin)};
+        sceneAssembly.translation = ToVector(origin);
+        sceneAssembly.activity = spentFuelAssemblyStore->GetAssemblyActivity(i);
+        sceneAssembly.activeRods = assembly->GetActiveFuelRodIDs();
+        scene.assemblies.push_back(sceneAssembly);
+    }
+
+    // Cameras by view
+    scene.cameras.resize(static_cast<std::size_t>(GetNViews()));
+    for(auto volume: *G4PhysicalVolumeStore::GetInstance())
+    {
+        if(volume->GetName()!="ComptonCamera" || volume->GetCopyNo()<0 || volume->GetCopyNo()>=GetNViews()) continue;
+        G4ThreeVector pMin, pMax;
+        volume->GetLogicalVolume()->GetSolid()->BoundingLimits(pMin, pMax);
+        auto rotation = volume->GetObjectRotationValue();
+        auto& camera = scene.cameras[static_cast<std::size_t>(volume->GetCopyNo())];
+        camera.centre = ToVector(volume->GetObjectTranslation() + rotation*(0.5*(pMin + pMax)));
+        camera.axes = {ToDirection(rotation*G4ThreeVector(1., 0., 0.)), ToDirection(rotation*G4ThreeVector(0., 1., 0.)),
+                       ToDirection(rotation*G4ThreeVector(0., 0., 1.))};
+        camera.halfSize = ToVector(0.5*(pMax - pMin));
+    }
+
+    if(!scene.Write(std::string(fileName)))
+    {
+        G4Exception("DetectorConstruction::ExportScreeningScene()", "", JustWarning,
+                    G4String("    Cannot write '" + fileName + "'.").c_str());
+        return false;
+    }
+    G4cout << "Screening scene at " << energy/keV << " keV (" << scene.GetNRods() << " rods, "
+           << scene.cameras.size() << " views) written to " << fileName << G4endl;
+    return true;
 }
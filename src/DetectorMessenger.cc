@@ -0,0 +1,224 @@
+#include "DetectorMessenger.hh"
+#include "DetectorConstruction.hh"
+#include "LeakageDetector.hh"
+#include "SpentFuelAssemblyBuilder.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcommand.hh"
+#include "G4UIparameter.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithADouble.hh"
+#include "G4UIcmdWithADoubleAndUnit.hh"
+#include "G4UIcmdWith3VectorAndUnit.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "G4UIcmdWithABool.hh"
+#include "G4UIcmdWithoutParameter.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <sstream>
+#include <vector>
+
+DetectorMessenger::DetectorMessenger(DetectorConstruction* detector)
+: G4UImessenger(), fDetector(detector)
+{
+    fCCTestDir = new G4UIdirectory("/ccTest/");
+    fCCTestDir->SetGuidance("ccTest application control.");
+
+    fDetDir = new G4UIdirectory("/ccTest/det/");
+    fDetDir->SetGuidance("Geometry parameters. After initialization, each change rebuilds");
+    fDetDir->SetGuidance("the geometry only (/run/reinitializeGeometry); physics tables are kept.");
+
+    fCameraCmd = new G4UIcmdWithAString("/ccTest/det/camera", this);
+    fCameraCmd->SetGuidance("Compton camera model.");
+    fCameraCmd->SetParameterName("type", false);
+    fCameraCmd->SetCandidates("TestCC1 LACC PixelatedCC");
+    fCameraCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fCameraCmd->SetToBeBroadcasted(false);
+
+    fSc2AbDistanceCmd = new G4UIcmdWithADoubleAndUnit("/ccTest/det/sc2abDistance", this);
+    fSc2AbDistanceCmd->SetGuidance("Scatter-to-absorber distance (negative: camera default).");
+    fSc2AbDistanceCmd->SetParameterName("distance", false);
+    fSc2AbDistanceCmd->SetDefaultUnit("cm");
+    fSc2AbDistanceCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fSc2AbDistanceCmd->SetToBeBroadcasted(false);
+
+    fFuelRodRatioCmd = new G4UIcmdWithADouble("/ccTest/det/fuelRodRatio", this);
+    fFuelRodRatioCmd->SetGuidance("Fraction of active fuel rods (randomly selected).");
+    fFuelRodRatioCmd->SetParameterName("ratio", false);
+    fFuelRodRatioCmd->SetRange("ratio>=0. && ratio<=1.");
+    fFuelRodRatioCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fFuelRodRatioCmd->SetToBeBroadcasted(false);
+
+    fNAssembliesCmd = new G4UIcmdWithAnInteger("/ccTest/det/nAssemblies", this);
+    fNAssembliesCmd->SetGuidance("Number of spent fuel assemblies. Above 1 they fill the central cells");
+    fNAssembliesCmd->SetGuidance("of a square cask basket (e.g. 24 or 32); fuel rod IDs run over all");
+    fNAssembliesCmd->SetGuidance("assemblies (rod + 256*assembly, basket order in output/data.txt).");
+    fNAssembliesCmd->SetParameterName("N", false);
+    fNAssembliesCmd->SetRange("N>=1 && N<=64");
+    fNAssembliesCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fNAssembliesCmd->SetToBeBroadcasted(false);
+
+    fHomogenizedCmd = new G4UIcmdWithABool("/ccTest/det/homogenized", this);
+    fHomogenizedCmd->SetGuidance("Replace the rod lattice of each assembly by one box of the lattice mixture");
+    fHomogenizedCmd->SetGuidance("(fuel, gap, cladding and surrounding material by volume fraction), with");
+    fHomogenizedCmd->SetGuidance("sources uniform over the box. For far-field studies; check the bias with");
+    fHomogenizedCmd->SetGuidance("/ccTest/det/validateHomogenized.");
+    fHomogenizedCmd->SetParameterName("homogenized", true);
+    fHomogenizedCmd->SetDefaultValue(true);
+    fHomogenizedCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fHomogenizedCmd->SetToBeBroadcasted(false);
+
+    fValidateHomogenizedCmd = new G4UIcmdWithAnInteger("/ccTest/det/validateHomogenized", this);
+    fValidateHomogenizedCmd->SetGuidance("Run nEvents with the explicit, then the homogenized assemblies, scoring");
+    fValidateHomogenizedCmd->SetGuidance("the photons leaving the assemblies, and compare the leakage spectra");
+    fValidateHomogenizedCmd->SetGuidance("(bias, chi2 per bin) and the event rates. The spectra are written to");
+    fValidateHomogenizedCmd->SetGuidance("output/leakage.txt; the geometry mode and output tag are restored.");
+    fValidateHomogenizedCmd->SetParameterName("nEvents", false);
+    fValidateHomogenizedCmd->SetRange("nEvents>0");
+    fValidateHomogenizedCmd->AvailableForStates(G4State_Idle);
+    fValidateHomogenizedCmd->SetToBeBroadcasted(false);
+
+    fExportSceneCmd = new G4UIcommand("/ccTest/det/exportScene", this);
+    fExportSceneCmd->SetGuidance("Write the rod lattice, the attenuation at the photon energy, the source and");
+    fExportSceneCmd->SetGuidance("the camera views of the current geometry, for the deterministic screening");
+    fExportSceneCmd->SetGuidance("of placements and diversion patterns with tools/screenPlacements.");
+    auto sceneFileParam = new G4UIparameter("fileName", 's', true);
+    sceneFileParam->SetDefaultValue("output/scene.txt");
+    fExportSceneCmd->SetParameter(sceneFileParam);
+    auto sceneEnergyParam = new G4UIparameter("energy", 'd', true);
+    sceneEnergyParam->SetDefaultValue(661.657);
+    sceneEnergyParam->SetParameterRange("energy>0.");
+    fExportSceneCmd->SetParameter(sceneEnergyParam);
+    auto sceneUnitParam = new G4UIparameter("unit", 's', true);
+    sceneUnitParam->SetDefaultValue("keV");
+    fExportSceneCmd->SetParameter(sceneUnitParam);
+    fExportSceneCmd->AvailableForStates(G4State_Idle);
+    fExportSceneCmd->SetToBeBroadcasted(false);
+
+    fAddViewCmd = new G4UIcmdWith3VectorAndUnit("/ccTest/det/addView", this);
+    fAddViewCmd->SetGuidance("Add a camera view: another camera of the same type centred at the given");
+    fAddViewCmd->SetGuidance("position and facing the centre of the source. Each view has its own");
+    fAddViewCmd->SetGuidance("readout and writes output/data_view<N>.txt (view 0: the camera below).");
+    fAddViewCmd->SetGuidance("A view overlapping the assemblies, the basket or another camera is rejected.");
+    fAddViewCmd->SetGuidance("  e.g. /ccTest/det/addView 100 0 210 cm");
+    fAddViewCmd->SetParameterName("x", "y", "z", false);
+    fAddViewCmd->SetDefaultUnit("cm");
+    fAddViewCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fAddViewCmd->SetToBeBroadcasted(false);
+
+    fClearViewsCmd = new G4UIcmdWithoutParameter("/ccTest/det/clearViews", this);
+    fClearViewsCmd->SetGuidance("Remove the added camera views (keep view 0).");
+    fClearViewsCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fClearViewsCmd->SetToBeBroadcasted(false);
+
+    // Assembly source distribution (the directory: NuclideLineSourceMessenger)
+    fAssemblyActivitiesCmd = new G4UIcommand("/ccTest/source/assemblyActivities", this);
+    fAssemblyActivitiesCmd->SetGuidance("Relative activity of each assembly, in basket order (missing: 1).");
+    fAssemblyActivitiesCmd->SetGuidance("  e.g. /ccTest/source/assemblyActivities 1 0.5 0.5 1");
+    fAssemblyActivitiesCmd->SetParameter(new G4UIparameter("activities", 's', false));
+    fAssemblyActivitiesCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fAssemblyActivitiesCmd->SetToBeBroadcasted(false);
+
+    fAxialProfileCmd = new G4UIcommand("/ccTest/source/axialProfile", this);
+    fAxialProfileCmd->SetGuidance("Relative activity in equal-height axial bins of the fuel, bottom to top");
+    fAxialProfileCmd->SetGuidance("(burnup profile; a single value restores the uniform profile).");
+    fAxialProfileCmd->SetParameter(new G4UIparameter("profile", 's', false));
+    fAxialProfileCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fAxialProfileCmd->SetToBeBroadcasted(false);
+}
+
+DetectorMessenger::~DetectorMessenger()
+{
+    delete fAxialProfileCmd;
+    delete fAssemblyActivitiesCmd;
+    delete fClearViewsCmd;
+    delete fAddViewCmd;
+    delete fExportSceneCmd;
+    delete fValidateHomogenizedCmd;
+    delete fHomogenizedCmd;
+    delete fNAssembliesCmd;
+    delete fFuelRodRatioCmd;
+    delete fSc2AbDistanceCmd;
+    delete fCameraCmd;
+    delete fDetDir;
+    delete fCCTestDir;
+}
+
+void DetectorMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+    if(command==fCameraCmd)
+    {
+        fDetector->SetCameraType(newValue);
+        fDetector->ReinitializeGeometry();
+    }
+    else if(command==fSc2AbDistanceCmd)
+    {
+        fDetector->SetSc2AbDistance(fSc2AbDistanceCmd->GetNewDoubleValue(newValue));
+        fDetector->ReinitializeGeometry();
+    }
+    else if(command==fFuelRodRatioCmd)
+    {
+        fDetector->SetFuelRodRatio(fFuelRodRatioCmd->GetNewDoubleValue(newValue));
+        fDetector->ReinitializeGeometry();
+    }
+    else if(command==fNAssembliesCmd)
+    {
+        fDetector->SetNAssemblies(fNAssembliesCmd->GetNewIntValue(newValue));
+        fDetector->ReinitializeGeometry();
+    }
+    else if(command==fHomogenizedCmd)
+    {
+        fDetector->SetHomogenized(fHomogenizedCmd->GetNewBoolValue(newValue));
+        fDetector->ReinitializeGeometry();
+    }
+    else if(command==fValidateHomogenizedCmd)
+        LeakageDetector::ValidateHomogenized(fDetector, fValidateHomogenizedCmd->GetNewIntValue(newValue));
+    else if(command==fExportSceneCmd)
+    {
+        std::istringstream iss(newValue);
+        G4String fileName, unit;
+        G4double energy;
+        iss >> fileName >> energy >> unit;
+        fDetector->ExportScreeningScene(fileName, energy*G4UIcommand::ValueOf(unit));
+    }
+    else if(command==fAddViewCmd)
+    {
+        auto position = fAddViewCmd->GetNew3VectorValue(newValue);
+        G4String overlap = fDetector->CheckView(position);
+        if(!overlap.empty())
+        {
+            G4Exception("DetectorMessenger::SetNewValue()", "", JustWarning,
+                        G4String("    A view at (" + G4UIcommand::ConvertToString(position/mm) + ") mm would overlap "
+                                 + overlap + "; not added.").c_str());
+            return;
+        }
+        fDetector->AddView(position);
+        fDetector->ReinitializeGeometry();
+    }
+    else if(command==fClearViewsCmd)
+    {
+        fDetector->ClearViews();
+        fDetector->ReinitializeGeometry();
+    }
+    else if(command==fAssemblyActivitiesCmd || command==fAxialProfileCmd)
+    {
+        std::istringstream iss(newValue);
+        std::vector<G4double> values;
+        for(G4double value; iss >> value;)
+        {
+            if(value<0.) break;
+            values.push_back(value);
+        }
+        if(!iss.eof())
+        {
+            G4Exception("DetectorMessenger::SetNewValue()", "", JustWarning,
+                        G4String("    Invalid relative activities '" + newValue + "'.").c_str());
+            return;
+        }
+        auto spentFuelAssemblyStore = SpentFuelAssemblyStore::GetInstance();
+        if(command==fAssemblyActivitiesCmd) spentFuelAssemblyStore->SetAssemblyActivities(values);
+        else spentFuelAssemblyStore->SetAxialProfile((values.size()>1) ? values : std::vector<G4double>());
+        // Before /run/initialize the first Construct() builds the tables
+        if(!spentFuelAssemblyStore->empty()) spentFuelAssemblyStore->Update();
+    }
+}
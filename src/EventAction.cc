@@ -1,6 +1,19 @@
 #include "EventAction.hh"
 #include "CCHit.hh"
+#include "CCInteractionBuffer.hh"
+#include "CCSensitiveDetector.hh"
+#include "Campaign.hh"
+#include "DetectorConstruction.hh"
+#include "EventInformation.hh"
+#include "NextEventEstimator.hh"
+#include "NuclideLineSource.hh"
+#include "PileUpStream.hh"
+#include "Run.hh"
+#include "SimulationService.hh"
+#include "StartupTimer.hh"
+#include "SymmetryFolding.hh"
 #include "SpentFuelAssemblyBuilder.hh"
+#include "SystemMatrix.hh"
 
 #include "G4RunManager.hh"
 #include "G4SDManager.hh"
@@ -8,58 +21,254 @@
 #include "G4SystemOfUnits.hh"
 #include "G4AutoLock.hh"
 
+#include <filesystem>
+
 namespace { G4Mutex aMutex = G4MUTEX_INITIALIZER; }
-std::ofstream EventAction::ofs;
+std::vector<std::ofstream> EventAction::ofs;
+std::vector<std::ofstream> EventAction::ofsInteractions;
+G4String EventAction::fOutputTag;
+G4String EventAction::fOutputDirectory = "output";
+G4String EventAction::fOpenDirectory;
+G4bool EventAction::fWriteFuelRodID = false;
+G4bool EventAction::fWriteLineID = false;
+G4bool EventAction::fWriteMeasurement = false;
+G4bool EventAction::fWriteFolded = false;
 
 EventAction::EventAction()
-: G4UserEventAction(), fCCHCID(-1)
+: G4UserEventAction()
+{}
+
+EventAction::~EventAction()
+{}
+
+void EventAction::OpenOutput(const G4String& tag, const G4String& configuration, G4int nViews)
 {
     G4AutoLock lock(&aMutex);
-    if(!ofs.is_open())
+    auto nuclideLineSource = NuclideLineSource::GetInstance();
+    auto symmetryFolding = SymmetryFolding::GetInstance();
+    if(!ofs.empty() && ofs[0].is_open() && tag==fOutputTag && fOutputDirectory==fOpenDirectory &&
+       ofs.size()==static_cast<std::size_t>(nViews) &&
+       Run::GetBasisMode()==fWriteFuelRodID && nuclideLineSource->IsEnabled()==fWriteLineID &&
+       CCSensitiveDetector::GetLightModelEnabled()==fWriteMeasurement && symmetryFolding->IsActive()==fWriteFolded) return;
+
+    ofs.clear();
+    ofsInteractions.clear();
+    ofs.resize(static_cast<std::size_t>(nViews));
+    ofsInteractions.resize(static_cast<std::size_t>(nViews));
+    fOutputTag = tag;
+    fOpenDirectory = fOutputDirectory;
+    fWriteFuelRodID = Run::GetBasisMode();
+    fWriteLineID = nuclideLineSource->IsEnabled();
+    fWriteMeasurement = CCSensitiveDetector::GetLightModelEnabled();
+    fWriteFolded = symmetryFolding->IsActive();
+
+    for(std::size_t view = 0; view<ofs.size(); ++view)
     {
-        ofs.open("output/data.txt");
-        SpentFuelAssemblyStore::GetInstance()->GetSpentFuelAssembly("SpentFuelAssembly")->PrintFuelRodStatus(ofs);
-        ofs << "# evtID\tParticleWeight\t"
+        auto& out = ofs[view];
+        out.open(GetOutputFileName(GetViewFileName("data", view), tag, ".txt"));
+        out << "# configuration: " << configuration << "\n";
+        if(nViews>1) out << "# view: " << view << "\n";
+        SpentFuelAssemblyStore::GetInstance()->PrintFuelRodStatus(out);
+        if(fWriteLineID) nuclideLineSource->Print(out);
+        if(fWriteFolded)
+        {
+            out << "# symmetry folding, one line per replica:";
+            symmetryFolding->PrintOperations(out);
+            out << "\n";
+        }
+        out << "# evtID\t" << (fWriteFuelRodID ? "FuelRodID\t" : "") << "ParticleWeight\t"
+            << (fWriteLineID ? "LineID\t" : "")
             << "DetID1\tX1(mm)\tY1(mm)\tZ1(mm)\tE1(MeV)\tT1(ns)\t"
-            << "DetID2\tX2(mm)\tY2(mm)\tZ2(mm)\tE2(MeV)\tT2(ns)\t\n";
+            << (fWriteMeasurement ? "XM1(mm)\tYM1(mm)\tZM1(mm)\tEM1(MeV)\t" : "")
+            << "DetID2\tX2(mm)\tY2(mm)\tZ2(mm)\tE2(MeV)\tT2(ns)\t"
+            << (fWriteMeasurement ? "XM2(mm)\tYM2(mm)\tZM2(mm)\tEM2(MeV)\t" : "") << "\n";
     }
 }
 
-EventAction::~EventAction()
+void EventAction::CloseOutput()
 {
     G4AutoLock lock(&aMutex);
-    if(ofs.is_open()) ofs.close();
+    ofs.clear();
+    ofsInteractions.clear();
+}
+
+void EventAction::FlushOutput()
+{
+    G4AutoLock lock(&aMutex);
+    for(auto& out: ofs) out.flush();
+    for(auto& out: ofsInteractions) out.flush();
+}
+
+void EventAction::GetOutputOffsets(std::vector<std::streamoff>& dataOffsets,
+                                   std::vector<std::streamoff>& interactionsOffsets)
+{
+    G4AutoLock lock(&aMutex);
+    dataOffsets.clear();
+    interactionsOffsets.clear();
+    for(auto& out: ofs)
+        dataOffsets.push_back(out.is_open() ? static_cast<std::streamoff>(out.flush().tellp()) : 0);
+    for(auto& out: ofsInteractions)
+        interactionsOffsets.push_back(out.is_open() ? static_cast<std::streamoff>(out.flush().tellp()) : 0);
+}
+
+G4bool EventAction::ResumeOutput(const G4String& tag, const std::vector<std::streamoff>& dataOffsets,
+                                 const std::vector<std::streamoff>& interactionsOffsets)
+{
+    G4AutoLock lock(&aMutex);
+    if(dataOffsets.empty() || interactionsOffsets.size()!=dataOffsets.size()) return false;
+    ofs.clear();
+    ofsInteractions.clear();
+    ofs.resize(dataOffsets.size());
+    ofsInteractions.resize(dataOffsets.size());
+    fOutputTag = tag;
+    fOpenDirectory = fOutputDirectory;
+    fWriteFuelRodID = Run::GetBasisMode();
+    fWriteLineID = NuclideLineSource::GetInstance()->IsEnabled();
+    fWriteMeasurement = CCSensitiveDetector::GetLightModelEnabled();
+    fWriteFolded = SymmetryFolding::GetInstance()->IsActive();
+
+    // Drop whatever was written after the checkpoint
+    for(std::size_t view = 0; view<dataOffsets.size(); ++view)
+    {
+        std::error_code error;
+        std::string dataFileName = GetOutputFileName(GetViewFileName("data", view), tag, ".txt");
+        std::filesystem::resize_file(dataFileName, static_cast<std::uintmax_t>(dataOffsets[view]), error);
+        if(error) return false;
+        ofs[view].open(dataFileName, std::ios::app);
+        if(!ofs[view].is_open()) return false;
+        if(interactionsOffsets[view]>0)
+        {
+            std::string interactionsFileName = GetOutputFileName(GetViewFileName("interactions", view), tag, ".bin");
+            std::filesystem::resize_file(interactionsFileName, static_cast<std::uintmax_t>(interactionsOffsets[view]), error);
+            if(error) return false;
+            ofsInteractions[view].open(interactionsFileName, std::ios::binary | std::ios::app);
+        }
+    }
+    return true;
+}
+
+G4bool EventAction::ContinueOutput(const G4String& tag, G4int nViews)
+{
+    std::vector<std::streamoff> dataOffsets, interactionsOffsets;
+    for(G4int view = 0; view<nViews; ++view)
+    {
+        std::error_code error;
+        auto dataSize = std::filesystem::file_size(
+                    std::string(GetOutputFileName(GetViewFileName("data", view), tag, ".txt")), error);
+        if(error) return false;
+        dataOffsets.push_back(static_cast<std::streamoff>(dataSize));
+        auto interactionsSize = std::filesystem::file_size(
+                    std::string(GetOutputFileName(GetViewFileName("interactions", view), tag, ".bin")), error);
+        interactionsOffsets.push_back(error ? 0 : static_cast<std::streamoff>(interactionsSize));
+    }
+    if(ResumeOutput(tag, dataOffsets, interactionsOffsets)) return true;
+    CloseOutput();
+    return false;
+}
+
+G4String EventAction::GetOutputFileName(const G4String& name, const G4String& tag, const G4String& extension)
+{
+    return fOutputDirectory + "/" + name + (tag.empty() ? G4String() : "_" + tag) + extension;
+}
+
+G4String EventAction::GetViewFileName(const G4String& name, std::size_t view)
+{
+    return (view==0) ? name : G4String(name + "_view" + std::to_string(view));
+}
+
+void EventAction::ResolveReadouts(G4int nViews)
+{
+    auto sdManager = G4SDManager::GetSDMpointer();
+    fReadouts.clear();
+    for(G4int view = 0; view<nViews; ++view)
+    {
+        auto sd = static_cast<CCSensitiveDetector*>(
+                    sdManager->FindSensitiveDetector(DetectorConstruction::GetReadoutName(view), false));
+        fReadouts.push_back({sd ? sd->GetHCID() : -1, sd});
+    }
 }
 
 void EventAction::EndOfEventAction(const G4Event* anEvent)
 {
-    if(fCCHCID==-1)
-        fCCHCID = G4SDManager::GetSDMpointer()->GetCollectionID("LACC/CCData");
+    StartupTimer::GetInstance()->FirstEventDone();
+    SimulationService::GetInstance()->EventDone();
+    NextEventEstimator::GetInstance()->EndOfEvent();
+    // A matrix sweep only tallies its rows (Run)
+    if(SystemMatrix::GetInstance()->IsActive()) return;
+
+    // Collection IDs are looked up only when the number of views changes
+    auto detector = static_cast<const DetectorConstruction*>(
+                G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+    if(fReadouts.size()!=static_cast<std::size_t>(detector->GetNViews())) ResolveReadouts(detector->GetNViews());
 
+    G4long eventID = Campaign::GetInstance()->GetEventOffset() + anEvent->GetEventID();
     auto HCE = anEvent->GetHCofThisEvent();
-    if(!HCE) return;
+    for(std::size_t view = 0; view<fReadouts.size(); ++view)
+    {
+        const auto& readout = fReadouts[view];
+        auto hitsMap = (HCE && readout.hcID>=0) ? static_cast<CCHitsMap*>(HCE->GetHC(readout.hcID)) : nullptr;
+        // Every event advances the arrival time, with or without hits
+        if(view==0 && PileUpStream::IsEnabled()) PileUpStream::AddEvent(eventID, hitsMap);
+
+        if(!hitsMap || hitsMap->entries()==0) continue; // empty HC
+//        if(hitsMap->entries()<2) continue; // coincidence only
+
+        G4double eventWeight = readout.sd->GetEventWeight();
+        auto symmetryFolding = SymmetryFolding::GetInstance();
+        if(symmetryFolding->IsActive())
+            for(const auto& replica: symmetryFolding->Replicate(hitsMap, readout.sd))
+                WriteEvent(view, eventID, anEvent, eventWeight*symmetryFolding->GetWeightFactor(), replica.get(), nullptr);
+        else WriteEvent(view, eventID, anEvent, eventWeight, hitsMap, readout.sd->GetInteractionBuffer());
+    }
+}
 
-    auto hitsMap = static_cast<CCHitsMap*>(HCE->GetHC(fCCHCID));
-    if(hitsMap->entries()==0) return; // empty HC
-//    if(hitsMap->entries()<2) return; // coincidence only
+void EventAction::WriteEvent(std::size_t view, G4long eventID, const G4Event* anEvent, G4double eventWeight,
+                             const CCHitsMap* hitsMap, const CCInteractionBuffer* interactionBuffer)
+{
+    auto eventInformation = static_cast<const EventInformation*>(anEvent->GetUserInformation());
 
     G4AutoLock lock(&aMutex);
-    ofs << anEvent->GetEventID() << "\t";
-    ofs.precision(5);
-    ofs << std::scientific
-        << hitsMap->begin()->second->GetWeight() << "\t";
+    if(view>=ofs.size()) return;
+    auto& out = ofs[view];
+    out << eventID << "\t";
+    if(fWriteFuelRodID) out << (eventInformation ? eventInformation->GetFuelRodID() : -1) << "\t";
+    out.precision(5);
+    out << std::scientific
+        << eventWeight << "\t";
+    if(fWriteLineID) out << (eventInformation ? eventInformation->GetLineID() : -1) << "\t";
     for(const auto& itr: *hitsMap)
     {
-        ofs.precision(1);
-        ofs << itr.first << "\t";
-        ofs << std::fixed
+        out.precision(1);
+        out << itr.first << "\t";
+        out << std::fixed
             << itr.second->GetPosition().x()/mm << "\t"
             << itr.second->GetPosition().y()/mm << "\t"
             << itr.second->GetPosition().z()/mm << "\t";
-        ofs.precision(3);
-        ofs << itr.second->GetDepE()/MeV << "\t"
+        out.precision(3);
+        out << itr.second->GetDepE()/MeV << "\t"
             << itr.second->GetTime()/ns << "\t";
+        if(fWriteMeasurement)
+        {
+            out.precision(1);
+            out << itr.second->GetMeasuredPosition().x()/mm << "\t"
+                << itr.second->GetMeasuredPosition().y()/mm << "\t"
+                << itr.second->GetMeasuredPosition().z()/mm << "\t";
+            out.precision(3);
+            out << itr.second->GetMeasuredDepE()/MeV << "\t";
+        }
     }
-    ofs << "\n";
-}
+    out << "\n";
 
+    // Individual interaction points (interaction mode)
+    if(interactionBuffer && interactionBuffer->GetEntries())
+    {
+        auto& outInteractions = ofsInteractions[view];
+        if(!outInteractions.is_open())
+        {
+            outInteractions.open(GetOutputFileName(GetViewFileName("interactions", view), fOutputTag, ".bin"),
+                                 std::ios::binary);
+            CCInteractionBuffer::WriteFileHeader(outInteractions);
+        }
+        interactionBuffer->Write(outInteractions, eventID, eventWeight);
+    }
+}
@@ -0,0 +1,14 @@
+#include "EventInformation.hh"
+
+EventInformation::EventInformation(G4int fuelRodID, G4int lineID)
+: G4VUserEventInformation(), fFuelRodID(fuelRodID), fLineID(lineID)
+{}
+
+EventInformation::~EventInformation()
+{}
+
+void EventInformation::Print() const
+{
+    G4cout << "    source fuel rod: " << fFuelRodID << G4endl;
+    if(fLineID>=0) G4cout << "    gamma line: " << fLineID << G4endl;
+}
@@ -0,0 +1,88 @@
+#include "EventSeeder.hh"
+#include "EventSeederMessenger.hh"
+
+#include "Randomize.hh"
+
+#include <chrono>
+#include <sstream>
+
+namespace
+{
+    // Philox4x32 constants (Salmon et al., SC11)
+    const std::uint32_t kMultiplier0 = 0xD2511F53, kMultiplier1 = 0xCD9E8D57;
+    const std::uint32_t kWeyl0 = 0x9E3779B9, kWeyl1 = 0xBB67AE85;
+    const G4int kRounds = 10;
+
+    inline void MulHiLo(std::uint32_t a, std::uint32_t b, std::uint32_t& hi, std::uint32_t& lo)
+    {
+        std::uint64_t product = static_cast<std::uint64_t>(a)*b;
+        hi = static_cast<std::uint32_t>(product >> 32);
+        lo = static_cast<std::uint32_t>(product);
+    }
+}
+
+EventSeeder* EventSeeder::GetInstance()
+{
+    static EventSeeder fInstance;
+    return &fInstance;
+}
+
+EventSeeder::EventSeeder()
+: fEnabled(false), fSeed(12345)
+{
+    fMessenger = std::make_unique<EventSeederMessenger>(this);
+}
+
+EventSeeder::~EventSeeder()
+{}
+
+std::array<std::uint32_t, 4> EventSeeder::Philox(std::array<std::uint32_t, 4> counter,
+                                                 std::array<std::uint32_t, 2> key)
+{
+    for(G4int round = 0; round<kRounds; ++round)
+    {
+        std::uint32_t hi0, lo0, hi1, lo1;
+        MulHiLo(kMultiplier0, counter[0], hi0, lo0);
+        MulHiLo(kMultiplier1, counter[2], hi1, lo1);
+        counter = {hi1 ^ counter[1] ^ key[0], lo1, hi0 ^ counter[3] ^ key[1], lo0};
+        key[0] += kWeyl0;
+        key[1] += kWeyl1;
+    }
+    return counter;
+}
+
+void EventSeeder::SeedEvent(G4int runID, G4long eventID) const
+{
+    auto id = static_cast<std::uint64_t>(eventID);
+    auto seed = static_cast<std::uint64_t>(fSeed);
+    auto random = Philox({static_cast<std::uint32_t>(id), static_cast<std::uint32_t>(id >> 32),
+                          static_cast<std::uint32_t>(runID), 0},
+                         {static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32)});
+
+    // Positive, non-zero and zero-terminated, as all engines accept
+    long seeds[5];
+    for(std::size_t i = 0; i<4; ++i) seeds[i] = static_cast<long>(random[i] & 0x7FFFFFFF) | 1;
+    seeds[4] = 0;
+    G4Random::getTheEngine()->setSeeds(seeds, -1);
+}
+
+void EventSeeder::Benchmark(G4int n, std::ostream& out) const
+{
+    // The engine state seeds the runs of the master: keep it
+    auto engine = G4Random::getTheEngine();
+    std::stringstream engineState;
+    G4Random::saveFullState(engineState);
+
+    auto start = std::chrono::steady_clock::now();
+    for(G4int i = 0; i<n; ++i) SeedEvent(0, i);
+    auto seeding = std::chrono::duration<G4double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    G4double sum = 0.;
+    for(G4int i = 0; i<n; ++i) sum += engine->flat();
+    auto drawing = std::chrono::duration<G4double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    G4Random::restoreFullState(engineState);
+    out << "Event seeding (" << engine->name() << "): " << seeding/n << " ns per reseed, "
+        << drawing/n << " ns per draw (" << sum/n << ")" << G4endl;
+}
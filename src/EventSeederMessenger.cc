@@ -0,0 +1,62 @@
+#include "EventSeederMessenger.hh"
+#include "EventSeeder.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcommand.hh"
+#include "G4UIparameter.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "G4UIcmdWithABool.hh"
+
+#include <sstream>
+
+EventSeederMessenger::EventSeederMessenger(EventSeeder* eventSeeder)
+: G4UImessenger(), fEventSeeder(eventSeeder)
+{
+    fRandomDir = new G4UIdirectory("/ccTest/random/");
+    fRandomDir->SetGuidance("Per-event random streams.");
+
+    fEventSeedsCmd = new G4UIcmdWithABool("/ccTest/random/eventSeeds", this);
+    fEventSeedsCmd->SetGuidance("Reseed each event from (seed, run ID, event ID) with the Philox counter-based");
+    fEventSeedsCmd->SetGuidance("generator: runs are then reproducible event by event for any number of threads.");
+    fEventSeedsCmd->SetParameterName("enable", true);
+    fEventSeedsCmd->SetDefaultValue(true);
+    fEventSeedsCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fEventSeedsCmd->SetToBeBroadcasted(false);
+
+    fEventSeedCmd = new G4UIcommand("/ccTest/random/seed", this);
+    fEventSeedCmd->SetGuidance("Seed of the per-event streams (default: the ccTest -s seed).");
+    fEventSeedCmd->SetParameter(new G4UIparameter("seed", 's', false));
+    fEventSeedCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fEventSeedCmd->SetToBeBroadcasted(false);
+
+    fSeedBenchmarkCmd = new G4UIcmdWithAnInteger("/ccTest/random/benchmark", this);
+    fSeedBenchmarkCmd->SetGuidance("Time n per-event reseeds against n draws of the engine.");
+    fSeedBenchmarkCmd->SetParameterName("n", true);
+    fSeedBenchmarkCmd->SetDefaultValue(1000000);
+    fSeedBenchmarkCmd->SetRange("n>0");
+    fSeedBenchmarkCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fSeedBenchmarkCmd->SetToBeBroadcasted(false);
+}
+
+EventSeederMessenger::~EventSeederMessenger()
+{
+    delete fSeedBenchmarkCmd;
+    delete fEventSeedCmd;
+    delete fEventSeedsCmd;
+    delete fRandomDir;
+}
+
+void EventSeederMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+    if(command==fEventSeedsCmd)
+        fEventSeeder->SetEnabled(fEventSeedsCmd->GetNewBoolValue(newValue));
+    else if(command==fEventSeedCmd)
+    {
+        std::istringstream iss(newValue);
+        G4long seed = 0;
+        iss >> seed;
+        fEventSeeder->SetSeed(seed);
+    }
+    else if(command==fSeedBenchmarkCmd)
+        fEventSeeder->Benchmark(fSeedBenchmarkCmd->GetNewIntValue(newValue), G4cout);
+}
@@ -3,11 +3,25 @@
 #include "G4Box.hh"
 #include "G4Tubs.hh"
 #include "G4IntersectionSolid.hh"
+#include "G4DisplacedSolid.hh"
+#include "G4ExtrudedSolid.hh"
 #include "G4LogicalVolume.hh"
 #include "G4PVPlacement.hh"
 #include "G4VisAttributes.hh"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <random>
+
 G4bool LAScintDet::fDefineMaterialsFlag = false;
+G4bool LAScintDet::fExtrudedSolids = false;
+const G4double LAScintDet::fCrystalHalfWidth = 135.*mm;
+const G4double LAScintDet::fCrystalFilletHalfWidth = 176.8*mm;
+const G4double LAScintDet::fPaintThickness = 2.5*mm;
+const G4double LAScintDet::fOpticalGlueThickness = 0.5*mm;
 
 LAScintDet::LAScintDet(G4double crystalThickness)
 : Detector(), fCrystalThickness(crystalThickness)
@@ -48,55 +62,28 @@ G4LogicalVolume* LAScintDet::ConstructFrontHousing()
     // | - OpticalWindow
     // | - OpticalGrease
 
-    // Fillet setting
-    auto filletRotMat = new G4RotationMatrix();
-    filletRotMat->rotateZ(45.*deg);
+    std::vector<G4VSolid*> slabSols;
+    for(const auto& slab: FilletedSlabs(fCrystalThickness))
+        slabSols.push_back(ConstructFilletedSlab(slab.name, slab.halfWidth, slab.filletHalfWidth, slab.halfZ,
+                                                 fExtrudedSolids));
 
-    // Crystal
-    G4double crystalWidth = 270.*mm, crystalFilletWidth = 353.6*mm;
-    auto crystalMainSol = new G4Box("CrystalMain", crystalWidth/2., crystalWidth/2., fCrystalThickness/2.);
-    auto crystalFilletSol = new G4Box("CrystalFillet", crystalFilletWidth/2., crystalFilletWidth/2., fCrystalThickness/2.);
-    auto crystalSol = new G4IntersectionSolid("Crystal", crystalMainSol, crystalFilletSol, filletRotMat, G4ThreeVector());
+    // Crystal (square with 45 deg fillets)
     auto NaITl = G4Material::GetMaterial("NaITl");
-    fCrystalLV = new G4LogicalVolume(crystalSol, NaITl, "Crystal");
+    fCrystalLV = new G4LogicalVolume(slabSols[kCrystalSlab], NaITl, "Crystal");
     auto crystalVA = new G4VisAttributes(G4Colour::White());
     crystalVA->SetForceSolid();
     fCrystalLV->SetVisAttributes(crystalVA);
 
     // Paint (For different type reflector on side & front, two geoms were divided.)
-    G4double paintThickness = 2.5*mm;
-    auto paintFilletSol = new G4Box("PaintFillet",
-                                    crystalFilletWidth/2. + paintThickness,
-                                    crystalFilletWidth/2. + paintThickness,
-                                    (fCrystalThickness + paintThickness)/2);
-    auto paintSideMainSol = new G4Box("PaintSideMain",
-                                  crystalWidth/2. + paintThickness,
-                                  crystalWidth/2. + paintThickness,
-                                  fCrystalThickness/2.);
-    auto paintSideSol = new G4IntersectionSolid("paintSide", paintSideMainSol, crystalFilletSol, filletRotMat, G4ThreeVector());
+    G4double paintThickness = fPaintThickness;
     auto nistMgO = G4Material::GetMaterial("G4_MAGNESIUM_OXIDE");
-    auto paintSideLV = new G4LogicalVolume(paintSideSol, nistMgO, "PaintSide");
-
-    auto paintFrontMainSol = new G4Box("PaintFrontMain",
-                                   crystalWidth/2. + paintThickness,
-                                   crystalWidth/2. + paintThickness,
-                                   paintThickness/2.);
-    auto paintFrontSol = new G4IntersectionSolid("PaintFront", paintFrontMainSol, paintFilletSol, filletRotMat, G4ThreeVector());
-    auto paintFrontLV = new G4LogicalVolume(paintFrontSol, nistMgO, "PaintFront");
+    auto paintSideLV = new G4LogicalVolume(slabSols[kPaintSideSlab], nistMgO, "PaintSide");
+    auto paintFrontLV = new G4LogicalVolume(slabSols[kPaintFrontSlab], nistMgO, "PaintFront");
 
     // Optical Glue
-    G4double opticalGlueThickness = 0.5*mm;
-    auto opticalGlueMainSol = new G4Box("OpticalGlueMain",
-                                        crystalWidth/2. + paintThickness,
-                                        crystalWidth/2. + paintThickness,
-                                        opticalGlueThickness/2.);
-    auto opticalGlueFilletSol = new G4Box("OpticalGlueFillet",
-                                          crystalFilletWidth/2. + paintThickness,
-                                          crystalFilletWidth/2. + paintThickness,
-                                          opticalGlueThickness/2);
-    auto opticalGlueSol = new G4IntersectionSolid("OpticalGlue", opticalGlueMainSol, opticalGlueFilletSol, filletRotMat, G4ThreeVector());
+    G4double opticalGlueThickness = fOpticalGlueThickness;
     auto BC630 = G4Material::GetMaterial("BC630");
-    auto opticalGlueLV = new G4LogicalVolume(opticalGlueSol, BC630, "OpticalGlue");
+    auto opticalGlueLV = new G4LogicalVolume(slabSols[kOpticalGlueSlab], BC630, "OpticalGlue");
 
     // Optical Window
     G4double opticalWindowWidth = 307.*mm, opticalWindowThickness = 10.*mm;
@@ -143,6 +130,125 @@ G4LogicalVolume* LAScintDet::ConstructFrontHousing()
     return frontHousingLV;
 }
 
+std::vector<LAScintDet::FilletedSlab> LAScintDet::FilletedSlabs(G4double crystalThickness)
+{
+    return
+    {
+        {"Crystal", fCrystalHalfWidth, fCrystalFilletHalfWidth, crystalThickness/2.},
+        {"paintSide", fCrystalHalfWidth + fPaintThickness, fCrystalFilletHalfWidth, crystalThickness/2.},
+        {"PaintFront", fCrystalHalfWidth + fPaintThickness, fCrystalFilletHalfWidth + fPaintThickness, fPaintThickness/2.},
+        {"OpticalGlue", fCrystalHalfWidth + fPaintThickness, fCrystalFilletHalfWidth + fPaintThickness,
+         fOpticalGlueThickness/2.}
+    };
+}
+
+G4VSolid* LAScintDet::ConstructFilletedSlab(const G4String& name, G4double halfWidth,
+                                            G4double filletHalfWidth, G4double halfZ, G4bool extruded)
+{
+    if(!extruded)
+    {
+        auto filletRotMat = new G4RotationMatrix();
+        filletRotMat->rotateZ(45.*deg);
+        auto mainSol = new G4Box(name + "Main", halfWidth, halfWidth, halfZ);
+        auto filletSol = new G4Box(name + "Fillet", filletHalfWidth, filletHalfWidth, halfZ);
+        return new G4IntersectionSolid(name, mainSol, filletSol, filletRotMat, G4ThreeVector());
+    }
+
+    // The rotated box cuts the corners along |x| + |y| = sqrt(2)*filletHalfWidth
+    G4double cut = std::sqrt(2.)*filletHalfWidth - halfWidth;
+    if(cut>=halfWidth) return new G4Box(name, halfWidth, halfWidth, halfZ);
+
+    std::vector<G4TwoVector> polygon = // clockwise
+    {
+        G4TwoVector(-cut, halfWidth), G4TwoVector(cut, halfWidth),
+        G4TwoVector(halfWidth, cut), G4TwoVector(halfWidth, -cut),
+        G4TwoVector(cut, -halfWidth), G4TwoVector(-cut, -halfWidth),
+        G4TwoVector(-halfWidth, -cut), G4TwoVector(-halfWidth, cut)
+    };
+    return new G4ExtrudedSolid(name, polygon, halfZ, G4TwoVector(), 1., G4TwoVector(), 1.);
+}
+
+void LAScintDet::CompareFilletedSolids(G4int nPoints, G4double crystalThickness, std::ostream& out)
+{
+    const auto slabs = FilletedSlabs(crystalThickness);
+
+    // Private engine: the master engine seeds the workers
+    std::mt19937_64 engine(12345);
+    std::uniform_real_distribution<G4double> flat(-1., 1.);
+    auto RandomDirection = [&]()
+    {
+        G4double cosTheta = flat(engine), phi = CLHEP::pi*flat(engine);
+        G4double sinTheta = std::sqrt(1. - cosTheta*cosTheta);
+        return G4ThreeVector(sinTheta*std::cos(phi), sinTheta*std::sin(phi), cosTheta);
+    };
+    auto Time = [](const std::function<G4double()>& loop, G4double& sink)
+    {
+        auto start = std::chrono::steady_clock::now();
+        sink += loop();
+        return std::chrono::duration<G4double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    out << "Filleted slabs (" << crystalThickness/cm << " cm crystal): G4IntersectionSolid vs G4ExtrudedSolid, "
+        << nPoints << " points\n"
+        << "  solid        volume(cm3) bool/extr   mismatches   ns/call bool/extr: Inside  DistanceToIn  DistanceToOut\n";
+    G4double sink = 0.;
+    for(const auto& slab: slabs)
+    {
+        auto booleanSol = ConstructFilletedSlab(slab.name + "Bool", slab.halfWidth, slab.filletHalfWidth, slab.halfZ, false);
+        auto extrudedSol = ConstructFilletedSlab(slab.name + "Extr", slab.halfWidth, slab.filletHalfWidth, slab.halfZ, true);
+
+        // Points in the bounding box enlarged by 10 %; rays towards the slab
+        std::vector<G4ThreeVector> points, directions;
+        G4int nMismatches = 0;
+        for(G4int i = 0; i<nPoints; ++i)
+        {
+            G4ThreeVector point(1.1*slab.halfWidth*flat(engine), 1.1*slab.halfWidth*flat(engine), 1.1*slab.halfZ*flat(engine));
+            EInside booleanInside = booleanSol->Inside(point), extrudedInside = extrudedSol->Inside(point);
+            if(booleanInside!=extrudedInside && booleanInside!=kSurface && extrudedInside!=kSurface) ++nMismatches;
+            points.push_back(point);
+            directions.push_back(RandomDirection());
+        }
+
+        std::vector<std::size_t> inside, outside;
+        for(std::size_t i = 0; i<points.size(); ++i)
+            (extrudedSol->Inside(points[i])==kInside ? inside : outside).push_back(i);
+
+        G4double nsInside[2], nsToIn[2], nsToOut[2];
+        G4VSolid* solids[2] = {booleanSol, extrudedSol};
+        for(G4int s = 0; s<2; ++s)
+        {
+            auto solid = solids[s];
+            nsInside[s] = Time([&]()
+            { G4double n = 0.; for(const auto& point: points) n += solid->Inside(point); return n; }, sink)/points.size();
+            nsToIn[s] = Time([&]()
+            { G4double d = 0.; for(auto i: outside) d += solid->DistanceToIn(points[i], directions[i]); return d; }, sink)
+                    /std::max<std::size_t>(outside.size(), 1);
+            nsToOut[s] = Time([&]()
+            { G4double d = 0.; for(auto i: inside) d += solid->DistanceToOut(points[i], directions[i]); return d; }, sink)
+                    /std::max<std::size_t>(inside.size(), 1);
+        }
+
+        out << "  " << std::setw(12) << std::left << slab.name << std::right << std::setprecision(5)
+            << std::setw(10) << booleanSol->GetCubicVolume()/cm3 << "/" << std::setw(10) << extrudedSol->GetCubicVolume()/cm3
+            << std::setw(8) << nMismatches << std::setprecision(3)
+            << "      " << std::setw(7) << nsInside[0] << "/" << std::setw(7) << nsInside[1]
+            << "  " << std::setw(7) << nsToIn[0] << "/" << std::setw(7) << nsToIn[1]
+            << "  " << std::setw(7) << nsToOut[0] << "/" << std::setw(7) << nsToOut[1] << "\n";
+
+        // Not part of the geometry: delete them with the parts of the
+        // boolean solid (its displaced fillet box included)
+        auto mainSol = booleanSol->GetConstituentSolid(0);
+        auto displacedSol = booleanSol->GetConstituentSolid(1)->GetDisplacedSolidPtr();
+        auto filletSol = displacedSol->GetConstituentMovedSolid();
+        delete booleanSol;
+        delete displacedSol;
+        delete mainSol;
+        delete filletSol;
+        delete extrudedSol;
+    }
+    out << "  (boolean volumes are Monte Carlo estimates; checksum " << sink << ")" << std::endl;
+}
+
 G4LogicalVolume* LAScintDet::ConstructRearHousing()
 {
     // - RearHousing
@@ -0,0 +1,127 @@
+#include "LACCMessenger.hh"
+#include "DetectorConstruction.hh"
+#include "CCSensitiveDetector.hh"
+#include "LACCBuilder.hh"
+#include "LightCollectionModel.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcommand.hh"
+#include "G4UIparameter.hh"
+#include "G4UIcmdWithABool.hh"
+
+#include <sstream>
+
+LACCMessenger::LACCMessenger(DetectorConstruction* detector)
+: G4UImessenger(), fDetector(detector)
+{
+    fLACCDir = new G4UIdirectory("/ccTest/lacc/");
+    fLACCDir->SetGuidance("LACC scintillation readout.");
+
+    fLightModelCmd = new G4UIcmdWithABool("/ccTest/lacc/lightModel", this);
+    fLightModelCmd->SetGuidance("Convert crystal deposits into PMT signals with light-collection tables,");
+    fLightModelCmd->SetGuidance("and write the Anger position and energy of each hit (XM, YM, ZM, EM).");
+    fLightModelCmd->SetParameterName("enable", true);
+    fLightModelCmd->SetDefaultValue(true);
+    fLightModelCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fLightModelCmd->SetToBeBroadcasted(false);
+
+    fLightTableCmd = new G4UIcommand("/ccTest/lacc/lightTable", this);
+    fLightTableCmd->SetGuidance("Load the light-collection table of a detector (0: scatter, 1: absorber)");
+    fLightTableCmd->SetGuidance("from a detailed optical run; otherwise the analytic table is used.");
+    auto detIDParam = new G4UIparameter("detID", 'i', false);
+    detIDParam->SetParameterRange("detID>=0");
+    fLightTableCmd->SetParameter(detIDParam);
+    fLightTableCmd->SetParameter(new G4UIparameter("fileName", 's', false));
+    fLightTableCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fLightTableCmd->SetToBeBroadcasted(false);
+
+    fWriteLightTableCmd = new G4UIcommand("/ccTest/lacc/writeAnalyticTable", this);
+    fWriteLightTableCmd->SetGuidance("Write the analytic table of a crystal of the given thickness");
+    fWriteLightTableCmd->SetGuidance("(file format reference for tables from optical runs).");
+    fWriteLightTableCmd->SetParameter(new G4UIparameter("fileName", 's', false));
+    auto thicknessParam = new G4UIparameter("thickness", 'd', false);
+    thicknessParam->SetParameterRange("thickness>0.");
+    fWriteLightTableCmd->SetParameter(thicknessParam);
+    auto thicknessUnitParam = new G4UIparameter("unit", 's', true);
+    thicknessUnitParam->SetDefaultValue("cm");
+    fWriteLightTableCmd->SetParameter(thicknessUnitParam);
+    fWriteLightTableCmd->SetToBeBroadcasted(false);
+
+    fExtrudedSolidsCmd = new G4UIcmdWithABool("/ccTest/lacc/extrudedSolids", this);
+    fExtrudedSolidsCmd->SetGuidance("Build the filleted crystal, side/front paint and optical glue as");
+    fExtrudedSolidsCmd->SetGuidance("octagonal G4ExtrudedSolid prisms instead of boolean intersections.");
+    fExtrudedSolidsCmd->SetParameterName("extruded", true);
+    fExtrudedSolidsCmd->SetDefaultValue(true);
+    fExtrudedSolidsCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fExtrudedSolidsCmd->SetToBeBroadcasted(false);
+
+    fCompareSolidsCmd = new G4UIcommand("/ccTest/lacc/compareSolids", this);
+    fCompareSolidsCmd->SetGuidance("Check that both filleted-slab constructions agree (volume, Inside() at");
+    fCompareSolidsCmd->SetGuidance("random points) and time Inside()/DistanceToIn()/DistanceToOut(), for the");
+    fCompareSolidsCmd->SetGuidance("slabs of a detector with the given crystal thickness (default: scatter).");
+    auto nPointsParam = new G4UIparameter("nPoints", 'i', true);
+    nPointsParam->SetDefaultValue(100000);
+    nPointsParam->SetParameterRange("nPoints>0");
+    fCompareSolidsCmd->SetParameter(nPointsParam);
+    auto compareThicknessParam = new G4UIparameter("thickness", 'd', true);
+    compareThicknessParam->SetDefaultValue(2.);
+    compareThicknessParam->SetParameterRange("thickness>0.");
+    fCompareSolidsCmd->SetParameter(compareThicknessParam);
+    auto compareUnitParam = new G4UIparameter("unit", 's', true);
+    compareUnitParam->SetDefaultValue("cm");
+    fCompareSolidsCmd->SetParameter(compareUnitParam);
+    fCompareSolidsCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fCompareSolidsCmd->SetToBeBroadcasted(false);
+}
+
+LACCMessenger::~LACCMessenger()
+{
+    delete fCompareSolidsCmd;
+    delete fExtrudedSolidsCmd;
+    delete fWriteLightTableCmd;
+    delete fLightTableCmd;
+    delete fLightModelCmd;
+    delete fLACCDir;
+}
+
+void LACCMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+    if(command==fLightModelCmd)
+        CCSensitiveDetector::SetLightModelEnabled(fLightModelCmd->GetNewBoolValue(newValue));
+    else if(command==fLightTableCmd)
+    {
+        std::istringstream iss(newValue);
+        G4int detID;
+        G4String fileName;
+        iss >> detID >> fileName;
+        if(!CCSensitiveDetector::LoadLightCollectionTable(detID, fileName))
+            G4Exception("LACCMessenger::SetNewValue()", "", JustWarning,
+                        G4String("    Cannot read the light-collection table '" + fileName + "'; detector "
+                                 + G4UIcommand::ConvertToString(detID) + " keeps its current table.").c_str());
+    }
+    else if(command==fWriteLightTableCmd)
+    {
+        std::istringstream iss(newValue);
+        G4String fileName, unit;
+        G4double thickness;
+        iss >> fileName >> thickness >> unit;
+        LightCollectionModel lightCollectionModel(LAScintDet::GetCrystalHalfWidth(), thickness*G4UIcommand::ValueOf(unit)/2.);
+        if(!lightCollectionModel.Write(fileName))
+            G4Exception("LACCMessenger::SetNewValue()", "", JustWarning,
+                        G4String("    Cannot write '" + fileName + "'.").c_str());
+    }
+    else if(command==fExtrudedSolidsCmd)
+    {
+        LAScintDet::SetExtrudedSolids(fExtrudedSolidsCmd->GetNewBoolValue(newValue));
+        if(fDetector->GetCameraType()=="LACC") fDetector->ReinitializeGeometry();
+    }
+    else if(command==fCompareSolidsCmd)
+    {
+        std::istringstream iss(newValue);
+        G4int nPoints;
+        G4double thickness;
+        G4String unit;
+        iss >> nPoints >> thickness >> unit;
+        LAScintDet::CompareFilletedSolids(nPoints, thickness*G4UIcommand::ValueOf(unit), G4cout);
+    }
+}
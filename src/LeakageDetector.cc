@@ -0,0 +1,148 @@
+#include "LeakageDetector.hh"
+#include "DetectorConstruction.hh"
+#include "EventAction.hh"
+#include "Run.hh"
+
+#include "G4Gamma.hh"
+#include "G4RunManager.hh"
+#include "G4Step.hh"
+#include "G4UIcommand.hh"
+#include "G4UImanager.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <vector>
+
+G4bool LeakageDetector::fEnabled = false;
+const G4int LeakageDetector::fNBins = 200;
+const G4double LeakageDetector::fMaxEnergy = 2.*MeV;
+
+LeakageDetector::LeakageDetector(G4String name)
+: G4VSensitiveDetector(name)
+{}
+
+LeakageDetector::~LeakageDetector()
+{}
+
+void LeakageDetector::Initialize(G4HCofThisEvent*)
+{
+    fEventLeakage.clear();
+}
+
+G4bool LeakageDetector::ProcessHits(G4Step* aStep, G4TouchableHistory*)
+{
+    auto postStepPoint = aStep->GetPostStepPoint();
+    if(aStep->GetTrack()->GetDefinition()!=G4Gamma::Definition()) return false;
+    if(postStepPoint->GetStepStatus()!=fGeomBoundary && postStepPoint->GetStepStatus()!=fWorldBoundary) return false;
+
+    // Moving between the volumes of an assembly is no leakage
+    const auto touchable = postStepPoint->GetTouchable();
+    if(postStepPoint->GetPhysicalVolume())
+        for(G4int depth = 0; depth<touchable->GetHistoryDepth(); ++depth)
+            if(touchable->GetVolume(depth)->GetName()=="SpentFuelAssembly") return false;
+
+    G4double weight = aStep->GetTrack()->GetWeight();
+    G4double energy = postStepPoint->GetKineticEnergy();
+    if(energy<fMaxEnergy) fEventLeakage[static_cast<G4int>(energy/fMaxEnergy*fNBins)] += weight;
+    fEventLeakage[fNBins] += weight;
+    return true;
+}
+
+void LeakageDetector::EndOfEvent(G4HCofThisEvent*)
+{
+    if(fEventLeakage.empty()) return;
+    auto run = static_cast<Run*>(G4RunManager::GetRunManager()->GetNonConstCurrentRun());
+    for(const auto& bin: fEventLeakage) run->AddLeakage(bin.first, bin.second);
+}
+
+void LeakageDetector::ValidateHomogenized(DetectorConstruction* detector, G4int nEvents)
+{
+    struct Result
+    {
+        std::vector<G4double> mean, variance; // per primary
+        G4double eventRate;
+    };
+    Result results[2]; // explicit, homogenized
+
+    G4bool homogenized = detector->GetHomogenized();
+    G4String outputTag = detector->GetOutputTag();
+    SetEnabled(true);
+    auto UImanager = G4UImanager::GetUIpointer();
+    for(G4int mode = 0; mode<2; ++mode)
+    {
+        // Also attaches the leakage detector to the rebuilt assemblies
+        detector->SetHomogenized(mode==1);
+        UImanager->ApplyCommand("/run/reinitializeGeometry");
+        detector->SetOutputTag(mode ? "homogenized" : "explicit");
+        auto start = std::chrono::steady_clock::now();
+        UImanager->ApplyCommand("/run/beamOn " + G4UIcommand::ConvertToString(nEvents));
+        G4double seconds = std::chrono::duration<G4double>(std::chrono::steady_clock::now() - start).count();
+
+        auto run = static_cast<const Run*>(G4RunManager::GetRunManager()->GetCurrentRun());
+        auto& result = results[mode];
+        G4double nPrimaries = run ? static_cast<G4double>(run->GetNEvents()) : 0.;
+        result.eventRate = (seconds>0.) ? nPrimaries/seconds : 0.;
+        result.mean.assign(static_cast<std::size_t>(GetNBins() + 1), 0.);
+        result.variance.assign(result.mean.size(), 0.);
+        if(!run || run->GetLeakage().empty() || nPrimaries<=0.) continue;
+        for(std::size_t bin = 0; bin<result.mean.size(); ++bin)
+        {
+            G4double mean = run->GetLeakage()[bin]/nPrimaries;
+            result.mean[bin] = mean;
+            result.variance[bin] = std::max(0., run->GetLeakage2()[bin]/nPrimaries - mean*mean)/nPrimaries;
+        }
+    }
+    SetEnabled(false);
+    detector->SetHomogenized(homogenized);
+    detector->SetOutputTag(outputTag);
+    UImanager->ApplyCommand("/run/reinitializeGeometry");
+
+    // Spectra and per-bin deviation of the homogenized from the explicit geometry
+    const auto& ex = results[0];
+    const auto& ho = results[1];
+    auto nBins = static_cast<std::size_t>(GetNBins());
+    G4double binWidth = GetMaxEnergy()/nBins;
+    G4String fileName = EventAction::GetOutputDirectory() + "/leakage.txt";
+    std::ofstream out(fileName);
+    out << "# Photon leakage per primary of the assemblies (" << nEvents << " events per geometry)\n"
+        << "# E_low(keV)\texplicit\terror\thomogenized\terror\tz\n";
+    G4double chi2 = 0., maxZ = 0., sumE[2] = {0., 0.}, sum[2] = {0., 0.};
+    G4int ndf = 0;
+    for(std::size_t bin = 0; bin<nBins; ++bin)
+    {
+        G4double sigma = std::sqrt(ex.variance[bin] + ho.variance[bin]);
+        G4double z = (sigma>0.) ? (ho.mean[bin] - ex.mean[bin])/sigma : 0.;
+        if(sigma>0.)
+        {
+            chi2 += z*z;
+            ++ndf;
+            maxZ = std::max(maxZ, std::abs(z));
+        }
+        for(G4int mode = 0; mode<2; ++mode)
+        {
+            sumE[mode] += (bin + 0.5)*binWidth*results[mode].mean[bin];
+            sum[mode] += results[mode].mean[bin];
+        }
+        out << bin*binWidth/keV << "\t" << ex.mean[bin] << "\t" << std::sqrt(ex.variance[bin]) << "\t"
+            << ho.mean[bin] << "\t" << std::sqrt(ho.variance[bin]) << "\t" << z << "\n";
+    }
+    if(!out)
+        G4Exception("LeakageDetector::ValidateHomogenized()", "", JustWarning,
+                    G4String("    Cannot write " + fileName + ".").c_str());
+
+    G4double total = ex.mean[nBins];
+    G4double bias = (total>0.) ? ho.mean[nBins]/total - 1. : 0.;
+    G4double biasError = (total>0.) ? std::sqrt(ex.variance[nBins] + ho.variance[nBins])/total : 0.;
+    G4cout << "Homogenized assembly validation (" << nEvents << " events per geometry):\n"
+           << "  leakage per primary\texplicit " << total << " +- " << std::sqrt(ex.variance[nBins])
+           << "\thomogenized " << ho.mean[nBins] << " +- " << std::sqrt(ho.variance[nBins]) << "\n"
+           << "  relative bias\t" << 100.*bias << " +- " << 100.*biasError << " %\n"
+           << "  mean energy (keV, < " << GetMaxEnergy()/keV << ")\texplicit "
+           << ((sum[0]>0.) ? sumE[0]/sum[0]/keV : 0.) << "\thomogenized " << ((sum[1]>0.) ? sumE[1]/sum[1]/keV : 0.) << "\n"
+           << "  spectrum\tchi2/ndf " << chi2 << "/" << ndf << "\tmax |z| " << maxZ << "\n"
+           << "  events/s\texplicit " << ex.eventRate << "\thomogenized " << ho.eventRate
+           << "\tspeed-up " << ((ex.eventRate>0.) ? ho.eventRate/ex.eventRate : 0.) << "\n"
+           << "  spectra: " << fileName << G4endl;
+}
@@ -0,0 +1,141 @@
+#include "LightCollectionModel.hh"
+
+#include <cmath>
+#include <fstream>
+
+namespace
+{
+    // Readout of LAScintDet (see LAScintDet::ConstructRearHousing())
+    const G4int kNPMTRows = 6;
+    const G4double kPMTPitch = 52.2*mm;
+    const G4double kPhotoCathodeWidth = 48.*mm;
+    // Crystal back face to photocathode: glue, window, grease, PMT glass
+    const G4double kOpticalStack = 0.5*mm + 10.*mm + 1.*mm + 1.5*mm;
+
+    // NaI(Tl) light yield, bialkali quantum efficiency, MgO reflectivity
+    const G4double kLightYield = 38./keV;
+    const G4double kQuantumEfficiency = 0.25;
+    const G4double kReflectivity = 0.95;
+
+    const G4int kNBinsXY = 27;
+    const G4int kNBinsZ = 6;
+
+    // Solid angle of the rectangle [x1,x2]x[y1,y2] at distance h along its normal
+    G4double RectangleSolidAngle(G4double x1, G4double x2, G4double y1, G4double y2, G4double h)
+    {
+        auto F = [h](G4double x, G4double y)
+        { return std::atan(x*y/(h*std::sqrt(x*x + y*y + h*h))); };
+        return F(x2, y2) - F(x1, y2) - F(x2, y1) + F(x1, y1);
+    }
+}
+
+LightCollectionModel::LightCollectionModel(G4double crystalHalfWidth, G4double crystalHalfThickness)
+: fNX(kNBinsXY), fNY(kNBinsXY), fNZ(kNBinsZ),
+  fHalfX(crystalHalfWidth), fHalfY(crystalHalfWidth), fHalfZ(crystalHalfThickness),
+  fCalibration(0.)
+{
+    for(G4int i = 0; i<kNPMTRows; ++i)
+        for(G4int j = 0; j<kNPMTRows; ++j)
+        {
+            fPMTX.push_back(kPMTPitch*j - (kNPMTRows - 1)/2.*kPMTPitch);
+            fPMTY.push_back(- kPMTPitch*i + (kNPMTRows - 1)/2.*kPMTPitch);
+        }
+
+    auto nPMTs = static_cast<std::size_t>(GetNPMTs());
+    fTable.resize(static_cast<std::size_t>(fNX*fNY*fNZ)*nPMTs);
+    G4double scale = kLightYield*kQuantumEfficiency/(4.*CLHEP::pi);
+    for(G4int iz = 0; iz<fNZ; ++iz)
+    {
+        G4double z = -fHalfZ + (iz + 0.5)*2.*fHalfZ/fNZ;
+        G4double hDirect = z + fHalfZ + kOpticalStack;
+        G4double hImage = 3.*fHalfZ - z + kOpticalStack; // mirrored at the front face
+        for(G4int iy = 0; iy<fNY; ++iy)
+            for(G4int ix = 0; ix<fNX; ++ix)
+            {
+                G4double x = -fHalfX + (ix + 0.5)*2.*fHalfX/fNX;
+                G4double y = -fHalfY + (iy + 0.5)*2.*fHalfY/fNY;
+                auto bin = static_cast<std::size_t>(ix + fNX*(iy + fNY*iz))*nPMTs;
+                for(std::size_t k = 0; k<nPMTs; ++k)
+                {
+                    G4double x1 = fPMTX[k] - kPhotoCathodeWidth/2. - x, x2 = x1 + kPhotoCathodeWidth;
+                    G4double y1 = fPMTY[k] - kPhotoCathodeWidth/2. - y, y2 = y1 + kPhotoCathodeWidth;
+                    G4double solidAngle = RectangleSolidAngle(x1, x2, y1, y2, hDirect)
+                                        + kReflectivity*RectangleSolidAngle(x1, x2, y1, y2, hImage);
+                    fTable[bin + k] = static_cast<G4float>(scale*solidAngle*keV);
+                }
+            }
+    }
+    Calibrate();
+}
+
+LightCollectionModel::LightCollectionModel(const G4String& fileName)
+: fNX(0), fNY(0), fNZ(0), fHalfX(0.), fHalfY(0.), fHalfZ(0.), fCalibration(0.)
+{
+    std::ifstream in(fileName);
+    G4int nPMTs = 0;
+    if(!(in >> fNX >> fNY >> fNZ >> nPMTs >> fHalfX >> fHalfY >> fHalfZ) ||
+       fNX<=0 || fNY<=0 || fNZ<=0 || nPMTs<=0)
+    {
+        G4Exception("LightCollectionModel::LightCollectionModel()", "", JustWarning,
+                    G4String("    Cannot read the table header of '" + fileName + "'.").c_str());
+        return;
+    }
+    fHalfX *= mm;
+    fHalfY *= mm;
+    fHalfZ *= mm;
+
+    fPMTX.resize(static_cast<std::size_t>(nPMTs));
+    fPMTY.resize(static_cast<std::size_t>(nPMTs));
+    for(std::size_t k = 0; k<fPMTX.size(); ++k)
+    {
+        in >> fPMTX[k] >> fPMTY[k];
+        fPMTX[k] *= mm;
+        fPMTY[k] *= mm;
+    }
+
+    std::vector<G4float> table(static_cast<std::size_t>(fNX*fNY*fNZ*nPMTs));
+    for(auto& value: table) in >> value;
+    if(!in)
+    {
+        G4Exception("LightCollectionModel::LightCollectionModel()", "", JustWarning,
+                    G4String("    '" + fileName + "' is shorter than its header states.").c_str());
+        return;
+    }
+    fTable = std::move(table);
+    Calibrate();
+}
+
+G4bool LightCollectionModel::Write(const G4String& fileName) const
+{
+    std::ofstream out(fileName);
+    if(!out) return false;
+
+    out << fNX << " " << fNY << " " << fNZ << " " << GetNPMTs() << " "
+        << fHalfX/mm << " " << fHalfY/mm << " " << fHalfZ/mm << "\n";
+    for(std::size_t k = 0; k<fPMTX.size(); ++k) out << fPMTX[k]/mm << " " << fPMTY[k]/mm << "\n";
+    for(std::size_t i = 0; i<fTable.size(); ++i)
+        out << fTable[i] << (((i + 1)%fPMTX.size()) ? " " : "\n");
+
+    return static_cast<G4bool>(out);
+}
+
+const G4float* LightCollectionModel::GetResponse(const G4ThreeVector& localPos) const
+{
+    auto Bin = [](G4double u, G4double half, G4int n)
+    {
+        auto i = static_cast<G4int>(std::floor((u + half)/(2.*half)*n));
+        return (i<0) ? 0 : ((i>=n) ? n - 1 : i);
+    };
+    G4int ix = Bin(localPos.x(), fHalfX, fNX);
+    G4int iy = Bin(localPos.y(), fHalfY, fNY);
+    G4int iz = Bin(localPos.z(), fHalfZ, fNZ);
+
+    return &fTable[static_cast<std::size_t>(ix + fNX*(iy + fNY*iz))*fPMTX.size()];
+}
+
+void LightCollectionModel::Calibrate()
+{
+    auto response = GetResponse(G4ThreeVector());
+    fCalibration = 0.;
+    for(G4int k = 0; k<GetNPMTs(); ++k) fCalibration += response[k];
+}
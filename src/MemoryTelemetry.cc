@@ -0,0 +1,161 @@
+#include "MemoryTelemetry.hh"
+#include "CCHit.hh"
+
+#include "G4AutoLock.hh"
+#include "G4DynamicParticle.hh"
+#include "G4Track.hh"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#include <unistd.h>
+
+namespace
+{
+    // Plain data only: the hooks may run before any constructor of the thread
+    struct HeapCounters
+    {
+        G4long nAllocations;
+        G4long nBytes;
+        G4long netBytes;
+        G4long peakNetBytes;
+    };
+    G4ThreadLocal HeapCounters heapCounters;
+    G4ThreadLocal HeapCounters runStartCounters;
+
+    std::size_t UsableSize(void* ptr)
+    {
+#ifdef __GLIBC__
+        return malloc_usable_size(ptr);
+#else
+        (void)ptr;
+        return 0;
+#endif
+    }
+
+    G4double MB(G4double bytes) { return bytes/(1024.*1024.); }
+
+    template<class T>
+    G4double PoolSize(G4Allocator<T>* allocator)
+    {
+        return allocator ? static_cast<G4double>(allocator->GetAllocatedSize()) : 0.;
+    }
+}
+
+std::atomic<G4bool> MemoryTelemetry::fEnabled(false);
+
+MemoryTelemetry* MemoryTelemetry::GetInstance()
+{
+    static MemoryTelemetry fInstance;
+    return &fInstance;
+}
+
+void MemoryTelemetry::CountAllocation(void* ptr)
+{
+    auto size = static_cast<G4long>(UsableSize(ptr));
+    ++heapCounters.nAllocations;
+    heapCounters.nBytes += size;
+    heapCounters.netBytes += size;
+    heapCounters.peakNetBytes = std::max(heapCounters.peakNetBytes, heapCounters.netBytes);
+}
+
+void MemoryTelemetry::CountDeallocation(void* ptr)
+{
+    heapCounters.netBytes -= static_cast<G4long>(UsableSize(ptr));
+}
+
+G4double MemoryTelemetry::GetRSS()
+{
+    std::ifstream statm("/proc/self/statm");
+    G4double size = 0., resident = 0.;
+    if(!(statm >> size >> resident)) return 0.;
+    return resident*static_cast<G4double>(sysconf(_SC_PAGESIZE));
+}
+
+G4double MemoryTelemetry::GetPeakRSS()
+{
+    std::ifstream status("/proc/self/status");
+    for(std::string line; std::getline(status, line);)
+    {
+        if(line.compare(0, 6, "VmHWM:")!=0) continue;
+        std::istringstream iss(line.substr(6));
+        G4double kB = 0.;
+        iss >> kB;
+        return kB*1024.;
+    }
+    return 0.;
+}
+
+void MemoryTelemetry::Mark(const G4String& phase)
+{
+    if(!IsEnabled()) return;
+    G4AutoLock lock(&fMutex);
+    fPhases.emplace_back(phase, GetRSS());
+}
+
+void MemoryTelemetry::BeginThreadRun()
+{
+    if(!IsEnabled()) return;
+    // The peak of this run starts from the current net heap
+    heapCounters.peakNetBytes = heapCounters.netBytes;
+    runStartCounters = heapCounters;
+}
+
+void MemoryTelemetry::EndThreadRun(G4int nEvents)
+{
+    if(!IsEnabled()) return;
+    G4double n = std::max(nEvents, 1);
+    ThreadSummary summary;
+    summary.threadID = G4Threading::G4GetThreadId();
+    summary.nEvents = nEvents;
+    summary.allocationsPerEvent = (heapCounters.nAllocations - runStartCounters.nAllocations)/n;
+    summary.bytesPerEvent = (heapCounters.nBytes - runStartCounters.nBytes)/n;
+    summary.peakHeap = static_cast<G4double>(heapCounters.peakNetBytes);
+    summary.hitPool = PoolSize(CCHitAllocator);
+    summary.trackPool = PoolSize(aTrackAllocator());
+    summary.particlePool = PoolSize(pDynamicParticleAllocator());
+
+    G4AutoLock lock(&fMutex);
+    fThreadSummaries.push_back(summary);
+}
+
+void MemoryTelemetry::EndRun(G4int runID, std::ostream& out)
+{
+    if(!IsEnabled()) return;
+    G4AutoLock lock(&fMutex);
+    fPhases.emplace_back("run " + std::to_string(runID), GetRSS());
+    std::sort(fThreadSummaries.begin(), fThreadSummaries.end(),
+              [](const ThreadSummary& a, const ThreadSummary& b) { return a.threadID<b.threadID; });
+
+    auto precision = out.precision(1);
+    auto flags = out.setf(std::ios::fixed, std::ios::floatfield);
+    out << "Memory telemetry (MB):" << G4endl;
+    for(const auto& phase: fPhases)
+        out << "  RSS after " << std::left << std::setw(16) << phase.first << std::right
+            << std::setw(10) << MB(phase.second) << G4endl;
+    out << "  peak RSS" << std::setw(27) << MB(GetPeakRSS()) << G4endl;
+    out << "  thread  events  allocs/event  kB/event  peak heap  hit pool  track pool  particle pool" << G4endl;
+    for(const auto& summary: fThreadSummaries)
+        out << std::setw(8) << summary.threadID << std::setw(8) << summary.nEvents
+            << std::setw(14) << summary.allocationsPerEvent << std::setw(10) << summary.bytesPerEvent/1024.
+            << std::setw(11) << MB(summary.peakHeap) << std::setw(10) << MB(summary.hitPool)
+            << std::setw(12) << MB(summary.trackPool) << std::setw(15) << MB(summary.particlePool) << G4endl;
+
+    // Memory of a thread: growth from the end of initialization, split evenly
+    G4double initializedRSS = 0.;
+    for(const auto& phase: fPhases)
+        if(phase.first=="physics") initializedRSS = phase.second;
+    if(initializedRSS>0. && !fThreadSummaries.empty())
+        out << "  RSS growth per thread since initialization: "
+            << MB((fPhases.back().second - initializedRSS)/fThreadSummaries.size()) << G4endl;
+    out.precision(precision);
+    out.flags(flags);
+
+    fThreadSummaries.clear();
+}
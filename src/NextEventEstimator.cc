@@ -0,0 +1,294 @@
+#include "NextEventEstimator.hh"
+#include "NextEventEstimatorMessenger.hh"
+#include "EventAction.hh"
+#include "Run.hh"
+
+#include "G4EmCalculator.hh"
+#include "G4Gamma.hh"
+#include "G4Navigator.hh"
+#include "G4PhysicalConstants.hh"
+#include "G4PhysicalVolumeStore.hh"
+#include "G4RunManager.hh"
+#include "G4Step.hh"
+#include "G4TransportationManager.hh"
+#include "G4VProcess.hh"
+
+#include <cmath>
+#include <fstream>
+
+namespace
+{
+    // Attenuation tables: log-spaced from kMinEnergy, kNPerDecade per decade
+    const G4double kMinEnergy = 1.*keV;
+    const G4int kNPerDecade = 100;
+    const G4int kNDecades = 4;
+    // Rays are not followed beyond this optical depth (contribution < 1e-13)
+    const G4double kMaxOpticalDepth = 30.;
+
+    // Klein-Nishina angular density per steradian, normalized to 1
+    G4double KleinNishinaDensity(G4double energy, G4double cosTheta)
+    {
+        G4double k = energy/electron_mass_c2;
+        G4double ratio = 1./(1. + k*(1. - cosTheta)); // E'/E
+        G4double differential = 0.5*ratio*ratio*(ratio + 1./ratio - (1. - cosTheta*cosTheta));
+        G4double logTerm = std::log(1. + 2.*k);
+        G4double total = twopi*((1. + k)/(k*k)*(2.*(1. + k)/(1. + 2.*k) - logTerm/k) + logTerm/(2.*k)
+                                - (1. + 3.*k)/((1. + 2.*k)*(1. + 2.*k)));
+        return differential/total;
+    }
+}
+
+G4ThreadLocal NextEventEstimator::ThreadState* NextEventEstimator::fThreadState = nullptr;
+
+NextEventEstimator* NextEventEstimator::GetInstance()
+{
+    static NextEventEstimator fInstance;
+    return &fInstance;
+}
+
+NextEventEstimator::NextEventEstimator()
+: fEnabled(false), fActive(false), fFaceGridN(0), fFaceGridView(0),
+  fNEnergyBins(200), fMaxEnergy(2.*MeV), fExclusionRadius(5.*mm)
+{
+    fMessenger = std::make_unique<NextEventEstimatorMessenger>(this);
+}
+
+NextEventEstimator::~NextEventEstimator()
+{}
+
+void NextEventEstimator::BeginRun()
+{
+    fActive = false;
+    fPoints = fFixedPoints;
+    if(!fEnabled) return;
+
+    // Grid over the front face of the camera of the view
+    if(fFaceGridN>0)
+    {
+        const G4VPhysicalVolume* camera = nullptr;
+        for(auto volume: *G4PhysicalVolumeStore::GetInstance())
+            if(volume->GetName()=="ComptonCamera" && volume->GetCopyNo()==fFaceGridView) camera = volume;
+        if(!camera)
+            G4Exception("NextEventEstimator::BeginRun()", "", JustWarning,
+                        G4String("    No camera of view " + std::to_string(fFaceGridView) + "; no face grid.").c_str());
+        else
+        {
+            G4ThreeVector pMin, pMax;
+            camera->GetLogicalVolume()->GetSolid()->BoundingLimits(pMin, pMax);
+            auto rotation = camera->GetObjectRotationValue();
+            for(G4int j = 0; j<fFaceGridN; ++j)
+                for(G4int i = 0; i<fFaceGridN; ++i)
+                {
+                    G4ThreeVector local(pMin.x() + (i + 0.5)*(pMax.x() - pMin.x())/fFaceGridN,
+                                        pMin.y() + (j + 0.5)*(pMax.y() - pMin.y())/fFaceGridN, pMax.z());
+                    fPoints.push_back(camera->GetObjectTranslation() + rotation*local);
+                }
+        }
+    }
+    if(fPoints.empty())
+    {
+        G4Exception("NextEventEstimator::BeginRun()", "", JustWarning,
+                    "    No detector point; the next-event estimator is off for this run.");
+        return;
+    }
+    fActive = true;
+}
+
+NextEventEstimator::ThreadState& NextEventEstimator::GetThreadState()
+{
+    if(!fThreadState) fThreadState = new ThreadState();
+    auto& state = *fThreadState;
+    auto run = G4RunManager::GetRunManager()->GetNonConstCurrentRun();
+    if(state.runID!=run->GetRunID())
+    {
+        // The geometry and the points may have changed since the last run
+        state.runID = run->GetRunID();
+        state.run = static_cast<Run*>(run);
+        if(!state.navigator) state.navigator = std::make_unique<G4Navigator>();
+        state.navigator->SetWorldVolume(
+                    G4TransportationManager::GetTransportationManager()->GetNavigatorForTracking()->GetWorldVolume());
+        state.eventFlux.assign(fPoints.size()*kNComponents, 0.);
+        state.eventScored = false;
+    }
+    return state;
+}
+
+void NextEventEstimator::ScoreStep(const G4Step* step)
+{
+    auto track = step->GetTrack();
+    if(track->GetDefinition()!=G4Gamma::Definition()) return;
+    auto preStepPoint = step->GetPreStepPoint();
+    auto postStepPoint = step->GetPostStepPoint();
+
+    // Emission of a primary photon (isotropic source)
+    if(track->GetParentID()==0 && track->GetCurrentStepNumber()==1)
+        Score(GetThreadState(), preStepPoint->GetPosition(), G4ThreeVector(), preStepPoint->GetKineticEnergy(),
+              preStepPoint->GetWeight(), kUncollided);
+
+    // Compton collision, possibly through the biasing wrapper
+    auto process = postStepPoint->GetProcessDefinedStep();
+    if(!process) return;
+    auto& state = GetThreadState();
+    auto found = state.compton.find(process);
+    if(found==state.compton.end())
+    {
+        const auto& name = process->GetProcessName();
+        found = state.compton.emplace(process, name=="compt" || name=="biasWrapper(compt)").first;
+    }
+    if(!found->second) return;
+    Score(state, postStepPoint->GetPosition(), preStepPoint->GetMomentumDirection(), preStepPoint->GetKineticEnergy(),
+          postStepPoint->GetWeight(), kScattered);
+}
+
+void NextEventEstimator::Score(ThreadState& state, const G4ThreeVector& position, const G4ThreeVector& direction,
+                               G4double energy, G4double weight, Component component)
+{
+    for(std::size_t p = 0; p<fPoints.size(); ++p)
+    {
+        auto ray = fPoints[p] - position;
+        G4double distance = ray.mag();
+        if(distance<=0.) continue;
+
+        // Density per steradian toward the point and the energy along the ray
+        G4double density = 1./fourpi, rayEnergy = energy;
+        if(component==kScattered)
+        {
+            G4double cosTheta = direction.dot(ray)/distance;
+            density = KleinNishinaDensity(energy, cosTheta);
+            rayEnergy = energy/(1. + energy/electron_mass_c2*(1. - cosTheta));
+        }
+        G4double bounded = std::max(distance, fExclusionRadius);
+        G4double flux = weight*density/(bounded*bounded);
+        if(flux<=0.) continue;
+        flux *= Transmission(state, position, fPoints[p], rayEnergy);
+        if(flux<=0.) continue;
+
+        auto index = p*kNComponents + component;
+        state.eventFlux[index] += flux;
+        state.eventScored = true;
+        if(rayEnergy<fMaxEnergy)
+            state.run->AddNextEventSpectrum(index*static_cast<std::size_t>(fNEnergyBins)
+                                            + static_cast<std::size_t>(rayEnergy/fMaxEnergy*fNEnergyBins), flux);
+    }
+}
+
+G4double NextEventEstimator::Transmission(ThreadState& state, const G4ThreeVector& start, const G4ThreeVector& end,
+                                          G4double energy) const
+{
+    auto direction = end - start;
+    G4double remaining = direction.mag();
+    direction /= remaining;
+
+    auto& navigator = *state.navigator;
+    auto volume = navigator.LocateGlobalPointAndSetup(start, &direction, false, false);
+    G4ThreeVector point = start;
+    G4double opticalDepth = 0.;
+    while(volume && remaining>0.)
+    {
+        G4double safety;
+        G4double step = std::min(navigator.ComputeStep(point, direction, remaining, safety), remaining);
+        if(step<=0.) step = std::min(remaining, 1.*nm); // stuck on a boundary
+        opticalDepth += step*GetAttenuationCoefficient(state, volume->GetLogicalVolume()->GetMaterial(), energy);
+        if(opticalDepth>kMaxOpticalDepth) return 0.;
+        remaining -= step;
+        point += step*direction;
+        if(remaining<=0.) break;
+        navigator.SetGeometricallyLimitedStep();
+        volume = navigator.LocateGlobalPointAndSetup(point, &direction, true);
+    }
+    return std::exp(-opticalDepth);
+}
+
+G4double NextEventEstimator::GetAttenuationCoefficient(ThreadState& state, const G4Material* material,
+                                                       G4double energy) const
+{
+    auto& table = state.attenuation[material];
+    if(table.empty())
+    {
+        G4EmCalculator emCalculator;
+        auto gamma = G4Gamma::Definition();
+        for(G4int i = 0; i<=kNDecades*kNPerDecade; ++i)
+        {
+            G4double tableEnergy = kMinEnergy*std::pow(10., static_cast<G4double>(i)/kNPerDecade);
+            G4double mu = 0.;
+            for(const char* process: {"compt", "phot", "conv"})
+                mu += emCalculator.ComputeCrossSectionPerVolume(tableEnergy, gamma, process, material);
+            table.push_back(mu);
+        }
+    }
+
+    // Linear in log(E), clamped to the table
+    G4double x = std::log10(energy/kMinEnergy)*kNPerDecade;
+    if(x<=0.) return table.front();
+    if(x>=kNDecades*kNPerDecade) return table.back();
+    auto i = static_cast<std::size_t>(x);
+    G4double f = x - static_cast<G4double>(i);
+    return (1. - f)*table[i] + f*table[i + 1];
+}
+
+void NextEventEstimator::EndOfEvent()
+{
+    if(!fActive || !fThreadState || !fThreadState->eventScored) return;
+    auto& state = *fThreadState;
+    for(std::size_t index = 0; index<state.eventFlux.size(); ++index)
+        if(state.eventFlux[index]>0.)
+        {
+            state.run->AddNextEventFlux(index, state.eventFlux[index]);
+            state.eventFlux[index] = 0.;
+        }
+    state.eventScored = false;
+}
+
+void NextEventEstimator::EndRun(const Run* run, const G4String& tag) const
+{
+    if(!fActive) return;
+    G4double nPrimaries = static_cast<G4double>(std::max(run->GetNEvents(), 1L));
+    const auto& flux = run->GetNextEventFlux();
+    const auto& flux2 = run->GetNextEventFlux2();
+    const auto& spectra = run->GetNextEventSpectra();
+    auto Mean = [&](std::size_t index) { return (index<flux.size()) ? flux[index]/nPrimaries : 0.; };
+    auto Error = [&](std::size_t index)
+    {
+        if(index>=flux.size()) return 0.;
+        G4double mean = flux[index]/nPrimaries;
+        return std::sqrt(std::max(0., flux2[index]/nPrimaries - mean*mean)/nPrimaries);
+    };
+
+    G4String fileName = EventAction::GetOutputFileName("nee", tag, ".txt");
+    std::ofstream out(fileName);
+    out << "# Next-event estimator: photon flux per primary (cm^-2), exclusion radius "
+        << fExclusionRadius/mm << " mm, " << run->GetNEvents() << " primaries\n"
+        << "# point\tX(mm)\tY(mm)\tZ(mm)\tuncollided\terror\tscattered\terror\n";
+    G4cout << "Next-event estimator, flux per primary (cm^-2):\n"
+           << "  point\tuncollided\trel. error\tscattered\trel. error" << G4endl;
+    for(std::size_t p = 0; p<fPoints.size(); ++p)
+    {
+        auto uncollided = p*kNComponents + kUncollided, scattered = p*kNComponents + kScattered;
+        out << p << "\t" << fPoints[p].x()/mm << "\t" << fPoints[p].y()/mm << "\t" << fPoints[p].z()/mm << "\t"
+            << Mean(uncollided)*cm2 << "\t" << Error(uncollided)*cm2 << "\t"
+            << Mean(scattered)*cm2 << "\t" << Error(scattered)*cm2 << "\n";
+        G4cout << "  " << p << "\t" << Mean(uncollided)*cm2 << "\t"
+               << ((Mean(uncollided)>0.) ? Error(uncollided)/Mean(uncollided) : 0.) << "\t"
+               << Mean(scattered)*cm2 << "\t" << ((Mean(scattered)>0.) ? Error(scattered)/Mean(scattered) : 0.) << G4endl;
+    }
+
+    // Spectra: one uncollided and one scattered column per point
+    out << "# spectra (cm^-2 per bin per primary)\n# E_low(keV)";
+    for(std::size_t p = 0; p<fPoints.size(); ++p) out << "\tP" << p << "_uncollided\tP" << p << "_scattered";
+    out << "\n";
+    auto nBins = static_cast<std::size_t>(fNEnergyBins);
+    for(std::size_t bin = 0; bin<nBins; ++bin)
+    {
+        out << bin*fMaxEnergy/fNEnergyBins/keV;
+        for(std::size_t index = 0; index<fPoints.size()*kNComponents; ++index)
+        {
+            auto spectrumIndex = index*nBins + bin;
+            out << "\t" << ((spectrumIndex<spectra.size()) ? spectra[spectrumIndex]/nPrimaries*cm2 : 0.);
+        }
+        out << "\n";
+    }
+    if(!out)
+        G4Exception("NextEventEstimator::EndRun()", "", JustWarning,
+                    G4String("    Cannot write " + fileName + ".").c_str());
+    else G4cout << "  written to " << fileName << G4endl;
+}
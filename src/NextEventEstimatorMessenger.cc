@@ -0,0 +1,125 @@
+#include "NextEventEstimatorMessenger.hh"
+#include "NextEventEstimator.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcommand.hh"
+#include "G4UIparameter.hh"
+#include "G4UIcmdWithADoubleAndUnit.hh"
+#include "G4UIcmdWithABool.hh"
+#include "G4UIcmdWithoutParameter.hh"
+
+#include <sstream>
+
+NextEventEstimatorMessenger::NextEventEstimatorMessenger(NextEventEstimator* estimator)
+: G4UImessenger(), fEstimator(estimator)
+{
+    fNEEDir = new G4UIdirectory("/ccTest/nee/");
+    fNEEDir->SetGuidance("Next-event point-detector estimator of the uncollided and scattered photon");
+    fNEEDir->SetGuidance("flux at detector points, written to output/nee.txt.");
+
+    fNEEEnableCmd = new G4UIcmdWithABool("/ccTest/nee/enable", this);
+    fNEEEnableCmd->SetGuidance("Score the flux at the detector points in the next runs.");
+    fNEEEnableCmd->SetParameterName("enable", true);
+    fNEEEnableCmd->SetDefaultValue(true);
+    fNEEEnableCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fNEEEnableCmd->SetToBeBroadcasted(false);
+
+    fNEEPointCmd = new G4UIcommand("/ccTest/nee/point", this);
+    fNEEPointCmd->SetGuidance("Add a detector point in the world frame.");
+    fNEEPointCmd->SetGuidance("  e.g. /ccTest/nee/point 0 0 150 cm");
+    fNEEPointCmd->SetParameter(new G4UIparameter("x", 'd', false));
+    fNEEPointCmd->SetParameter(new G4UIparameter("y", 'd', false));
+    fNEEPointCmd->SetParameter(new G4UIparameter("z", 'd', false));
+    auto pointUnitParam = new G4UIparameter("unit", 's', true);
+    pointUnitParam->SetDefaultValue("cm");
+    fNEEPointCmd->SetParameter(pointUnitParam);
+    fNEEPointCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fNEEPointCmd->SetToBeBroadcasted(false);
+
+    fNEEFaceGridCmd = new G4UIcommand("/ccTest/nee/faceGrid", this);
+    fNEEFaceGridCmd->SetGuidance("Detector points on an n x n grid over the front face of the camera of a");
+    fNEEFaceGridCmd->SetGuidance("view, placed at the beginning of each run.");
+    auto faceGridNParam = new G4UIparameter("n", 'i', false);
+    faceGridNParam->SetParameterRange("n>0");
+    fNEEFaceGridCmd->SetParameter(faceGridNParam);
+    auto faceGridViewParam = new G4UIparameter("view", 'i', true);
+    faceGridViewParam->SetDefaultValue(0);
+    faceGridViewParam->SetParameterRange("view>=0");
+    fNEEFaceGridCmd->SetParameter(faceGridViewParam);
+    fNEEFaceGridCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fNEEFaceGridCmd->SetToBeBroadcasted(false);
+
+    fNEEClearCmd = new G4UIcmdWithoutParameter("/ccTest/nee/clear", this);
+    fNEEClearCmd->SetGuidance("Remove all detector points and the face grid.");
+    fNEEClearCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fNEEClearCmd->SetToBeBroadcasted(false);
+
+    fNEEEnergyBinningCmd = new G4UIcommand("/ccTest/nee/energyBinning", this);
+    fNEEEnergyBinningCmd->SetGuidance("Binning of the flux spectra at the detector points.");
+    auto neeNBinsParam = new G4UIparameter("nBins", 'i', false);
+    neeNBinsParam->SetParameterRange("nBins>0");
+    fNEEEnergyBinningCmd->SetParameter(neeNBinsParam);
+    auto neeMaxEnergyParam = new G4UIparameter("maxEnergy", 'd', false);
+    neeMaxEnergyParam->SetParameterRange("maxEnergy>0.");
+    fNEEEnergyBinningCmd->SetParameter(neeMaxEnergyParam);
+    auto neeEnergyUnitParam = new G4UIparameter("unit", 's', true);
+    neeEnergyUnitParam->SetDefaultValue("keV");
+    fNEEEnergyBinningCmd->SetParameter(neeEnergyUnitParam);
+    fNEEEnergyBinningCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fNEEEnergyBinningCmd->SetToBeBroadcasted(false);
+
+    fNEEExclusionRadiusCmd = new G4UIcmdWithADoubleAndUnit("/ccTest/nee/exclusionRadius", this);
+    fNEEExclusionRadiusCmd->SetGuidance("Lower bound of the distance to a detector point in the 1/R^2 factor,");
+    fNEEExclusionRadiusCmd->SetGuidance("which keeps the variance finite for collisions near the point.");
+    fNEEExclusionRadiusCmd->SetParameterName("radius", false);
+    fNEEExclusionRadiusCmd->SetRange("radius>0.");
+    fNEEExclusionRadiusCmd->SetDefaultUnit("mm");
+    fNEEExclusionRadiusCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fNEEExclusionRadiusCmd->SetToBeBroadcasted(false);
+}
+
+NextEventEstimatorMessenger::~NextEventEstimatorMessenger()
+{
+    delete fNEEExclusionRadiusCmd;
+    delete fNEEEnergyBinningCmd;
+    delete fNEEClearCmd;
+    delete fNEEFaceGridCmd;
+    delete fNEEPointCmd;
+    delete fNEEEnableCmd;
+    delete fNEEDir;
+}
+
+void NextEventEstimatorMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+    if(command==fNEEEnableCmd)
+        fEstimator->SetEnabled(fNEEEnableCmd->GetNewBoolValue(newValue));
+    else if(command==fNEEPointCmd)
+    {
+        std::istringstream iss(newValue);
+        G4double x, y, z;
+        G4String unit;
+        iss >> x >> y >> z >> unit;
+        G4double value = G4UIcommand::ValueOf(unit);
+        fEstimator->AddPoint(G4ThreeVector(x*value, y*value, z*value));
+    }
+    else if(command==fNEEFaceGridCmd)
+    {
+        std::istringstream iss(newValue);
+        G4int n, view;
+        iss >> n >> view;
+        fEstimator->SetFaceGrid(n, view);
+    }
+    else if(command==fNEEClearCmd)
+        fEstimator->ClearPoints();
+    else if(command==fNEEEnergyBinningCmd)
+    {
+        std::istringstream iss(newValue);
+        G4int nBins;
+        G4double value;
+        G4String unit;
+        iss >> nBins >> value >> unit;
+        fEstimator->SetEnergyBinning(nBins, value*G4UIcommand::ValueOf(unit));
+    }
+    else if(command==fNEEExclusionRadiusCmd)
+        fEstimator->SetExclusionRadius(fNEEExclusionRadiusCmd->GetNewDoubleValue(newValue));
+}
@@ -0,0 +1,105 @@
+#include "NuclideLineSource.hh"
+#include "NuclideLineSourceMessenger.hh"
+
+#include "Randomize.hh"
+
+#include <cmath>
+
+NuclideLineSource* NuclideLineSource::GetInstance()
+{
+    static NuclideLineSource fInstance;
+    return &fInstance;
+}
+
+NuclideLineSource::NuclideLineSource()
+: fEnabled(false), fCoolingTime(0.)
+{
+    // Half-lives and lines with yield >1% (ENSDF)
+    fNuclides =
+    {
+        {"Cs137", 30.08*year, 1.*becquerel},
+        {"Cs134", 2.0652*year, 0.},
+        {"Eu154", 8.601*year, 0.}
+    };
+    fLines =
+    {
+        {"Cs137", 661.657*keV, 0.851},
+
+        {"Cs134", 475.365*keV, 0.0148},
+        {"Cs134", 563.246*keV, 0.0834},
+        {"Cs134", 569.331*keV, 0.1537},
+        {"Cs134", 604.721*keV, 0.9762},
+        {"Cs134", 795.864*keV, 0.8553},
+        {"Cs134", 801.953*keV, 0.0869},
+        {"Cs134", 1365.185*keV, 0.0302},
+
+        {"Eu154", 123.071*keV, 0.404},
+        {"Eu154", 247.930*keV, 0.0689},
+        {"Eu154", 591.755*keV, 0.0495},
+        {"Eu154", 692.420*keV, 0.0179},
+        {"Eu154", 723.301*keV, 0.2005},
+        {"Eu154", 756.800*keV, 0.0452},
+        {"Eu154", 873.183*keV, 0.1222},
+        {"Eu154", 996.290*keV, 0.1048},
+        {"Eu154", 1004.760*keV, 0.1801},
+        {"Eu154", 1274.429*keV, 0.349},
+        {"Eu154", 1596.480*keV, 0.0178}
+    };
+    Update();
+    fMessenger = std::make_unique<NuclideLineSourceMessenger>(this);
+}
+
+NuclideLineSource::~NuclideLineSource()
+{}
+
+G4bool NuclideLineSource::SetActivity(const G4String& nuclide, G4double activity)
+{
+    for(auto& aNuclide: fNuclides)
+    {
+        if(aNuclide.name!=nuclide) continue;
+        aNuclide.activity = activity;
+        Update();
+        return true;
+    }
+
+    G4Exception("NuclideLineSource::SetActivity()", "", JustWarning,
+                G4String("    Unknown nuclide '" + nuclide + "'.").c_str());
+    return false;
+}
+
+void NuclideLineSource::SetCoolingTime(G4double coolingTime)
+{
+    fCoolingTime = coolingTime;
+    Update();
+}
+
+void NuclideLineSource::Update()
+{
+    fIntensities.assign(fLines.size(), 0.);
+    for(const auto& nuclide: fNuclides)
+    {
+        G4double activity = nuclide.activity*std::exp(-std::log(2.)*fCoolingTime/nuclide.halfLife);
+        for(std::size_t i = 0; i<fLines.size(); ++i)
+            if(fLines[i].nuclide==nuclide.name) fIntensities[i] = activity*fLines[i].yield;
+    }
+    fAliasTable = AliasTable(fIntensities);
+
+    if(GetTotalIntensity()<=0.)
+        G4Exception("NuclideLineSource::Update()", "", JustWarning,
+                    "    All nuclide activities are zero.");
+}
+
+G4int NuclideLineSource::SampleLine() const
+{
+    return fAliasTable.Sample(G4UniformRand());
+}
+
+void NuclideLineSource::Print(std::ostream& out) const
+{
+    out << "# gamma lines (cooling time " << fCoolingTime/year << " y, "
+        << "total " << GetTotalIntensity()/becquerel << " photons/s)\n"
+        << "# LineID\tNuclide\tE(keV)\tRelativeIntensity\n";
+    for(std::size_t i = 0; i<fLines.size(); ++i)
+        out << "# " << i << "\t" << fLines[i].nuclide << "\t" << fLines[i].energy/keV << "\t"
+            << (GetTotalIntensity()>0. ? fIntensities[i]/GetTotalIntensity() : 0.) << "\n";
+}
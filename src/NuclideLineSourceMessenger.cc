@@ -0,0 +1,82 @@
+#include "NuclideLineSourceMessenger.hh"
+#include "NuclideLineSource.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcommand.hh"
+#include "G4UIparameter.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithADoubleAndUnit.hh"
+#include "G4UIcmdWithoutParameter.hh"
+
+#include <sstream>
+
+NuclideLineSourceMessenger::NuclideLineSourceMessenger(NuclideLineSource* source)
+: G4UImessenger(), fSource(source)
+{
+    fSourceDir = new G4UIdirectory("/ccTest/source/");
+    fSourceDir->SetGuidance("Primary source.");
+
+    fSourceTypeCmd = new G4UIcmdWithAString("/ccTest/source/type", this);
+    fSourceTypeCmd->SetGuidance("gun: particle and energy of /gun/.");
+    fSourceTypeCmd->SetGuidance("nuclides: gammas sampled from the nuclide line table; the line ID is");
+    fSourceTypeCmd->SetGuidance("recorded per event (LineID column of output/data.txt).");
+    fSourceTypeCmd->SetParameterName("type", false);
+    fSourceTypeCmd->SetCandidates("gun nuclides");
+    fSourceTypeCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fSourceTypeCmd->SetToBeBroadcasted(false);
+
+    fActivityCmd = new G4UIcommand("/ccTest/source/activity", this);
+    fActivityCmd->SetGuidance("Activity of a nuclide at discharge (only ratios matter for the sampling).");
+    auto nuclideParam = new G4UIparameter("nuclide", 's', false);
+    nuclideParam->SetParameterCandidates("Cs137 Cs134 Eu154");
+    fActivityCmd->SetParameter(nuclideParam);
+    auto activityParam = new G4UIparameter("activity", 'd', false);
+    activityParam->SetParameterRange("activity>=0.");
+    fActivityCmd->SetParameter(activityParam);
+    auto activityUnitParam = new G4UIparameter("unit", 's', true);
+    activityUnitParam->SetDefaultValue("Bq");
+    fActivityCmd->SetParameter(activityUnitParam);
+    fActivityCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fActivityCmd->SetToBeBroadcasted(false);
+
+    fCoolingTimeCmd = new G4UIcmdWithADoubleAndUnit("/ccTest/source/coolingTime", this);
+    fCoolingTimeCmd->SetGuidance("Time since discharge; activities decay with the nuclide half-lives.");
+    fCoolingTimeCmd->SetParameterName("time", false);
+    fCoolingTimeCmd->SetRange("time>=0.");
+    fCoolingTimeCmd->SetDefaultUnit("y");
+    fCoolingTimeCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fCoolingTimeCmd->SetToBeBroadcasted(false);
+
+    fListLinesCmd = new G4UIcmdWithoutParameter("/ccTest/source/list", this);
+    fListLinesCmd->SetGuidance("Print the gamma line table with the current relative intensities.");
+    fListLinesCmd->SetToBeBroadcasted(false);
+}
+
+NuclideLineSourceMessenger::~NuclideLineSourceMessenger()
+{
+    delete fAxialProfileCmd;
+    delete fAssemblyActivitiesCmd;
+    delete fListLinesCmd;
+    delete fCoolingTimeCmd;
+    delete fActivityCmd;
+    delete fSourceTypeCmd;
+    delete fSourceDir;
+}
+
+void NuclideLineSourceMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+    if(command==fSourceTypeCmd)
+        fSource->SetEnabled(newValue=="nuclides");
+    else if(command==fActivityCmd)
+    {
+        std::istringstream iss(newValue);
+        G4String nuclide, unit;
+        G4double activity;
+        iss >> nuclide >> activity >> unit;
+        fSource->SetActivity(nuclide, activity*G4UIcommand::ValueOf(unit));
+    }
+    else if(command==fCoolingTimeCmd)
+        fSource->SetCoolingTime(fCoolingTimeCmd->GetNewDoubleValue(newValue));
+    else if(command==fListLinesCmd)
+        fSource->Print(G4cout);
+}
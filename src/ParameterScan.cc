@@ -0,0 +1,63 @@
+#include "ParameterScan.hh"
+#include "ParameterScanMessenger.hh"
+#include "DetectorConstruction.hh"
+
+#include "G4UIcommand.hh"
+#include "G4UImanager.hh"
+
+#include <chrono>
+#include <cstdlib>
+#include <sstream>
+#include <vector>
+
+ParameterScan::ParameterScan(DetectorConstruction* detector)
+: fDetector(detector)
+{
+    fMessenger = std::make_unique<ParameterScanMessenger>(this);
+}
+
+ParameterScan::~ParameterScan()
+{}
+
+void ParameterScan::Scan(const G4String& parameterName, G4int nEvents, const G4String& values)
+{
+    std::vector<G4String> valueVec;
+    std::istringstream iss(values);
+    for(G4String value; iss >> value;) valueVec.push_back(value);
+
+    // A trailing non-numeric token of a length scan is its unit
+    G4String unit;
+    char* end = nullptr;
+    if(parameterName=="sc2abDistance" && !valueVec.empty() &&
+       (std::strtod(valueVec.back().c_str(), &end), *end!='\0'))
+    {
+        unit = valueVec.back();
+        valueVec.pop_back();
+    }
+
+    auto UImanager = G4UImanager::GetUIpointer();
+    G4String outputTag = fDetector->GetOutputTag();
+    std::vector<std::pair<G4String, G4double>> timings;
+    for(const auto& value: valueVec)
+    {
+        G4String setCommand = "/ccTest/det/" + parameterName + " " + value;
+        if(!unit.empty()) setCommand += " " + unit;
+        if(UImanager->ApplyCommand(setCommand)!=0)
+        {
+            G4Exception("ParameterScan::Scan()", "", JustWarning,
+                        G4String("    Scan aborted at '" + setCommand + "'.").c_str());
+            break;
+        }
+        fDetector->SetOutputTag(parameterName + "_" + value + unit);
+        auto start = std::chrono::steady_clock::now();
+        UImanager->ApplyCommand("/run/beamOn " + G4UIcommand::ConvertToString(nEvents));
+        timings.emplace_back(value + unit, std::chrono::duration<G4double>(std::chrono::steady_clock::now() - start).count());
+    }
+    fDetector->SetOutputTag(outputTag);
+
+    G4cout << "Scan of " << parameterName << " (" << nEvents << " events per point):\n"
+           << "  value\twall time (s)\tevents/s" << G4endl;
+    for(const auto& timing: timings)
+        G4cout << "  " << timing.first << "\t" << timing.second << "\t"
+               << ((timing.second>0.) ? nEvents/timing.second : 0.) << G4endl;
+}
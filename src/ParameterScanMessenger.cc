@@ -0,0 +1,53 @@
+#include "ParameterScanMessenger.hh"
+#include "ParameterScan.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcommand.hh"
+#include "G4UIparameter.hh"
+
+#include <sstream>
+
+ParameterScanMessenger::ParameterScanMessenger(ParameterScan* scan)
+: G4UImessenger(), fScan(scan)
+{
+    fScanDir = new G4UIdirectory("/ccTest/scan/");
+    fScanDir->SetGuidance("In-process parameter scans.");
+
+    fScanCmd = new G4UIcommand("/ccTest/scan/run", this);
+    fScanCmd->SetGuidance("Run nEvents for each value of a geometry parameter.");
+    fScanCmd->SetGuidance("Only the geometry is rebuilt between the points, and each point");
+    fScanCmd->SetGuidance("writes to its own output file tagged with the parameter value.");
+    fScanCmd->SetGuidance("  e.g. /ccTest/scan/run sc2abDistance 100000 5 10 15 20 cm");
+    fScanCmd->SetGuidance("       /ccTest/scan/run camera 100000 TestCC1 LACC");
+    fScanCmd->SetGuidance("The wall time of each point is summarized at the end (scaling");
+    fScanCmd->SetGuidance("benchmark, e.g. /ccTest/scan/run nAssemblies 100000 1 2 4 8 16 24 32).");
+    auto parameterParam = new G4UIparameter("parameter", 's', false);
+    parameterParam->SetParameterCandidates("camera sc2abDistance fuelRodRatio nAssemblies homogenized");
+    fScanCmd->SetParameter(parameterParam);
+    auto nEventsParam = new G4UIparameter("nEvents", 'i', false);
+    nEventsParam->SetParameterRange("nEvents>0");
+    fScanCmd->SetParameter(nEventsParam);
+    auto valuesParam = new G4UIparameter("values", 's', false);
+    fScanCmd->SetParameter(valuesParam);
+    fScanCmd->AvailableForStates(G4State_Idle);
+    fScanCmd->SetToBeBroadcasted(false);
+}
+
+ParameterScanMessenger::~ParameterScanMessenger()
+{
+    delete fScanCmd;
+    delete fScanDir;
+}
+
+void ParameterScanMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+    if(command==fScanCmd)
+    {
+        std::istringstream iss(newValue);
+        G4String parameterName, values;
+        G4int nEvents;
+        iss >> parameterName >> nEvents;
+        std::getline(iss, values);
+        fScan->Scan(parameterName, nEvents, values);
+    }
+}
@@ -10,11 +10,17 @@
 #include "G4IonBinaryCascadePhysics.hh"
 #include "G4NeutronTrackingCut.hh"
 
-PhysicsList::PhysicsList()
+PhysicsList::PhysicsList(G4bool lean)
 : G4VModularPhysicsList()
 {
     SetVerboseLevel(1);
 
+    if(lean)
+    {
+        RegisterPhysics(new G4EmStandardPhysics());
+        return;
+    }
+
     // Decay physics
     RegisterPhysics(new G4DecayPhysics());
     // EM physics
@@ -0,0 +1,128 @@
+#include "PileUpStream.hh"
+#include "EventAction.hh"
+#include "SinglesStream.hh"
+
+#include "G4Threading.hh"
+#include "Randomize.hh"
+#ifdef G4MULTITHREADED
+#include "G4MTRunManager.hh"
+#endif
+
+#include <algorithm>
+#include <filesystem>
+
+G4double PileUpStream::fActivity = 0.;
+G4bool PileUpStream::fStreaming = false;
+G4String PileUpStream::fStreamTag;
+G4String PileUpStream::fStreamDirectory;
+G4int PileUpStream::fNStreams = 1;
+G4bool PileUpStream::fAppend = false;
+G4double PileUpStream::fRunStart = 0.;
+G4double PileUpStream::fRunWindow = 0.;
+G4double PileUpStream::fStreamTime = 0.;
+G4ThreadLocal SinglesWriter* PileUpStream::fWriter = nullptr;
+
+G4String PileUpStream::GetFileName(const G4String& tag, G4int threadID)
+{
+    return EventAction::GetOutputFileName("singles", tag, "_t" + std::to_string(threadID) + ".bin");
+}
+
+void PileUpStream::BeginMasterRun(const G4String& tag, G4long nEvents)
+{
+    if(!IsEnabled())
+    {
+        fStreaming = false;
+        return;
+    }
+
+    fNStreams = 1;
+#ifdef G4MULTITHREADED
+    if(G4Threading::IsMultithreadedApplication())
+        fNStreams = G4MTRunManager::GetMasterRunManager()->GetNumberOfThreads();
+#endif
+    fAppend = fStreaming && tag==fStreamTag && EventAction::GetOutputDirectory()==fStreamDirectory;
+    if(!fAppend) fStreamTime = 0.;
+    fStreaming = true;
+    fStreamTag = tag;
+    fStreamDirectory = EventAction::GetOutputDirectory();
+    fRunStart = fStreamTime;
+    fRunWindow = static_cast<G4double>(nEvents)/fActivity;
+    fStreamTime += fRunWindow;
+}
+
+void PileUpStream::GetStreamState(G4double& time, std::vector<std::uintmax_t>& fileSizes)
+{
+    time = 0.;
+    fileSizes.clear();
+    if(!fStreaming) return;
+
+    time = fStreamTime;
+    for(G4int threadID = 0; threadID<fNStreams; ++threadID)
+    {
+        std::error_code error;
+        auto size = std::filesystem::file_size(std::string(GetFileName(fStreamTag, threadID)), error);
+        fileSizes.push_back(error ? 0 : size);
+    }
+}
+
+G4bool PileUpStream::ResumeStreams(const G4String& tag, G4double time, const std::vector<std::uintmax_t>& fileSizes)
+{
+    fStreaming = false;
+    if(fileSizes.empty()) return true;
+
+    // Drop whatever was written after the checkpoint
+    for(std::size_t threadID = 0; threadID<fileSizes.size(); ++threadID)
+    {
+        std::error_code error;
+        std::filesystem::resize_file(std::string(GetFileName(tag, static_cast<G4int>(threadID))), fileSizes[threadID], error);
+        if(error) return false;
+    }
+    fStreaming = true;
+    fStreamTag = tag;
+    fStreamDirectory = EventAction::GetOutputDirectory();
+    fStreamTime = time;
+    return true;
+}
+
+void PileUpStream::BeginRun(const G4String& tag)
+{
+    EndRun();
+    if(!IsEnabled() || !fStreaming) return;
+
+    G4int threadID = std::max(G4Threading::G4GetThreadId(), 0);
+    G4String fileName = GetFileName(tag, threadID);
+    fWriter = new SinglesWriter(fileName, fAppend);
+    if(!fWriter->IsOpen())
+        G4Exception("PileUpStream::BeginRun()", "", JustWarning,
+                    G4String("    Cannot write '" + fileName + "'.").c_str());
+}
+
+void PileUpStream::EndRun()
+{
+    delete fWriter;
+    fWriter = nullptr;
+}
+
+void PileUpStream::AddEvent(G4long eventID, const CCHitsMap* hitsMap)
+{
+    if(!fWriter) return;
+
+    // Drawn for every event, with or without hits
+    G4double arrivalTime = fRunStart + G4UniformRand()*fRunWindow;
+    if(!hitsMap) return;
+
+    for(const auto& itr: *hitsMap)
+    {
+        const CCHit* hit = itr.second;
+        Single single;
+        single.time = (arrivalTime + hit->GetTime())/ns;
+        single.eventID = eventID;
+        single.detID = itr.first;
+        single.energy = static_cast<float>(hit->GetMeasuredDepE()/keV);
+        single.x = static_cast<float>(hit->GetMeasuredPosition().x()/mm);
+        single.y = static_cast<float>(hit->GetMeasuredPosition().y()/mm);
+        single.z = static_cast<float>(hit->GetMeasuredPosition().z()/mm);
+        single.weight = static_cast<float>(hit->GetWeight());
+        fWriter->Add(single);
+    }
+}
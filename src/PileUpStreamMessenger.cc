@@ -0,0 +1,46 @@
+#include "PileUpStreamMessenger.hh"
+#include "PileUpStream.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcommand.hh"
+#include "G4UIparameter.hh"
+
+#include <sstream>
+
+PileUpStreamMessenger::PileUpStreamMessenger()
+: G4UImessenger()
+{
+    fPileUpDir = new G4UIdirectory("/ccTest/pileup/");
+    fPileUpDir->SetGuidance("Time-stamped singles streams at a given activity (see tools/sortCoincidences).");
+
+    fPileUpActivityCmd = new G4UIcommand("/ccTest/pileup/activity", this);
+    fPileUpActivityCmd->SetGuidance("Poisson arrival rate of the simulated primaries (0 disables). Each thread");
+    fPileUpActivityCmd->SetGuidance("writes its singles to output/singles[_<tag>]_t<thread>.bin in time order;");
+    fPileUpActivityCmd->SetGuidance("runs with the same tag continue the streams.");
+    auto pileUpActivityParam = new G4UIparameter("activity", 'd', false);
+    pileUpActivityParam->SetParameterRange("activity>=0.");
+    fPileUpActivityCmd->SetParameter(pileUpActivityParam);
+    auto pileUpUnitParam = new G4UIparameter("unit", 's', true);
+    pileUpUnitParam->SetDefaultValue("Bq");
+    fPileUpActivityCmd->SetParameter(pileUpUnitParam);
+    fPileUpActivityCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fPileUpActivityCmd->SetToBeBroadcasted(false);
+}
+
+PileUpStreamMessenger::~PileUpStreamMessenger()
+{
+    delete fPileUpActivityCmd;
+    delete fPileUpDir;
+}
+
+void PileUpStreamMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+    if(command==fPileUpActivityCmd)
+    {
+        std::istringstream iss(newValue);
+        G4double activity;
+        G4String unit;
+        iss >> activity >> unit;
+        PileUpStream::SetActivity(activity*G4UIcommand::ValueOf(unit));
+    }
+}
@@ -0,0 +1,85 @@
+#include "PixelatedCCBuilder.hh"
+#include "TestCCBuilder.hh"
+
+#include "G4Box.hh"
+#include "G4LogicalVolume.hh"
+#include "G4VisAttributes.hh"
+#include "G4PVPlacement.hh"
+#include "G4PVReplica.hh"
+
+PixelatedDetector::PixelatedDetector(G4int nPixelX, G4int nPixelY,
+                                     G4double pixelPitch, G4double pixelThickness, G4double reflectorThickness)
+: Detector(), fNPixelX(nPixelX), fNPixelY(nPixelY)
+{
+    // Geometry tree view
+    // - PixelModule
+    // | - PixelRow (replica along y, fNPixelY)
+    // | | - PixelCell (replica along x, fNPixelX, reflector)
+    // | | | - Pixel (crystal)
+    //
+    // Replicas keep the number of physical volumes and the navigation cost
+    // independent of the pixel count.
+
+    if(fNPixelX<1 || fNPixelX>256 || fNPixelY<1 || fNPixelY>256)
+        G4Exception("PixelatedDetector::PixelatedDetector()", "", FatalException,
+                    "    Number of pixels per axis must be 1-256.");
+
+    auto GAGGCe = GAGGDetector::FindOrBuildGAGGCe();
+    auto nistBaSO4 = G4NistManager::Instance()->FindOrBuildMaterial("G4_BARIUM_SULFATE");
+
+    G4double crystalWidth = pixelPitch - reflectorThickness;
+    auto pixelSol = new G4Box("Pixel", crystalWidth/2., crystalWidth/2., pixelThickness/2.);
+    fPixelLV = new G4LogicalVolume(pixelSol, GAGGCe, "Pixel");
+    auto pixelVA = new G4VisAttributes(G4Colour::Yellow());
+    pixelVA->SetForceSolid();
+    fPixelLV->SetVisAttributes(pixelVA);
+
+    auto cellSol = new G4Box("PixelCell", pixelPitch/2., pixelPitch/2., pixelThickness/2.);
+    auto cellLV = new G4LogicalVolume(cellSol, nistBaSO4, "PixelCell");
+    cellLV->SetVisAttributes(G4VisAttributes::Invisible);
+    new G4PVPlacement(nullptr, G4ThreeVector(), fPixelLV, "Pixel", cellLV, false, 0);
+
+    auto rowSol = new G4Box("PixelRow", fNPixelX*pixelPitch/2., pixelPitch/2., pixelThickness/2.);
+    auto rowLV = new G4LogicalVolume(rowSol, nistBaSO4, "PixelRow");
+    rowLV->SetVisAttributes(G4VisAttributes::Invisible);
+    new G4PVReplica("PixelCell", cellLV, rowLV, kXAxis, fNPixelX, pixelPitch);
+
+    auto moduleSol = new G4Box("PixelModule", fNPixelX*pixelPitch/2., fNPixelY*pixelPitch/2., pixelThickness/2.);
+    fDetectorLV = new G4LogicalVolume(moduleSol, nistBaSO4, "PixelModule");
+    fDetectorLV->SetVisAttributes(G4VisAttributes::Invisible);
+    new G4PVReplica("PixelRow", rowLV, fDetectorLV, kYAxis, fNPixelY, pixelPitch);
+}
+
+PixelatedCC::PixelatedCC(G4String name, G4double sc2abDistance,
+                         G4int nPixelX, G4int nPixelY, G4double pixelPitch,
+                         G4double scThk, G4double abThk)
+: SimpleScAbCC(name, sc2abDistance)
+{
+    // Geometry tree view
+    // - PixelatedCC
+    // | - Scatter (PixelModule, copy 0)
+    // | - Absorber (PixelModule, copy 1)
+
+    G4double reflectorThickness = 0.2*mm;
+    fScatter = std::make_shared<PixelatedDetector>(nPixelX, nPixelY, pixelPitch, scThk, reflectorThickness);
+    fAbsorber = std::make_shared<PixelatedDetector>(nPixelX, nPixelY, pixelPitch, abThk, reflectorThickness);
+
+    G4ThreeVector pMin, pMax;
+    fScatter->GetLogicalVolume()->GetSolid()->BoundingLimits(pMin, pMax);
+    G4ThreeVector scatterDimension = pMax - pMin;
+    fAbsorber->GetLogicalVolume()->GetSolid()->BoundingLimits(pMin, pMax);
+    G4ThreeVector absorberDimension = pMax - pMin;
+    G4double CCWidth = std::max(scatterDimension.x(), absorberDimension.x());
+    G4double CCLength = std::max(scatterDimension.y(), absorberDimension.y());
+    fSc2AbDistance = std::max(scatterDimension.z(), fSc2AbDistance);
+    G4double CCHeight = fSc2AbDistance + absorberDimension.z();
+
+    auto CCSol = new G4Box(GetName(), CCWidth/2., CCLength/2., CCHeight/2.);
+    auto nistAir = G4NistManager::Instance()->FindOrBuildMaterial("G4_AIR");
+    fCCLV = new G4LogicalVolume(CCSol, nistAir, GetName());
+
+    new G4PVPlacement(nullptr, G4ThreeVector(0., 0., CCHeight/2. - scatterDimension.z()/2.),
+                      fScatter->GetLogicalVolume(), "Scatter", fCCLV, false, 0);
+    new G4PVPlacement(nullptr, G4ThreeVector(0., 0., - CCHeight/2. + absorberDimension.z()/2.),
+                      fAbsorber->GetLogicalVolume(), "Absorber", fCCLV, false, 1);
+}
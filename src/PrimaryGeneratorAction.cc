@@ -1,8 +1,18 @@
 #include "PrimaryGeneratorAction.hh"
 #include "SpentFuelAssemblyBuilder.hh"
 #include "PrimarySamplingTools.hh"
+#include "EventInformation.hh"
+#include "NuclideLineSource.hh"
+#include "Run.hh"
+#include "Campaign.hh"
+#include "EventSeeder.hh"
+#include "SystemMatrix.hh"
+#include "SymmetryFolding.hh"
 
 #include "G4Tubs.hh"
+#include "G4Gamma.hh"
+#include "G4PrimaryParticle.hh"
+#include "G4RunManager.hh"
 
 PrimaryGeneratorAction::PrimaryGeneratorAction()
 : G4VUserPrimaryGeneratorAction()
@@ -15,24 +25,38 @@ PrimaryGeneratorAction::~PrimaryGeneratorAction()
 
 void PrimaryGeneratorAction::GeneratePrimaries(G4Event* anEvent)
 {
-    if(!fSpentFuelAssembly)
-        fSpentFuelAssembly = SpentFuelAssemblyStore::GetInstance()->GetSpentFuelAssembly("SpentFuelAssembly");
+    // Nothing random is drawn in the event before this point
+    auto eventSeeder = EventSeeder::GetInstance();
+    if(eventSeeder->IsEnabled())
+    {
+        auto campaign = Campaign::GetInstance();
+        G4int runID = campaign->IsActive() ? 0 : G4RunManager::GetRunManager()->GetCurrentRun()->GetRunID();
+        eventSeeder->SeedEvent(runID, campaign->GetEventOffset() + anEvent->GetEventID());
+    }
+
+    auto spentFuelAssemblyStore = SpentFuelAssemblyStore::GetInstance();
 
     G4double particleWeight = 1.;
-    G4double fuelRodHeight = 2*static_cast<G4Tubs*>(fSpentFuelAssembly->GetFuelRod()->GetLogicalVolume()->GetSolid())->GetZHalfLength();
+    G4double fuelRodHeight = 2*static_cast<G4Tubs*>(spentFuelAssemblyStore->front()->GetFuelRod()->GetLogicalVolume()->GetSolid())->GetZHalfLength();
     particleWeight *= fuelRodHeight/(4.*m);
 
-    // source position
-    G4int randomFuelRodCopyNumber = fSpentFuelAssembly->SampleRandomFuelRodID();
-    auto randomPointInFuelRod = fSpentFuelAssembly->GetFuelRod()->SampleRandomPointInFuelRod();
-    auto fuelRodPosition = fSpentFuelAssembly->GetFuelRodLocation(randomFuelRodCopyNumber);
-    auto spentFuelAssemblyRotation =
-            G4PhysicalVolumeStore::GetInstance()->GetVolume("SpentFuelAssembly")->GetObjectRotationValue();
-    auto spentFuelAssemblyTranslation =
-            G4PhysicalVolumeStore::GetInstance()->GetVolume("SpentFuelAssembly")->GetObjectTranslation();
-    auto srcPos =
-            spentFuelAssemblyTranslation +
-            (fuelRodPosition + randomPointInFuelRod).rotate(spentFuelAssemblyRotation.axisAngle());
+    // source position: assembly -> rod -> axial position
+    // (basis mode: every rod, whatever its status; matrix sweep: the point of the event;
+    // symmetry folding: moved into the fundamental domain)
+    G4int randomFuelRodCopyNumber;
+    G4ThreeVector srcPos;
+    auto systemMatrix = SystemMatrix::GetInstance();
+    if(systemMatrix->IsActive())
+    {
+        randomFuelRodCopyNumber = systemMatrix->GetPointID(anEvent->GetEventID());
+        srcPos = systemMatrix->SamplePoint(randomFuelRodCopyNumber);
+        particleWeight = 1.; // matrix elements are per emitted photon
+    }
+    else
+    {
+        srcPos = spentFuelAssemblyStore->SampleSourcePosition(Run::GetBasisMode(), randomFuelRodCopyNumber);
+        srcPos = SymmetryFolding::GetInstance()->Fold(srcPos, randomFuelRodCopyNumber);
+    }
     fPrimary->SetParticlePosition(srcPos);
 
     // source direction
@@ -43,4 +67,17 @@ void PrimaryGeneratorAction::GeneratePrimaries(G4Event* anEvent)
     // Generate primary
     fPrimary->GeneratePrimaryVertex(anEvent);
     anEvent->GetPrimaryVertex()->SetWeight(particleWeight);
+
+    // Nuclide source: gamma energy from the line table (the gun keeps its own)
+    G4int lineID = -1;
+    auto nuclideLineSource = NuclideLineSource::GetInstance();
+    if(nuclideLineSource->IsEnabled())
+    {
+        lineID = nuclideLineSource->SampleLine();
+        auto primary = anEvent->GetPrimaryVertex()->GetPrimary();
+        primary->SetParticleDefinition(G4Gamma::Definition());
+        primary->SetKineticEnergy(nuclideLineSource->GetLine(lineID).energy);
+    }
+
+    anEvent->SetUserInformation(new EventInformation(randomFuelRodCopyNumber, lineID));
 }
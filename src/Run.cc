@@ -0,0 +1,269 @@
+#include "Run.hh"
+#include "BasisLibrary.hh"
+#include "CCHit.hh"
+#include "CCSensitiveDetector.hh"
+#include "DetectorConstruction.hh"
+#include "EventInformation.hh"
+#include "LeakageDetector.hh"
+#include "NextEventEstimator.hh"
+#include "SpentFuelAssemblyBuilder.hh"
+#include "SymmetryFolding.hh"
+#include "SystemMatrix.hh"
+
+#include "G4RunManager.hh"
+#include "G4SDManager.hh"
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+
+namespace
+{
+    void WriteVector(std::ostream& out, const std::vector<G4double>& values)
+    {
+        auto size = static_cast<std::uint64_t>(values.size());
+        out.write(reinterpret_cast<const char*>(&size), sizeof(size));
+        out.write(reinterpret_cast<const char*>(values.data()), static_cast<std::streamsize>(size*sizeof(G4double)));
+    }
+
+    G4bool ReadVector(std::istream& in, std::vector<G4double>& values)
+    {
+        std::uint64_t size = 0;
+        if(!in.read(reinterpret_cast<char*>(&size), sizeof(size)) || size>(1ull << 32)) return false;
+        values.resize(static_cast<std::size_t>(size));
+        return static_cast<G4bool>(in.read(reinterpret_cast<char*>(values.data()),
+                                           static_cast<std::streamsize>(size*sizeof(G4double))));
+    }
+}
+
+G4bool Run::fBasisMode = false;
+G4int Run::fBasisNEnergyBins = 256;
+G4double Run::fBasisMaxEnergy = 2.*MeV;
+G4int Run::fBasisNImageBins = 32;
+G4double Run::fBasisImageHalfWidth = 10.*cm;
+
+Run::Run()
+: G4Run(), fCCHCID(-1), fCCSD(nullptr), fNCoincidences(0), fAborted(false)
+{
+    fNKilledTracks.fill(0);
+    fKilledEnergy.fill(0.);
+    if(!fBasisMode) return;
+
+    // Assemblies stacked along y: global rod ID = x + nX*(y + nY*assembly)
+    auto spentFuelAssemblyStore = SpentFuelAssemblyStore::GetInstance();
+    const auto& spentFuelAssembly = spentFuelAssemblyStore->front();
+    fBasisLibrary = std::make_unique<BasisLibrary>(spentFuelAssembly->GetNX(),
+                                                   spentFuelAssembly->GetNY()*static_cast<G4int>(spentFuelAssemblyStore->size()),
+                                                   fBasisNEnergyBins, fBasisMaxEnergy/keV,
+                                                   fBasisNImageBins, fBasisImageHalfWidth/mm);
+}
+
+Run::~Run()
+{}
+
+void Run::RecordEvent(const G4Event* anEvent)
+{
+    G4Run::RecordEvent(anEvent);
+    ++fTallies.nEvents;
+    ++fPendingTallies.nEvents;
+    ReportToTarget();
+
+    auto eventInformation = static_cast<const EventInformation*>(anEvent->GetUserInformation());
+    if(fBasisLibrary && eventInformation) fBasisLibrary->AddPrimary(eventInformation->GetFuelRodID());
+
+    // Run tallies and the basis library follow the camera below the source (view 0)
+    if(fCCHCID==-1)
+    {
+        auto sdManager = G4SDManager::GetSDMpointer();
+        fCCHCID = sdManager->GetCollectionID(DetectorConstruction::GetReadoutName(0) + "/CCData");
+        fCCSD = static_cast<CCSensitiveDetector*>(
+                    sdManager->FindSensitiveDetector(DetectorConstruction::GetReadoutName(0), false));
+    }
+    auto HCE = anEvent->GetHCofThisEvent();
+    auto hitsMap = HCE ? static_cast<CCHitsMap*>(HCE->GetHC(fCCHCID)) : nullptr;
+
+    // Matrix sweep: every photon counts for its source point
+    auto systemMatrix = SystemMatrix::GetInstance();
+    G4double weight = fCCSD ? fCCSD->GetEventWeight() : 0.;
+    if(systemMatrix->IsActive() && eventInformation)
+        systemMatrix->RecordEvent(eventInformation->GetFuelRodID(), hitsMap, weight);
+    if(!hitsMap || hitsMap->entries()==0) return;
+    if(hitsMap->entries()>=2) ++fNCoincidences;
+
+    // Symmetry folding: every replica counts with its share of the weight;
+    // the replicas of a history are one sample of the tallies
+    std::array<G4double, RunTarget::kNTallies> eventWeights;
+    eventWeights.fill(0.);
+    auto symmetryFolding = SymmetryFolding::GetInstance();
+    if(symmetryFolding->IsActive())
+        for(const auto& replica: symmetryFolding->Replicate(hitsMap, fCCSD))
+            RecordHits(replica.get(), weight*symmetryFolding->GetWeightFactor(), eventInformation, eventWeights);
+    else RecordHits(hitsMap, weight, eventInformation, eventWeights);
+
+    for(auto tallies: {&fTallies, &fPendingTallies})
+        for(G4int tally = 0; tally<RunTarget::kNTallies; ++tally)
+            if(eventWeights[static_cast<std::size_t>(tally)]>0.)
+                tallies->Add(static_cast<RunTarget::Tally>(tally), eventWeights[static_cast<std::size_t>(tally)]);
+}
+
+void Run::RecordHits(const CCHitsMap* hitsMap, G4double weight, const EventInformation* eventInformation,
+                     std::array<G4double, RunTarget::kNTallies>& eventWeights)
+{
+    G4bool basis = fBasisLibrary && eventInformation;
+    if(basis) fBasisLibrary->AddSingle(eventInformation->GetFuelRodID(), weight);
+    if(hitsMap->entries()<2) return;
+
+    // The source is above the camera: the scatter hit is the one with max z
+    G4double eSum = 0.;
+    const CCHit* scatterHit = nullptr;
+    for(const auto& itr: *hitsMap)
+    {
+        eSum += itr.second->GetDepE();
+        if(!scatterHit || itr.second->GetPosition().z()>scatterHit->GetPosition().z())
+            scatterHit = itr.second;
+    }
+    G4ThreeVector scatterPos = scatterHit->GetPosition();
+
+    auto runTarget = RunTarget::GetInstance();
+    eventWeights[RunTarget::kCoincidences] += weight;
+    if(runTarget->InEnergyWindow(eSum)) eventWeights[RunTarget::kEnergyWindow] += weight;
+    if(runTarget->InImageRegion(scatterPos.x(), scatterPos.y())) eventWeights[RunTarget::kImageRegion] += weight;
+
+    if(basis)
+        fBasisLibrary->AddCoincidence(eventInformation->GetFuelRodID(), weight, eSum/keV,
+                                      scatterPos.x()/mm, scatterPos.y()/mm);
+}
+
+void Run::ReportToTarget()
+{
+    auto runTarget = RunTarget::GetInstance();
+    if(fAborted || !runTarget->IsActive()) return;
+
+    // Other threads may have met the target in the meantime
+    G4bool stop = runTarget->StopRequested();
+    if(!stop && fPendingTallies.nEvents>=runTarget->GetCheckInterval())
+        stop = runTarget->Report(fPendingTallies);
+    if(!stop) return;
+
+    // Soft abort: the event loop of this thread ends after the current event
+    G4RunManager::GetRunManager()->AbortRun(true);
+    fAborted = true;
+}
+
+void Run::Merge(const G4Run* aRun)
+{
+    auto localRun = static_cast<const Run*>(aRun);
+    if(fBasisLibrary && localRun->fBasisLibrary) fBasisLibrary->Merge(*localRun->fBasisLibrary);
+    fTallies.Merge(localRun->fTallies);
+    fNCoincidences += localRun->fNCoincidences;
+    for(std::size_t rule = 0; rule<fNKilledTracks.size(); ++rule)
+    {
+        fNKilledTracks[rule] += localRun->fNKilledTracks[rule];
+        fKilledEnergy[rule] += localRun->fKilledEnergy[rule];
+    }
+    if(fLeakage.size()<localRun->fLeakage.size())
+    {
+        fLeakage.resize(localRun->fLeakage.size(), 0.);
+        fLeakage2.resize(localRun->fLeakage.size(), 0.);
+    }
+    for(std::size_t bin = 0; bin<localRun->fLeakage.size(); ++bin)
+    {
+        fLeakage[bin] += localRun->fLeakage[bin];
+        fLeakage2[bin] += localRun->fLeakage2[bin];
+    }
+    if(fNextEventFlux.size()<localRun->fNextEventFlux.size())
+    {
+        fNextEventFlux.resize(localRun->fNextEventFlux.size(), 0.);
+        fNextEventFlux2.resize(localRun->fNextEventFlux.size(), 0.);
+    }
+    for(std::size_t index = 0; index<localRun->fNextEventFlux.size(); ++index)
+    {
+        fNextEventFlux[index] += localRun->fNextEventFlux[index];
+        fNextEventFlux2[index] += localRun->fNextEventFlux2[index];
+    }
+    if(fNextEventSpectra.size()<localRun->fNextEventSpectra.size())
+        fNextEventSpectra.resize(localRun->fNextEventSpectra.size(), 0.);
+    for(std::size_t index = 0; index<localRun->fNextEventSpectra.size(); ++index)
+        fNextEventSpectra[index] += localRun->fNextEventSpectra[index];
+
+    G4Run::Merge(aRun);
+}
+
+void Run::PrintKilledTracks(std::ostream& out) const
+{
+    const char* ruleNames[StackingAction::kNRules] = {"particle", "creation volume", "energy"};
+    out << "Killed secondaries:";
+    for(G4int rule = 0; rule<StackingAction::kNRules; ++rule)
+        out << (rule ? ", " : " ") << "by " << ruleNames[rule] << " " << fNKilledTracks[rule]
+            << " (" << fKilledEnergy[rule]/MeV << " MeV)";
+    out << G4endl;
+}
+
+void Run::AddLeakage(G4int bin, G4double weight)
+{
+    if(fLeakage.empty())
+    {
+        fLeakage.resize(static_cast<std::size_t>(LeakageDetector::GetNBins() + 1), 0.);
+        fLeakage2.resize(fLeakage.size(), 0.);
+    }
+    fLeakage[static_cast<std::size_t>(bin)] += weight;
+    fLeakage2[static_cast<std::size_t>(bin)] += weight*weight;
+}
+
+void Run::AddNextEventFlux(std::size_t index, G4double flux)
+{
+    if(fNextEventFlux.empty())
+    {
+        fNextEventFlux.resize(NextEventEstimator::GetInstance()->GetNPoints()*NextEventEstimator::kNComponents, 0.);
+        fNextEventFlux2.resize(fNextEventFlux.size(), 0.);
+    }
+    fNextEventFlux[index] += flux;
+    fNextEventFlux2[index] += flux*flux;
+}
+
+void Run::AddNextEventSpectrum(std::size_t index, G4double flux)
+{
+    if(fNextEventSpectra.empty())
+    {
+        auto nextEventEstimator = NextEventEstimator::GetInstance();
+        fNextEventSpectra.resize(nextEventEstimator->GetNPoints()*NextEventEstimator::kNComponents
+                                 *static_cast<std::size_t>(nextEventEstimator->GetNEnergyBins()), 0.);
+    }
+    fNextEventSpectra[index] += flux;
+}
+
+G4double Run::GetCoincidenceRelativeError() const
+{
+    return RunTarget::RelativeError(fTallies.nEvents, fTallies.weight[RunTarget::kCoincidences],
+                                    fTallies.weight2[RunTarget::kCoincidences]);
+}
+
+G4bool Run::Write(std::ostream& out) const
+{
+    out.write(reinterpret_cast<const char*>(&fTallies), sizeof(fTallies));
+    out.write(reinterpret_cast<const char*>(&fNCoincidences), sizeof(fNCoincidences));
+    G4bool basis = static_cast<G4bool>(fBasisLibrary);
+    out.write(reinterpret_cast<const char*>(&basis), sizeof(basis));
+    if(basis) fBasisLibrary->Write(out);
+    out.write(reinterpret_cast<const char*>(fNKilledTracks.data()), sizeof(fNKilledTracks));
+    out.write(reinterpret_cast<const char*>(fKilledEnergy.data()), sizeof(fKilledEnergy));
+    for(auto values: {&fLeakage, &fLeakage2, &fNextEventFlux, &fNextEventFlux2, &fNextEventSpectra})
+        WriteVector(out, *values);
+    return static_cast<G4bool>(out);
+}
+
+G4bool Run::Read(std::istream& in)
+{
+    G4bool basis = false;
+    in.read(reinterpret_cast<char*>(&fTallies), sizeof(fTallies));
+    in.read(reinterpret_cast<char*>(&fNCoincidences), sizeof(fNCoincidences));
+    in.read(reinterpret_cast<char*>(&basis), sizeof(basis));
+    if(!in || basis!=static_cast<G4bool>(fBasisLibrary)) return false;
+    if(basis && !fBasisLibrary->Read(in)) return false;
+    in.read(reinterpret_cast<char*>(fNKilledTracks.data()), sizeof(fNKilledTracks));
+    in.read(reinterpret_cast<char*>(fKilledEnergy.data()), sizeof(fKilledEnergy));
+    for(auto values: {&fLeakage, &fLeakage2, &fNextEventFlux, &fNextEventFlux2, &fNextEventSpectra})
+        if(!ReadVector(in, *values)) return false;
+    numberOfEvent = static_cast<G4int>(std::min<G4long>(fTallies.nEvents, INT_MAX));
+    return true;
+}
@@ -1,13 +1,123 @@
 #include "RunAction.hh"
+#include "EventAction.hh"
+#include "DetectorConstruction.hh"
+#include "Run.hh"
+#include "BasisLibrary.hh"
+#include "Campaign.hh"
+#include "ComptonBiasingOperator.hh"
+#include "MemoryTelemetry.hh"
+#include "NextEventEstimator.hh"
+#include "PileUpStream.hh"
+#include "RunTarget.hh"
+#include "StackingAction.hh"
+#include "SymmetryFolding.hh"
+#include "SystemMatrix.hh"
+
+#include "G4Threading.hh"
+
+#include <algorithm>
+
+G4double RunAction::fAnalogFigureOfMerit = 0.;
 
 RunAction::RunAction()
 : G4UserRunAction()
 {}
 
 RunAction::~RunAction()
-{}
+{
+    if(IsMaster()) EventAction::CloseOutput();
+}
+
+G4Run* RunAction::GenerateRun()
+{
+    return new Run();
+}
 
 void RunAction::BeginOfRunAction(const G4Run* aRun)
 {
     G4RunManager::GetRunManager()->SetPrintProgress(static_cast<G4int>(aRun->GetNumberOfEventToBeProcessed() * 0.1));
+
+    if(IsMaster())
+    {
+        auto detector = static_cast<const DetectorConstruction*>(
+                    G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+        SymmetryFolding::GetInstance()->BeginRun();
+        NextEventEstimator::GetInstance()->BeginRun();
+        EventAction::OpenOutput(detector->GetOutputTag(), detector->GetConfiguration(), detector->GetNViews());
+        PileUpStream::BeginMasterRun(detector->GetOutputTag(), aRun->GetNumberOfEventToBeProcessed());
+        fStartTime = std::chrono::steady_clock::now();
+        RunTarget::GetInstance()->BeginRun();
+    }
+    // Singles streams and heap counters belong to the threads processing events
+    if(!IsMaster() || !G4Threading::IsMultithreadedApplication())
+    {
+        auto detector = static_cast<const DetectorConstruction*>(
+                    G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+        PileUpStream::BeginRun(detector->GetOutputTag());
+        MemoryTelemetry::GetInstance()->BeginThreadRun();
+    }
+}
+
+void RunAction::EndOfRunAction(const G4Run* aRun)
+{
+    if(!IsMaster() || !G4Threading::IsMultithreadedApplication())
+    {
+        PileUpStream::EndRun();
+        SystemMatrix::GetInstance()->EndThreadRun();
+        MemoryTelemetry::GetInstance()->EndThreadRun(aRun->GetNumberOfEvent());
+    }
+    if(!IsMaster()) return;
+
+    EventAction::FlushOutput();
+    PrintFigureOfMerit(aRun);
+    auto runTarget = RunTarget::GetInstance();
+    if(runTarget->IsActive()) runTarget->Print(G4cout, static_cast<const Run*>(aRun)->GetTallies());
+
+    // A campaign reports and writes the sums over all its segments
+    auto campaign = Campaign::GetInstance();
+    if(campaign->IsActive()) campaign->EndOfRun(static_cast<const Run*>(aRun));
+    auto run = campaign->IsActive() ? campaign->GetTotal() : static_cast<const Run*>(aRun);
+    if(StackingAction::HasKillRules()) run->PrintKilledTracks(G4cout);
+    auto nextEventEstimator = NextEventEstimator::GetInstance();
+    if(nextEventEstimator->IsActive())
+        nextEventEstimator->EndRun(run, static_cast<const DetectorConstruction*>(
+                                       G4RunManager::GetRunManager()->GetUserDetectorConstruction())->GetOutputTag());
+    auto basisLibrary = run->GetBasisLibrary();
+    if(basisLibrary)
+    {
+        auto detector = static_cast<const DetectorConstruction*>(
+                    G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+        G4String tag = detector->GetOutputTag();
+        G4String fileName = EventAction::GetOutputFileName("basis", tag, ".dat");
+        if(basisLibrary->Write(fileName))
+            G4cout << "Basis library of " << basisLibrary->GetNRods() << " fuel rods written to "
+                   << fileName << G4endl;
+        else
+            G4Exception("RunAction::EndOfRunAction()", "", JustWarning,
+                        G4String("    Cannot write '" + fileName + "'.").c_str());
+    }
+
+    MemoryTelemetry::GetInstance()->EndRun(aRun->GetRunID(), G4cout);
+}
+
+void RunAction::PrintFigureOfMerit(const G4Run* aRun) const
+{
+    auto run = static_cast<const Run*>(aRun);
+    G4double seconds = std::chrono::duration<G4double>(std::chrono::steady_clock::now() - fStartTime).count();
+    G4double relativeError = run->GetCoincidenceRelativeError();
+    G4bool biased = ComptonBiasingOperator::IsActive();
+
+    G4cout << "Coincidences: " << run->GetNCoincidences() << " events, "
+           << run->GetCoincidenceWeight()/std::max(run->GetNEvents(), 1L) << " per primary"
+           << " (rel. error " << relativeError << ", " << seconds << " s, "
+           << (biased ? "biased" : "analog") << ")" << G4endl;
+    if(relativeError<=0. || seconds<=0.) return;
+
+    // FOM = 1/(R^2 T)
+    G4double figureOfMerit = 1./(relativeError*relativeError*seconds);
+    G4cout << "Coincidence figure of merit: " << figureOfMerit << " /s";
+    if(biased && fAnalogFigureOfMerit>0.)
+        G4cout << ", gain over the last analog run: " << figureOfMerit/fAnalogFigureOfMerit;
+    G4cout << G4endl;
+    if(!biased) fAnalogFigureOfMerit = figureOfMerit;
 }
@@ -0,0 +1,470 @@
+#include "RunCache.hh"
+#include "RunCacheMessenger.hh"
+#include "DetectorConstruction.hh"
+#include "EventAction.hh"
+#include "EventSeeder.hh"
+#include "PileUpStream.hh"
+#include "Run.hh"
+#include "G4RunManager.hh"
+#include "G4UImanager.hh"
+#include "Randomize.hh"
+#include <unistd.h>
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <climits>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+namespace
+{
+    namespace fs = std::filesystem;
+
+    // SHA-256 (FIPS 180-4)
+    class Sha256
+    {
+    public:
+        Sha256() : fState{0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19},
+                   fLength(0), fBufferSize(0) {}
+
+        void Update(const void* data, std::size_t size)
+        {
+            auto bytes = static_cast<const unsigned char*>(data);
+            fLength += size;
+            while(size>0)
+            {
+                auto n = std::min(size, fBuffer.size() - fBufferSize);
+                std::memcpy(fBuffer.data() + fBufferSize, bytes, n);
+                fBufferSize += n;
+                bytes += n;
+                size -= n;
+                if(fBufferSize==fBuffer.size())
+                {
+                    Compress(fBuffer.data());
+                    fBufferSize = 0;
+                }
+            }
+        }
+
+        std::string HexDigest()
+        {
+            std::uint64_t bits = fLength*8;
+            unsigned char padding[72] = {0x80};
+            std::size_t nPadding = (fBufferSize<56) ? 56 - fBufferSize : 120 - fBufferSize;
+            Update(padding, nPadding);
+            unsigned char length[8];
+            for(int i = 0; i<8; ++i) length[i] = static_cast<unsigned char>(bits >> (56 - 8*i));
+            Update(length, 8);
+            std::ostringstream out;
+            for(auto word: fState) out << std::hex << std::setw(8) << std::setfill('0') << word;
+            return out.str();
+        }
+
+    private:
+        static std::uint32_t Rotate(std::uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+
+        void Compress(const unsigned char* block)
+        {
+            static const std::uint32_t k[64] = {
+                0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+                0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+                0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+                0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+                0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+                0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+                0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+                0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+            std::uint32_t w[64];
+            for(int i = 0; i<16; ++i)
+                w[i] = (std::uint32_t(block[4*i]) << 24) | (std::uint32_t(block[4*i + 1]) << 16)
+                       | (std::uint32_t(block[4*i + 2]) << 8) | std::uint32_t(block[4*i + 3]);
+            for(int i = 16; i<64; ++i)
+            {
+                auto s0 = Rotate(w[i - 15], 7) ^ Rotate(w[i - 15], 18) ^ (w[i - 15] >> 3);
+                auto s1 = Rotate(w[i - 2], 17) ^ Rotate(w[i - 2], 19) ^ (w[i - 2] >> 10);
+                w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+            }
+            auto s = fState;
+            for(int i = 0; i<64; ++i)
+            {
+                auto t1 = s[7] + (Rotate(s[4], 6) ^ Rotate(s[4], 11) ^ Rotate(s[4], 25))
+                          + ((s[4] & s[5]) ^ (~s[4] & s[6])) + k[i] + w[i];
+                auto t2 = (Rotate(s[0], 2) ^ Rotate(s[0], 13) ^ Rotate(s[0], 22))
+                          + ((s[0] & s[1]) ^ (s[0] & s[2]) ^ (s[1] & s[2]));
+                s = {t1 + t2, s[0], s[1], s[2], s[3] + t1, s[4], s[5], s[6]};
+            }
+            for(std::size_t i = 0; i<8; ++i) fState[i] += s[i];
+        }
+
+        std::array<std::uint32_t, 8> fState;
+        std::array<unsigned char, 64> fBuffer;
+        std::uint64_t fLength;
+        std::size_t fBufferSize;
+    };
+
+    std::string HashString(const std::string& text)
+    {
+        Sha256 sha;
+        sha.Update(text.data(), text.size());
+        return sha.HexDigest();
+    }
+
+    // Empty if the file cannot be read
+    std::string HashFile(const std::string& fileName)
+    {
+        std::ifstream in(fileName, std::ios::binary);
+        if(!in) return "";
+        Sha256 sha;
+        std::vector<char> buffer(1 << 16);
+        while(in.read(buffer.data(), static_cast<std::streamsize>(buffer.size())) || in.gcount()>0)
+            sha.Update(buffer.data(), static_cast<std::size_t>(in.gcount()));
+        return sha.HexDigest();
+    }
+
+    const std::string& ExecutableHash()
+    {
+        // Falls back on the build time of this file
+        static const std::string hash = []()
+        {
+            auto fileHash = HashFile("/proc/self/exe");
+            return fileHash.empty() ? std::string("built " __DATE__ " " __TIME__) : fileHash;
+        }();
+        return hash;
+    }
+
+    // Commands without effect on the outputs of a run (or accounted for
+    // otherwise: earlier runs by the run ID and the engine state)
+    G4bool IsIgnored(const G4String& command)
+    {
+        std::string path = command.substr(0, command.find(' '));
+        std::string lower = path;
+        std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return std::tolower(c); });
+        for(const char* prefix: {"/vis/", "/control/", "/gui/", "/ccTest/cache/", "/run/beamOn", "/run/printProgress"})
+            if(path.compare(0, std::strlen(prefix), prefix)==0) return true;
+        return lower.find("verbose")!=std::string::npos;
+    }
+
+    std::int64_t ModificationTime(const fs::path& path)
+    {
+        std::error_code error;
+        return static_cast<std::int64_t>(fs::last_write_time(path, error).time_since_epoch().count());
+    }
+}
+
+RunCache* RunCache::GetInstance()
+{
+    static RunCache fInstance;
+    return &fInstance;
+}
+
+RunCache::RunCache()
+: fMaxSize(10000000000ull), fLastNEvents(0), fLastNCoincidences(0),
+  fNHits(0), fNMisses(0), fNStored(0), fNEvicted(0), fSavedSeconds(0.)
+{
+    // The whole command history enters the key (default: last 20 commands)
+    G4UImanager::GetUIpointer()->SetMaxHistSize(INT_MAX);
+    fMessenger = std::make_unique<RunCacheMessenger>(this);
+}
+
+RunCache::~RunCache()
+{}
+
+G4String RunCache::Configuration(G4int runID, G4int nEvents) const
+{
+    auto runManager = G4RunManager::GetRunManager();
+    auto detector = static_cast<const DetectorConstruction*>(runManager->GetUserDetectorConstruction());
+    auto eventSeeder = EventSeeder::GetInstance();
+    std::ostringstream engineState;
+    G4Random::saveFullState(engineState);
+    G4String engine = engineState.str();
+    std::replace(engine.begin(), engine.end(), '\n', ' ');
+
+    std::ostringstream out;
+    out << "executable " << ExecutableHash() << "\n"
+        << "geant4 " << runManager->GetVersionString() << "\n"
+        << "physics " << fPhysics << "\n"
+        << "threads " << runManager->GetNumberOfThreads() << "\n"
+        << "run " << runID << " " << nEvents << "\n"
+        << "engine " << engine << "\n"
+        << "eventSeeds " << eventSeeder->IsEnabled() << " " << eventSeeder->GetSeed() << "\n"
+        << "tag " << detector->GetOutputTag() << "\n";
+    std::istringstream geometry(detector->GetConfiguration());
+    for(std::string line; std::getline(geometry, line);) out << "geometry " << line << "\n";
+
+    auto UImanager = G4UImanager::GetUIpointer();
+    for(G4int i = 0; i<UImanager->GetNumberOfHistory(); ++i)
+    {
+        G4String command = UImanager->GetPreviousCommand(i);
+        if(IsIgnored(command)) continue;
+        out << "command " << command << "\n";
+        // Macros, tables, spectra...: by content
+        std::istringstream tokens(command);
+        for(std::string token; tokens >> token;)
+        {
+            std::error_code error;
+            if(token[0]!='/' && fs::is_regular_file(token, error))
+                out << "file " << token << " " << HashFile(token) << "\n";
+        }
+    }
+    return out.str();
+}
+
+std::map<G4String, std::pair<std::uintmax_t, std::int64_t>> RunCache::ScanOutputs() const
+{
+    std::map<G4String, std::pair<std::uintmax_t, std::int64_t>> outputs;
+    std::error_code error;
+    fs::path outputDirectory(std::string(EventAction::GetOutputDirectory()));
+    auto cacheDirectory = fs::weakly_canonical(std::string(fDirectory), error);
+    for(fs::recursive_directory_iterator it(outputDirectory, error), end; !error && it!=end; it.increment(error))
+    {
+        // The cache may lie within the output directory
+        if(it->is_directory(error) && fs::weakly_canonical(it->path(), error)==cacheDirectory)
+        {
+            it.disable_recursion_pending();
+            continue;
+        }
+        if(!it->is_regular_file(error)) continue;
+        auto size = it->file_size(error);
+        outputs[fs::relative(it->path(), outputDirectory, error).generic_string()]
+                = {size, ModificationTime(it->path())};
+    }
+    return outputs;
+}
+
+G4bool RunCache::Lookup(G4int runID, G4int nEvents)
+{
+    fConfiguration = Configuration(runID, nEvents);
+    fKey = HashString(fConfiguration);
+    fs::path entry = fs::path(std::string(fDirectory))/std::string(fKey);
+
+    std::ifstream manifest(entry/"manifest.txt");
+    if(manifest)
+    {
+        // Nothing in the output directory changes before the entry is known
+        // to be complete: manifest, every listed file and a valid engine state
+        G4long nRunEvents = -1, nCoincidences = 0;
+        G4double seconds = 0.;
+        std::vector<std::string> files;
+        for(std::string line; std::getline(manifest, line);)
+        {
+            std::istringstream iss(line);
+            std::string keyword;
+            iss >> keyword;
+            if(keyword=="events") iss >> nRunEvents;
+            else if(keyword=="coincidences") iss >> nCoincidences;
+            else if(keyword=="seconds") iss >> seconds;
+            else if(keyword=="file")
+            {
+                std::string file;
+                std::getline(iss >> std::ws, file);
+                files.push_back(file);
+            }
+        }
+        std::error_code error;
+        G4bool complete = nRunEvents>=0;
+        for(const auto& file: files)
+            if(complete) complete = fs::is_regular_file(entry/"files"/file, error);
+        std::ifstream engineIn(entry/"engine.txt");
+        std::ostringstream engineState;
+        if(complete) complete = engineIn && (engineState << engineIn.rdbuf()) && !engineState.str().empty();
+
+        // Copies next to the outputs, renamed over them only once all exist.
+        // An entry evicted meanwhile by another process is a miss.
+        fs::path outputDirectory(std::string(EventAction::GetOutputDirectory()));
+        std::vector<std::pair<fs::path, fs::path>> copies; // temporary, output
+        for(const auto& file: files)
+        {
+            if(!complete) break;
+            fs::path output = outputDirectory/file;
+            fs::path temporary = output;
+            temporary += ".cache.tmp";
+            fs::create_directories(output.parent_path(), error);
+            if(!error) fs::copy_file(entry/"files"/file, temporary, fs::copy_options::overwrite_existing, error);
+            if(error) complete = false;
+            else copies.emplace_back(temporary, output);
+        }
+        std::ostringstream previousEngineState;
+        G4Random::saveFullState(previousEngineState);
+        if(complete)
+        {
+            std::istringstream engineStateIn(engineState.str());
+            complete = static_cast<G4bool>(G4Random::restoreFullState(engineStateIn));
+        }
+
+        // The data files are replaced under closed streams, then reopened for
+        // appending, as they are after a simulated run
+        auto detector = static_cast<const DetectorConstruction*>(
+                    G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+        if(complete)
+        {
+            EventAction::CloseOutput();
+            for(const auto& copy: copies)
+            {
+                fs::rename(copy.first, copy.second, error);
+                if(error)
+                {
+                    G4Exception("RunCache::Lookup()", "", JustWarning,
+                                G4String("    Cannot replace '" + copy.second.string() + "': "
+                                         + error.message() + "; outputs partially restored.").c_str());
+                    complete = false;
+                    break;
+                }
+            }
+            EventAction::ContinueOutput(detector->GetOutputTag(), detector->GetNViews());
+        }
+        if(!complete)
+        {
+            for(const auto& copy: copies) fs::remove(copy.first, error);
+            std::istringstream previousEngineStateIn(previousEngineState.str());
+            G4Random::restoreFullState(previousEngineStateIn);
+        }
+        else
+        {
+            PileUpStream::BeginMasterRun(detector->GetOutputTag(), nEvents);
+            fs::last_write_time(entry/"manifest.txt", fs::file_time_type::clock::now(), error);
+            fLastNEvents = nRunEvents;
+            fLastNCoincidences = nCoincidences;
+            ++fNHits;
+            fSavedSeconds += seconds;
+            G4cout << "Run cache hit " << fKey.substr(0, 12) << ": " << files.size()
+                   << " output files restored (" << seconds << " s of simulation saved)" << G4endl;
+            fKey.clear();
+            return true;
+        }
+    }
+
+    ++fNMisses;
+    G4cout << "Run cache miss " << fKey.substr(0, 12) << G4endl;
+    fOutputsBefore = ScanOutputs();
+    fStartTime = std::chrono::steady_clock::now();
+    return false;
+}
+
+void RunCache::Store(const Run* run)
+{
+    if(fKey.empty()) return;
+    G4String key = fKey;
+    fKey.clear();
+    G4double seconds = std::chrono::duration<G4double>(std::chrono::steady_clock::now() - fStartTime).count();
+    if(!run || run->GetNumberOfEvent()<run->GetNumberOfEventToBeProcessed())
+    {
+        G4cout << "Run cache: run " << key.substr(0, 12) << " ended early, not stored" << G4endl;
+        return;
+    }
+    fLastNEvents = run->GetNEvents();
+    fLastNCoincidences = run->GetNCoincidences();
+
+    // Also done at the end of the run: nothing of the run may stay buffered
+    EventAction::FlushOutput();
+    std::vector<G4String> files;
+    for(const auto& output: ScanOutputs())
+    {
+        auto before = fOutputsBefore.find(output.first);
+        if(before==fOutputsBefore.end() || before->second!=output.second) files.push_back(output.first);
+    }
+
+    // Complete in a private directory first, then renamed into place
+    std::error_code error;
+    fs::path directory = std::string(fDirectory);
+    fs::path entry = directory/std::string(key);
+    fs::path temporary = directory/(".tmp-" + key + "-" + std::to_string(getpid()));
+    fs::remove_all(temporary, error);
+    fs::create_directories(temporary/"files", error);
+    fs::path outputDirectory(std::string(EventAction::GetOutputDirectory()));
+    for(const auto& file: files)
+    {
+        if(error) break;
+        fs::create_directories((temporary/"files"/std::string(file)).parent_path(), error);
+        fs::copy_file(outputDirectory/std::string(file), temporary/"files"/std::string(file), error);
+    }
+    if(!error)
+    {
+        std::ofstream engineOut(temporary/"engine.txt");
+        G4Random::saveFullState(engineOut);
+        std::ofstream configurationOut(temporary/"configuration.txt");
+        configurationOut << fConfiguration;
+        std::ofstream manifest(temporary/"manifest.txt");
+        manifest << "# ccTest run cache entry\n"
+                 << "events " << fLastNEvents << "\n"
+                 << "coincidences " << fLastNCoincidences << "\n"
+                 << "seconds " << seconds << "\n";
+        for(const auto& file: files) manifest << "file " << file << "\n";
+        if(!engineOut || !configurationOut || !(manifest << std::flush))
+            error = std::make_error_code(std::errc::io_error);
+    }
+    if(!error) fs::rename(temporary, entry, error);
+    if(error)
+    {
+        // Also when another process stored the same entry first
+        fs::remove_all(temporary, error);
+        if(!fs::exists(entry/"manifest.txt", error))
+            G4Exception("RunCache::Store()", "", JustWarning,
+                        G4String("    Run not stored in the cache " + fDirectory + ".").c_str());
+        return;
+    }
+    ++fNStored;
+    G4cout << "Run cache: stored " << key.substr(0, 12) << " (" << files.size() << " output files)" << G4endl;
+    Evict(key);
+}
+
+void RunCache::Evict(const G4String& keep)
+{
+    struct Entry
+    {
+        fs::path path;
+        std::int64_t lastUse;
+        std::uintmax_t size;
+    };
+    std::vector<Entry> entries;
+    std::uintmax_t total = 0;
+    std::error_code error;
+    for(fs::directory_iterator it(std::string(fDirectory), error), end; !error && it!=end; it.increment(error))
+    {
+        if(!fs::exists(it->path()/"manifest.txt")) continue;
+        Entry entry = {it->path(), ModificationTime(it->path()/"manifest.txt"), 0};
+        std::error_code sizeError;
+        for(fs::recursive_directory_iterator file(it->path(), sizeError), fileEnd;
+            !sizeError && file!=fileEnd; file.increment(sizeError))
+            if(file->is_regular_file(sizeError)) entry.size += file->file_size(sizeError);
+        total += entry.size;
+        entries.push_back(entry);
+    }
+
+    // Least recently used first
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.lastUse<b.lastUse; });
+    for(const auto& entry: entries)
+    {
+        if(total<=fMaxSize) break;
+        if(entry.path.filename()==std::string(keep)) continue;
+        std::error_code removeError;
+        fs::remove_all(entry.path, removeError);
+        if(removeError) continue;
+        total -= entry.size;
+        ++fNEvicted;
+    }
+}
+
+void RunCache::Report(std::ostream& out) const
+{
+    if(!IsEnabled())
+    {
+        out << "Run cache disabled (/ccTest/cache/directory)" << std::endl;
+        return;
+    }
+    std::size_t nEntries = 0;
+    std::uintmax_t size = 0;
+    std::error_code error;
+    for(fs::recursive_directory_iterator it(std::string(fDirectory), error), end; !error && it!=end; it.increment(error))
+    {
+        if(it->is_regular_file(error)) size += it->file_size(error);
+        if(it.depth()==0 && fs::exists(it->path()/"manifest.txt", error)) ++nEntries;
+    }
+    out << "Run cache " << fDirectory << ": " << nEntries << " entries, " << size/1.e6 << " MB of "
+        << fMaxSize/1.e6 << " MB\n"
+        << "  this session: " << fNHits << " hits, " << fNMisses << " misses, " << fNStored << " stored, "
+        << fNEvicted << " evicted, " << fSavedSeconds << " s of simulation saved" << std::endl;
+}
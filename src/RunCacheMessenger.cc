@@ -0,0 +1,79 @@
+#include "RunCacheMessenger.hh"
+#include "RunCache.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcommand.hh"
+#include "G4UIparameter.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithoutParameter.hh"
+
+#include <filesystem>
+#include <sstream>
+
+RunCacheMessenger::RunCacheMessenger(RunCache* runCache)
+: G4UImessenger(), fRunCache(runCache)
+{
+    fCacheDir = new G4UIdirectory("/ccTest/cache/");
+    fCacheDir->SetGuidance("Content-addressed cache of runs: a run whose configuration (code, physics,");
+    fCacheDir->SetGuidance("commands, geometry, random state) was already simulated is restored from");
+    fCacheDir->SetGuidance("the cache instead of being run again.");
+
+    fCacheDirectoryCmd = new G4UIcmdWithAString("/ccTest/cache/directory", this);
+    fCacheDirectoryCmd->SetGuidance("Cache directory (created if needed); 'none' disables the cache.");
+    fCacheDirectoryCmd->SetParameterName("directory", false);
+    fCacheDirectoryCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fCacheDirectoryCmd->SetToBeBroadcasted(false);
+
+    fCacheMaxSizeCmd = new G4UIcommand("/ccTest/cache/maxSize", this);
+    fCacheMaxSizeCmd->SetGuidance("Size limit; beyond it the least recently used entries are evicted.");
+    auto cacheSizeParam = new G4UIparameter("size", 'd', false);
+    cacheSizeParam->SetParameterRange("size>0.");
+    fCacheMaxSizeCmd->SetParameter(cacheSizeParam);
+    auto cacheUnitParam = new G4UIparameter("unit", 's', true);
+    cacheUnitParam->SetParameterCandidates("kB MB GB");
+    cacheUnitParam->SetDefaultValue("GB");
+    fCacheMaxSizeCmd->SetParameter(cacheUnitParam);
+    fCacheMaxSizeCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fCacheMaxSizeCmd->SetToBeBroadcasted(false);
+
+    fCacheReportCmd = new G4UIcmdWithoutParameter("/ccTest/cache/report", this);
+    fCacheReportCmd->SetGuidance("Print the entries and size of the cache, and the hits and misses so far.");
+    fCacheReportCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fCacheReportCmd->SetToBeBroadcasted(false);
+}
+
+RunCacheMessenger::~RunCacheMessenger()
+{
+    delete fCacheReportCmd;
+    delete fCacheMaxSizeCmd;
+    delete fCacheDirectoryCmd;
+    delete fCacheDir;
+}
+
+void RunCacheMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+    if(command==fCacheDirectoryCmd)
+    {
+        if(newValue=="none") fRunCache->SetDirectory("");
+        else
+        {
+            std::error_code error;
+            std::filesystem::create_directories(std::string(newValue), error);
+            if(error)
+                G4Exception("RunCacheMessenger::SetNewValue()", "", JustWarning,
+                            G4String("    Cannot create the cache directory " + newValue + ".").c_str());
+            else fRunCache->SetDirectory(newValue);
+        }
+    }
+    else if(command==fCacheMaxSizeCmd)
+    {
+        std::istringstream iss(newValue);
+        G4double size;
+        G4String unit;
+        iss >> size >> unit;
+        G4double bytes = size*((unit=="kB") ? 1.e3 : (unit=="MB") ? 1.e6 : 1.e9);
+        fRunCache->SetMaxSize(static_cast<std::uintmax_t>(bytes));
+    }
+    else if(command==fCacheReportCmd)
+        fRunCache->Report(G4cout);
+}
@@ -0,0 +1,78 @@
+#include "RunMessenger.hh"
+#include "Run.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcommand.hh"
+#include "G4UIparameter.hh"
+#include "G4UIcmdWithABool.hh"
+
+#include <sstream>
+
+RunMessenger::RunMessenger()
+: G4UImessenger()
+{
+    fBasisDir = new G4UIdirectory("/ccTest/basis/");
+    fBasisDir->SetGuidance("Per-rod response basis library (see tools/synthesizeBasis).");
+
+    fBasisModeCmd = new G4UIcmdWithABool("/ccTest/basis/enable", this);
+    fBasisModeCmd->SetGuidance("Start primaries uniformly in all fuel rods, ignoring the rod status,");
+    fBasisModeCmd->SetGuidance("add the source rod ID to output/data.txt and write the per-rod");
+    fBasisModeCmd->SetGuidance("responses of each run to output/basis.dat.");
+    fBasisModeCmd->SetParameterName("enable", true);
+    fBasisModeCmd->SetDefaultValue(true);
+    fBasisModeCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fBasisModeCmd->SetToBeBroadcasted(false);
+
+    fBasisEnergyBinningCmd = new G4UIcommand("/ccTest/basis/energyBinning", this);
+    fBasisEnergyBinningCmd->SetGuidance("Binning of the summed-energy spectrum of coincidence events.");
+    auto nEnergyBinsParam = new G4UIparameter("nBins", 'i', false);
+    nEnergyBinsParam->SetParameterRange("nBins>0");
+    fBasisEnergyBinningCmd->SetParameter(nEnergyBinsParam);
+    auto maxEnergyParam = new G4UIparameter("maxEnergy", 'd', false);
+    maxEnergyParam->SetParameterRange("maxEnergy>0.");
+    fBasisEnergyBinningCmd->SetParameter(maxEnergyParam);
+    auto energyUnitParam = new G4UIparameter("unit", 's', true);
+    energyUnitParam->SetDefaultValue("keV");
+    fBasisEnergyBinningCmd->SetParameter(energyUnitParam);
+    fBasisEnergyBinningCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fBasisEnergyBinningCmd->SetToBeBroadcasted(false);
+
+    fBasisImageBinningCmd = new G4UIcommand("/ccTest/basis/imageBinning", this);
+    fBasisImageBinningCmd->SetGuidance("Binning of the x-y scatter hit image (nBins x nBins, centred on the axis).");
+    auto nImageBinsParam = new G4UIparameter("nBins", 'i', false);
+    nImageBinsParam->SetParameterRange("nBins>0");
+    fBasisImageBinningCmd->SetParameter(nImageBinsParam);
+    auto halfWidthParam = new G4UIparameter("halfWidth", 'd', false);
+    halfWidthParam->SetParameterRange("halfWidth>0.");
+    fBasisImageBinningCmd->SetParameter(halfWidthParam);
+    auto lengthUnitParam = new G4UIparameter("unit", 's', true);
+    lengthUnitParam->SetDefaultValue("cm");
+    fBasisImageBinningCmd->SetParameter(lengthUnitParam);
+    fBasisImageBinningCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fBasisImageBinningCmd->SetToBeBroadcasted(false);
+}
+
+RunMessenger::~RunMessenger()
+{
+    delete fBasisImageBinningCmd;
+    delete fBasisEnergyBinningCmd;
+    delete fBasisModeCmd;
+    delete fBasisDir;
+}
+
+void RunMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+    if(command==fBasisModeCmd)
+        Run::SetBasisMode(fBasisModeCmd->GetNewBoolValue(newValue));
+    else if(command==fBasisEnergyBinningCmd || command==fBasisImageBinningCmd)
+    {
+        std::istringstream iss(newValue);
+        G4int nBins;
+        G4double value;
+        G4String unit;
+        iss >> nBins >> value >> unit;
+        value *= G4UIcommand::ValueOf(unit);
+        if(command==fBasisEnergyBinningCmd) Run::SetBasisEnergyBinning(nBins, value);
+        else Run::SetBasisImageBinning(nBins, value);
+    }
+}
@@ -0,0 +1,114 @@
+#include "RunTarget.hh"
+#include "RunTargetMessenger.hh"
+
+#include "G4SystemOfUnits.hh"
+#include "G4AutoLock.hh"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    const char* const kTallyNames[RunTarget::kNTallies] = {"coincidences", "energy window", "image region"};
+}
+
+void RunTarget::Sums::Merge(const Sums& other)
+{
+    nEvents += other.nEvents;
+    for(G4int i = 0; i<kNTallies; ++i)
+    {
+        weight[i] += other.weight[i];
+        weight2[i] += other.weight2[i];
+    }
+}
+
+RunTarget* RunTarget::GetInstance()
+{
+    static RunTarget fInstance;
+    return &fInstance;
+}
+
+RunTarget::RunTarget()
+: fRelativeError(0.), fEMin(0.), fEMax(0.), fX1(0.), fX2(0.), fY1(0.), fY2(0.),
+  fWallTime(0.), fMinEvents(10000), fCheckInterval(1000), fStop(false)
+{
+    fMessenger = std::make_unique<RunTargetMessenger>(this);
+}
+
+RunTarget::~RunTarget()
+{}
+
+G4bool RunTarget::IsTallyActive(Tally tally) const
+{
+    if(tally==kEnergyWindow) return fEMax>fEMin;
+    if(tally==kImageRegion) return fX2>fX1 && fY2>fY1;
+    return true;
+}
+
+void RunTarget::BeginRun()
+{
+    G4AutoLock lock(&fMutex);
+    fTotals = Sums();
+    fStartTime = std::chrono::steady_clock::now();
+    fStopReason = "";
+    fStop = false;
+}
+
+G4bool RunTarget::Report(Sums& sums)
+{
+    if(fStop) return true;
+    G4AutoLock lock(&fMutex, std::try_to_lock);
+    if(!lock.owns_lock()) return false;
+
+    fTotals.Merge(sums);
+    sums = Sums();
+
+    G4double seconds = std::chrono::duration<G4double>(std::chrono::steady_clock::now() - fStartTime).count();
+    if(fWallTime>0. && seconds*s>=fWallTime)
+        fStopReason = "wall-time budget spent";
+    else if(fRelativeError>0. && TargetReached())
+        fStopReason = "target relative error reached";
+    else
+        return false;
+
+    fStop = true;
+    return true;
+}
+
+G4bool RunTarget::TargetReached() const
+{
+    if(fTotals.nEvents<fMinEvents) return false;
+    for(G4int i = 0; i<kNTallies; ++i)
+    {
+        auto tally = static_cast<Tally>(i);
+        if(!IsTallyActive(tally)) continue;
+        G4double relativeError = RelativeError(fTotals.nEvents, fTotals.weight[i], fTotals.weight2[i]);
+        if(relativeError<=0. || relativeError>fRelativeError) return false;
+    }
+    return true;
+}
+
+void RunTarget::Print(std::ostream& out, const Sums& tallies) const
+{
+    out << "Run target: " << (fStopReason.empty() ? G4String("event limit reached") : fStopReason)
+        << " after " << tallies.nEvents << " events" << G4endl;
+    for(G4int i = 0; i<kNTallies; ++i)
+    {
+        auto tally = static_cast<Tally>(i);
+        if(!IsTallyActive(tally)) continue;
+        out << "  " << kTallyNames[i] << ": " << tallies.weight[i]/std::max(tallies.nEvents, 1L)
+            << " per primary, rel. error "
+            << RelativeError(tallies.nEvents, tallies.weight[i], tallies.weight2[i]);
+        if(fRelativeError>0.) out << " (target " << fRelativeError << ")";
+        out << G4endl;
+    }
+}
+
+G4double RunTarget::RelativeError(G4long nEvents, G4double weight, G4double weight2)
+{
+    // Events outside the tally score 0
+    if(weight<=0. || nEvents<2) return 0.;
+    G4double n = nEvents;
+    G4double variance = (weight2/n - std::pow(weight/n, 2))/(n - 1.);
+    return std::sqrt(std::max(variance, 0.))/(weight/n);
+}
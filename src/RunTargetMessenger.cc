@@ -0,0 +1,115 @@
+#include "RunTargetMessenger.hh"
+#include "RunTarget.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcommand.hh"
+#include "G4UIparameter.hh"
+#include "G4UIcmdWithADouble.hh"
+#include "G4UIcmdWithADoubleAndUnit.hh"
+#include "G4UIcmdWithAnInteger.hh"
+
+#include <sstream>
+
+RunTargetMessenger::RunTargetMessenger(RunTarget* runTarget)
+: G4UImessenger(), fRunTarget(runTarget)
+{
+    fTargetDir = new G4UIdirectory("/ccTest/target/");
+    fTargetDir->SetGuidance("Precision-targeted runs: /run/beamOn gives the maximum number of events,");
+    fTargetDir->SetGuidance("and the run ends once all active tallies reach the target relative error");
+    fTargetDir->SetGuidance("or the wall-time budget is spent.");
+
+    fTargetErrorCmd = new G4UIcmdWithADouble("/ccTest/target/relativeError", this);
+    fTargetErrorCmd->SetGuidance("Target relative error of the weighted coincidence count and of the");
+    fTargetErrorCmd->SetGuidance("energy window and image region tallies, if set (0 disables).");
+    fTargetErrorCmd->SetParameterName("error", false);
+    fTargetErrorCmd->SetRange("error>=0.");
+    fTargetErrorCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fTargetErrorCmd->SetToBeBroadcasted(false);
+
+    fTargetEnergyWindowCmd = new G4UIcommand("/ccTest/target/energyWindow", this);
+    fTargetEnergyWindowCmd->SetGuidance("Also target the coincidences with summed deposit in [eMin, eMax]");
+    fTargetEnergyWindowCmd->SetGuidance("(eMax<=eMin disables).");
+    fTargetEnergyWindowCmd->SetParameter(new G4UIparameter("eMin", 'd', false));
+    fTargetEnergyWindowCmd->SetParameter(new G4UIparameter("eMax", 'd', false));
+    auto windowUnitParam = new G4UIparameter("unit", 's', true);
+    windowUnitParam->SetDefaultValue("keV");
+    fTargetEnergyWindowCmd->SetParameter(windowUnitParam);
+    fTargetEnergyWindowCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fTargetEnergyWindowCmd->SetToBeBroadcasted(false);
+
+    fTargetImageRegionCmd = new G4UIcommand("/ccTest/target/imageRegion", this);
+    fTargetImageRegionCmd->SetGuidance("Also target the coincidences with the scatter hit in [x1,x2]x[y1,y2]");
+    fTargetImageRegionCmd->SetGuidance("(x2<=x1 or y2<=y1 disables).");
+    fTargetImageRegionCmd->SetParameter(new G4UIparameter("x1", 'd', false));
+    fTargetImageRegionCmd->SetParameter(new G4UIparameter("x2", 'd', false));
+    fTargetImageRegionCmd->SetParameter(new G4UIparameter("y1", 'd', false));
+    fTargetImageRegionCmd->SetParameter(new G4UIparameter("y2", 'd', false));
+    auto regionUnitParam = new G4UIparameter("unit", 's', true);
+    regionUnitParam->SetDefaultValue("cm");
+    fTargetImageRegionCmd->SetParameter(regionUnitParam);
+    fTargetImageRegionCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fTargetImageRegionCmd->SetToBeBroadcasted(false);
+
+    fTargetWallTimeCmd = new G4UIcmdWithADoubleAndUnit("/ccTest/target/wallTime", this);
+    fTargetWallTimeCmd->SetGuidance("Wall-time budget of each run (0 disables).");
+    fTargetWallTimeCmd->SetParameterName("time", false);
+    fTargetWallTimeCmd->SetRange("time>=0.");
+    fTargetWallTimeCmd->SetDefaultUnit("s");
+    fTargetWallTimeCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fTargetWallTimeCmd->SetToBeBroadcasted(false);
+
+    fTargetMinEventsCmd = new G4UIcmdWithAnInteger("/ccTest/target/minEvents", this);
+    fTargetMinEventsCmd->SetGuidance("Events before the relative error target is checked.");
+    fTargetMinEventsCmd->SetParameterName("nEvents", false);
+    fTargetMinEventsCmd->SetRange("nEvents>=0");
+    fTargetMinEventsCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fTargetMinEventsCmd->SetToBeBroadcasted(false);
+
+    fTargetCheckIntervalCmd = new G4UIcmdWithAnInteger("/ccTest/target/checkInterval", this);
+    fTargetCheckIntervalCmd->SetGuidance("Events between the reports of each thread.");
+    fTargetCheckIntervalCmd->SetParameterName("nEvents", false);
+    fTargetCheckIntervalCmd->SetRange("nEvents>0");
+    fTargetCheckIntervalCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fTargetCheckIntervalCmd->SetToBeBroadcasted(false);
+}
+
+RunTargetMessenger::~RunTargetMessenger()
+{
+    delete fTargetCheckIntervalCmd;
+    delete fTargetMinEventsCmd;
+    delete fTargetWallTimeCmd;
+    delete fTargetImageRegionCmd;
+    delete fTargetEnergyWindowCmd;
+    delete fTargetErrorCmd;
+    delete fTargetDir;
+}
+
+void RunTargetMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+    if(command==fTargetErrorCmd)
+        fRunTarget->SetRelativeError(fTargetErrorCmd->GetNewDoubleValue(newValue));
+    else if(command==fTargetEnergyWindowCmd)
+    {
+        std::istringstream iss(newValue);
+        G4double eMin, eMax;
+        G4String unit;
+        iss >> eMin >> eMax >> unit;
+        G4double value = G4UIcommand::ValueOf(unit);
+        fRunTarget->SetEnergyWindow(eMin*value, eMax*value);
+    }
+    else if(command==fTargetImageRegionCmd)
+    {
+        std::istringstream iss(newValue);
+        G4double x1, x2, y1, y2;
+        G4String unit;
+        iss >> x1 >> x2 >> y1 >> y2 >> unit;
+        G4double value = G4UIcommand::ValueOf(unit);
+        fRunTarget->SetImageRegion(x1*value, x2*value, y1*value, y2*value);
+    }
+    else if(command==fTargetWallTimeCmd)
+        fRunTarget->SetWallTime(fTargetWallTimeCmd->GetNewDoubleValue(newValue));
+    else if(command==fTargetMinEventsCmd)
+        fRunTarget->SetMinEvents(fTargetMinEventsCmd->GetNewIntValue(newValue));
+    else if(command==fTargetCheckIntervalCmd)
+        fRunTarget->SetCheckInterval(fTargetCheckIntervalCmd->GetNewIntValue(newValue));
+}
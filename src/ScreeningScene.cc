@@ -0,0 +1,126 @@
+#include "ScreeningScene.hh"
+
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+
+namespace
+{
+    std::ostream& operator<<(std::ostream& out, const ScreeningScene::Vector& v)
+    { return out << v[0] << " " << v[1] << " " << v[2]; }
+
+    std::istream& operator>>(std::istream& in, ScreeningScene::Vector& v)
+    { return in >> v[0] >> v[1] >> v[2]; }
+}
+
+ScreeningScene::Vector ScreeningScene::GetRodLocation(const Assembly& assembly, int rodID) const
+{
+    // As SpentFuelAssemblyParameterisation
+    return {(rodID%assembly.nx - (assembly.nx - 1)/2.)*assembly.interval,
+            (rodID/assembly.nx - (assembly.ny - 1)/2.)*assembly.interval, 0.};
+}
+
+std::vector<double> ScreeningScene::GetRodActivities() const
+{
+    std::vector<double> activities(static_cast<std::size_t>(GetNRods()), 0.);
+    auto nRods = static_cast<std::size_t>(GetNRodsPerAssembly());
+    for(std::size_t i = 0; i<assemblies.size(); ++i)
+        for(auto rodID: assemblies[i].activeRods)
+            activities[static_cast<std::size_t>(rodID) + nRods*i] = assemblies[i].activity;
+    return activities;
+}
+
+ScreeningScene::Vector ScreeningScene::GetSourceCentre() const
+{
+    Vector centre = {};
+    for(const auto& assembly: assemblies)
+        for(std::size_t k = 0; k<3; ++k) centre[k] += assembly.translation[k]/static_cast<double>(assemblies.size());
+    return centre;
+}
+
+bool ScreeningScene::Write(const std::string& fileName) const
+{
+    std::ofstream out(fileName);
+    return out && Write(out);
+}
+
+bool ScreeningScene::Read(const std::string& fileName)
+{
+    std::ifstream in(fileName);
+    return in && Read(in);
+}
+
+bool ScreeningScene::Write(std::ostream& out) const
+{
+    out << std::setprecision(std::numeric_limits<double>::max_digits10);
+    out << "# screening scene (keV, mm, 1/mm)\n"
+        << "energy " << energy << "\n"
+        << "attenuation " << muSurrounding << " " << muWorld << "\n"
+        << "# rod: pellet, gap and cladding radii, half height, attenuation of each\n"
+        << "rod " << rod.pelletRadius << " " << rod.gapRadius << " " << rod.claddingRadius << " " << rod.halfHeight
+        << " " << rod.muPellet << " " << rod.muGap << " " << rod.muCladding << "\n";
+    out << "axialProfile " << axialProfile.size();
+    for(auto value: axialProfile) out << " " << value;
+    out << "\n# assembly: nx ny interval, half size, local axes, translation, activity, active rods\n";
+    for(const auto& assembly: assemblies)
+    {
+        out << "assembly " << assembly.nx << " " << assembly.ny << " " << assembly.interval << " "
+            << assembly.halfSize << " " << assembly.axes[0] << " " << assembly.axes[1] << " " << assembly.axes[2] << " "
+            << assembly.translation << " " << assembly.activity << " " << assembly.activeRods.size();
+        for(auto rodID: assembly.activeRods) out << " " << rodID;
+        out << "\n";
+    }
+    out << "# camera: centre, local axes, half size\n";
+    for(const auto& camera: cameras)
+        out << "camera " << camera.centre << " " << camera.axes[0] << " " << camera.axes[1] << " " << camera.axes[2]
+            << " " << camera.halfSize << "\n";
+
+    return static_cast<bool>(out);
+}
+
+bool ScreeningScene::Read(std::istream& in)
+{
+    *this = ScreeningScene();
+    for(std::string line; std::getline(in, line);)
+    {
+        if(line.empty() || line[0]=='#') continue;
+        std::istringstream iss(line);
+        std::string keyword;
+        iss >> keyword;
+        if(keyword=="energy") iss >> energy;
+        else if(keyword=="attenuation") iss >> muSurrounding >> muWorld;
+        else if(keyword=="rod")
+            iss >> rod.pelletRadius >> rod.gapRadius >> rod.claddingRadius >> rod.halfHeight
+                >> rod.muPellet >> rod.muGap >> rod.muCladding;
+        else if(keyword=="axialProfile")
+        {
+            std::size_t n = 0;
+            iss >> n;
+            axialProfile.resize(n);
+            for(auto& value: axialProfile) iss >> value;
+        }
+        else if(keyword=="assembly")
+        {
+            Assembly assembly;
+            std::size_t nActiveRods = 0;
+            iss >> assembly.nx >> assembly.ny >> assembly.interval >> assembly.halfSize
+                >> assembly.axes[0] >> assembly.axes[1] >> assembly.axes[2] >> assembly.translation
+                >> assembly.activity >> nActiveRods;
+            assembly.activeRods.resize(nActiveRods);
+            for(auto& rodID: assembly.activeRods) iss >> rodID;
+            if(iss && !assemblies.empty()
+               && (assembly.nx!=assemblies.front().nx || assembly.ny!=assemblies.front().ny)) return false;
+            assemblies.push_back(assembly);
+        }
+        else if(keyword=="camera")
+        {
+            Camera camera;
+            iss >> camera.centre >> camera.axes[0] >> camera.axes[1] >> camera.axes[2] >> camera.halfSize;
+            cameras.push_back(camera);
+        }
+        else return false;
+        if(!iss) return false;
+    }
+    return energy>0. && !assemblies.empty();
+}
@@ -0,0 +1,344 @@
+#include "SimulationService.hh"
+#include "CachingRunManager.hh"
+#include "Campaign.hh"
+#include "EventAction.hh"
+#include "EventSeeder.hh"
+#include "Run.hh"
+#include "RunCache.hh"
+
+#include "G4AutoLock.hh"
+#include "G4RunManager.hh"
+#include "G4UIcommandStatus.hh"
+#include "G4UImanager.hh"
+#include "Randomize.hh"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace
+{
+    std::string Trim(const std::string& str)
+    {
+        auto begin = str.find_first_not_of(" \t\r");
+        if(begin==std::string::npos) return std::string();
+        return str.substr(begin, str.find_last_not_of(" \t\r") - begin + 1);
+    }
+
+    // Request text of a connection: up to the "end" or "shutdown" line, or
+    // the client closing its side
+    std::string ReadRequestText(int connection)
+    {
+        std::string text, line;
+        char buffer[4096];
+        for(ssize_t n; (n = recv(connection, buffer, sizeof(buffer), 0))!=0;)
+        {
+            if(n<0)
+            {
+                if(errno==EINTR) continue;
+                break;
+            }
+            for(ssize_t i = 0; i<n; ++i)
+            {
+                if(buffer[i]!='\n') { line += buffer[i]; continue; }
+                text += line + "\n";
+                auto key = Trim(line);
+                if(key=="end" || key=="shutdown") return text;
+                line.clear();
+            }
+        }
+        return text + line;
+    }
+}
+
+SimulationService* SimulationService::GetInstance()
+{
+    static SimulationService fInstance;
+    return &fInstance;
+}
+
+SimulationService::SimulationService()
+: fBaselineChanged(false), fRunning(false), fNEventsDone(0), fNEvents(0), fProgressInterval(1)
+{}
+
+G4bool SimulationService::ParseRequest(std::istream& in, Request& request, G4String& error)
+{
+    request = Request();
+    for(std::string line; std::getline(in, line);)
+    {
+        line = Trim(line);
+        if(line.empty() || line[0]=='#') continue;
+        auto separator = line.find_first_of(" \t");
+        std::string key = line.substr(0, separator);
+        std::string value = separator==std::string::npos ? std::string() : Trim(line.substr(separator));
+
+        if(key=="end") break;
+        if(key=="shutdown") { request.shutdown = true; break; }
+        if(key=="events" || key=="seed")
+        {
+            std::istringstream iss(value);
+            G4long number = -1;
+            if(!(iss >> number) || number<0)
+            {
+                error = "invalid " + key + " '" + value + "'";
+                return false;
+            }
+            (key=="events" ? request.nEvents : request.seed) = number;
+            continue;
+        }
+        if(value.empty())
+        {
+            error = "missing value of '" + key + "'";
+            return false;
+        }
+        if(key=="macro") request.commands.push_back("/control/execute " + value);
+        else if(key=="command") request.commands.push_back(value);
+        else if(key=="output") request.outputDirectory = value;
+        else
+        {
+            error = "unknown key '" + key + "'";
+            return false;
+        }
+    }
+    return true;
+}
+
+G4bool SimulationService::Serve(const G4String& endpoint, const G4String& baselineMacro)
+{
+    fDefaultOutputDirectory = EventAction::GetOutputDirectory();
+    fBaselineMacro = baselineMacro;
+    fBaselineChanged = false;
+    std::error_code error;
+    if(std::filesystem::is_directory(std::string(endpoint), error)) return ServeSpool(endpoint);
+    return ServeSocket(endpoint);
+}
+
+G4bool SimulationService::ServeSocket(const G4String& path)
+{
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    std::error_code error;
+    if(path.size()>=sizeof(address.sun_path)
+       || (std::filesystem::exists(std::string(path), error) && !std::filesystem::is_socket(std::string(path), error)))
+    {
+        G4Exception("SimulationService::ServeSocket()", "", JustWarning,
+                    G4String("    '" + path + "' is not a usable socket path.").c_str());
+        return false;
+    }
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+    // A socket left behind by an earlier service is replaced
+    unlink(path.c_str());
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(listener<0 || bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address))<0
+       || listen(listener, 16)<0)
+    {
+        G4Exception("SimulationService::ServeSocket()", "", JustWarning,
+                    G4String("    Cannot listen on '" + path + "': " + std::strerror(errno)).c_str());
+        if(listener>=0) close(listener);
+        return false;
+    }
+    G4cout << "Simulation service listening on " << path << G4endl;
+
+    for(G4bool shutdown = false; !shutdown;)
+    {
+        int connection = accept(listener, nullptr, nullptr);
+        if(connection<0)
+        {
+            if(errno==EINTR) continue;
+            break;
+        }
+        std::istringstream requestText(ReadRequestText(connection));
+        {
+            G4AutoLock lock(&fMutex);
+            // The client may be gone: no SIGPIPE
+            fStatusSink = [connection](const std::string& line)
+            {
+                std::string message = line + "\n";
+                send(connection, message.data(), message.size(), MSG_NOSIGNAL);
+            };
+        }
+
+        Request request;
+        G4String parseError;
+        if(!ParseRequest(requestText, request, parseError)) Status("error " + parseError);
+        else if(request.shutdown)
+        {
+            Status("done shutdown");
+            shutdown = true;
+        }
+        else Execute(request);
+
+        {
+            G4AutoLock lock(&fMutex);
+            fStatusSink = nullptr;
+        }
+        close(connection);
+    }
+    close(listener);
+    unlink(path.c_str());
+    G4cout << "Simulation service stopped" << G4endl;
+    return true;
+}
+
+G4bool SimulationService::ServeSpool(const G4String& directory)
+{
+    G4cout << "Simulation service watching " << directory << G4endl;
+    for(G4bool shutdown = false; !shutdown;)
+    {
+        std::vector<std::filesystem::path> requestFiles;
+        std::error_code error;
+        for(const auto& entry: std::filesystem::directory_iterator(std::string(directory), error))
+            if(entry.path().extension()==".req") requestFiles.push_back(entry.path());
+        if(requestFiles.empty())
+        {
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+            continue;
+        }
+        std::sort(requestFiles.begin(), requestFiles.end());
+
+        // Claim the request first, so that it is not taken twice
+        auto base = requestFiles.front();
+        base.replace_extension();
+        std::string runningFile = base.string() + ".running";
+        if(std::rename(requestFiles.front().c_str(), runningFile.c_str())!=0) continue;
+
+        std::ofstream status(base.string() + ".status", std::ios::app);
+        {
+            G4AutoLock lock(&fMutex);
+            fStatusSink = [&status](const std::string& line) { status << line << std::endl; };
+        }
+
+        std::ifstream in(runningFile);
+        Request request;
+        G4String parseError;
+        G4bool ok = ParseRequest(in, request, parseError);
+        if(!ok) Status("error " + parseError);
+        else if(request.shutdown)
+        {
+            Status("done shutdown");
+            shutdown = true;
+        }
+        else ok = Execute(request);
+
+        {
+            G4AutoLock lock(&fMutex);
+            fStatusSink = nullptr;
+        }
+        std::rename(runningFile.c_str(), (base.string() + (ok ? ".done" : ".failed")).c_str());
+    }
+    G4cout << "Simulation service stopped" << G4endl;
+    return true;
+}
+
+G4bool SimulationService::Execute(const Request& request)
+{
+    Status("accepted");
+    auto start = std::chrono::steady_clock::now();
+
+    G4String outputDirectory = request.outputDirectory.empty() ? fDefaultOutputDirectory : request.outputDirectory;
+    std::error_code error;
+    std::filesystem::create_directories(std::string(outputDirectory), error);
+    if(error)
+    {
+        Status("error cannot create the output directory " + outputDirectory + ": " + error.message());
+        G4cout << "Service request failed: output directory " << outputDirectory << G4endl;
+        return false;
+    }
+
+    // Back to the baseline, before the settings of the request
+    auto UImanager = G4UImanager::GetUIpointer();
+    if(fBaselineChanged && !fBaselineMacro.empty())
+    {
+        auto commandStatus = UImanager->ApplyCommand("/control/execute " + fBaselineMacro);
+        if(commandStatus!=fCommandSucceeded)
+        {
+            Status("error startup macro '" + fBaselineMacro + "' failed (status " + std::to_string(commandStatus) + ")");
+            G4cout << "Service request failed: startup macro " << fBaselineMacro << G4endl;
+            return false;
+        }
+    }
+    fBaselineChanged = !request.commands.empty() || request.nEvents>0;
+
+    EventAction::SetOutputDirectory(outputDirectory);
+    if(request.seed>=0)
+    {
+        G4Random::setTheSeed(request.seed);
+        EventSeeder::GetInstance()->SetSeed(request.seed);
+    }
+
+    for(const auto& command: request.commands)
+    {
+        auto commandStatus = UImanager->ApplyCommand(command);
+        if(commandStatus!=fCommandSucceeded)
+        {
+            Status("error '" + command + "' failed (status " + std::to_string(commandStatus) + ")");
+            G4cout << "Service request failed: " << command << G4endl;
+            return false;
+        }
+    }
+
+    fNEvents = request.nEvents;
+    fNEventsDone = 0;
+    fProgressInterval = std::max<G4long>(1, request.nEvents/10);
+    G4long nEvents = 0, nCoincidences = 0;
+    fRunning = true;
+    if(request.nEvents>INT_MAX)
+    {
+        auto campaign = Campaign::GetInstance();
+        campaign->BeamOn(request.nEvents);
+        if(auto total = campaign->GetTotal())
+        {
+            nEvents = total->GetNEvents();
+            nCoincidences = total->GetNCoincidences();
+        }
+    }
+    else if(request.nEvents>0)
+    {
+        auto runManager = G4RunManager::GetRunManager();
+        runManager->BeamOn(static_cast<G4int>(request.nEvents));
+        if(static_cast<CachingRunManager*>(runManager)->LastRunRestored())
+        {
+            nEvents = RunCache::GetInstance()->GetLastNEvents();
+            nCoincidences = RunCache::GetInstance()->GetLastNCoincidences();
+        }
+        else if(auto run = static_cast<const Run*>(runManager->GetCurrentRun()))
+        {
+            nEvents = run->GetNEvents();
+            nCoincidences = run->GetNCoincidences();
+        }
+    }
+    fRunning = false;
+    // The client may read the outputs as soon as it sees "done"
+    EventAction::FlushOutput();
+
+    G4double seconds = std::chrono::duration<G4double>(std::chrono::steady_clock::now() - start).count();
+    std::ostringstream summary;
+    summary << "events=" << nEvents << " coincidences=" << nCoincidences << " seconds=" << seconds;
+    Status("done " + summary.str());
+    G4cout << "Service request done: " << summary.str() << G4endl;
+    return true;
+}
+
+void SimulationService::ReportProgress(G4long nEventsDone)
+{
+    Status("progress " + std::to_string(nEventsDone) + " " + std::to_string(fNEvents));
+}
+
+void SimulationService::Status(const std::string& line)
+{
+    G4AutoLock lock(&fMutex);
+    if(fStatusSink) fStatusSink(line);
+}
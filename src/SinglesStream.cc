@@ -0,0 +1,84 @@
+#include "SinglesStream.hh"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    const char kMagic[4] = {'C', 'C', 'S', '1'};
+
+    template<typename T>
+    void WriteValue(std::ostream& out, const T& value)
+    { out.write(reinterpret_cast<const char*>(&value), sizeof(T)); }
+
+    template<typename T>
+    void ReadValue(std::istream& in, T& value)
+    { in.read(reinterpret_cast<char*>(&value), sizeof(T)); }
+}
+
+SinglesWriter::SinglesWriter(const std::string& fileName, bool append)
+: fOut(fileName, append ? std::ios::binary | std::ios::app : std::ios::binary), fNWritten(0)
+{
+    fOut.seekp(0, std::ios::end);
+    if(fOut && fOut.tellp()==0) fOut.write(kMagic, sizeof(kMagic));
+}
+
+SinglesWriter::~SinglesWriter()
+{
+    Close();
+}
+
+void SinglesWriter::BeginEvent(double arrivalTime)
+{
+    Flush(arrivalTime);
+}
+
+void SinglesWriter::Close()
+{
+    if(!fOut.is_open()) return;
+    Flush(fPending.empty() ? 0. : std::max_element(fPending.begin(), fPending.end(),
+                                                   [](const Single& a, const Single& b)
+                                                   { return a.time<b.time; })->time);
+    fOut.close();
+}
+
+void SinglesWriter::Flush(double upToTime)
+{
+    auto end = std::partition(fPending.begin(), fPending.end(),
+                              [upToTime](const Single& single) { return single.time<=upToTime; });
+    std::sort(fPending.begin(), end, [](const Single& a, const Single& b) { return a.time<b.time; });
+    for(auto itr = fPending.begin(); itr!=end; ++itr)
+    {
+        WriteValue(fOut, itr->time);
+        WriteValue(fOut, itr->eventID);
+        WriteValue(fOut, itr->detID);
+        WriteValue(fOut, itr->energy);
+        WriteValue(fOut, itr->x);
+        WriteValue(fOut, itr->y);
+        WriteValue(fOut, itr->z);
+        WriteValue(fOut, itr->weight);
+    }
+    fNWritten += static_cast<std::uint64_t>(end - fPending.begin());
+    fPending.erase(fPending.begin(), end);
+}
+
+SinglesReader::SinglesReader(const std::string& fileName)
+: fIn(fileName, std::ios::binary), fValid(false)
+{
+    char magic[4];
+    fValid = fIn.read(magic, sizeof(magic)) && std::memcmp(magic, kMagic, sizeof(kMagic))==0;
+}
+
+bool SinglesReader::Next(Single& single)
+{
+    if(!fValid) return false;
+    ReadValue(fIn, single.time);
+    ReadValue(fIn, single.eventID);
+    ReadValue(fIn, single.detID);
+    ReadValue(fIn, single.energy);
+    ReadValue(fIn, single.x);
+    ReadValue(fIn, single.y);
+    ReadValue(fIn, single.z);
+    ReadValue(fIn, single.weight);
+    return static_cast<bool>(fIn);
+}
@@ -8,6 +8,7 @@
 #include "G4PVParameterised.hh"
 #include "G4VisAttributes.hh"
 #include "G4RandomTools.hh"
+#include "G4UIcommand.hh"
 
 #include <algorithm>
 #include <random>
@@ -36,8 +37,8 @@ FuelRod::FuelRod()
     G4double HeGapHeight = claddingHeight;
     auto HeGapSol = new G4Tubs("HeGap", 0., HeGapOuterDiameter/2., HeGapHeight/2., 0., 360.*deg);
     auto HeGas = G4Material::GetMaterial("HeGas");
-    auto HeGapLV = new G4LogicalVolume(HeGapSol, HeGas, "HeGap");
-    new G4PVPlacement(nullptr, G4ThreeVector(), HeGapLV, "HeGap", fCladdingLV, false, 0);
+    fHeGapLV = new G4LogicalVolume(HeGapSol, HeGas, "HeGap");
+    new G4PVPlacement(nullptr, G4ThreeVector(), fHeGapLV, "HeGap", fCladdingLV, false, 0);
 
     // Fuel pellet of LEU
     G4double fuelPelletDiameter = 8.26*mm;
@@ -47,7 +48,17 @@ FuelRod::FuelRod()
     fFuelPelletLV = new G4LogicalVolume(fuelPelletSol, LEU, "FuelPellet");
     auto fuelPelletVA = new G4VisAttributes(G4Colour::Magenta());
     fFuelPelletLV->SetVisAttributes(fuelPelletVA);
-    new G4PVPlacement(nullptr, G4ThreeVector(), fFuelPelletLV, "FuelPellet", HeGapLV, false, 0);
+    new G4PVPlacement(nullptr, G4ThreeVector(), fFuelPelletLV, "FuelPellet", fHeGapLV, false, 0);
+}
+
+std::vector<std::pair<G4Material*, G4double>> FuelRod::GetCrossSections() const
+{
+    G4double fuelPelletRadius = static_cast<G4Tubs*>(fFuelPelletLV->GetSolid())->GetRMax();
+    G4double HeGapRadius = static_cast<G4Tubs*>(fHeGapLV->GetSolid())->GetRMax();
+    G4double claddingRadius = static_cast<G4Tubs*>(fCladdingLV->GetSolid())->GetRMax();
+    return {{fFuelPelletLV->GetMaterial(), pi*fuelPelletRadius*fuelPelletRadius},
+            {fHeGapLV->GetMaterial(), pi*(HeGapRadius*HeGapRadius - fuelPelletRadius*fuelPelletRadius)},
+            {fCladdingLV->GetMaterial(), pi*(claddingRadius*claddingRadius - HeGapRadius*HeGapRadius)}};
 }
 
 G4ThreeVector FuelRod::SampleRandomPointInFuelRod() const
@@ -60,6 +71,15 @@ G4ThreeVector FuelRod::SampleRandomPointInFuelRod() const
     return G4ThreeVector(randomXYPoint.x(), randomXYPoint.y(), randomZPoint);
 }
 
+G4ThreeVector FuelRod::SampleRandomPointInFuelRod(G4double zFraction) const
+{
+    G4double fuelPelletDiameter = 2*static_cast<G4Tubs*>(fFuelPelletLV->GetSolid())->GetRMax();
+    G4double fuelPelletHeight = 2*static_cast<G4Tubs*>(fFuelPelletLV->GetSolid())->GetZHalfLength();
+    G4TwoVector randomXYPoint = G4RandomPointInEllipse(fuelPelletDiameter/2., fuelPelletDiameter/2.);
+
+    return G4ThreeVector(randomXYPoint.x(), randomXYPoint.y(), (zFraction - 0.5)*fuelPelletHeight);
+}
+
 void FuelRod::DefineMaterials()
 {
     auto nist = G4NistManager::Instance();
@@ -117,12 +137,13 @@ void FuelRod::DefineMaterials()
     fDefineMaterialsFlag = true;
 }
 
-SpentFuelAssembly::SpentFuelAssembly(G4String name, G4Material* surrMat, G4int nx, G4int ny, G4double interval)
-: fName(name), fNX(nx), fNY(ny), fInterval(interval)
+SpentFuelAssembly::SpentFuelAssembly(G4String name, G4Material* surrMat, G4int nx, G4int ny, G4double interval,
+                                     G4bool homogenized)
+: fName(name), fNX(nx), fNY(ny), fInterval(interval), fHomogenized(homogenized)
 {
     // Geometry tree view
     // - SpentFuelAssembly
-    // | - FuelRod (fNX*fNY)
+    // | - FuelRod (fNX*fNY; none when homogenized)
 
     fFuelRod = std::make_shared<FuelRod>();
     G4double fuelRodRadius = static_cast<G4Tubs*>(fFuelRod->GetLogicalVolume()->GetSolid())->GetRMax();
@@ -131,17 +152,52 @@ SpentFuelAssembly::SpentFuelAssembly(G4String name, G4Material* surrMat, G4int n
                                           fInterval*(fNX - 1)/2. + fuelRodRadius,
                                           fInterval*(fNY - 1)/2. + fuelRodRadius,
                                           fuelRodHeight/2.);
-    fSpentFuelAssemblyLV = new G4LogicalVolume(spentFuelAssemblySol, surrMat, fName);
-
     fSpentFuelAssemblyParam = new SpentFuelAssemblyParameterisation(fNX, fNY, fInterval);
-    new G4PVParameterised("FuelRod", fFuelRod->GetLogicalVolume(), fSpentFuelAssemblyLV,
-                                       kXAxis, fNX*fNY, fSpentFuelAssemblyParam);
+    if(fHomogenized)
+    {
+        fSpentFuelAssemblyLV = new G4LogicalVolume(spentFuelAssemblySol, GetHomogenizedMaterial(surrMat), fName);
+        fSpentFuelAssemblyLV->SetVisAttributes(new G4VisAttributes(G4Colour::Magenta()));
+    }
+    else
+    {
+        fSpentFuelAssemblyLV = new G4LogicalVolume(spentFuelAssemblySol, surrMat, fName);
+        new G4PVParameterised("FuelRod", fFuelRod->GetLogicalVolume(), fSpentFuelAssemblyLV,
+                                           kXAxis, fNX*fNY, fSpentFuelAssemblyParam);
+    }
 
     for(G4int i = 0; i<fNX*fNY; ++i) fFuelRodIDVec.push_back(i);
 
     SpentFuelAssemblyStore::GetInstance()->Register(std::shared_ptr<SpentFuelAssembly>(this));
 }
 
+G4Material* SpentFuelAssembly::GetHomogenizedMaterial(G4Material* surrMat) const
+{
+    // One mixture per lattice and surrounding material, kept across rebuilds
+    G4String materialName = "Homogenized_" + surrMat->GetName() + "_" + G4UIcommand::ConvertToString(fNX) + "x"
+            + G4UIcommand::ConvertToString(fNY) + "_" + G4UIcommand::ConvertToString(fInterval/mm) + "mm";
+    if(auto material = G4Material::GetMaterial(materialName, false)) return material;
+
+    // Volume fractions of the box cross section; mass fractions = density x volume
+    G4double fuelRodRadius = static_cast<G4Tubs*>(fFuelRod->GetLogicalVolume()->GetSolid())->GetRMax();
+    G4double area = (fInterval*(fNX - 1) + 2.*fuelRodRadius)*(fInterval*(fNY - 1) + 2.*fuelRodRadius);
+    G4int nFuelRods = fNX*fNY;
+    auto components = fFuelRod->GetCrossSections();
+    for(auto& component: components) component.second *= nFuelRods;
+    components.emplace_back(surrMat, area - nFuelRods*pi*fuelRodRadius*fuelRodRadius);
+
+    G4double mass = 0.;
+    for(const auto& component: components) mass += component.first->GetDensity()*component.second;
+    auto material = new G4Material(materialName, mass/area, static_cast<G4int>(components.size()));
+    G4cout << "Homogenized assembly material " << materialName << " (" << mass/area/(g/cm3) << " g/cm3):";
+    for(const auto& component: components)
+    {
+        material->AddMaterial(component.first, component.first->GetDensity()*component.second/mass);
+        G4cout << " " << component.first->GetName() << " " << component.second/area*100. << "%";
+    }
+    G4cout << " by volume" << G4endl;
+    return material;
+}
+
 G4ThreeVector SpentFuelAssembly::GetFuelRodLocation(const G4int i) const
 {
     if(i<0 || i>=fNX*fNY)
@@ -154,6 +210,42 @@ G4ThreeVector SpentFuelAssembly::GetFuelRodLocation(const G4int i) const
     return fSpentFuelAssemblyParam->GetTranslation(i);
 }
 
+std::vector<G4LogicalVolume*> SpentFuelAssembly::GetLogicalVolumes() const
+{
+    std::vector<G4LogicalVolume*> volumes = {fSpentFuelAssemblyLV};
+    if(!fHomogenized)
+        for(auto volume: fFuelRod->GetLogicalVolumes()) volumes.push_back(volume);
+    return volumes;
+}
+
+G4ThreeVector SpentFuelAssembly::SampleRandomPointInLattice(G4double zFraction) const
+{
+    auto box = static_cast<G4Box*>(fSpentFuelAssemblyLV->GetSolid());
+    return G4ThreeVector((2.*G4UniformRand() - 1.)*box->GetXHalfLength(),
+                         (2.*G4UniformRand() - 1.)*box->GetYHalfLength(),
+                         (zFraction - 0.5)*2.*box->GetZHalfLength());
+}
+
+G4ThreeVector SpentFuelAssembly::SampleRandomPointInCell(G4int i, G4double zFraction) const
+{
+    // Square cell of the rod, cut at the box faces
+    auto box = static_cast<G4Box*>(fSpentFuelAssemblyLV->GetSolid());
+    auto centre = GetFuelRodLocation(i);
+    G4double xMin = std::max(centre.x() - fInterval/2., -box->GetXHalfLength());
+    G4double xMax = std::min(centre.x() + fInterval/2., box->GetXHalfLength());
+    G4double yMin = std::max(centre.y() - fInterval/2., -box->GetYHalfLength());
+    G4double yMax = std::min(centre.y() + fInterval/2., box->GetYHalfLength());
+    return G4ThreeVector(xMin + G4UniformRand()*(xMax - xMin), yMin + G4UniformRand()*(yMax - yMin),
+                         (zFraction - 0.5)*2.*box->GetZHalfLength());
+}
+
+G4int SpentFuelAssembly::GetLatticeCell(const G4ThreeVector& localPos) const
+{
+    auto ix = static_cast<G4int>(std::floor(localPos.x()/fInterval + fNX/2.));
+    auto iy = static_cast<G4int>(std::floor(localPos.y()/fInterval + fNY/2.));
+    return std::clamp(ix, 0, fNX - 1) + fNX*std::clamp(iy, 0, fNY - 1);
+}
+
 void SpentFuelAssembly::SetFuelRodStatus(G4double ratio)
 {
     if(ratio<0. || ratio>1.)
@@ -204,3 +296,100 @@ std::shared_ptr<SpentFuelAssembly> SpentFuelAssemblyStore::GetSpentFuelAssembly(
     return std::shared_ptr<SpentFuelAssembly>(nullptr);
 }
 
+
+
+void SpentFuelAssemblyStore::Update()
+{
+    std::vector<G4double> weights;
+    for(std::size_t i = 0; i<size(); ++i)
+    {
+        weights.push_back(GetAssemblyActivity(i)*at(i)->GetNActiveFuelRods());
+    }
+    fAssemblyTable = std::make_unique<AliasTable>(weights);
+    if(!empty() && fAssemblyTable->GetTotalWeight()<=0.)
+        G4Exception("SpentFuelAssemblyStore::Update()", "", JustWarning,
+                    "    No active fuel rod with a non-zero activity; only basis runs are possible.");
+
+    fAxialTable = std::make_unique<AliasTable>(fAxialProfile.empty() ? std::vector<G4double>(1, 1.) : fAxialProfile);
+    if(fAxialTable->GetTotalWeight()<=0.)
+    {
+        G4Exception("SpentFuelAssemblyStore::Update()", "", JustWarning,
+                    "    The axial profile has no positive bin; a uniform profile is used.");
+        fAxialTable = std::make_unique<AliasTable>(std::vector<G4double>(1, 1.));
+    }
+}
+
+G4int SpentFuelAssemblyStore::GetNFuelRods() const
+{
+    G4int nFuelRods = 0;
+    for(const auto& assembly: *this) nFuelRods += assembly->GetNX()*assembly->GetNY();
+    return nFuelRods;
+}
+
+G4ThreeVector SpentFuelAssemblyStore::SampleSourcePosition(G4bool allRods, G4int& fuelRodID) const
+{
+    // All the assemblies share the rod lattice
+    auto assemblyID = allRods ? static_cast<G4int>(G4UniformRand()*size())
+                              : fAssemblyTable->Sample(G4UniformRand());
+    const auto& assembly = at(static_cast<std::size_t>(assemblyID));
+    G4int nFuelRods = assembly->GetNX()*assembly->GetNY();
+    if(assembly->IsHomogenized())
+    {
+        auto pointInLattice = assembly->SampleRandomPointInLattice(SampleZFraction());
+        fuelRodID = assembly->GetLatticeCell(pointInLattice) + nFuelRods*assemblyID;
+        return assembly->LocalToGlobal(pointInLattice);
+    }
+    G4int rodID = allRods ? static_cast<G4int>(G4UniformRand()*nFuelRods) : assembly->SampleRandomFuelRodID();
+
+    fuelRodID = rodID + nFuelRods*assemblyID;
+    return SamplePointInFuelRod(fuelRodID);
+}
+
+G4ThreeVector SpentFuelAssemblyStore::SamplePointInFuelRod(G4int fuelRodID) const
+{
+    const auto& assembly = front();
+    G4int nFuelRods = assembly->GetNX()*assembly->GetNY();
+    const auto& rodAssembly = at(static_cast<std::size_t>(fuelRodID/nFuelRods));
+    G4int rodID = fuelRodID%nFuelRods;
+
+    G4double zFraction = SampleZFraction();
+    if(rodAssembly->IsHomogenized()) return rodAssembly->LocalToGlobal(rodAssembly->SampleRandomPointInCell(rodID, zFraction));
+    auto pointInFuelRod = rodAssembly->GetFuelRod()->SampleRandomPointInFuelRod(zFraction);
+    return rodAssembly->LocalToGlobal(rodAssembly->GetFuelRodLocation(rodID) + pointInFuelRod);
+}
+
+G4double SpentFuelAssemblyStore::SampleZFraction() const
+{
+    // Axial bin, then uniform within the bin
+    G4double nAxialBins = static_cast<G4double>(fAxialTable->size());
+    return (fAxialTable->Sample(G4UniformRand()) + G4UniformRand())/nAxialBins;
+}
+
+G4ThreeVector SpentFuelAssemblyStore::GetFuelRodPosition(G4int fuelRodID) const
+{
+    const auto& assembly = front();
+    G4int nFuelRods = assembly->GetNX()*assembly->GetNY();
+    const auto& rodAssembly = at(static_cast<std::size_t>(fuelRodID/nFuelRods));
+    return rodAssembly->LocalToGlobal(rodAssembly->GetFuelRodLocation(fuelRodID%nFuelRods));
+}
+
+void SpentFuelAssemblyStore::PrintFuelRodStatus(std::ostream& out) const
+{
+    if(size()>1) out << "# assemblies: " << size() << G4endl;
+    for(std::size_t i = 0; i<size(); ++i)
+    {
+        if(size()>1)
+        {
+            auto position = at(i)->LocalToGlobal(G4ThreeVector());
+            out << "# assembly " << i << " at (" << position.x()/mm << ", " << position.y()/mm << ") mm, relative activity "
+                << ((i<fAssemblyActivities.size()) ? fAssemblyActivities[i] : 1.) << G4endl;
+        }
+        at(i)->PrintFuelRodStatus(out);
+    }
+    if(!fAxialProfile.empty())
+    {
+        out << "# axial profile:";
+        for(auto value: fAxialProfile) out << " " << value;
+        out << G4endl;
+    }
+}
@@ -0,0 +1,168 @@
+#include "StackingAction.hh"
+#include "Run.hh"
+
+#include "G4Gamma.hh"
+#include "G4LogicalVolume.hh"
+#include "G4LogicalVolumeStore.hh"
+#include "G4ParticleDefinition.hh"
+#include "G4ParticleTable.hh"
+#include "G4PhysicalVolumeStore.hh"
+#include "G4RunManager.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4Threading.hh"
+#include "G4Track.hh"
+#include "G4VSolid.hh"
+
+#include <cmath>
+
+std::vector<G4String> StackingAction::fParticleRules;
+std::vector<std::pair<G4String, G4String>> StackingAction::fVolumeRules;
+std::vector<std::pair<G4String, G4double>> StackingAction::fEnergyRules;
+G4bool StackingAction::fCameraPriority = false;
+
+G4bool StackingAction::Selector::Matches(const G4ParticleDefinition* definition) const
+{
+    switch(type)
+    {
+    case kAll: return true;
+    case kIons: return definition->GetParticleType()=="nucleus";
+    default: return definition==particle;
+    }
+}
+
+StackingAction::StackingAction()
+: G4UserStackingAction(), fRun(nullptr), fRunID(-1)
+{}
+
+StackingAction::~StackingAction()
+{}
+
+void StackingAction::ClearRules()
+{
+    fParticleRules.clear();
+    fVolumeRules.clear();
+    fEnergyRules.clear();
+}
+
+void StackingAction::PrintRules(std::ostream& out)
+{
+    for(const auto& particle: fParticleRules) out << "  kill " << particle << G4endl;
+    for(const auto& rule: fVolumeRules) out << "  kill " << rule.first << " created in " << rule.second << G4endl;
+    for(const auto& rule: fEnergyRules) out << "  kill " << rule.first << " below " << rule.second/keV << " keV" << G4endl;
+    if(fCameraPriority) out << "  photons toward the camera first" << G4endl;
+}
+
+void StackingAction::PrepareNewEvent()
+{
+    // Tallies go to the Run of this thread; rules and cameras are resolved once per run
+    fRun = static_cast<Run*>(G4RunManager::GetRunManager()->GetNonConstCurrentRun());
+    if(fRun && fRun->GetRunID()!=fRunID)
+    {
+        fRunID = fRun->GetRunID();
+        Resolve();
+    }
+}
+
+G4ClassificationOfNewTrack StackingAction::ClassifyNewTrack(const G4Track* track)
+{
+    auto definition = track->GetDefinition();
+    if(track->GetParentID()>0)
+    {
+        G4int rule = kNRules;
+        for(const auto& selector: fParticleSelectors)
+            if(selector.Matches(definition)) { rule = kParticleRule; break; }
+        if(rule==kNRules && !fVolumeSelectors.empty() && track->GetVolume())
+        {
+            auto volume = track->GetVolume()->GetLogicalVolume();
+            for(const auto& selector: fVolumeSelectors)
+                if(selector.second==volume && selector.first.Matches(definition)) { rule = kVolumeRule; break; }
+        }
+        if(rule==kNRules)
+            for(const auto& selector: fEnergySelectors)
+                if(track->GetKineticEnergy()<selector.second && selector.first.Matches(definition)) { rule = kEnergyRule; break; }
+        if(rule!=kNRules)
+        {
+            if(fRun) fRun->AddKilledTrack(rule, track->GetKineticEnergy());
+            return fKill;
+        }
+    }
+
+    if(fCameraPriority && definition==G4Gamma::Definition())
+        return HeadsToCamera(track) ? fUrgent : fWaiting;
+    return fUrgent;
+}
+
+void StackingAction::Resolve()
+{
+    fParticleSelectors.clear();
+    fVolumeSelectors.clear();
+    fEnergySelectors.clear();
+    fCameras.clear();
+
+    Selector selector;
+    for(const auto& particle: fParticleRules)
+        if(Resolve(particle, selector)) fParticleSelectors.push_back(selector);
+    auto logicalVolumeStore = G4LogicalVolumeStore::GetInstance();
+    for(const auto& rule: fVolumeRules)
+    {
+        // Several logical volumes may share the name (one per camera, assembly type, ...)
+        G4bool found = false;
+        for(auto volume: *logicalVolumeStore)
+            if(volume->GetName()==rule.second && Resolve(rule.first, selector))
+            {
+                fVolumeSelectors.emplace_back(selector, volume);
+                found = true;
+            }
+        if(!found && G4Threading::G4GetThreadId()<=0)
+            G4Exception("StackingAction::Resolve()", "", JustWarning,
+                        G4String("    No logical volume '" + rule.second + "'; rule ignored.").c_str());
+    }
+    for(const auto& rule: fEnergyRules)
+        if(Resolve(rule.first, selector)) fEnergySelectors.emplace_back(selector, rule.second);
+
+    if(!fCameraPriority) return;
+    for(auto volume: *G4PhysicalVolumeStore::GetInstance())
+    {
+        if(volume->GetName()!="ComptonCamera") continue;
+        G4ThreeVector pMin, pMax;
+        volume->GetLogicalVolume()->GetSolid()->BoundingLimits(pMin, pMax);
+        auto rotation = volume->GetObjectRotationValue();
+        fCameras.push_back({volume->GetObjectTranslation() + rotation*(0.5*(pMin + pMax)), 0.5*(pMax - pMin).mag()});
+    }
+}
+
+G4bool StackingAction::Resolve(const G4String& particle, Selector& selector) const
+{
+    selector.particle = nullptr;
+    if(particle=="all") selector.type = Selector::kAll;
+    else if(particle=="ions") selector.type = Selector::kIons;
+    else
+    {
+        selector.type = Selector::kParticle;
+        selector.particle = G4ParticleTable::GetParticleTable()->FindParticle(particle);
+        if(!selector.particle)
+        {
+            if(G4Threading::G4GetThreadId()<=0)
+                G4Exception("StackingAction::Resolve()", "", JustWarning,
+                            G4String("    Unknown particle '" + particle + "'; rule ignored.").c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+G4bool StackingAction::HeadsToCamera(const G4Track* track) const
+{
+    const auto& position = track->GetPosition();
+    const auto& direction = track->GetMomentumDirection();
+    for(const auto& camera: fCameras)
+    {
+        auto toCamera = camera.centre - position;
+        G4double distance = toCamera.mag();
+        if(distance<=camera.radius) return true;
+        // Inside the cone of half angle asin(radius/distance) around the camera centre
+        G4double cosHalfAngle = std::sqrt(1. - camera.radius*camera.radius/(distance*distance));
+        if(direction.dot(toCamera)>=cosHalfAngle*distance) return true;
+    }
+    return false;
+}
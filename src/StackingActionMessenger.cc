@@ -0,0 +1,101 @@
+#include "StackingActionMessenger.hh"
+#include "StackingAction.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcommand.hh"
+#include "G4UIparameter.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithABool.hh"
+#include "G4UIcmdWithoutParameter.hh"
+
+#include <sstream>
+
+StackingActionMessenger::StackingActionMessenger()
+: G4UImessenger()
+{
+    fStackDir = new G4UIdirectory("/ccTest/stack/");
+    fStackDir->SetGuidance("Kill rules for secondaries and the priority of camera-bound photons.");
+    fStackDir->SetGuidance("Particles: a particle name, 'ions' (nuclei) or 'all'. Primaries are never killed.");
+
+    fKillParticleCmd = new G4UIcmdWithAString("/ccTest/stack/killParticle", this);
+    fKillParticleCmd->SetGuidance("Kill the secondaries of a particle type (e.g. nu_e, anti_nu_e).");
+    fKillParticleCmd->SetParameterName("particle", false);
+    fKillParticleCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fKillParticleCmd->SetToBeBroadcasted(false);
+
+    fKillInVolumeCmd = new G4UIcommand("/ccTest/stack/killInVolume", this);
+    fKillInVolumeCmd->SetGuidance("Kill the secondaries of a particle type created in a logical volume.");
+    fKillInVolumeCmd->SetGuidance("  e.g. /ccTest/stack/killInVolume e- FuelPellet");
+    fKillInVolumeCmd->SetParameter(new G4UIparameter("particle", 's', false));
+    fKillInVolumeCmd->SetParameter(new G4UIparameter("volume", 's', false));
+    fKillInVolumeCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fKillInVolumeCmd->SetToBeBroadcasted(false);
+
+    fKillBelowCmd = new G4UIcommand("/ccTest/stack/killBelow", this);
+    fKillBelowCmd->SetGuidance("Kill the secondaries of a particle type below a kinetic energy.");
+    fKillBelowCmd->SetGuidance("  e.g. /ccTest/stack/killBelow e- 100 keV");
+    fKillBelowCmd->SetParameter(new G4UIparameter("particle", 's', false));
+    auto killEnergyParam = new G4UIparameter("energy", 'd', false);
+    killEnergyParam->SetParameterRange("energy>0.");
+    fKillBelowCmd->SetParameter(killEnergyParam);
+    auto killEnergyUnitParam = new G4UIparameter("unit", 's', true);
+    killEnergyUnitParam->SetDefaultValue("keV");
+    fKillBelowCmd->SetParameter(killEnergyUnitParam);
+    fKillBelowCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fKillBelowCmd->SetToBeBroadcasted(false);
+
+    fCameraPriorityCmd = new G4UIcmdWithABool("/ccTest/stack/cameraPriority", this);
+    fCameraPriorityCmd->SetGuidance("Track the photons heading toward a camera first (others: waiting stack).");
+    fCameraPriorityCmd->SetParameterName("enable", true);
+    fCameraPriorityCmd->SetDefaultValue(true);
+    fCameraPriorityCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fCameraPriorityCmd->SetToBeBroadcasted(false);
+
+    fClearStackRulesCmd = new G4UIcmdWithoutParameter("/ccTest/stack/clear", this);
+    fClearStackRulesCmd->SetGuidance("Remove all kill rules.");
+    fClearStackRulesCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fClearStackRulesCmd->SetToBeBroadcasted(false);
+
+    fListStackRulesCmd = new G4UIcmdWithoutParameter("/ccTest/stack/list", this);
+    fListStackRulesCmd->SetGuidance("Print the kill rules and the camera priority.");
+    fListStackRulesCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fListStackRulesCmd->SetToBeBroadcasted(false);
+}
+
+StackingActionMessenger::~StackingActionMessenger()
+{
+    delete fListStackRulesCmd;
+    delete fClearStackRulesCmd;
+    delete fCameraPriorityCmd;
+    delete fKillBelowCmd;
+    delete fKillInVolumeCmd;
+    delete fKillParticleCmd;
+    delete fStackDir;
+}
+
+void StackingActionMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+    if(command==fKillParticleCmd)
+        StackingAction::KillParticle(newValue);
+    else if(command==fKillInVolumeCmd)
+    {
+        std::istringstream iss(newValue);
+        G4String particle, volume;
+        iss >> particle >> volume;
+        StackingAction::KillInVolume(particle, volume);
+    }
+    else if(command==fKillBelowCmd)
+    {
+        std::istringstream iss(newValue);
+        G4String particle, unit;
+        G4double energy;
+        iss >> particle >> energy >> unit;
+        StackingAction::KillBelow(particle, energy*G4UIcommand::ValueOf(unit));
+    }
+    else if(command==fCameraPriorityCmd)
+        StackingAction::SetCameraPriority(fCameraPriorityCmd->GetNewBoolValue(newValue));
+    else if(command==fClearStackRulesCmd)
+        StackingAction::ClearRules();
+    else if(command==fListStackRulesCmd)
+        StackingAction::PrintRules(G4cout);
+}
@@ -0,0 +1,46 @@
+#include "StartupTimer.hh"
+
+#include <iomanip>
+
+namespace
+{
+    G4double Seconds(std::chrono::steady_clock::duration duration)
+    {
+        return std::chrono::duration<G4double>(duration).count();
+    }
+}
+
+StartupTimer* StartupTimer::GetInstance()
+{
+    static StartupTimer fInstance;
+    return &fInstance;
+}
+
+StartupTimer::StartupTimer()
+: fStartTime(std::chrono::steady_clock::now()), fLastMarkTime(fStartTime), fFirstEventDone(false)
+{}
+
+void StartupTimer::Mark(const G4String& phase)
+{
+    auto now = std::chrono::steady_clock::now();
+    fPhases.emplace_back(phase, Seconds(now - fLastMarkTime));
+    fLastMarkTime = now;
+    // Only events after the last mark count as the first one
+    fFirstEventDone = false;
+}
+
+void StartupTimer::Print(std::ostream& out) const
+{
+    out << "Startup time (s):" << G4endl;
+    auto precision = out.precision(3);
+    auto flags = out.setf(std::ios::fixed, std::ios::floatfield);
+    for(const auto& phase: fPhases)
+        out << "  " << std::left << std::setw(16) << phase.first << std::right << phase.second << G4endl;
+    if(fFirstEventDone)
+        out << "  " << std::left << std::setw(16) << "first event" << std::right
+            << Seconds(fFirstEventTime - fLastMarkTime) << G4endl;
+    out << "  " << std::left << std::setw(16) << "total" << std::right
+        << Seconds(std::chrono::steady_clock::now() - fStartTime) << G4endl;
+    out.precision(precision);
+    out.flags(flags);
+}
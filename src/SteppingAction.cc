@@ -0,0 +1,8 @@
+#include "SteppingAction.hh"
+
+SteppingAction::SteppingAction()
+: G4UserSteppingAction()
+{}
+
+SteppingAction::~SteppingAction()
+{}
@@ -0,0 +1,338 @@
+#include "SymmetryFolding.hh"
+#include "SymmetryFoldingMessenger.hh"
+#include "CCSensitiveDetector.hh"
+#include "NextEventEstimator.hh"
+#include "PileUpStream.hh"
+#include "Run.hh"
+#include "SpentFuelAssemblyBuilder.hh"
+#include "SystemMatrix.hh"
+
+#include "G4Box.hh"
+#include "G4Navigator.hh"
+#include "G4PhysicalVolumeStore.hh"
+#include "G4RunManager.hh"
+#include "G4TouchableHistory.hh"
+#include "G4TransportationManager.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <sstream>
+
+namespace
+{
+    const G4double kTolerance = 1.e-3*mm;
+    const G4int kNProbes = 4096; // per region and operation
+
+    // Operations of the square
+    const SymmetryFolding::Operation kOperations[] = {
+        {"identity", 1, 0, 0, 1}, {"rot90", 0, -1, 1, 0}, {"rot180", -1, 0, 0, -1}, {"rot270", 0, 1, -1, 0},
+        {"mirrorX", -1, 0, 0, 1}, {"mirrorY", 1, 0, 0, -1}, {"diagonal", 0, 1, 1, 0}, {"antidiagonal", 0, -1, -1, 0}};
+
+    G4String Format(const G4ThreeVector& position)
+    {
+        std::ostringstream oss;
+        oss << "(" << position.x()/mm << ", " << position.y()/mm << ", " << position.z()/mm << ") mm";
+        return oss.str();
+    }
+
+    // Axis-aligned extent of a solid placed with the given transformation
+    void ExtendRegion(const G4VSolid* solid, const G4RotationMatrix& rotation, const G4ThreeVector& translation,
+                      G4ThreeVector& regionMin, G4ThreeVector& regionMax)
+    {
+        G4ThreeVector pMin, pMax;
+        solid->BoundingLimits(pMin, pMax);
+        for(G4int corner = 0; corner<8; ++corner)
+        {
+            auto point = translation + rotation*G4ThreeVector((corner & 1) ? pMax.x() : pMin.x(),
+                                                              (corner & 2) ? pMax.y() : pMin.y(),
+                                                              (corner & 4) ? pMax.z() : pMin.z());
+            regionMin.set(std::min(regionMin.x(), point.x()), std::min(regionMin.y(), point.y()), std::min(regionMin.z(), point.z()));
+            regionMax.set(std::max(regionMax.x(), point.x()), std::max(regionMax.y(), point.y()), std::max(regionMax.z(), point.z()));
+        }
+    }
+}
+
+G4ThreadLocal SymmetryFolding::ThreadState* SymmetryFolding::fThreadState = nullptr;
+
+SymmetryFolding* SymmetryFolding::GetInstance()
+{
+    static SymmetryFolding fInstance;
+    return &fInstance;
+}
+
+SymmetryFolding::SymmetryFolding()
+: fEnabled(false), fActive(false)
+{
+    fMessenger = std::make_unique<SymmetryFoldingMessenger>(this);
+}
+
+SymmetryFolding::~SymmetryFolding()
+{}
+
+void SymmetryFolding::BeginRun()
+{
+    fActive = false;
+    if(!fEnabled) return;
+    fActive = Check(G4cout);
+    if(!fActive)
+        G4Exception("SymmetryFolding::BeginRun()", "", JustWarning,
+                    "    The symmetry preconditions do not hold; this run is not folded.");
+}
+
+G4String SymmetryFolding::CheckSetup() const
+{
+    if(Run::GetBasisMode()) return "basis mode (per-rod tallies)";
+    if(SystemMatrix::GetInstance()->IsActive()) return "matrix sweep (per-point rows)";
+    if(PileUpStream::IsEnabled()) return "pile-up (one arrival per history)";
+    if(CCSensitiveDetector::GetMaxInteractionsPerDetector()>0) return "interaction mode";
+    if(CCSensitiveDetector::GetLightModelEnabled()) return "light model (per-detector light tables)";
+    if(NextEventEstimator::GetInstance()->IsEnabled()) return "next-event estimator (scores not replicated)";
+
+    auto spentFuelAssemblyStore = SpentFuelAssemblyStore::GetInstance();
+    if(spentFuelAssemblyStore->empty()) return "no assembly";
+    const auto& front = spentFuelAssemblyStore->front();
+    for(const auto& assembly: *spentFuelAssemblyStore)
+    {
+        if(assembly->GetNX()!=front->GetNX() || assembly->GetNY()!=front->GetNY())
+            return "assemblies of different lattices";
+        auto centre = assembly->LocalToGlobal(G4ThreeVector());
+        if((assembly->LocalToGlobal(G4ThreeVector(1., 0., 0.)) - centre - G4ThreeVector(1., 0., 0.)).mag()>1.e-9 ||
+           (assembly->LocalToGlobal(G4ThreeVector(0., 1., 0.)) - centre - G4ThreeVector(0., 1., 0.)).mag()>1.e-9)
+            return "rotated assembly " + assembly->GetName();
+    }
+    return G4String();
+}
+
+G4bool SymmetryFolding::Check(std::ostream& out)
+{
+    fOperations.clear();
+    fRodImages.clear();
+    auto reason = CheckSetup();
+    if(!reason.empty())
+    {
+        out << "Symmetry folding: not possible with " << reason << G4endl;
+        return false;
+    }
+
+    // Axis: vertical, through the centre of the assemblies
+    auto spentFuelAssemblyStore = SpentFuelAssemblyStore::GetInstance();
+    fAxis = G4ThreeVector();
+    for(const auto& assembly: *spentFuelAssemblyStore) fAxis += assembly->LocalToGlobal(G4ThreeVector());
+    fAxis /= static_cast<G4double>(spentFuelAssemblyStore->size());
+    fAxis.setZ(0.);
+
+    // Rods a source can start in; a homogenized assembly samples all its cells
+    G4int nRods = spentFuelAssemblyStore->front()->GetNX()*spentFuelAssemblyStore->front()->GetNY();
+    fActiveRods.assign(static_cast<std::size_t>(spentFuelAssemblyStore->GetNFuelRods()), false);
+    for(std::size_t i = 0; i<spentFuelAssemblyStore->size(); ++i)
+    {
+        const auto& assembly = spentFuelAssemblyStore->at(i);
+        auto first = fActiveRods.begin() + nRods*static_cast<G4int>(i);
+        if(assembly->IsHomogenized()) std::fill(first, first + nRods, true);
+        else for(auto rod: assembly->GetActiveFuelRodIDs()) first[rod] = true;
+    }
+
+    G4Navigator navigator;
+    navigator.SetWorldVolume(G4TransportationManager::GetTransportationManager()->GetNavigatorForTracking()->GetWorldVolume());
+    out << "Symmetry folding about the axis x = " << fAxis.x()/mm << " mm, y = " << fAxis.y()/mm << " mm:\n";
+    for(const auto& operation: kOperations)
+    {
+        std::vector<G4int> rodImages;
+        reason = CheckOperation(operation, navigator, rodImages);
+        if(!reason.empty())
+        {
+            out << "  " << operation.name << " rejected: " << reason << "\n";
+            continue;
+        }
+        fOperations.push_back(operation);
+        fRodImages.push_back(rodImages);
+    }
+    PrintOperations(out);
+    out << G4endl;
+    return fOperations.size()>1;
+}
+
+G4String SymmetryFolding::CheckOperation(const Operation& operation, G4Navigator& navigator,
+                                         std::vector<G4int>& rodImages) const
+{
+    std::ostringstream reason;
+
+    // Source: rods onto rods of the same status, assemblies onto assemblies
+    // of the same total activity
+    auto spentFuelAssemblyStore = SpentFuelAssemblyStore::GetInstance();
+    G4int nRods = spentFuelAssemblyStore->front()->GetNX()*spentFuelAssemblyStore->front()->GetNY();
+    rodImages.assign(fActiveRods.size(), -1);
+    for(G4int rod = 0; rod<static_cast<G4int>(rodImages.size()); ++rod)
+    {
+        auto position = spentFuelAssemblyStore->GetFuelRodPosition(rod);
+        G4int image = FindFuelRod(Apply(operation, position));
+        if(image<0)
+        {
+            reason << "fuel rod " << rod << " at " << Format(position) << " has no image rod";
+            return reason.str();
+        }
+        auto assemblyID = static_cast<std::size_t>(rod/nRods), imageAssemblyID = static_cast<std::size_t>(image/nRods);
+        G4double activity = spentFuelAssemblyStore->GetAssemblyActivity(assemblyID)
+                            *spentFuelAssemblyStore->at(assemblyID)->GetNActiveFuelRods();
+        G4double imageActivity = spentFuelAssemblyStore->GetAssemblyActivity(imageAssemblyID)
+                                 *spentFuelAssemblyStore->at(imageAssemblyID)->GetNActiveFuelRods();
+        if(std::abs(activity - imageActivity)>1.e-9*std::max(activity, imageActivity))
+        {
+            reason << "assembly " << assemblyID << " maps onto assembly " << imageAssemblyID << " of another activity";
+            return reason.str();
+        }
+        if(fActiveRods[static_cast<std::size_t>(rod)]!=fActiveRods[static_cast<std::size_t>(image)])
+        {
+            reason << "the rod status is not symmetric (rod " << rod << " maps onto rod " << image << ")";
+            return reason.str();
+        }
+        rodImages[static_cast<std::size_t>(rod)] = image;
+    }
+
+    // Cameras onto themselves
+    const G4double huge = std::numeric_limits<G4double>::max();
+    std::vector< std::pair<G4ThreeVector, G4ThreeVector> > regions;
+    for(auto volume: *G4PhysicalVolumeStore::GetInstance())
+    {
+        if(volume->GetName()!="ComptonCamera") continue;
+        G4ThreeVector pMin, pMax;
+        volume->GetLogicalVolume()->GetSolid()->BoundingLimits(pMin, pMax);
+        auto rotation = volume->GetObjectRotationValue();
+        auto centre = volume->GetObjectTranslation() + rotation*(0.5*(pMin + pMax));
+        if((Apply(operation, centre) - centre).mag()>kTolerance)
+        {
+            reason << "camera " << volume->GetCopyNo() << " at " << Format(centre) << " does not map onto itself";
+            return reason.str();
+        }
+        regions.emplace_back(G4ThreeVector(huge, huge, huge), -G4ThreeVector(huge, huge, huge));
+        ExtendRegion(volume->GetLogicalVolume()->GetSolid(), rotation, volume->GetObjectTranslation(),
+                     regions.back().first, regions.back().second);
+    }
+    regions.emplace_back(G4ThreeVector(huge, huge, huge), -G4ThreeVector(huge, huge, huge));
+    for(const auto& assembly: *spentFuelAssemblyStore)
+        ExtendRegion(assembly->GetLogicalVolume()->GetSolid(), G4RotationMatrix(), assembly->LocalToGlobal(G4ThreeVector()),
+                     regions.back().first, regions.back().second);
+
+    // Volumes around the cameras and the assemblies, at probe points (fixed
+    // sequence, the event random engine is left alone)
+    std::mt19937_64 engine(20240611);
+    std::uniform_real_distribution<G4double> uniform(0., 1.);
+    for(const auto& region: regions)
+    {
+        auto size = region.second - region.first;
+        for(G4int i = 0; i<kNProbes; ++i)
+        {
+            G4ThreeVector point(region.first.x() + uniform(engine)*size.x(), region.first.y() + uniform(engine)*size.y(),
+                                region.first.z() + uniform(engine)*size.z());
+            auto volume = navigator.LocateGlobalPointAndSetup(point, nullptr, false, true);
+            auto imageVolume = navigator.LocateGlobalPointAndSetup(Apply(operation, point), nullptr, false, true);
+            auto logicalVolume = volume ? volume->GetLogicalVolume() : nullptr;
+            auto imageLogicalVolume = imageVolume ? imageVolume->GetLogicalVolume() : nullptr;
+            if(logicalVolume==imageLogicalVolume) continue;
+            reason << (logicalVolume ? logicalVolume->GetName() : G4String("outside")) << " at " << Format(point)
+                   << " maps onto " << (imageLogicalVolume ? imageLogicalVolume->GetName() : G4String("outside"));
+            return reason.str();
+        }
+    }
+    return G4String();
+}
+
+G4int SymmetryFolding::FindFuelRod(const G4ThreeVector& position) const
+{
+    auto spentFuelAssemblyStore = SpentFuelAssemblyStore::GetInstance();
+    for(std::size_t i = 0; i<spentFuelAssemblyStore->size(); ++i)
+    {
+        const auto& assembly = spentFuelAssemblyStore->at(i);
+        auto box = static_cast<const G4Box*>(assembly->GetLogicalVolume()->GetSolid());
+        auto localPos = position - assembly->LocalToGlobal(G4ThreeVector());
+        if(std::abs(localPos.x())>box->GetXHalfLength() + kTolerance ||
+           std::abs(localPos.y())>box->GetYHalfLength() + kTolerance) continue;
+        G4int cell = assembly->GetLatticeCell(localPos);
+        if((assembly->GetFuelRodLocation(cell) - localPos).perp()>kTolerance) return -1;
+        return cell + assembly->GetNX()*assembly->GetNY()*static_cast<G4int>(i);
+    }
+    return -1;
+}
+
+void SymmetryFolding::PrintOperations(std::ostream& out) const
+{
+    out << "  operations:";
+    for(const auto& operation: fOperations) out << " " << operation.name;
+    if(fOperations.size()<=1) out << " (no folding)";
+}
+
+G4ThreeVector SymmetryFolding::Fold(const G4ThreeVector& position, G4int& fuelRodID) const
+{
+    if(!fActive) return position;
+
+    // Fundamental domain: the lowest rod ID of each orbit
+    std::size_t best = 0;
+    auto rod = static_cast<std::size_t>(fuelRodID);
+    for(std::size_t k = 1; k<fOperations.size(); ++k)
+        if(fRodImages[k][rod]<fRodImages[best][rod]) best = k;
+    fuelRodID = fRodImages[best][rod];
+    return Apply(fOperations[best], position);
+}
+
+const std::vector< std::unique_ptr<CCHitsMap> >& SymmetryFolding::Replicate(const CCHitsMap* hitsMap,
+                                                                              const CCSensitiveDetector* sd)
+{
+    if(!fThreadState) fThreadState = new ThreadState();
+    auto& state = *fThreadState;
+    G4int runID = G4RunManager::GetRunManager()->GetCurrentRun()->GetRunID();
+    if(state.runID!=runID)
+    {
+        // The geometry may have been rebuilt since the last run
+        state.runID = runID;
+        if(!state.navigator) state.navigator = std::make_unique<G4Navigator>();
+        state.navigator->SetWorldVolume(
+                    G4TransportationManager::GetTransportationManager()->GetNavigatorForTracking()->GetWorldVolume());
+        state.detectorImages.clear();
+    }
+
+    while(state.replicas.size()<fOperations.size())
+        state.replicas.push_back(std::make_unique<CCHitsMap>("SymmetryFolding", "CCData"));
+    G4double weightFactor = GetWeightFactor();
+    for(std::size_t k = 0; k<fOperations.size(); ++k)
+    {
+        auto& replica = *state.replicas[k];
+        replica.clear();
+        for(const auto& itr: *hitsMap)
+        {
+            const auto hit = itr.second;
+            G4int detID = (k==0) ? itr.first : GetDetectorImage(state, sd, k, itr.first, hit->GetPosition());
+            auto image = new CCHit(hit->GetDepE(), Apply(fOperations[k], hit->GetPosition()), hit->GetTime(),
+                                   hit->GetWeight()*weightFactor);
+            replica.add(detID, image);
+        }
+    }
+    state.replicas.resize(fOperations.size());
+    return state.replicas;
+}
+
+G4int SymmetryFolding::GetDetectorImage(ThreadState& state, const CCSensitiveDetector* sd, std::size_t k,
+                                        G4int detID, const G4ThreeVector& position) const
+{
+    auto key = std::make_tuple(sd, k, detID);
+    auto found = state.detectorImages.find(key);
+    if(found!=state.detectorImages.end()) return found->second;
+
+    // The detector centre is mapped rather than the hit, which may lie on a
+    // boundary; only IDs found this way are kept
+    auto& navigator = *state.navigator;
+    auto InDetector = [sd](const G4VPhysicalVolume* volume)
+    { return volume && volume->GetLogicalVolume()->GetSensitiveDetector()==sd; };
+    auto volume = navigator.LocateGlobalPointAndSetup(position, nullptr, false, true);
+    std::unique_ptr<G4TouchableHistory> touchable(navigator.CreateTouchableHistory());
+    G4bool centred = InDetector(volume) && sd->GetDetectorID(touchable.get())==detID;
+    auto point = centred ? touchable->GetTranslation() : position;
+
+    auto imageVolume = navigator.LocateGlobalPointAndSetup(Apply(fOperations[k], point), nullptr, false, true);
+    if(!InDetector(imageVolume)) return detID;
+    touchable.reset(navigator.CreateTouchableHistory());
+    G4int imageID = sd->GetDetectorID(touchable.get());
+    if(centred) state.detectorImages[key] = imageID;
+    return imageID;
+}
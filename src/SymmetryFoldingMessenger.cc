@@ -0,0 +1,44 @@
+#include "SymmetryFoldingMessenger.hh"
+#include "SymmetryFolding.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithABool.hh"
+#include "G4UIcmdWithoutParameter.hh"
+
+SymmetryFoldingMessenger::SymmetryFoldingMessenger(SymmetryFolding* symmetryFolding)
+: G4UImessenger(), fSymmetryFolding(symmetryFolding)
+{
+    fFoldDir = new G4UIdirectory("/ccTest/fold/");
+    fFoldDir->SetGuidance("Lattice-symmetry folding: sources in the fundamental domain of the symmetry");
+    fFoldDir->SetGuidance("group of the square that the placements allow, hits replicated under the");
+    fFoldDir->SetGuidance("group with 1/(order) of the weight each.");
+
+    fFoldEnableCmd = new G4UIcmdWithABool("/ccTest/fold/enable", this);
+    fFoldEnableCmd->SetGuidance("Fold the next runs; the preconditions are checked at the beginning of");
+    fFoldEnableCmd->SetGuidance("each run, which is not folded if they do not hold.");
+    fFoldEnableCmd->SetParameterName("enable", true);
+    fFoldEnableCmd->SetDefaultValue(true);
+    fFoldEnableCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fFoldEnableCmd->SetToBeBroadcasted(false);
+
+    fFoldCheckCmd = new G4UIcmdWithoutParameter("/ccTest/fold/check", this);
+    fFoldCheckCmd->SetGuidance("Print the symmetry operations the current geometry and source allow,");
+    fFoldCheckCmd->SetGuidance("and why the others are rejected.");
+    fFoldCheckCmd->AvailableForStates(G4State_Idle);
+    fFoldCheckCmd->SetToBeBroadcasted(false);
+}
+
+SymmetryFoldingMessenger::~SymmetryFoldingMessenger()
+{
+    delete fFoldCheckCmd;
+    delete fFoldEnableCmd;
+    delete fFoldDir;
+}
+
+void SymmetryFoldingMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+    if(command==fFoldEnableCmd)
+        fSymmetryFolding->SetEnabled(fFoldEnableCmd->GetNewBoolValue(newValue));
+    else if(command==fFoldCheckCmd)
+        fSymmetryFolding->Check(G4cout);
+}
@@ -0,0 +1,369 @@
+#include "SystemMatrix.hh"
+#include "SystemMatrixMessenger.hh"
+#include "DetectorConstruction.hh"
+#include "EventAction.hh"
+#include "Run.hh"
+#include "SpentFuelAssemblyBuilder.hh"
+
+#include "G4AutoLock.hh"
+#include "G4LogicalVolume.hh"
+#include "G4RunManager.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4Tubs.hh"
+#include "G4UIcommand.hh"
+#include "G4UImanager.hh"
+#include "Randomize.hh"
+#ifdef G4MULTITHREADED
+#include "G4MTRunManager.hh"
+#endif
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <filesystem>
+#include <sstream>
+
+namespace
+{
+    const char kMagic[4] = {'C', 'C', 'S', 'M'};
+    const std::int32_t kVersion = 1;
+    const std::int32_t kFooterID = -1;
+    // Index and probability of a non-zero element
+    const std::int64_t kElementSize = sizeof(std::uint64_t) + sizeof(float);
+
+    template<class T>
+    void WriteValue(std::ostream& out, T value)
+    {
+        out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    template<class T>
+    T ReadValue(std::istream& in)
+    {
+        T value = T();
+        in.read(reinterpret_cast<char*>(&value), sizeof(value));
+        return value;
+    }
+
+    // Bin of x in [-halfWidth, halfWidth), -1 outside
+    G4int PositionBin(G4double x, G4int nBins, G4double halfWidth)
+    {
+        G4double bin = std::floor((x + halfWidth)/(2.*halfWidth)*nBins);
+        return (bin<0. || bin>=nBins) ? -1 : static_cast<G4int>(bin);
+    }
+}
+
+G4ThreadLocal SystemMatrix::Row* SystemMatrix::fThreadRow = nullptr;
+
+SystemMatrix* SystemMatrix::GetInstance()
+{
+    static SystemMatrix fInstance;
+    return &fInstance;
+}
+
+SystemMatrix::SystemMatrix()
+: fPointsMode(kRods), fNVoxelsX(16), fNVoxelsY(16), fVoxelHalfWidth(10.*cm),
+  fNPositionBins(16), fPositionHalfWidth(10.*cm), fNEnergyBins(32), fMaxEnergy(2.*MeV),
+  fActive(false), fEventsPerPoint(1), fVoxelZMin(0.), fVoxelZMax(0.), fNRowsWritten(0)
+{
+    fMessenger = std::make_unique<SystemMatrixMessenger>(this);
+}
+
+SystemMatrix::~SystemMatrix()
+{}
+
+void SystemMatrix::Sweep(G4int eventsPerPoint)
+{
+    if(::Run::GetBasisMode())
+    {
+        G4Exception("SystemMatrix::Sweep()", "", JustWarning,
+                    "    The basis mode samples its own source points; disable it for a matrix sweep.");
+        return;
+    }
+
+    auto detector = static_cast<const DetectorConstruction*>(
+                G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+    G4String fileName = fFileName.empty()
+            ? EventAction::GetOutputFileName("matrix", detector->GetOutputTag(), ".dat") : fFileName;
+    fEventsPerPoint = eventsPerPoint;
+    BuildPoints();
+    std::string header = BuildHeader(detector->GetConfiguration());
+
+    fIndex.clear();
+    fPending.clear();
+    fOut.close();
+    std::ifstream in(fileName, std::ios::binary);
+    G4bool resumed = in.is_open();
+    in.close();
+    if(resumed && !Resume(fileName, header)) return;
+    if(!resumed)
+    {
+        fOut.open(fileName, std::ios::binary | std::ios::trunc);
+        fOut.write(header.data(), static_cast<std::streamsize>(header.size()));
+    }
+    if(resumed)
+        G4cout << "System matrix " << fileName << ": " << fIndex.size() << " of " << fPoints.size()
+               << " points already done" << G4endl;
+
+    fRemainingPoints.clear();
+    for(G4int pointID = 0; pointID<static_cast<G4int>(fPoints.size()); ++pointID)
+        if(!fIndex.count(pointID)) fRemainingPoints.push_back(pointID);
+    G4long nEvents = static_cast<G4long>(fRemainingPoints.size())*eventsPerPoint;
+    if(nEvents>INT_MAX)
+    {
+        G4Exception("SystemMatrix::Sweep()", "", JustWarning,
+                    G4String("    " + G4UIcommand::ConvertToString(nEvents)
+                             + " events exceed a single run; use fewer events per point.").c_str());
+        fOut.close();
+        return;
+    }
+
+    if(nEvents>0)
+    {
+        // Whole points per request of a worker
+#ifdef G4MULTITHREADED
+        auto mtRunManager = G4MTRunManager::GetMasterRunManager();
+        G4int eventModulo = mtRunManager ? mtRunManager->GetEventModulo() : 0;
+        if(mtRunManager) mtRunManager->SetEventModulo(eventsPerPoint);
+#endif
+        fActive = true;
+        fNRowsWritten = 0;
+        fStartTime = fLastReport = std::chrono::steady_clock::now();
+        G4UImanager::GetUIpointer()->ApplyCommand("/run/beamOn " + G4UIcommand::ConvertToString(static_cast<G4int>(nEvents)));
+        fActive = false;
+#ifdef G4MULTITHREADED
+        if(mtRunManager) mtRunManager->SetEventModulo(eventModulo);
+#endif
+        PrintProgress(G4cout, true);
+    }
+
+    if(fIndex.size()==fPoints.size() && fOut.is_open())
+    {
+        WriteFooter();
+        G4cout << "System matrix of " << fPoints.size() << " points written to " << fileName << G4endl;
+    }
+    else if(fIndex.size()<fPoints.size())
+        G4cout << "System matrix incomplete (" << fIndex.size() << " of " << fPoints.size()
+               << " points); sweep again to resume." << G4endl;
+    fOut.close();
+    fPending.clear();
+}
+
+void SystemMatrix::BuildPoints()
+{
+    auto store = SpentFuelAssemblyStore::GetInstance();
+    G4int nFuelRods = store->GetNFuelRods();
+    fPoints.clear();
+    if(fPointsMode==kRods)
+    {
+        for(G4int fuelRodID = 0; fuelRodID<nFuelRods; ++fuelRodID)
+            fPoints.push_back(store->GetFuelRodPosition(fuelRodID));
+        return;
+    }
+
+    // Voxels: centred on the mean rod position, over the height of the rods
+    G4ThreeVector centre;
+    for(G4int fuelRodID = 0; fuelRodID<nFuelRods; ++fuelRodID) centre += store->GetFuelRodPosition(fuelRodID);
+    centre /= std::max(nFuelRods, 1);
+    G4double fuelRodHalfHeight =
+            static_cast<G4Tubs*>(store->front()->GetFuelRod()->GetLogicalVolume()->GetSolid())->GetZHalfLength();
+    fVoxelZMin = centre.z() - fuelRodHalfHeight;
+    fVoxelZMax = centre.z() + fuelRodHalfHeight;
+
+    G4double dx = 2.*fVoxelHalfWidth/fNVoxelsX, dy = 2.*fVoxelHalfWidth/fNVoxelsY;
+    for(G4int ix = 0; ix<fNVoxelsX; ++ix)
+        for(G4int iy = 0; iy<fNVoxelsY; ++iy)
+            fPoints.emplace_back(centre.x() - fVoxelHalfWidth + (ix + 0.5)*dx,
+                                 centre.y() - fVoxelHalfWidth + (iy + 0.5)*dy, centre.z());
+}
+
+std::string SystemMatrix::BuildHeader(const G4String& configuration) const
+{
+    std::ostringstream out;
+    out.write(kMagic, sizeof(kMagic));
+    WriteValue<std::int32_t>(out, kVersion);
+    WriteValue<std::int32_t>(out, fPointsMode);
+    WriteValue<std::int32_t>(out, static_cast<std::int32_t>(fPoints.size()));
+    WriteValue<std::int64_t>(out, fEventsPerPoint);
+    WriteValue<std::int32_t>(out, fNPositionBins);
+    WriteValue<G4double>(out, fPositionHalfWidth/mm);
+    WriteValue<std::int32_t>(out, fNEnergyBins);
+    WriteValue<G4double>(out, fMaxEnergy/MeV);
+    WriteValue<std::int64_t>(out, static_cast<std::int64_t>(configuration.size()));
+    out.write(configuration.data(), static_cast<std::streamsize>(configuration.size()));
+    for(const auto& point: fPoints)
+    {
+        WriteValue<G4double>(out, point.x()/mm);
+        WriteValue<G4double>(out, point.y()/mm);
+        WriteValue<G4double>(out, point.z()/mm);
+    }
+    return out.str();
+}
+
+G4bool SystemMatrix::Resume(const G4String& fileName, const std::string& header)
+{
+    std::error_code error;
+    auto fileSize = static_cast<std::int64_t>(std::filesystem::file_size(std::string(fileName), error));
+    std::ifstream in(fileName, std::ios::binary);
+    std::string fileHeader(header.size(), '\0');
+    if(error || !in.read(&fileHeader[0], static_cast<std::streamsize>(header.size())) || fileHeader!=header)
+    {
+        G4Exception("SystemMatrix::Resume()", "", JustWarning,
+                    G4String("    '" + fileName + "' was written with another configuration, points or binning;\n"
+                             "    remove it or set another /ccTest/matrix/file.").c_str());
+        return false;
+    }
+
+    // Complete rows, up to a partly written one or the footer
+    auto end = static_cast<std::int64_t>(header.size());
+    G4bool footer = false;
+    while(end<fileSize)
+    {
+        in.seekg(end);
+        auto pointID = ReadValue<std::int32_t>(in);
+        if(in && pointID==kFooterID) { footer = true; break; }
+        ReadValue<std::int64_t>(in);
+        auto nnz = ReadValue<std::int64_t>(in);
+        auto rowEnd = static_cast<std::int64_t>(in.tellg()) + nnz*kElementSize;
+        if(!in || pointID<0 || pointID>=static_cast<G4int>(fPoints.size()) || nnz<0 || rowEnd>fileSize) break;
+        fIndex[pointID] = end;
+        end = rowEnd;
+    }
+    in.close();
+    if(footer) return true;
+
+    std::filesystem::resize_file(std::string(fileName), static_cast<std::uintmax_t>(end), error);
+    if(!error) fOut.open(fileName, std::ios::binary | std::ios::app);
+    if(error || !fOut.is_open())
+    {
+        G4Exception("SystemMatrix::Resume()", "", JustWarning,
+                    G4String("    Cannot append to '" + fileName + "'.").c_str());
+        return false;
+    }
+    return true;
+}
+
+G4ThreeVector SystemMatrix::SamplePoint(G4int pointID) const
+{
+    if(fPointsMode==kRods) return SpentFuelAssemblyStore::GetInstance()->SamplePointInFuelRod(pointID);
+
+    const auto& centre = fPoints[static_cast<std::size_t>(pointID)];
+    G4double dx = 2.*fVoxelHalfWidth/fNVoxelsX, dy = 2.*fVoxelHalfWidth/fNVoxelsY;
+    return G4ThreeVector(centre.x() + (G4UniformRand() - 0.5)*dx, centre.y() + (G4UniformRand() - 0.5)*dy,
+                         fVoxelZMin + G4UniformRand()*(fVoxelZMax - fVoxelZMin));
+}
+
+void SystemMatrix::RecordEvent(G4int pointID, const CCHitsMap* hitsMap, G4double eventWeight)
+{
+    if(!fThreadRow) fThreadRow = new Row{pointID, 0, {}};
+    else if(fThreadRow->pointID!=pointID)
+    {
+        if(fThreadRow->nEvents>0) Deposit(*fThreadRow);
+        fThreadRow->pointID = pointID;
+        fThreadRow->nEvents = 0;
+        fThreadRow->weights.clear();
+    }
+    ++fThreadRow->nEvents;
+    if(!hitsMap || hitsMap->entries()<2) return;
+
+    // The source is above the camera: scatter hit = max z, absorber hit = min z
+    const CCHit* scatterHit = nullptr;
+    const CCHit* absorberHit = nullptr;
+    for(const auto& itr: *hitsMap)
+    {
+        const auto hit = itr.second;
+        if(!scatterHit || hit->GetPosition().z()>scatterHit->GetPosition().z()) scatterHit = hit;
+        if(!absorberHit || hit->GetPosition().z()<absorberHit->GetPosition().z()) absorberHit = hit;
+    }
+
+    G4int bins[4] = {PositionBin(scatterHit->GetPosition().x(), fNPositionBins, fPositionHalfWidth),
+                     PositionBin(scatterHit->GetPosition().y(), fNPositionBins, fPositionHalfWidth),
+                     PositionBin(absorberHit->GetPosition().x(), fNPositionBins, fPositionHalfWidth),
+                     PositionBin(absorberHit->GetPosition().y(), fNPositionBins, fPositionHalfWidth)};
+    G4double energyBin = std::floor(scatterHit->GetDepE()/fMaxEnergy*fNEnergyBins);
+    if(energyBin<0. || energyBin>=fNEnergyBins) return;
+    std::uint64_t index = 0;
+    for(auto bin: bins)
+    {
+        if(bin<0) return;
+        index = index*static_cast<std::uint64_t>(fNPositionBins) + static_cast<std::uint64_t>(bin);
+    }
+    index = index*static_cast<std::uint64_t>(fNEnergyBins) + static_cast<std::uint64_t>(energyBin);
+    fThreadRow->weights[index] += eventWeight;
+}
+
+void SystemMatrix::EndThreadRun()
+{
+    if(!fThreadRow) return;
+    if(fThreadRow->nEvents>0) Deposit(*fThreadRow);
+    delete fThreadRow;
+    fThreadRow = nullptr;
+}
+
+void SystemMatrix::Deposit(Row& row)
+{
+    G4AutoLock lock(&fMutex);
+    // A point processed by a single thread is written directly
+    auto itr = fPending.find(row.pointID);
+    if(itr==fPending.end() && row.nEvents>=fEventsPerPoint) WriteRow(row);
+    else
+    {
+        if(itr==fPending.end()) itr = fPending.emplace(row.pointID, Row{row.pointID, 0, {}}).first;
+        auto& pending = itr->second;
+        pending.nEvents += row.nEvents;
+        for(const auto& element: row.weights) pending.weights[element.first] += element.second;
+        if(pending.nEvents<fEventsPerPoint) return;
+        WriteRow(pending);
+        fPending.erase(itr);
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    if(now - fLastReport>=std::chrono::seconds(10))
+    {
+        fLastReport = now;
+        PrintProgress(G4cout, false);
+    }
+}
+
+void SystemMatrix::WriteRow(const Row& row)
+{
+    std::vector<std::pair<std::uint64_t, G4double>> elements(row.weights.begin(), row.weights.end());
+    std::sort(elements.begin(), elements.end());
+
+    fIndex[row.pointID] = static_cast<std::int64_t>(fOut.tellp());
+    WriteValue<std::int32_t>(fOut, row.pointID);
+    WriteValue<std::int64_t>(fOut, row.nEvents);
+    WriteValue<std::int64_t>(fOut, static_cast<std::int64_t>(elements.size()));
+    for(const auto& element: elements)
+    {
+        WriteValue<std::uint64_t>(fOut, element.first);
+        WriteValue<float>(fOut, static_cast<float>(element.second/row.nEvents));
+    }
+    // Complete rows survive an interruption
+    fOut.flush();
+    ++fNRowsWritten;
+}
+
+void SystemMatrix::WriteFooter()
+{
+    WriteValue<std::int32_t>(fOut, kFooterID);
+    WriteValue<std::int64_t>(fOut, static_cast<std::int64_t>(fIndex.size()));
+    for(const auto& entry: fIndex)
+    {
+        WriteValue<std::int32_t>(fOut, entry.first);
+        WriteValue<std::int64_t>(fOut, entry.second);
+    }
+    fOut.flush();
+}
+
+void SystemMatrix::PrintProgress(std::ostream& out, G4bool summary)
+{
+    G4double seconds = std::chrono::duration<G4double>(std::chrono::steady_clock::now() - fStartTime).count();
+    G4double pointsPerSecond = seconds>0. ? fNRowsWritten/seconds : 0.;
+    auto nRemaining = static_cast<G4double>(fPoints.size() - fIndex.size());
+    out << (summary ? "System matrix sweep: " : "System matrix: ") << fIndex.size() << " of " << fPoints.size()
+        << " points, " << pointsPerSecond << " points/s, " << pointsPerSecond*fEventsPerPoint << " events/s";
+    if(summary) out << ", " << fNRowsWritten << " points in " << seconds << " s";
+    else if(pointsPerSecond>0.) out << ", ETA " << nRemaining/pointsPerSecond << " s";
+    out << G4endl;
+}
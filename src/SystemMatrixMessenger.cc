@@ -0,0 +1,127 @@
+#include "SystemMatrixMessenger.hh"
+#include "SystemMatrix.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcommand.hh"
+#include "G4UIparameter.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithAnInteger.hh"
+
+#include <sstream>
+
+SystemMatrixMessenger::SystemMatrixMessenger(SystemMatrix* systemMatrix)
+: G4UImessenger(), fSystemMatrix(systemMatrix)
+{
+    fMatrixDir = new G4UIdirectory("/ccTest/matrix/");
+    fMatrixDir->SetGuidance("System response matrix of the camera: coincidence response per source point,");
+    fMatrixDir->SetGuidance("binned as (scatter x, y, absorber x, y, scatter energy), in one indexed file.");
+
+    fMatrixPointsCmd = new G4UIcmdWithAString("/ccTest/matrix/points", this);
+    fMatrixPointsCmd->SetGuidance("Source points: every fuel rod of the assemblies, or the voxels of a grid.");
+    fMatrixPointsCmd->SetParameterName("points", false);
+    fMatrixPointsCmd->SetCandidates("rods voxels");
+    fMatrixPointsCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fMatrixPointsCmd->SetToBeBroadcasted(false);
+
+    fMatrixVoxelGridCmd = new G4UIcommand("/ccTest/matrix/voxelGrid", this);
+    fMatrixVoxelGridCmd->SetGuidance("nx x ny voxels over +-halfWidth around the assembly axis, each over");
+    fMatrixVoxelGridCmd->SetGuidance("the fuel height.");
+    auto nxParam = new G4UIparameter("nx", 'i', false);
+    nxParam->SetParameterRange("nx>0");
+    fMatrixVoxelGridCmd->SetParameter(nxParam);
+    auto nyParam = new G4UIparameter("ny", 'i', false);
+    nyParam->SetParameterRange("ny>0");
+    fMatrixVoxelGridCmd->SetParameter(nyParam);
+    auto voxelHalfWidthParam = new G4UIparameter("halfWidth", 'd', false);
+    voxelHalfWidthParam->SetParameterRange("halfWidth>0.");
+    fMatrixVoxelGridCmd->SetParameter(voxelHalfWidthParam);
+    auto voxelUnitParam = new G4UIparameter("unit", 's', true);
+    voxelUnitParam->SetDefaultValue("cm");
+    fMatrixVoxelGridCmd->SetParameter(voxelUnitParam);
+    fMatrixVoxelGridCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fMatrixVoxelGridCmd->SetToBeBroadcasted(false);
+
+    fMatrixPositionBinningCmd = new G4UIcommand("/ccTest/matrix/positionBinning", this);
+    fMatrixPositionBinningCmd->SetGuidance("Binning of the x and y of the scatter and absorber hits");
+    fMatrixPositionBinningCmd->SetGuidance("(nBins over +-halfWidth, centred on the axis).");
+    auto nPositionBinsParam = new G4UIparameter("nBins", 'i', false);
+    nPositionBinsParam->SetParameterRange("nBins>0");
+    fMatrixPositionBinningCmd->SetParameter(nPositionBinsParam);
+    auto positionHalfWidthParam = new G4UIparameter("halfWidth", 'd', false);
+    positionHalfWidthParam->SetParameterRange("halfWidth>0.");
+    fMatrixPositionBinningCmd->SetParameter(positionHalfWidthParam);
+    auto positionUnitParam = new G4UIparameter("unit", 's', true);
+    positionUnitParam->SetDefaultValue("cm");
+    fMatrixPositionBinningCmd->SetParameter(positionUnitParam);
+    fMatrixPositionBinningCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fMatrixPositionBinningCmd->SetToBeBroadcasted(false);
+
+    fMatrixEnergyBinningCmd = new G4UIcommand("/ccTest/matrix/energyBinning", this);
+    fMatrixEnergyBinningCmd->SetGuidance("Binning of the energy deposited in the scatter hit.");
+    auto nMatrixEnergyBinsParam = new G4UIparameter("nBins", 'i', false);
+    nMatrixEnergyBinsParam->SetParameterRange("nBins>0");
+    fMatrixEnergyBinningCmd->SetParameter(nMatrixEnergyBinsParam);
+    auto matrixMaxEnergyParam = new G4UIparameter("maxEnergy", 'd', false);
+    matrixMaxEnergyParam->SetParameterRange("maxEnergy>0.");
+    fMatrixEnergyBinningCmd->SetParameter(matrixMaxEnergyParam);
+    auto matrixEnergyUnitParam = new G4UIparameter("unit", 's', true);
+    matrixEnergyUnitParam->SetDefaultValue("keV");
+    fMatrixEnergyBinningCmd->SetParameter(matrixEnergyUnitParam);
+    fMatrixEnergyBinningCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fMatrixEnergyBinningCmd->SetToBeBroadcasted(false);
+
+    fMatrixFileCmd = new G4UIcmdWithAString("/ccTest/matrix/file", this);
+    fMatrixFileCmd->SetGuidance("Matrix file (default: output/matrix[_<tag>].dat).");
+    fMatrixFileCmd->SetParameterName("fileName", false);
+    fMatrixFileCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fMatrixFileCmd->SetToBeBroadcasted(false);
+
+    fMatrixRunCmd = new G4UIcmdWithAnInteger("/ccTest/matrix/run", this);
+    fMatrixRunCmd->SetGuidance("Simulate eventsPerPoint photons from each source point not yet in the");
+    fMatrixRunCmd->SetGuidance("matrix file; an existing file of the same setup is completed (restart).");
+    fMatrixRunCmd->SetParameterName("eventsPerPoint", false);
+    fMatrixRunCmd->SetRange("eventsPerPoint>0");
+    fMatrixRunCmd->AvailableForStates(G4State_Idle);
+    fMatrixRunCmd->SetToBeBroadcasted(false);
+}
+
+SystemMatrixMessenger::~SystemMatrixMessenger()
+{
+    delete fMatrixRunCmd;
+    delete fMatrixFileCmd;
+    delete fMatrixEnergyBinningCmd;
+    delete fMatrixPositionBinningCmd;
+    delete fMatrixVoxelGridCmd;
+    delete fMatrixPointsCmd;
+    delete fMatrixDir;
+}
+
+void SystemMatrixMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+    if(command==fMatrixPointsCmd)
+        fSystemMatrix->SetPointsMode(newValue=="voxels" ? SystemMatrix::kVoxels : SystemMatrix::kRods);
+    else if(command==fMatrixVoxelGridCmd)
+    {
+        std::istringstream iss(newValue);
+        G4int nx, ny;
+        G4double halfWidth;
+        G4String unit;
+        iss >> nx >> ny >> halfWidth >> unit;
+        fSystemMatrix->SetVoxelGrid(nx, ny, halfWidth*G4UIcommand::ValueOf(unit));
+    }
+    else if(command==fMatrixPositionBinningCmd || command==fMatrixEnergyBinningCmd)
+    {
+        std::istringstream iss(newValue);
+        G4int nBins;
+        G4double value;
+        G4String unit;
+        iss >> nBins >> value >> unit;
+        value *= G4UIcommand::ValueOf(unit);
+        if(command==fMatrixPositionBinningCmd) fSystemMatrix->SetPositionBinning(nBins, value);
+        else fSystemMatrix->SetEnergyBinning(nBins, value);
+    }
+    else if(command==fMatrixFileCmd)
+        fSystemMatrix->SetFileName(newValue);
+    else if(command==fMatrixRunCmd)
+        fSystemMatrix->Sweep(fMatrixRunCmd->GetNewIntValue(newValue));
+}
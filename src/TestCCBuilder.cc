@@ -11,6 +11,16 @@ GAGGDetector::GAGGDetector()
     G4double crystalWidth = 5.*cm;
     G4double crystalLength = crystalWidth;
     G4double crystalThickness = 10.*mm;
+    auto GAGGCe = FindOrBuildGAGGCe();
+    auto crystalSol = new G4Box("GAGGDetector", crystalWidth/2., crystalLength/2., crystalThickness/2.);
+    fDetectorLV = new G4LogicalVolume(crystalSol, GAGGCe, "GAGGDetector");
+    auto crystalVA = new G4VisAttributes(G4Colour::Yellow());
+    crystalVA->SetForceSolid();
+    fDetectorLV->SetVisAttributes(crystalVA);
+}
+
+G4Material* GAGGDetector::FindOrBuildGAGGCe()
+{
     G4NistManager* nist = G4NistManager::Instance();
     auto nistElGd = nist->FindOrBuildElement("Gd");
     auto nistElAl = nist->FindOrBuildElement("Al");
@@ -29,11 +39,8 @@ GAGGDetector::GAGGDetector()
         GAGGCe->AddMaterial(GAGG, 99.*perCent);
         GAGGCe->AddElement(nistElCe, 1.*perCent);
     }
-    auto crystalSol = new G4Box("GAGGDetector", crystalWidth/2., crystalLength/2., crystalThickness/2.);
-    fDetectorLV = new G4LogicalVolume(crystalSol, GAGGCe, "GAGGDetector");
-    auto crystalVA = new G4VisAttributes(G4Colour::Yellow());
-    crystalVA->SetForceSolid();
-    fDetectorLV->SetVisAttributes(crystalVA);
+
+    return GAGGCe;
 }
 
 TestCC1::TestCC1(G4String name, G4double sc2abDistance)
@@ -0,0 +1,91 @@
+// Client of the simulation service (ccTest -serve <socket>): sends one run
+// request and prints the status lines streamed back until the request ends.
+//
+//   ccClient -s <socket> [-m <macro>] [-c <command>] [-n <events>] [-seed <seed>]
+//            [-o <output directory>]
+//   ccClient -s <socket> -shutdown
+//
+// -m and -c are repeatable and applied in order. Macro and output paths are
+// made absolute, as the service may run in another directory.
+// Exit status: 0 if the request is done, 1 otherwise.
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace
+{
+    void PrintUsage()
+    {
+        std::cerr << "Usage: ccClient -s <socket> [-m <macro>] [-c <command>] [-n <events>] [-seed <seed>]\n"
+                  << "                [-o <output directory>]\n"
+                  << "       ccClient -s <socket> -shutdown" << std::endl;
+    }
+
+    std::string Absolute(const std::string& path)
+    {
+        std::error_code error;
+        auto absolute = std::filesystem::absolute(path, error);
+        return error ? path : absolute.string();
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::string socketPath, request;
+    for(int i = 1; i<argc; ++i)
+    {
+        std::string option = argv[i];
+        if(option=="-shutdown") { request += "shutdown\n"; continue; }
+        if(i + 1>=argc) { PrintUsage(); return 1; }
+        std::string value = argv[++i];
+        if(option=="-s") socketPath = value;
+        else if(option=="-m") request += "macro " + Absolute(value) + "\n";
+        else if(option=="-c") request += "command " + value + "\n";
+        else if(option=="-n") request += "events " + value + "\n";
+        else if(option=="-seed") request += "seed " + value + "\n";
+        else if(option=="-o") request += "output " + Absolute(value) + "\n";
+        else { PrintUsage(); return 1; }
+    }
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if(socketPath.empty() || socketPath.size()>=sizeof(address.sun_path)) { PrintUsage(); return 1; }
+    std::strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+    request += "end\n";
+
+    int connection = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(connection<0 || connect(connection, reinterpret_cast<sockaddr*>(&address), sizeof(address))<0)
+    {
+        std::cerr << "Cannot connect to " << socketPath << ": " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+    if(send(connection, request.data(), request.size(), MSG_NOSIGNAL)!=static_cast<ssize_t>(request.size()))
+    {
+        std::cerr << "Cannot send the request: " << std::strerror(errno) << std::endl;
+        close(connection);
+        return 1;
+    }
+
+    // The service closes the connection at the end of the request
+    bool done = false;
+    std::string line;
+    char buffer[4096];
+    for(ssize_t n; (n = recv(connection, buffer, sizeof(buffer), 0))>0;)
+        for(ssize_t i = 0; i<n; ++i)
+        {
+            if(buffer[i]!='\n') { line += buffer[i]; continue; }
+            std::cout << line << std::endl;
+            if(line.compare(0, 4, "done")==0) done = true;
+            line.clear();
+        }
+    close(connection);
+    return done ? 0 : 1;
+}
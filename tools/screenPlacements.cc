@@ -0,0 +1,325 @@
+// Screens camera placements and diversion patterns with the deterministic
+// uncollided flux of a screening scene (written with /ccTest/det/exportScene),
+// before any Geant4 run.
+//
+//   screenPlacements <scene.txt> [-p <placements.txt>] [-d <patterns.txt>]
+//                    [-n <grid>] [-e <emittedPhotons>] [-t <threads>]
+//                    [-r <rings>] [-a <pointsPerRing>] [-c <nee.txt>]
+//                    [-o <outputPrefix>]
+//
+// placements.txt: "name x y z [unit]" per line, the camera centre (as for
+//                 /ccTest/det/addView), facing the centre of the source, with
+//                 the size of the camera of view 0. Default: the scene views.
+// patterns.txt:   "name rodID rodID ..." per line, the (global) rods removed
+//                 from the active rods of the scene.
+// -n:             n x n cells over the front face of the camera (default 8)
+// -e:             photons emitted at the scene energy by the baseline source
+//                 (default 1e9); counts and significances scale with it
+// -r, -a:         source quadrature over the pellet cross section (default
+//                 3 rings of 8 points, within 1% of converged below the rods)
+// -c:             cross-check: the uncollided flux per primary at the points
+//                 of a next-event estimator output (/ccTest/nee/) of a run
+//                 with a monoenergetic source at the scene energy
+//
+// Outputs <prefix>_maps.txt (expected uncollided photons per face cell, per
+// placement) and <prefix>_patterns.txt (total counts per placement and
+// pattern, with the significance |N - N_baseline|/sqrt(N_baseline)).
+
+#include "AttenuationRayTracer.hh"
+#include "ScreeningScene.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    using Vector = ScreeningScene::Vector;
+
+    struct Placement
+    {
+        std::string name;
+        ScreeningScene::Camera camera;
+    };
+    struct Pattern
+    {
+        std::string name;
+        std::vector<int> removedRods;
+    };
+
+    void PrintUsage()
+    {
+        std::cerr << "Usage: screenPlacements <scene.txt> [-p <placements.txt>] [-d <patterns.txt>]\n"
+                  << "                        [-n <grid>] [-e <emittedPhotons>] [-t <threads>]\n"
+                  << "                        [-r <rings>] [-a <pointsPerRing>] [-c <nee.txt>]\n"
+                  << "                        [-o <outputPrefix>]" << std::endl;
+    }
+
+    double Unit(const std::string& unit)
+    {
+        static const std::map<std::string, double> units = {{"mm", 1.}, {"cm", 10.}, {"m", 1000.}};
+        auto found = units.find(unit);
+        return (found!=units.end()) ? found->second : 0.;
+    }
+
+    // The camera axis (+z) turned onto the direction, as in DetectorConstruction
+    ScreeningScene::Camera FaceTo(const ScreeningScene::Camera& model, const Vector& centre, const Vector& target)
+    {
+        ScreeningScene::Camera camera = model;
+        camera.centre = centre;
+        Vector d = {target[0] - centre[0], target[1] - centre[1], target[2] - centre[2]};
+        double norm = std::sqrt(d[0]*d[0] + d[1]*d[1] + d[2]*d[2]);
+        for(auto& value: d) value /= norm;
+        camera.axes = {Vector{1., 0., 0.}, Vector{0., 1., 0.}, Vector{0., 0., 1.}};
+        if(d[2]<-1. + 1.e-12) camera.axes = {Vector{1., 0., 0.}, Vector{0., -1., 0.}, Vector{0., 0., -1.}};
+        else if(d[2]<1. - 1.e-12)
+        {
+            // Rodrigues, about z x d
+            double kNorm = std::sqrt(d[0]*d[0] + d[1]*d[1]);
+            Vector k = {-d[1]/kNorm, d[0]/kNorm, 0.};
+            double c = d[2], s = kNorm;
+            for(auto& axis: camera.axes)
+            {
+                Vector v = axis;
+                Vector cross = {k[1]*v[2] - k[2]*v[1], k[2]*v[0] - k[0]*v[2], k[0]*v[1] - k[1]*v[0]};
+                double dot = k[0]*v[0] + k[1]*v[1] + k[2]*v[2];
+                for(std::size_t l = 0; l<3; ++l) axis[l] = v[l]*c + cross[l]*s + k[l]*dot*(1. - c);
+            }
+        }
+        return camera;
+    }
+
+    bool ReadPlacements(const std::string& fileName, const ScreeningScene& scene, std::vector<Placement>& placements)
+    {
+        std::ifstream in(fileName);
+        if(!in) return false;
+        auto target = scene.GetSourceCentre();
+        for(std::string line; std::getline(in, line);)
+        {
+            if(line.empty() || line[0]=='#') continue;
+            std::istringstream iss(line);
+            Placement placement;
+            Vector centre;
+            std::string unit = "cm";
+            if(!(iss >> placement.name >> centre[0] >> centre[1] >> centre[2])) return false;
+            iss >> unit;
+            if(Unit(unit)<=0.) return false;
+            for(auto& value: centre) value *= Unit(unit);
+            placement.camera = FaceTo(scene.cameras.front(), centre, target);
+            placements.push_back(placement);
+        }
+        return true;
+    }
+
+    bool ReadPatterns(const std::string& fileName, int nRods, std::vector<Pattern>& patterns)
+    {
+        std::ifstream in(fileName);
+        if(!in) return false;
+        for(std::string line; std::getline(in, line);)
+        {
+            if(line.empty() || line[0]=='#') continue;
+            std::istringstream iss(line);
+            Pattern pattern;
+            iss >> pattern.name;
+            for(int rodID; iss >> rodID;)
+            {
+                if(rodID<0 || rodID>=nRods) return false;
+                pattern.removedRods.push_back(rodID);
+            }
+            std::sort(pattern.removedRods.begin(), pattern.removedRods.end());
+            pattern.removedRods.erase(std::unique(pattern.removedRods.begin(), pattern.removedRods.end()),
+                                      pattern.removedRods.end());
+            patterns.push_back(pattern);
+        }
+        return true;
+    }
+
+    // Points and uncollided flux (cm^-2 per primary) with its error
+    struct NEEPoint
+    {
+        Vector position;
+        double flux, error;
+    };
+    bool ReadNextEventEstimate(const std::string& fileName, std::vector<NEEPoint>& points)
+    {
+        std::ifstream in(fileName);
+        if(!in) return false;
+        for(std::string line; std::getline(in, line);)
+        {
+            if(line.rfind("# spectra", 0)==0) break;
+            if(line.empty() || line[0]=='#') continue;
+            std::istringstream iss(line);
+            int index;
+            NEEPoint point;
+            if(!(iss >> index >> point.position[0] >> point.position[1] >> point.position[2]
+                 >> point.flux >> point.error)) return false;
+            points.push_back(point);
+        }
+        return !points.empty();
+    }
+
+    std::vector<Vector> FaceCells(const ScreeningScene::Camera& camera, int n)
+    {
+        std::vector<Vector> cells;
+        for(int j = 0; j<n; ++j)
+            for(int i = 0; i<n; ++i)
+            {
+                double u = (-1. + (2.*i + 1.)/n)*camera.halfSize[0], v = (-1. + (2.*j + 1.)/n)*camera.halfSize[1];
+                Vector cell;
+                for(std::size_t l = 0; l<3; ++l)
+                    cell[l] = camera.centre[l] + u*camera.axes[0][l] + v*camera.axes[1][l]
+                            + camera.halfSize[2]*camera.axes[2][l];
+                cells.push_back(cell);
+            }
+        return cells;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if(argc<2) { PrintUsage(); return 1; }
+
+    std::string sceneName = argv[1], placementsName, patternsName, neeName, prefix = "screening";
+    int n = 8;
+    double emitted = 1.e9;
+    AttenuationRayTracer::Settings settings;
+    settings.nThreads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    for(int i = 2; i<argc - 1; i += 2)
+    {
+        std::string option = argv[i];
+        if(option=="-p") placementsName = argv[i + 1];
+        else if(option=="-d") patternsName = argv[i + 1];
+        else if(option=="-n") n = std::atoi(argv[i + 1]);
+        else if(option=="-e") emitted = std::atof(argv[i + 1]);
+        else if(option=="-t") settings.nThreads = std::atoi(argv[i + 1]);
+        else if(option=="-r") settings.nRadial = std::atoi(argv[i + 1]);
+        else if(option=="-a") settings.nAzimuthal = std::atoi(argv[i + 1]);
+        else if(option=="-c") neeName = argv[i + 1];
+        else if(option=="-o") prefix = argv[i + 1];
+        else { PrintUsage(); return 1; }
+    }
+    if(n<1 || settings.nThreads<1 || settings.nRadial<1 || settings.nAzimuthal<1) { PrintUsage(); return 1; }
+
+    ScreeningScene scene;
+    if(!scene.Read(sceneName))
+    {
+        std::cerr << "Cannot read screening scene '" << sceneName << "'." << std::endl;
+        return 1;
+    }
+    auto activities = scene.GetRodActivities();
+    double totalActivity = 0.;
+    for(auto activity: activities) totalActivity += activity;
+    if(totalActivity<=0.)
+    {
+        std::cerr << "The scene has no active fuel rod." << std::endl;
+        return 1;
+    }
+
+    std::vector<Placement> placements;
+    if(placementsName.empty())
+        for(std::size_t view = 0; view<scene.cameras.size(); ++view)
+            placements.push_back({"view" + std::to_string(view), scene.cameras[view]});
+    else if(scene.cameras.empty() || !ReadPlacements(placementsName, scene, placements))
+    {
+        std::cerr << "Cannot read placements '" << placementsName << "' (\"name x y z [mm|cm|m]\")." << std::endl;
+        return 1;
+    }
+    std::vector<Pattern> patterns;
+    if(!patternsName.empty() && !ReadPatterns(patternsName, scene.GetNRods(), patterns))
+    {
+        std::cerr << "Cannot read patterns '" << patternsName << "' (\"name rodID ...\", rod IDs below "
+                  << scene.GetNRods() << ")." << std::endl;
+        return 1;
+    }
+
+    AttenuationRayTracer tracer(scene, settings);
+    std::cout << "scene:        " << scene.assemblies.size() << " assemblies, " << scene.GetNRods() << " rods, "
+              << scene.energy << " keV\n"
+              << "quadrature:   " << tracer.GetNSourceNodes() << " source points per rod\n"
+              << "placements:   " << placements.size() << ", " << n << " x " << n << " face cells\n"
+              << "patterns:     " << patterns.size() << "\n"
+              << "threads:      " << settings.nThreads << std::endl;
+
+    // Cross-check against the next-event estimator of a full simulation
+    if(!neeName.empty())
+    {
+        std::vector<NEEPoint> points;
+        if(!ReadNextEventEstimate(neeName, points))
+        {
+            std::cerr << "Cannot read next-event estimates '" << neeName << "'." << std::endl;
+            return 1;
+        }
+        std::vector<Vector> positions;
+        for(const auto& point: points) positions.push_back(point.position);
+        auto response = tracer.Response(positions);
+        double chi2 = 0.;
+        std::cout << "cross-check against " << neeName << " (uncollided flux per primary, cm^-2):\n"
+                  << "  point\tray traced\tsimulated\terror\tratio\tpull" << std::endl;
+        for(std::size_t p = 0; p<points.size(); ++p)
+        {
+            double flux = 0.;
+            for(std::size_t rod = 0; rod<activities.size(); ++rod)
+                flux += activities[rod]/totalActivity*response[p*activities.size() + rod];
+            flux *= 100.; // mm^-2 -> cm^-2
+            double pull = (points[p].error>0.) ? (flux - points[p].flux)/points[p].error : 0.;
+            chi2 += pull*pull;
+            std::cout << "  " << p << "\t" << flux << "\t" << points[p].flux << "\t" << points[p].error << "\t"
+                      << ((points[p].flux>0.) ? flux/points[p].flux : 0.) << "\t" << pull << std::endl;
+        }
+        std::cout << "  chi2/ndf = " << chi2 << "/" << points.size() << std::endl;
+    }
+
+    std::ofstream mapsOut(prefix + "_maps.txt");
+    std::ofstream patternsOut(prefix + "_patterns.txt");
+    mapsOut << "# expected uncollided photons per face cell for " << emitted << " emitted photons, "
+            << n << " x " << n << " cells (rows: local y, columns: local x)\n";
+    patternsOut << "# placement\tpattern\tcounts\tbaseline\tsignificance\n";
+    auto start = std::chrono::steady_clock::now();
+    for(const auto& placement: placements)
+    {
+        const auto& camera = placement.camera;
+        double cellArea = 4.*camera.halfSize[0]*camera.halfSize[1]/(n*n);
+        auto cells = FaceCells(camera, n);
+        auto response = tracer.Response(cells, &camera.axes[2]);
+
+        // Counts per rod on the whole face, then the baseline map
+        std::vector<double> rodCounts(activities.size(), 0.);
+        mapsOut << "# " << placement.name << " centre " << camera.centre[0] << " " << camera.centre[1] << " "
+                << camera.centre[2] << " mm\n";
+        double baseline = 0.;
+        for(std::size_t cell = 0; cell<cells.size(); ++cell)
+        {
+            double counts = 0.;
+            for(std::size_t rod = 0; rod<activities.size(); ++rod)
+            {
+                double rodCount = emitted*activities[rod]/totalActivity*cellArea*response[cell*activities.size() + rod];
+                rodCounts[rod] += rodCount;
+                counts += rodCount;
+            }
+            baseline += counts;
+            mapsOut << counts << ((cell%static_cast<std::size_t>(n)==static_cast<std::size_t>(n - 1)) ? "\n" : " ");
+        }
+        patternsOut << placement.name << "\tbaseline\t" << baseline << "\t" << baseline << "\t0\n";
+        for(const auto& pattern: patterns)
+        {
+            double counts = baseline;
+            for(auto rodID: pattern.removedRods) counts -= rodCounts[static_cast<std::size_t>(rodID)];
+            patternsOut << placement.name << "\t" << pattern.name << "\t" << counts << "\t" << baseline << "\t"
+                        << ((baseline>0.) ? std::abs(counts - baseline)/std::sqrt(baseline) : 0.) << "\n";
+        }
+    }
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "screened in   " << elapsed << " s (" << elapsed/static_cast<double>(placements.size())
+              << " s per placement)\n"
+              << "written to    " << prefix << "_maps.txt, " << prefix << "_patterns.txt" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,102 @@
+// Sorts the per-thread singles streams of a pile-up run
+// (output/singles[_<tag>]_t<thread>.bin, written with /ccTest/pileup/activity)
+// into coincidences, with a coincidence window and a detector dead time.
+//
+//   sortCoincidences [-w <window(ns)>] [-d <deadTime(ns)>] [-p <0|1 paralyzable>]
+//                    [-o <coincidences.txt>] <singles_t0.bin> [<singles_t1.bin> ...]
+//
+// The streams are k-way merged and sorted on the fly, so memory does not grow
+// with the number of singles. Prints the singles and coincidence rates over
+// the simulated time span, the dead-time losses and the fraction of random
+// (pile-up) coincidences.
+// -o: one line per coincidence: true(1)/random(0), n, then n x
+//     "evtID detID t(ns) E(keV) x y z(mm) weight"
+
+#include "CoincidenceSorter.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    void PrintUsage()
+    {
+        std::cerr << "Usage: sortCoincidences [-w <window(ns)>] [-d <deadTime(ns)>] [-p <0|1 paralyzable>]\n"
+                  << "                        [-o <coincidences.txt>] <singles_t0.bin> [<singles_t1.bin> ...]"
+                  << std::endl;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    CoincidenceSorter::Settings settings;
+    std::string outName;
+    std::vector<std::string> fileNames;
+    for(int i = 1; i<argc; ++i)
+    {
+        std::string option = argv[i];
+        if(option[0]!='-') { fileNames.push_back(option); continue; }
+        if(i + 1>=argc) { PrintUsage(); return 1; }
+        if(option=="-w") settings.window = std::atof(argv[++i]);
+        else if(option=="-d") settings.deadTime = std::atof(argv[++i]);
+        else if(option=="-p") settings.paralyzable = std::atoi(argv[++i])!=0;
+        else if(option=="-o") outName = argv[++i];
+        else { PrintUsage(); return 1; }
+    }
+    if(fileNames.empty()) { PrintUsage(); return 1; }
+
+    SinglesMerger merger(fileNames);
+    if(!merger.IsValid())
+    {
+        std::cerr << "Cannot read all singles streams." << std::endl;
+        return 1;
+    }
+
+    std::ofstream out;
+    CoincidenceSorter::Callback callback;
+    if(!outName.empty())
+    {
+        out.open(outName);
+        out << "# window " << settings.window << " ns, dead time " << settings.deadTime << " ns"
+            << (settings.paralyzable ? " (paralyzable)" : "") << "\n";
+        callback = [&out](const std::vector<Single>& singles, bool trueCoincidence)
+        {
+            out << trueCoincidence << "\t" << singles.size();
+            for(const auto& single: singles)
+                out << "\t" << single.eventID << "\t" << single.detID << "\t" << single.time << "\t"
+                    << single.energy << "\t" << single.x << "\t" << single.y << "\t" << single.z << "\t"
+                    << single.weight;
+            out << "\n";
+        };
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    CoincidenceSorter sorter(settings, callback);
+    for(Single single; merger.Next(single);) sorter.Process(single);
+    sorter.Finish();
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const auto& counters = sorter.GetCounters();
+    double span = (counters.lastTime - counters.firstTime)*1e-9; // s
+    auto Rate = [span](std::uint64_t n) { return span>0. ? n/span : 0.; };
+    auto Fraction = [](std::uint64_t n, std::uint64_t total) { return total ? static_cast<double>(n)/total : 0.; };
+    std::cout << "streams:            " << fileNames.size() << "\n"
+              << "time span:          " << span << " s\n"
+              << "singles:            " << counters.singles << " (" << Rate(counters.singles) << " /s)\n"
+              << "dead-time losses:   " << counters.deadTimeLosses << " ("
+              << Fraction(counters.deadTimeLosses, counters.singles) << ")\n"
+              << "coincidences:       " << counters.coincidences << " (" << Rate(counters.coincidences) << " /s)\n"
+              << "  true:             " << counters.trueCoincidences << "\n"
+              << "  random fraction:  " << Fraction(counters.coincidences - counters.trueCoincidences,
+                                                    counters.coincidences) << "\n"
+              << "  > 2 detectors:    " << counters.multipleCoincidences << "\n"
+              << "sorted in " << elapsed << " s (" << counters.singles/std::max(elapsed, 1e-9)
+              << " singles/s)" << std::endl;
+
+    return 0;
+}
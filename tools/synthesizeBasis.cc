@@ -0,0 +1,160 @@
+// Synthesizes the camera response to an arbitrary fuel rod activity map from
+// a per-rod basis library (output/basis.dat, written with /ccTest/basis/enable).
+//
+//   synthesizeBasis <basis.dat> (-p <pattern.txt> | -r <activeRatio> [-s <seed>])
+//                   [-l <data.txt>] [-o <outputPrefix>]
+//
+// pattern.txt: one activity per fuel rod, whitespace separated, in the rod ID
+//              order of the fuel rod status map (lines starting with '#' are
+//              skipped). 0/1 patterns select active rods.
+// -r:          random pattern with the given fraction of active rods
+// -l:          coincidence list of the basis run (output/data.txt with the
+//              FuelRodID column), rewritten with synthesized event weights
+//
+// Outputs <prefix>_spectrum.txt, <prefix>_image.txt (and <prefix>_list.txt);
+// all values are expected counts per unit activity and started primary.
+
+#include "BasisLibrary.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    void PrintUsage()
+    {
+        std::cerr << "Usage: synthesizeBasis <basis.dat> (-p <pattern.txt> | -r <activeRatio> [-s <seed>])\n"
+                  << "                       [-l <data.txt>] [-o <outputPrefix>]" << std::endl;
+    }
+
+    bool ReadPattern(const std::string& fileName, std::vector<double>& activity)
+    {
+        std::ifstream in(fileName);
+        if(!in) return false;
+        activity.clear();
+        for(std::string line; std::getline(in, line);)
+        {
+            if(line.empty() || line[0]=='#') continue;
+            std::istringstream iss(line);
+            for(double value; iss >> value;) activity.push_back(value);
+        }
+        return true;
+    }
+
+    std::vector<double> RandomPattern(int nRods, double ratio, unsigned seed)
+    {
+        std::vector<int> rodIDs(static_cast<std::size_t>(nRods));
+        std::iota(rodIDs.begin(), rodIDs.end(), 0);
+        std::vector<int> activeRodIDs;
+        std::sample(rodIDs.begin(), rodIDs.end(), std::back_inserter(activeRodIDs),
+                    static_cast<int>(nRods*ratio), std::mt19937{seed});
+
+        std::vector<double> activity(static_cast<std::size_t>(nRods), 0.);
+        for(auto rodID: activeRodIDs) activity[static_cast<std::size_t>(rodID)] = 1.;
+        return activity;
+    }
+
+    // evtID FuelRodID ParticleWeight rest... -> evtID Weight rest...
+    std::size_t ReweightList(const BasisLibrary& basis, const std::vector<double>& activity,
+                             const std::string& inName, const std::string& outName)
+    {
+        std::ifstream in(inName);
+        std::ofstream out(outName);
+        std::size_t nEvents = 0;
+        out << "# synthesized from " << inName << "\n";
+        for(std::string line; std::getline(in, line);)
+        {
+            if(line.empty() || line[0]=='#') continue;
+            std::istringstream iss(line);
+            std::string evtID, rest;
+            int rodID;
+            double weight;
+            if(!(iss >> evtID >> rodID >> weight)) continue;
+            if(rodID<0 || rodID>=basis.GetNRods()) continue;
+            double scale = basis.GetScale(rodID, activity[static_cast<std::size_t>(rodID)]);
+            if(scale==0.) continue;
+            std::getline(iss, rest);
+            out << evtID << "\t" << weight*scale << rest << "\n";
+            ++nEvents;
+        }
+        return nEvents;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if(argc<2) { PrintUsage(); return 1; }
+
+    std::string basisName = argv[1], patternName, listName, prefix = "synthesized";
+    double ratio = -1.;
+    unsigned seed = 0;
+    for(int i = 2; i<argc - 1; i += 2)
+    {
+        std::string option = argv[i];
+        if(option=="-p") patternName = argv[i + 1];
+        else if(option=="-r") ratio = std::atof(argv[i + 1]);
+        else if(option=="-s") seed = static_cast<unsigned>(std::atol(argv[i + 1]));
+        else if(option=="-l") listName = argv[i + 1];
+        else if(option=="-o") prefix = argv[i + 1];
+        else { PrintUsage(); return 1; }
+    }
+
+    BasisLibrary basis;
+    if(!basis.Read(basisName))
+    {
+        std::cerr << "Cannot read basis library '" << basisName << "'." << std::endl;
+        return 1;
+    }
+
+    std::vector<double> activity;
+    if(!patternName.empty())
+    {
+        if(!ReadPattern(patternName, activity) || static_cast<int>(activity.size())!=basis.GetNRods())
+        {
+            std::cerr << "Pattern '" << patternName << "' must list " << basis.GetNRods()
+                      << " rod activities." << std::endl;
+            return 1;
+        }
+    }
+    else if(ratio>=0. && ratio<=1.) activity = RandomPattern(basis.GetNRods(), ratio, seed);
+    else { PrintUsage(); return 1; }
+
+    auto start = std::chrono::steady_clock::now();
+    auto response = basis.Synthesize(activity);
+    auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "fuel rods:     " << basis.GetNX() << " x " << basis.GetNY() << "\n"
+              << "singles:       " << response.singles << "\n"
+              << "coincidences:  " << response.coincidences << "\n"
+              << "synthesized in " << elapsed << " ms" << std::endl;
+
+    std::ofstream spectrumOut(prefix + "_spectrum.txt");
+    spectrumOut << "# E_low(keV)\tE_high(keV)\tcounts\n";
+    double binWidth = basis.GetMaxEnergy()/basis.GetNEnergyBins();
+    for(int i = 0; i<basis.GetNEnergyBins(); ++i)
+        spectrumOut << i*binWidth << "\t" << (i + 1)*binWidth << "\t"
+                    << response.spectrum[static_cast<std::size_t>(i)] << "\n";
+
+    std::ofstream imageOut(prefix + "_image.txt");
+    imageOut << "# " << basis.GetNImageBins() << " x " << basis.GetNImageBins() << " bins, "
+             << "x/y from " << -basis.GetImageHalfWidth() << " to " << basis.GetImageHalfWidth() << " mm\n";
+    for(int iy = 0; iy<basis.GetNImageBins(); ++iy)
+    {
+        for(int ix = 0; ix<basis.GetNImageBins(); ++ix)
+            imageOut << response.image[static_cast<std::size_t>(ix + basis.GetNImageBins()*iy)] << " ";
+        imageOut << "\n";
+    }
+
+    if(!listName.empty())
+        std::cout << "list events:   " << ReweightList(basis, activity, listName, prefix + "_list.txt") << std::endl;
+
+    return 0;
+}